@@ -0,0 +1,723 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/ngc.h"
+#include <fcntl.h>
+#include <getopt.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Benchmark driver for the library hot paths and the CLI. Each benchmark
+// runs on every input set; iterations per sample are calibrated so that a
+// sample lasts at least --sample-time seconds, and the median of the
+// samples is reported.
+
+#define DEFAULT_SAMPLES 15
+#define DEFAULT_SAMPLE_TIME 0.02
+#define DEFAULT_THRESHOLD 0.10
+#define MAX_BASELINE 256
+#define NAME_SIZE 64
+
+typedef struct {
+    const char* name;
+    double throat_radius;
+    double exit_radius;
+    double gamma;
+} BenchInput;
+
+// Expansion ratios 2.25, 9, 64 and 400
+static const BenchInput bench_inputs[] = {
+    { "low-ar",  0.010, 0.015, 1.40 },
+    { "mid-ar",  0.010, 0.030, 1.30 },
+    { "high-ar", 0.010, 0.080, 1.20 },
+    { "vacuum",  0.010, 0.200, 1.15 },
+};
+#define NUM_INPUTS ((int)(sizeof(bench_inputs) / sizeof(bench_inputs[0])))
+
+typedef struct {
+    const BenchInput* input;
+    NozzleGeometry nozzle;
+    FlowConditions conditions;
+    char data_path[MAX_FILENAME];
+    char plot_path[MAX_FILENAME];
+    char mesh_path[MAX_FILENAME];
+    const char* cli_path;
+    char* const* cli_argv;
+} BenchState;
+
+typedef int (*BenchFn)(BenchState* state, long long iterations);
+
+typedef struct {
+    const char* name;
+    BenchFn run;
+    int needs_cli;
+} Benchmark;
+
+typedef struct {
+    double median;               // ns/op
+    double mean;
+    double stddev;
+    double min;
+    long long iterations;        // Per sample
+    int samples;
+} BenchStats;
+
+typedef struct {
+    char benchmark[NAME_SIZE];
+    char input[NAME_SIZE];
+    double median;
+    double stddev;
+} BaselineEntry;
+
+// Results feed into this so the calls cannot be optimized away
+static volatile double bench_sink;
+
+static int bench_geometry(BenchState* state, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        if (calculate_bell_nozzle_geometry(&state->nozzle, 0.8) != 0) {
+            return -1;
+        }
+        bench_sink += state->nozzle.geometry[state->nozzle.num_points - 1].y;
+    }
+    return 0;
+}
+
+static int bench_exit_conditions(BenchState* state, long long iterations) {
+    double pressure, temperature, velocity;
+    for (long long i = 0; i < iterations; i++) {
+        bench_sink += calculate_exit_conditions(&state->nozzle, &state->conditions,
+                                                &pressure, &temperature, &velocity);
+    }
+    return isfinite(bench_sink) ? 0 : -1;
+}
+
+static int bench_performance(BenchState* state, long long iterations) {
+    PerformanceResults results;
+    for (long long i = 0; i < iterations; i++) {
+        if (calculate_performance(&state->nozzle, &state->conditions, &results) != 0) {
+            return -1;
+        }
+        bench_sink += results.specific_impulse;
+    }
+    return 0;
+}
+
+// Per case of a 1024-case block of the same design
+static int bench_performance_batch(BenchState* state, long long iterations) {
+    enum { BLOCK = 1024 };
+    static double in[8][BLOCK], out[9][BLOCK];
+    const double values[8] = {
+        state->nozzle.throat_radius, state->nozzle.exit_radius, state->conditions.chamber_pressure,
+        state->conditions.ambient_pressure, state->conditions.chamber_temperature,
+        state->conditions.molecular_weight, state->conditions.gamma, state->conditions.gas_constant
+    };
+    for (int f = 0; f < 8; f++) {
+        for (int i = 0; i < BLOCK; i++) {
+            in[f][i] = values[f];
+        }
+    }
+    PerformanceBatchInput input = { in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7] };
+    PerformanceBatchOutput output = { out[0], out[1], out[2], out[3], out[4], out[5], out[6], out[7], out[8] };
+
+    for (long long done = 0; done < iterations; done += BLOCK) {
+        size_t count = iterations - done < BLOCK ? (size_t)(iterations - done) : BLOCK;
+        calculate_performance_batch(&input, &output, count);
+        bench_sink += out[0][count - 1];
+    }
+    return 0;
+}
+
+// As batch, through the single-precision kernels
+static int bench_performance_batch_f32(BenchState* state, long long iterations) {
+    enum { BLOCK = 1024 };
+    static float in[8][BLOCK], out[9][BLOCK];
+    const double values[8] = {
+        state->nozzle.throat_radius, state->nozzle.exit_radius, state->conditions.chamber_pressure,
+        state->conditions.ambient_pressure, state->conditions.chamber_temperature,
+        state->conditions.molecular_weight, state->conditions.gamma, state->conditions.gas_constant
+    };
+    for (int f = 0; f < 8; f++) {
+        for (int i = 0; i < BLOCK; i++) {
+            in[f][i] = (float)values[f];
+        }
+    }
+    PerformanceBatchInputF input = { in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7] };
+    PerformanceBatchOutputF output = { out[0], out[1], out[2], out[3], out[4], out[5], out[6], out[7], out[8] };
+
+    for (long long done = 0; done < iterations; done += BLOCK) {
+        size_t count = iterations - done < BLOCK ? (size_t)(iterations - done) : BLOCK;
+        calculate_performance_batch_f32(&input, &output, count);
+        bench_sink += out[0][count - 1];
+    }
+    return 0;
+}
+
+// Ascent profile: one op is one altitude point, 0 to 80 km
+static int bench_thrust_profile(BenchState* state, long long iterations) {
+    enum { BLOCK = 256 };
+    double altitudes[BLOCK], thrust[BLOCK], isp[BLOCK];
+    unsigned char separated[BLOCK];
+    AmbientPerformanceOutput output = { thrust, isp, NULL, separated };
+    ThrustProfile profile;
+    NozzleContour contour;
+
+    nozzle_contour_init(&contour, state->nozzle.throat_radius, state->nozzle.exit_radius, NULL, 0);
+    if (calculate_bell_nozzle_contour(&contour, 0.8, NULL) != 0 ||
+        thrust_profile_init(&profile, &contour, &state->conditions) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < BLOCK; i++) {
+        altitudes[i] = 80000.0 * i / (BLOCK - 1);
+    }
+
+    for (long long done = 0; done < iterations; done += BLOCK) {
+        size_t count = iterations - done < BLOCK ? (size_t)(iterations - done) : BLOCK;
+        thrust_profile_altitudes(&profile, altitudes, &output, count);
+        bench_sink += thrust[count - 1];
+    }
+    return 0;
+}
+
+// Per station of a 1000-point uniform contour
+static int bench_flow_profile(BenchState* state, long long iterations) {
+    enum { STATIONS = 1000 };
+    static Point points[STATIONS];
+    static double mach[STATIONS], pressure[STATIONS];
+    FlowProfileOutput output = { NULL, mach, pressure, NULL, NULL, NULL };
+    ContourOptions options = { CONTOUR_UNIFORM, STATIONS, 0 };
+    NozzleContour contour;
+
+    nozzle_contour_init(&contour, state->nozzle.throat_radius, state->nozzle.exit_radius, points, STATIONS);
+    if (calculate_bell_nozzle_contour(&contour, 0.8, &options) != 0) {
+        return -1;
+    }
+
+    for (long long done = 0; done < iterations; done += contour.num_points) {
+        if (calculate_flow_profile(&contour, &state->conditions, &output) != 0) {
+            return -1;
+        }
+        bench_sink += pressure[contour.num_points - 1];
+    }
+    return 0;
+}
+
+// Per station of a 1000-point uniform contour
+static int bench_thermal_profile(BenchState* state, long long iterations) {
+    enum { STATIONS = 1000 };
+    static Point points[STATIONS];
+    static double heat_flux[STATIONS];
+    ThermalConditions thermal = { 800.0, 0.0, 0.0, 0.0 };
+    ThermalProfileOutput output = { NULL, NULL, heat_flux };
+    ContourOptions options = { CONTOUR_UNIFORM, STATIONS, 0 };
+    NozzleContour contour;
+
+    nozzle_contour_init(&contour, state->nozzle.throat_radius, state->nozzle.exit_radius, points, STATIONS);
+    if (calculate_bell_nozzle_contour(&contour, 0.8, &options) != 0) {
+        return -1;
+    }
+
+    for (long long done = 0; done < iterations; done += contour.num_points) {
+        if (calculate_thermal_profile(&contour, &state->conditions, &thermal, &output, NULL) != 0) {
+            return -1;
+        }
+        bench_sink += heat_flux[contour.num_points - 1];
+    }
+    return 0;
+}
+
+static int bench_sensitivities(BenchState* state, long long iterations) {
+    NozzleDesign design = { state->nozzle.throat_radius, state->nozzle.exit_radius, 0.8, state->conditions };
+    PerformanceSensitivities sensitivities;
+
+    for (long long i = 0; i < iterations; i++) {
+        if (calculate_performance_sensitivities(&design, &sensitivities) != 0) {
+            return -1;
+        }
+        bench_sink += sensitivities.jacobian[SENSITIVITY_THRUST][SWEEP_GAMMA];
+    }
+    return 0;
+}
+
+// A table built on first use and kept mapped. It is small so that building
+// it does not upset the calibration; a lookup costs the same on any grid
+static const CfSurrogate* bench_surrogate(BenchState* state) {
+    static CfSurrogate surrogate;
+    static int ready;
+    if (!ready) {
+        SurrogateConfig config = { 1.5, 1000.0, 64, 1.1, 1.7, 16, 1 };
+        if (build_cf_surrogate(NULL, &config, state->data_path) != 0 ||
+            cf_surrogate_open(NULL, &surrogate, state->data_path) != 0) {
+            return NULL;
+        }
+        ready = 1;
+    }
+    return &surrogate;
+}
+
+static int bench_surrogate_lookup(BenchState* state, long long iterations, SurrogateInterpolation method) {
+    const CfSurrogate* surrogate = bench_surrogate(state);
+    if (!surrogate) {
+        return -1;
+    }
+
+    // A slowly changing chamber pressure, as along a trajectory
+    SurrogateResult result;
+    for (long long i = 0; i < iterations; i++) {
+        if (cf_surrogate_lookup(surrogate, method, state->nozzle.expansion_ratio, state->conditions.gamma,
+                                10.0 + (double)(i & 1023), &result) != 0) {
+            return -1;
+        }
+        bench_sink += result.thrust_coefficient;
+    }
+    return 0;
+}
+
+static int bench_surrogate_linear(BenchState* state, long long iterations) {
+    return bench_surrogate_lookup(state, iterations, SURROGATE_LINEAR);
+}
+
+static int bench_surrogate_cubic(BenchState* state, long long iterations) {
+    return bench_surrogate_lookup(state, iterations, SURROGATE_CUBIC);
+}
+
+// LOX/LH2 over a range of mixture ratios, each solved from the cold start
+static int bench_chamber_equilibrium(BenchState* state, long long iterations) {
+    ChamberState chamber;
+
+    for (long long i = 0; i < iterations; i++) {
+        if (calculate_chamber_state(NULL, PROPELLANT_LOX_LH2, 4.0 + 0.004 * (double)(i & 1023),
+                                    state->conditions.chamber_pressure, &chamber) != 0) {
+            return -1;
+        }
+        bench_sink += chamber.properties.gamma_shifting;
+    }
+    return 0;
+}
+
+// Per lookup in a small table built on first use
+static int bench_propellant_table(BenchState* state, long long iterations) {
+    static PropellantTable table;
+    static int ready;
+    if (!ready) {
+        PropellantTableConfig config = { PROPELLANT_LOX_LH2, 4.0, 8.0, 32, 1.0e5, 1.0e8, 4, 1 };
+        if (build_propellant_table(NULL, &config, &table) != 0) {
+            return -1;
+        }
+        ready = 1;
+    }
+
+    ChamberProperties properties;
+    for (long long i = 0; i < iterations; i++) {
+        if (propellant_table_lookup(&table, 4.0 + 0.0039 * (double)(i & 1023), state->conditions.chamber_pressure,
+                                    &properties) != 0) {
+            return -1;
+        }
+        bench_sink += properties.gamma_shifting;
+    }
+    return 0;
+}
+
+// Per sample, with five uncertain inputs on one thread
+static int bench_monte_carlo(BenchState* state, long long iterations) {
+    UncertaintyConfig config;
+    UncertaintySummary summary;
+
+    memset(&config, 0, sizeof(config));
+    config.base.throat_radius = state->nozzle.throat_radius;
+    config.base.exit_radius = state->nozzle.exit_radius;
+    config.base.length_fraction = 0.8;
+    config.base.conditions = state->conditions;
+    config.inputs[SWEEP_THROAT_RADIUS] = (UncertainInput){ UNCERTAINTY_UNIFORM, 0.999 * state->nozzle.throat_radius,
+                                                           1.001 * state->nozzle.throat_radius };
+    config.inputs[SWEEP_EXIT_RADIUS] = (UncertainInput){ UNCERTAINTY_UNIFORM, 0.999 * state->nozzle.exit_radius,
+                                                         1.001 * state->nozzle.exit_radius };
+    config.inputs[SWEEP_CHAMBER_PRESSURE] = (UncertainInput){ UNCERTAINTY_NORMAL, 1.0e6, 2.0e4 };
+    config.inputs[SWEEP_CHAMBER_TEMPERATURE] = (UncertainInput){ UNCERTAINTY_NORMAL, 3000.0, 30.0 };
+    config.inputs[SWEEP_GAMMA] = (UncertainInput){ UNCERTAINTY_NORMAL, state->input->gamma, 0.005 };
+    config.samples = iterations;
+    config.num_threads = 1;
+
+    if (run_uncertainty_analysis(&config, &summary) != 0) {
+        return -1;
+    }
+    bench_sink += summary.outputs[UNCERTAINTY_THRUST].mean;
+    return 0;
+}
+
+// Per design, exploring exit radius and length fraction against four objectives on one thread
+static int bench_pareto(BenchState* state, long long iterations) {
+    ParetoConfig config;
+    ParetoFront front;
+    ParetoSummary summary;
+
+    memset(&config, 0, sizeof(config));
+    config.base.throat_radius = state->nozzle.throat_radius;
+    config.base.exit_radius = state->nozzle.exit_radius;
+    config.base.length_fraction = 0.8;
+    config.base.conditions = state->conditions;
+    config.bounds[SWEEP_EXIT_RADIUS] = (DesignBound){ 1, 1.1 * state->nozzle.throat_radius,
+                                                      10.0 * state->nozzle.throat_radius };
+    config.bounds[SWEEP_LENGTH_FRACTION] = (DesignBound){ 1, 0.6, 1.0 };
+    config.max_evaluations = iterations;
+    config.num_threads = 1;
+    if (parse_pareto_objectives(&config, "isp,length,exit-area,wall-area") != 0 ||
+        run_pareto_exploration(NULL, &config, &front, &summary) != 0) {
+        return -1;
+    }
+    bench_sink += (double)front.count;
+    pareto_front_free(&front);
+    return 0;
+}
+
+// One 200-point, 128-segment STL mesh (50,944 triangles) on one thread
+static int bench_mesh_stl(BenchState* state, long long iterations) {
+    enum { STATIONS = 200 };
+    static Point points[STATIONS];
+    ContourOptions options = { CONTOUR_UNIFORM, STATIONS, 0 };
+    MeshOptions mesh = { MESH_STL, 128, 0.0, 1 };
+    NozzleContour contour;
+
+    nozzle_contour_init(&contour, state->nozzle.throat_radius, state->nozzle.exit_radius, points, STATIONS);
+    if (calculate_bell_nozzle_contour(&contour, 0.8, &options) != 0) {
+        return -1;
+    }
+
+    for (long long i = 0; i < iterations; i++) {
+        if (write_nozzle_mesh(NULL, &contour, &mesh, state->mesh_path) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench_write_geometry(BenchState* state, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        if (write_geometry_data(NULL, &state->nozzle, state->data_path) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// The CLI's default run in-process: validate, contour, performance,
+// PNG plot and text geometry output
+static int bench_pipeline(BenchState* state, long long iterations) {
+    Point points[MAX_POINTS];
+    NozzleContour contour;
+    PerformanceResults results;
+
+    for (long long i = 0; i < iterations; i++) {
+        nozzle_contour_init(&contour, state->nozzle.throat_radius, state->nozzle.exit_radius, points, MAX_POINTS);
+        if (validate_input_parameters(NULL, &state->nozzle, &state->conditions) != 0 ||
+            calculate_bell_nozzle_contour(&contour, 0.8, NULL) != 0 ||
+            calculate_contour_performance(&contour, &state->conditions, &results) != 0 ||
+            plot_nozzle_contour(NULL, &contour, state->plot_path) != 0 ||
+            write_contour_data(NULL, &contour, state->data_path) != 0) {
+            return -1;
+        }
+        bench_sink += results.thrust;
+    }
+    return 0;
+}
+
+// The CLI executable end to end, including process startup
+static int bench_cli(BenchState* state, long long iterations) {
+    posix_spawn_file_actions_t actions;
+    if (posix_spawn_file_actions_init(&actions) != 0) {
+        return -1;
+    }
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    int status = 0;
+    for (long long i = 0; i < iterations && status == 0; i++) {
+        pid_t pid;
+        int exit_status;
+        if (posix_spawn(&pid, state->cli_path, &actions, NULL, state->cli_argv, NULL) != 0 ||
+            waitpid(pid, &exit_status, 0) != pid || !WIFEXITED(exit_status) || WEXITSTATUS(exit_status) != 0) {
+            status = -1;
+        }
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
+    return status;
+}
+
+static const Benchmark benchmarks[] = {
+    { "geometry", bench_geometry, 0 },
+    { "exit_conditions", bench_exit_conditions, 0 },
+    { "performance", bench_performance, 0 },
+    { "batch", bench_performance_batch, 0 },
+    { "batch_f32", bench_performance_batch_f32, 0 },
+    { "sensitivities", bench_sensitivities, 0 },
+    { "surrogate_linear", bench_surrogate_linear, 0 },
+    { "surrogate_cubic", bench_surrogate_cubic, 0 },
+    { "chamber_equilibrium", bench_chamber_equilibrium, 0 },
+    { "propellant_table", bench_propellant_table, 0 },
+    { "thrust_profile", bench_thrust_profile, 0 },
+    { "flow_profile", bench_flow_profile, 0 },
+    { "thermal_profile", bench_thermal_profile, 0 },
+    { "monte_carlo", bench_monte_carlo, 0 },
+    { "pareto", bench_pareto, 0 },
+    { "mesh_stl", bench_mesh_stl, 0 },
+    { "write_geometry_data", bench_write_geometry, 0 },
+    { "pipeline", bench_pipeline, 0 },
+    { "cli", bench_cli, 1 },
+};
+#define NUM_BENCHMARKS ((int)(sizeof(benchmarks) / sizeof(benchmarks[0])))
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static int measure(const Benchmark* benchmark, BenchState* state, int samples, double sample_time,
+                   BenchStats* stats) {
+    // Calibrate (this also warms caches and the page cache for file output)
+    long long iterations = 1;
+    for (;;) {
+        double start = ngc_wall_time();
+        if (benchmark->run(state, iterations) != 0) {
+            return -1;
+        }
+        double elapsed = ngc_wall_time() - start;
+        if (elapsed >= sample_time || iterations >= (1LL << 40)) {
+            break;
+        }
+        // Aim 20% past the target so the next trial usually succeeds
+        double scale = elapsed > 0 ? 1.2 * sample_time / elapsed : 100.0;
+        iterations = (long long)ceil(iterations * (scale < 100.0 ? (scale > 2.0 ? scale : 2.0) : 100.0));
+    }
+
+    double* ns = malloc((size_t)samples * sizeof(double));
+    if (!ns) {
+        return -1;
+    }
+
+    double sum = 0.0;
+    for (int s = 0; s < samples; s++) {
+        double start = ngc_wall_time();
+        if (benchmark->run(state, iterations) != 0) {
+            free(ns);
+            return -1;
+        }
+        ns[s] = (ngc_wall_time() - start) * 1e9 / iterations;
+        sum += ns[s];
+    }
+
+    stats->mean = sum / samples;
+    double variance = 0.0;
+    for (int s = 0; s < samples; s++) {
+        variance += (ns[s] - stats->mean) * (ns[s] - stats->mean);
+    }
+    stats->stddev = samples > 1 ? sqrt(variance / (samples - 1)) : 0.0;
+
+    qsort(ns, (size_t)samples, sizeof(double), compare_doubles);
+    stats->min = ns[0];
+    stats->median = samples % 2 ? ns[samples / 2] : 0.5 * (ns[samples / 2 - 1] + ns[samples / 2]);
+    stats->iterations = iterations;
+    stats->samples = samples;
+    free(ns);
+    return 0;
+}
+
+static int load_baseline(const char* filename, BaselineEntry* entries, int capacity) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        printf("Error: Cannot open baseline %s\n", filename);
+        return -1;
+    }
+
+    char line[512];
+    int count = 0;
+    while (count < capacity && fgets(line, sizeof(line), file)) {
+        BaselineEntry* entry = &entries[count];
+        double mean;
+        if (sscanf(line, "%63[^,],%63[^,],%lf,%lf,%lf", entry->benchmark, entry->input,
+                   &entry->median, &mean, &entry->stddev) == 5) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static const BaselineEntry* find_baseline(const BaselineEntry* entries, int count,
+                                          const char* benchmark, const char* input) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].benchmark, benchmark) == 0 && strcmp(entries[i].input, input) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void print_bench_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("\nNGC benchmark suite\n\n");
+    printf("Options:\n");
+    printf("  -h, --help              Show this help message\n");
+    printf("  --samples N             Timed samples per benchmark (default: %d)\n", DEFAULT_SAMPLES);
+    printf("  --sample-time S         Minimum seconds per sample (default: %g)\n", DEFAULT_SAMPLE_TIME);
+    printf("  --filter TEXT           Only run benchmarks whose name contains TEXT\n");
+    printf("  --output FILE           Write results as CSV\n");
+    printf("  --baseline FILE         Compare against results from an earlier --output\n");
+    printf("  --threshold F           Relative slowdown reported as a regression (default: %g)\n",
+           DEFAULT_THRESHOLD);
+    printf("  --cli PATH              ngc executable for the cli benchmark (default: bin/ngc)\n");
+    printf("\nExit status is 1 when any benchmark regressed against the baseline.\n");
+}
+
+int main(int argc, char* argv[]) {
+    int samples = DEFAULT_SAMPLES;
+    double sample_time = DEFAULT_SAMPLE_TIME;
+    double threshold = DEFAULT_THRESHOLD;
+    const char* filter = NULL;
+    const char* output_filename = NULL;
+    const char* baseline_filename = NULL;
+    const char* cli_path = "bin/ngc";
+
+    static struct option long_options[] = {
+        {"help", no_argument, 0, 'h'},
+        {"samples", required_argument, 0, 's'},
+        {"sample-time", required_argument, 0, 't'},
+        {"filter", required_argument, 0, 'f'},
+        {"output", required_argument, 0, 'o'},
+        {"baseline", required_argument, 0, 'b'},
+        {"threshold", required_argument, 0, 'r'},
+        {"cli", required_argument, 0, 'c'},
+        {0, 0, 0, 0}
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (c) {
+            case 'h': print_bench_usage(argv[0]); return 0;
+            case 's': samples = atoi(optarg); break;
+            case 't': sample_time = atof(optarg); break;
+            case 'f': filter = optarg; break;
+            case 'o': output_filename = optarg; break;
+            case 'b': baseline_filename = optarg; break;
+            case 'r': threshold = atof(optarg); break;
+            case 'c': cli_path = optarg; break;
+            default:
+                print_bench_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (samples < 1 || !(sample_time > 0) || !(threshold >= 0)) {
+        printf("Error: --samples, --sample-time and --threshold must be positive\n");
+        return 1;
+    }
+
+    BaselineEntry baseline[MAX_BASELINE];
+    int baseline_count = 0;
+    if (baseline_filename) {
+        baseline_count = load_baseline(baseline_filename, baseline, MAX_BASELINE);
+        if (baseline_count < 0) {
+            return 1;
+        }
+    }
+
+    FILE* output = NULL;
+    if (output_filename) {
+        output = fopen(output_filename, "w");
+        if (!output) {
+            printf("Error: Cannot create %s\n", output_filename);
+            return 1;
+        }
+        fprintf(output, "benchmark,input,median_ns,mean_ns,stddev_ns,min_ns,ops_per_second,iterations,samples\n");
+    }
+
+    int cli_available = access(cli_path, X_OK) == 0;
+    const char* temp_dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+    printf("%-20s %-8s %14s %8s %14s %s\n", "benchmark", "input", "ns/op", "+/-", "ops/s",
+           baseline_count > 0 ? "vs baseline" : "");
+
+    int regressions = 0;
+    int failures = 0;
+    for (int b = 0; b < NUM_BENCHMARKS; b++) {
+        const Benchmark* benchmark = &benchmarks[b];
+        if (filter && !strstr(benchmark->name, filter)) {
+            continue;
+        }
+        if (benchmark->needs_cli && !cli_available) {
+            printf("%-20s skipped: %s is not executable\n", benchmark->name, cli_path);
+            continue;
+        }
+
+        for (int i = 0; i < NUM_INPUTS; i++) {
+            BenchState state;
+            memset(&state, 0, sizeof(state));
+            state.input = &bench_inputs[i];
+            state.nozzle.throat_radius = state.input->throat_radius;
+            state.nozzle.exit_radius = state.input->exit_radius;
+            state.conditions.chamber_pressure = 1.0e6;
+            state.conditions.ambient_pressure = 101325;
+            state.conditions.chamber_temperature = 3000;
+            state.conditions.molecular_weight = 0.020;
+            state.conditions.gamma = state.input->gamma;
+            state.conditions.gas_constant = 8.314462618;
+            calculate_bell_nozzle_geometry(&state.nozzle, 0.8);
+            snprintf(state.data_path, sizeof(state.data_path), "%s/ngc_bench_%ld.dat", temp_dir, (long)getpid());
+            snprintf(state.plot_path, sizeof(state.plot_path), "%s/ngc_bench_%ld.png", temp_dir, (long)getpid());
+            snprintf(state.mesh_path, sizeof(state.mesh_path), "%s/ngc_bench_%ld.stl", temp_dir, (long)getpid());
+
+            char throat[32], exit_radius[32], gamma[32];
+            snprintf(throat, sizeof(throat), "%g", state.input->throat_radius);
+            snprintf(exit_radius, sizeof(exit_radius), "%g", state.input->exit_radius);
+            snprintf(gamma, sizeof(gamma), "%g", state.input->gamma);
+            char* cli_argv[] = { (char*)cli_path, "-t", throat, "-e", exit_radius, "-g", gamma,
+                                 "-o", state.plot_path, "-d", state.data_path, NULL };
+            state.cli_path = cli_path;
+            state.cli_argv = cli_argv;
+
+            BenchStats stats;
+            int status = measure(benchmark, &state, samples, sample_time, &stats);
+            unlink(state.data_path);
+            unlink(state.plot_path);
+            unlink(state.mesh_path);
+            if (status != 0) {
+                printf("%-20s %-8s failed\n", benchmark->name, state.input->name);
+                failures++;
+                continue;
+            }
+
+            char comparison[64] = "";
+            const BaselineEntry* base = find_baseline(baseline, baseline_count, benchmark->name, state.input->name);
+            if (base && base->median > 0) {
+                double change = stats.median / base->median - 1.0;
+                // A slowdown must clear the threshold and both runs' noise
+                double noise = 2.0 * (stats.stddev + base->stddev);
+                int regressed = change > threshold && stats.median - base->median > noise;
+                regressions += regressed;
+                snprintf(comparison, sizeof(comparison), "%+6.1f%%%s", 100.0 * change,
+                         regressed ? "  REGRESSION" : "");
+            } else if (baseline_count > 0) {
+                snprintf(comparison, sizeof(comparison), "new");
+            }
+
+            printf("%-20s %-8s %14.1f %7.1f%% %14.0f %s\n", benchmark->name, state.input->name, stats.median,
+                   stats.mean > 0 ? 100.0 * stats.stddev / stats.mean : 0.0, 1e9 / stats.median, comparison);
+            fflush(stdout);
+
+            if (output) {
+                fprintf(output, "%s,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%lld,%d\n", benchmark->name, state.input->name,
+                        stats.median, stats.mean, stats.stddev, stats.min, 1e9 / stats.median,
+                        stats.iterations, stats.samples);
+            }
+        }
+    }
+
+    if (output) {
+        fclose(output);
+        printf("\nResults written to %s\n", output_filename);
+    }
+    if (baseline_count > 0) {
+        printf("%d regression%s against %s (threshold %.0f%%)\n", regressions, regressions == 1 ? "" : "s",
+               baseline_filename, 100.0 * threshold);
+    }
+    return regressions > 0 || failures > 0 ? 1 : 0;
+}
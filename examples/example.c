@@ -1,7 +1,18 @@
 #include "../include/ngc.h"
 
+// Prints the library's informational messages, such as files written
+static void print_diagnostic(void* user_data, const char* message) {
+    (void)user_data;
+    printf("  %s\n", message);
+}
+
 // Example program demonstrating how to use the NGC library programmatically
 int main() {
+    // Errors are recorded in the context; library functions never print
+    NgcContext context;
+    ngc_context_init(&context);
+    context.diagnostic = print_diagnostic;
+
     // Initialize data structures
     NozzleGeometry nozzle = {0};
     FlowConditions conditions = {0};
@@ -17,13 +28,13 @@ int main() {
     conditions.chamber_temperature = 3600;   // 3600 K
     conditions.molecular_weight = 0.022;     // 22 g/mol
     conditions.gamma = 1.25;                 // Typical for LOX/RP-1
-    conditions.gas_constant = 8314.5;        // J/(kmol·K)
+    conditions.gas_constant = 8.314462618;   // J/(mol·K)
 
     printf("=== NGC LIBRARY EXAMPLE ===\n\n");
 
     // Validate parameters
-    if (validate_input_parameters(&nozzle, &conditions) != 0) {
-        printf("Error: Invalid input parameters\n");
+    if (validate_input_parameters(&context, &nozzle, &conditions) != 0) {
+        printf("Error: %s\n", ngc_context_error(&context));
         return 1;
     }
 
@@ -48,18 +59,17 @@ int main() {
     }
 
     // Print results
-    print_performance_results(&results);
-
-    // Generate geometry data file
-    write_geometry_data(&nozzle, "example_nozzle_geometry.dat");
+    print_performance_results(stdout, &results);
 
-    // Generate plot
-    plot_nozzle_geometry(&nozzle, "example_nozzle_plot.png");
+    // Generate geometry data file and plot
+    printf("\nOutput files:\n");
+    if (write_geometry_data(&context, &nozzle, "example_nozzle_geometry.dat") != 0 ||
+        plot_nozzle_geometry(&context, &nozzle, "example_nozzle_plot.png") != 0) {
+        printf("Error: %s\n", ngc_context_error(&context));
+        return 1;
+    }
 
-    printf("Example completed! Check the generated files:\n");
-    printf("  - example_nozzle_geometry.dat\n");
-    printf("  - example_nozzle_plot.png (if gnuplot is available)\n");
-    printf("  - nozzle_upper.dat and nozzle_lower.dat\n");
+    printf("\nExample completed!\n");
 
     return 0;
 }
\ No newline at end of file
@@ -4,18 +4,39 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 
 // Constants
 #define PI 3.14159265358979323846
 #define MAX_POINTS 1000
 #define MAX_FILENAME 256
 
+// Version of the performance model. Bump it whenever a change to the
+// evaluation alters the results for the same design; stored caches written
+// under another version are discarded.
+#define NGC_MODEL_VERSION 1
+
+// Binary data files
+#define NGC_DATA_MAGIC "NGCDATA"
+#define NGC_DATA_VERSION 2
+#define NGC_DATA_HEADER_SIZE 640
+#define NGC_DATA_BYTE_ORDER 0x01020304u
+
+// Library messages
+#define NGC_MESSAGE_SIZE 256
+
 // Data structures
 typedef struct {
     double x;
     double y;
 } Point;
 
+// Single-precision contour point: half the storage, positions to about 1e-7 relative
+typedef struct {
+    float x;
+    float y;
+} PointF;
+
 typedef struct {
     double throat_radius;        // Throat radius (m)
     double exit_radius;          // Exit radius (m)
@@ -27,6 +48,42 @@ typedef struct {
     Point geometry[MAX_POINTS];  // Nozzle geometry points
 } NozzleGeometry;
 
+// Contour over caller- or arena-owned point storage. Leading fields mirror
+// NozzleGeometry; a capacity of 0 computes only the scalar parameters.
+typedef struct {
+    double throat_radius;        // Throat radius (m)
+    double exit_radius;          // Exit radius (m)
+    double throat_x;             // Throat x-position (m)
+    double exit_x;               // Exit x-position (m)
+    double expansion_ratio;      // Area expansion ratio
+    double bell_angle;           // Bell angle (radians)
+    int num_points;              // Number of points generated
+    int capacity;                // Size of the points buffer
+    Point* points;               // Contour points (not owned)
+} NozzleContour;
+
+typedef enum {
+    CONTOUR_UNIFORM = 0,         // Equal axial spacing
+    CONTOUR_ADAPTIVE             // Spacing driven by contour curvature
+} ContourSpacing;
+
+typedef struct {
+    ContourSpacing spacing;
+    int num_points;              // Uniform: points to generate (0 = capacity)
+    double tolerance;            // Adaptive: maximum radial interpolation error (m); fails if capacity is too small
+} ContourOptions;
+
+// Radius r(x) of a contour; stores r''(x) when second_derivative is non-NULL
+typedef double (*ContourRadiusFn)(const void* context, double x, double* second_derivative);
+
+// Bump allocator for contour buffers; allocations are 64-byte aligned
+typedef struct {
+    unsigned char* base;
+    size_t size;
+    size_t used;
+    int owns_memory;
+} NgcArena;
+
 typedef struct {
     double chamber_pressure;     // Chamber pressure (Pa)
     double ambient_pressure;     // Ambient pressure (Pa)
@@ -45,28 +102,921 @@ typedef struct {
     double mass_flow_rate;       // Mass flow rate (kg/s)
     double characteristic_velocity; // Characteristic velocity (m/s)
     double thrust_coefficient;   // Thrust coefficient
+    double exit_mach;            // Exit Mach number
 } PerformanceResults;
 
+// Per-gamma constants for the inverse area-Mach relation
+typedef struct {
+    double gamma;                // Specific heat ratio
+    double half_gm1;             // (gamma - 1) / 2
+    double exponent;             // (gamma + 1) / (2 (gamma - 1))
+    double log_critical;         // ln(2 / (gamma + 1))
+    double sonic_scale;          // (gamma + 1) / 2
+    double tolerance;            // Relative Mach tolerance (default 1e-12)
+    int max_iterations;          // Newton iteration limit (default 50)
+} AreaMachSolver;
+
+// Receives informational messages (files written); errors go to NgcContext.error
+typedef void (*NgcDiagnosticFn)(void* user_data, const char* message);
+
+// Per-caller message state. Library functions never print: functions that
+// can report a reason for failure take a context, record the message in it
+// and return -1. Give each thread its own context; NULL discards messages.
+typedef struct {
+    char error[NGC_MESSAGE_SIZE];    // Last error message (empty if none)
+    NgcDiagnosticFn diagnostic;      // Optional sink for informational messages
+    void* user_data;                 // Passed to diagnostic
+} NgcContext;
+
+// Profiled stages; times are inclusive (performance contains throat and exit_solve)
+typedef enum {
+    NGC_STAGE_GEOMETRY = 0,      // Contour generation (bell or moc)
+    NGC_STAGE_THROAT,            // Throat conditions
+    NGC_STAGE_EXIT_SOLVE,        // Exit conditions (area-Mach solve)
+    NGC_STAGE_PERFORMANCE,       // Performance evaluation
+    NGC_STAGE_FLOW,              // Flow profile along the contour
+    NGC_STAGE_THERMAL,           // Wall heat transfer along the contour
+    NGC_STAGE_PLOT,              // Plot rendering
+    NGC_STAGE_IO,                // File output
+    NGC_NUM_STAGES
+} NgcProfileStage;
+
+typedef struct {
+    long long calls;
+    long long timed_calls;       // Calls that were timed
+    double timed_seconds;        // Time spent in the timed calls
+} NgcStageProfile;
+
+// Stage timers and solver counters for the threads it is attached to
+typedef struct {
+    NgcStageProfile stages[NGC_NUM_STAGES];
+    long long solver_calls;      // Area-Mach solves
+    long long solver_iterations; // Newton iterations over all solves
+    long long solver_failures;   // Solves that did not converge
+    unsigned int sample_mask;    // One call in (sample_mask + 1) per stage is timed
+    unsigned int sample_phase[NGC_NUM_STAGES];  // Offsets the timed calls of each stage
+    double clock_overhead;       // Cost of one clock read, taken off every timed call
+} NgcProfile;
+
+// Compact description of one design case (no contour storage)
+typedef struct {
+    double throat_radius;        // Throat radius (m)
+    double exit_radius;          // Exit radius (m)
+    double length_fraction;      // Bell length fraction
+    FlowConditions conditions;   // Chamber and ambient state
+} NozzleDesign;
+
+// Memoized design results, shared between threads (see ngc_cache_create)
+typedef struct NgcCache NgcCache;
+
+typedef struct {
+    long long lookups;
+    long long hits;
+    long long insertions;        // Results added (loaded entries excluded)
+    long long evictions;         // Least recently used entries dropped since loading
+    long long entries;           // Entries held now
+    long long capacity;          // Most entries held, exactly the requested size
+    long long loaded;            // Store entries held once loading ended
+    long long load_dropped;      // Store entries that did not fit
+    double hit_rate;             // hits / lookups
+    double mean_lookup_seconds;  // Estimated from a sample of the lookups
+} NgcCacheStats;
+
+// Parameters that can be varied in a sweep
+typedef enum {
+    SWEEP_THROAT_RADIUS = 0,
+    SWEEP_EXIT_RADIUS,
+    SWEEP_CHAMBER_PRESSURE,
+    SWEEP_AMBIENT_PRESSURE,
+    SWEEP_CHAMBER_TEMPERATURE,
+    SWEEP_MOLECULAR_WEIGHT,
+    SWEEP_GAMMA,
+    SWEEP_LENGTH_FRACTION,
+    SWEEP_NUM_PARAMETERS
+} SweepParameter;
+
+typedef struct {
+    double start;                // First value
+    double stop;                 // Last value (inclusive)
+    int count;                   // Number of values (0 = use base design value)
+} SweepRange;
+
+typedef struct {
+    NozzleDesign base;                        // Values for parameters not swept
+    SweepRange ranges[SWEEP_NUM_PARAMETERS];  // Per-parameter ranges
+    int num_threads;                          // Worker threads (0 = all cores)
+    long long chunk_size;                     // Cases per work chunk (0 = automatic)
+    PerformanceResults* results;              // Optional per-case output, indexed by case
+    NgcProfile* profile;                      // Optional: receives the workers' merged profiles
+    NgcCache* cache;                          // Optional: memoizes case results
+} SweepConfig;
+
+typedef struct {
+    long long total_cases;       // Size of the Cartesian product
+    long long completed_cases;   // Cases evaluated successfully
+    long long failed_cases;      // Cases rejected by validation or the solver
+    int threads_used;            // Worker threads actually started
+    double elapsed_seconds;      // Wall-clock time of the sweep
+    double cases_per_second;     // Throughput
+    NozzleDesign best_design;    // Case with the highest specific impulse
+    PerformanceResults best_results;
+} SweepSummary;
+
+// Hot-gas wall state for the Bartz heat-transfer correlation; zero
+// transport properties are estimated from the flow conditions
+typedef struct {
+    double wall_temperature;         // Gas-side wall temperature (K)
+    double throat_curvature_radius;  // Wall radius of curvature at the throat (m, 0 = from the contour)
+    double prandtl_number;           // 0 = 4 gamma / (9 gamma - 5)
+    double viscosity;                // Chamber gas viscosity (Pa-s, 0 = Bartz's estimate)
+} ThermalConditions;
+
+// Quantity maximized by the design optimizer
+typedef enum {
+    OPTIMIZE_SPECIFIC_IMPULSE = 0,
+    OPTIMIZE_THRUST_COEFFICIENT
+} OptimizeObjective;
+
+// Envelope constraints; a value of 0 disables the constraint
+typedef struct {
+    double max_length;           // Maximum nozzle length exit_x (m)
+    double max_exit_diameter;    // Maximum exit diameter (m)
+    double min_pressure_ratio;   // Minimum exit/ambient pressure ratio
+    double max_pressure_ratio;   // Maximum exit/ambient pressure ratio
+    double max_heat_flux;        // Maximum throat wall heat flux (W/m^2, see OptimizeConfig.thermal)
+} DesignConstraints;
+
+typedef struct {
+    int enabled;                 // Parameter is optimized
+    double lower;                // Lower bound
+    double upper;                // Upper bound
+} DesignBound;
+
+typedef struct {
+    NozzleDesign base;                        // Start point and values of fixed parameters
+    DesignBound bounds[SWEEP_NUM_PARAMETERS]; // Optimized parameters
+    OptimizeObjective objective;
+    DesignConstraints constraints;
+    ThermalConditions thermal;   // Wall state for constraints.max_heat_flux
+    int population;              // Candidates per generation (0 = automatic)
+    int max_evaluations;         // Evaluation budget (0 = 2000)
+    double tolerance;            // Step size, as a fraction of the bounds, at which to stop (0 = 1e-6)
+    int num_threads;             // Worker threads (0 = all cores)
+    unsigned long long seed;     // Random seed (0 = fixed default)
+    NgcCache* cache;             // Optional: memoizes candidate results
+} OptimizeConfig;
+
+typedef struct {
+    NozzleDesign best_design;    // Best design found (feasible if any was)
+    PerformanceResults best_results;
+    double best_length;          // Nozzle length of the best design (m)
+    double best_objective;       // Objective value of the best design
+    int feasible;                // 1 if the best design meets every constraint
+    int converged;               // 1 if the step size tolerance was reached
+    int evaluations;             // Designs evaluated
+    int generations;             // Populations evaluated
+    int threads_used;            // Worker threads actually started (last generation)
+    double elapsed_seconds;      // Wall-clock time
+} OptimizeSummary;
+
+// Objectives of a Pareto exploration; each is maximized or minimized as noted
+typedef enum {
+    PARETO_SPECIFIC_IMPULSE = 0, // Maximized
+    PARETO_THRUST_COEFFICIENT,   // Maximized
+    PARETO_THRUST,               // Maximized
+    PARETO_LENGTH,               // Nozzle length exit_x, minimized
+    PARETO_EXIT_AREA,            // Minimized
+    PARETO_WALL_AREA,            // Wetted wall area from throat to exit, minimized
+    PARETO_NUM_OBJECTIVES
+} ParetoObjective;
+
+// One non-dominated design; also the record layout of NGC_DATA_PARETO files
+typedef struct {
+    double parameters[SWEEP_NUM_PARAMETERS];  // Design, indexed by SweepParameter
+    double specific_impulse;     // (s)
+    double thrust;               // (N)
+    double thrust_coefficient;
+    double length;               // Nozzle length exit_x (m)
+    double exit_area;            // (m^2)
+    double wall_area;            // (m^2)
+} ParetoPoint;
+
+#define PARETO_NUM_FIELDS 14
+
+typedef struct {
+    NozzleDesign base;                        // Values of the fixed parameters
+    DesignBound bounds[SWEEP_NUM_PARAMETERS]; // Explored parameters
+    int objectives[PARETO_NUM_OBJECTIVES];    // 1 for the objectives traded against each other
+    long long max_evaluations;   // Designs evaluated (0 = 100000)
+    double initial_fraction;     // Share of the budget sampled over the whole box first (0 = 0.25)
+    int batch_size;              // Designs evaluated in parallel per round (0 = 4096)
+    int num_threads;             // Worker threads (0 = all cores)
+    unsigned long long seed;     // Random seed (0 = fixed default)
+} ParetoConfig;
+
+// Non-dominated set returned by run_pareto_exploration (see pareto_front_free)
+typedef struct {
+    ParetoPoint* points;         // Sorted by the first enabled objective, best first
+    long long count;
+} ParetoFront;
+
+typedef struct {
+    long long evaluations;       // Designs evaluated
+    long long failed;            // Designs rejected by validation or the solver
+    long long accepted;          // Designs that entered the archive when evaluated
+    long long removed;           // Archive members later dominated
+    long long peak_size;         // Largest archive size
+    int rounds;                  // Parallel batches
+    int threads_used;            // Worker threads actually started (last batch)
+    double elapsed_seconds;      // Wall-clock time
+    double evaluations_per_second;
+} ParetoSummary;
+
+// Input distributions for Monte Carlo uncertainty analysis
+typedef enum {
+    UNCERTAINTY_FIXED = 0,       // Base design value
+    UNCERTAINTY_NORMAL,          // a = mean, b = standard deviation
+    UNCERTAINTY_UNIFORM          // a = lower bound, b = upper bound
+} UncertaintyDistribution;
+
+typedef struct {
+    UncertaintyDistribution distribution;
+    double a;
+    double b;
+} UncertainInput;
+
+// Outputs whose distributions are estimated
+typedef enum {
+    UNCERTAINTY_THRUST = 0,
+    UNCERTAINTY_SPECIFIC_IMPULSE,
+    UNCERTAINTY_THRUST_COEFFICIENT,
+    UNCERTAINTY_MASS_FLOW_RATE,
+    UNCERTAINTY_NUM_OUTPUTS
+} UncertaintyOutput;
+
+// Quantiles reported for each output (see uncertainty_quantile_level)
+#define UNCERTAINTY_NUM_QUANTILES 7
+
+typedef struct {
+    NozzleDesign base;                            // Values for inputs without a distribution
+    UncertainInput inputs[SWEEP_NUM_PARAMETERS];  // Per-parameter distributions
+    long long samples;           // Designs drawn
+    unsigned long long seed;     // Random seed (0 = fixed default)
+    int num_threads;             // Worker threads (0 = all cores)
+    int single_precision;        // Evaluate with calculate_performance_batch_f32, except
+                                 // below PRECISION_F32_GAMMA_MIN (see check_performance_f32)
+} UncertaintyConfig;
+
+typedef struct {
+    double mean;
+    double std_dev;              // Sample standard deviation
+    double min;
+    double max;
+    double quantiles[UNCERTAINTY_NUM_QUANTILES];  // Within 0.05% relative
+} UncertaintyStatistics;
+
+typedef struct {
+    long long samples;           // Designs drawn
+    long long completed;         // Designs evaluated
+    long long rejected;          // Designs outside the valid inputs, or without a finite result
+    long long double_fallback;   // Single-precision designs evaluated in double for their gamma
+    int threads_used;            // Worker threads actually started
+    double elapsed_seconds;      // Wall-clock time
+    double samples_per_second;   // Throughput
+    UncertaintyStatistics outputs[UNCERTAINTY_NUM_OUTPUTS];
+} UncertaintySummary;
+
+// Outputs differentiated by calculate_performance_sensitivities
+typedef enum {
+    SENSITIVITY_THRUST = 0,
+    SENSITIVITY_SPECIFIC_IMPULSE,
+    SENSITIVITY_THRUST_COEFFICIENT,
+    SENSITIVITY_EXIT_PRESSURE,
+    SENSITIVITY_NUM_OUTPUTS
+} SensitivityOutput;
+
+typedef struct {
+    PerformanceResults results;  // Values at the design
+    // d output / d input, indexed by SensitivityOutput and SweepParameter (SI units)
+    double jacobian[SENSITIVITY_NUM_OUTPUTS][SWEEP_NUM_PARAMETERS];
+} PerformanceSensitivities;
+
+// Request server settings (see run_server)
+typedef struct {
+    NozzleDesign base;           // Values for fields a request leaves out
+    const char* socket_path;     // Unix domain socket to listen on (NULL = standard input/output)
+    int num_threads;             // Worker threads for large batches (0 = all cores)
+    int max_batch;               // Requests evaluated together (0 = 4096)
+    const volatile int* stop;    // Optional: the server returns once this becomes nonzero
+    NgcCache* cache;             // Optional: memoizes request results
+} ServerConfig;
+
+typedef struct {
+    long long requests;          // Requests answered
+    long long failed_requests;   // Malformed requests and rejected designs
+    long long batches;           // Evaluation rounds
+    int largest_batch;           // Most requests evaluated together
+    int connections;             // Clients accepted (socket mode)
+} ServerSummary;
+
+// Case-file batch settings (see run_case_file)
+typedef struct {
+    NozzleDesign base;           // Values for fields a row leaves out
+    const char* input_path;      // CSV or JSON Lines case file ("-" = standard input)
+    const char* output_path;     // Results in the input's format (NULL or "-" = standard output)
+    int num_threads;             // Evaluation threads (0 = all cores)
+    NgcCache* cache;             // Optional: memoizes row results
+} CaseFileConfig;
+
+typedef struct {
+    long long rows;              // Cases read
+    long long failed_rows;       // Malformed rows and rejected designs
+    int csv;                     // 1 for a CSV file, 0 for JSON Lines
+    int threads_used;            // Evaluation threads started
+    double elapsed_seconds;      // Wall-clock time, reading and writing included
+    double rows_per_second;      // Throughput
+} CaseFileSummary;
+
+// Structure-of-arrays input for batch performance evaluation
+typedef struct {
+    const double* throat_radius;
+    const double* exit_radius;
+    const double* chamber_pressure;
+    const double* ambient_pressure;
+    const double* chamber_temperature;
+    const double* molecular_weight;
+    const double* gamma;
+    const double* gas_constant;
+} PerformanceBatchInput;
+
+// Structure-of-arrays output; each array mirrors a PerformanceResults field
+typedef struct {
+    double* thrust;
+    double* specific_impulse;
+    double* exit_velocity;
+    double* exit_pressure;
+    double* exit_temperature;
+    double* mass_flow_rate;
+    double* characteristic_velocity;
+    double* thrust_coefficient;
+    double* exit_mach;
+} PerformanceBatchOutput;
+
+// Single-precision batch input and output (see calculate_performance_batch_f32)
+typedef struct {
+    const float* throat_radius;
+    const float* exit_radius;
+    const float* chamber_pressure;
+    const float* ambient_pressure;
+    const float* chamber_temperature;
+    const float* molecular_weight;
+    const float* gamma;
+    const float* gas_constant;
+} PerformanceBatchInputF;
+
+typedef struct {
+    float* thrust;
+    float* specific_impulse;
+    float* exit_velocity;
+    float* exit_pressure;
+    float* exit_temperature;
+    float* mass_flow_rate;
+    float* characteristic_velocity;
+    float* thrust_coefficient;
+    float* exit_mach;
+} PerformanceBatchOutputF;
+
+// Ambient-independent performance of one nozzle and chamber state, so thrust
+// can be evaluated over many ambient pressures (see thrust_profile_init)
+typedef struct {
+    double momentum_thrust;      // Mass flow rate times exit velocity (N)
+    double exit_pressure;        // Exit pressure (Pa)
+    double exit_area;            // Exit area (m^2)
+    double weight_flow_rate;     // Mass flow rate times standard gravity (N/s)
+    double throat_force;         // Chamber pressure times throat area (N)
+    double separation_pressure;  // Ambient pressure above which the flow separates (Pa)
+} ThrustProfile;
+
+// Structure-of-arrays output of the ambient sweeps; any array may be NULL
+typedef struct {
+    double* thrust;
+    double* specific_impulse;
+    double* thrust_coefficient;
+    unsigned char* separated;    // 1 where the exit flow is predicted to separate
+} AmbientPerformanceOutput;
+
+// Structure-of-arrays flow state at each contour station; any array may be NULL
+typedef struct {
+    double* area_ratio;          // Local area over throat area
+    double* mach;
+    double* pressure;            // Static pressure (Pa)
+    double* temperature;         // Static temperature (K)
+    double* density;             // (kg/m^3)
+    double* velocity;            // (m/s)
+} FlowProfileOutput;
+
+// Structure-of-arrays wall heat transfer at each contour station; any array may be NULL
+typedef struct {
+    double* heat_transfer_coefficient;   // Gas-side coefficient (W/m^2-K)
+    double* adiabatic_wall_temperature;  // (K)
+    double* heat_flux;                   // Into the wall (W/m^2)
+} ThermalProfileOutput;
+
+typedef struct {
+    double peak_heat_flux;           // (W/m^2)
+    double peak_x;                   // Station of the peak (m)
+    double heat_rate;                // Heat flux integrated over the wall (W)
+    double throat_curvature_radius;  // Value used (m)
+} ThermalSummary;
+
+// One nozzle of a thermal batch (see calculate_thermal_batch)
+typedef struct {
+    const NozzleContour* contour;
+    const FlowConditions* conditions;
+    const ThermalConditions* thermal;
+    ThermalProfileOutput output;     // Arrays of contour->num_points entries
+    ThermalSummary summary;          // Filled on success
+    int status;                      // 0 or -1
+} ThermalCase;
+
+// Instruction set used by the batch kernels
+typedef enum {
+    BATCH_ISA_AUTO = 0,          // Best available on this CPU
+    BATCH_ISA_SCALAR,
+    BATCH_ISA_AVX2,
+    BATCH_ISA_AVX512
+} BatchIsa;
+
+// Outputs compared by check_performance_f32
+typedef enum {
+    PRECISION_THRUST = 0,
+    PRECISION_SPECIFIC_IMPULSE,
+    PRECISION_THRUST_COEFFICIENT,
+    PRECISION_NUM_OUTPUTS
+} PrecisionOutput;
+
+// Expansion-ratio bands of a precision check, spaced logarithmically
+#define PRECISION_NUM_BANDS 4
+
+// Below this gamma the rounding of gamma - 1 to float costs the float
+// kernels more than 1e-5 of relative error (about 2e-7 / (gamma - 1)), so
+// single-precision runs evaluate those designs in double
+#define PRECISION_F32_GAMMA_MIN 1.05
+
+// Ranges of a precision check; zero fields take the defaults in parentheses.
+// Ambient pressure is drawn up to ambient_ratio times the exit pressure, so
+// every case has attached flow with the default of 2.5 (Summerfield), and
+// never above the throat pressure, so every case is choked.
+typedef struct {
+    long long samples;           // Random cases (0 = 1000000)
+    double expansion_min;        // Expansion ratio, log-uniform (1.01 .. 10000)
+    double expansion_max;
+    double gamma_min;            // Specific heat ratio, uniform (1 .. 1.67, above the minimum)
+    double gamma_max;
+    double pressure_min;         // Chamber pressure, log-uniform (1e5 .. 3e7 Pa)
+    double pressure_max;
+    double temperature_min;      // Chamber temperature, uniform (500 .. 4000 K)
+    double temperature_max;
+    double ambient_ratio;        // Largest ambient to exit pressure ratio (2.5)
+    BatchIsa isa;                // Kernels of both paths
+    int num_threads;             // Worker threads (0 = all cores)
+    unsigned long long seed;     // Random seed (0 = fixed default)
+} PrecisionConfig;
+
+typedef struct {
+    double expansion_min;        // Band edges
+    double expansion_max;
+    double gamma_min;
+    double gamma_max;
+    long long samples;
+    double max_error[PRECISION_NUM_OUTPUTS];   // Largest relative error against the double path
+    double mean_error[PRECISION_NUM_OUTPUTS];
+} PrecisionBand;
+
+// total, bands and worst cover the designs at or above PRECISION_F32_GAMMA_MIN;
+// low_gamma holds the errors the float path would have below it
+typedef struct {
+    PrecisionBand total;
+    PrecisionBand bands[PRECISION_NUM_BANDS];
+    PrecisionBand low_gamma;
+    NozzleDesign worst[PRECISION_NUM_OUTPUTS]; // Case with the largest error of each output
+    long long nonfinite;         // Single-precision cases that overflowed, counted as errors of 1
+    double contour_error;        // Largest PointF rounding of bell contours, relative to the throat radius
+    double f32_ns_per_case;      // Single-threaded kernel time of each path
+    double f64_ns_per_case;
+    int threads_used;
+    double elapsed_seconds;
+} PrecisionReport;
+
+// Record layout of a binary data file
+typedef enum {
+    NGC_DATA_GEOMETRY = 1,       // Records are contour points (x, y)
+    NGC_DATA_SWEEP = 2,          // Records are PerformanceResults, one per sweep case
+    NGC_DATA_SURROGATE = 3,      // Records are surrogate table nodes (see build_cf_surrogate)
+    NGC_DATA_PARETO = 4          // Records are ParetoPoint, one per non-dominated design
+} NgcDataKind;
+
+// Fixed 640-byte header; records follow as record_count rows of
+// record_fields doubles, in native byte order, starting at header_size
+typedef struct {
+    char magic[8];               // NGC_DATA_MAGIC
+    uint32_t version;            // NGC_DATA_VERSION
+    uint32_t byte_order;         // NGC_DATA_BYTE_ORDER as written by the producer
+    uint32_t kind;               // NgcDataKind
+    uint32_t record_fields;      // Doubles per record
+    uint64_t record_count;       // Points or sweep cases
+    uint64_t header_size;        // Offset of the first record (bytes)
+    double throat_radius;        // Geometry parameters (geometry files)
+    double exit_radius;
+    double throat_x;
+    double exit_x;
+    double expansion_ratio;
+    double bell_angle;
+    double base[SWEEP_NUM_PARAMETERS];         // Base design, indexed by SweepParameter (sweep files)
+    double gas_constant;
+    double range_start[SWEEP_NUM_PARAMETERS];  // Sweep ranges, indexed by SweepParameter
+    double range_stop[SWEEP_NUM_PARAMETERS];
+    int64_t range_count[SWEEP_NUM_PARAMETERS];
+    char fields[288];            // Comma-separated record field names
+} NgcDataHeader;
+
+// Read-only memory mapping of a binary data file
+typedef struct {
+    const NgcDataHeader* header;
+    const double* records;       // Points directly into the mapping
+    void* mapping;
+    size_t mapping_size;
+} NgcDataFile;
+
+// Quantities tabulated by a thrust-coefficient surrogate
+typedef enum {
+    SURROGATE_VACUUM_CF = 0,     // Thrust coefficient without ambient pressure
+    SURROGATE_EXIT_MACH,
+    SURROGATE_PRESSURE_RATIO,    // pe / pc
+    SURROGATE_TEMPERATURE_RATIO, // Te / Tc
+    SURROGATE_NUM_FIELDS
+} SurrogateField;
+
+typedef enum {
+    SURROGATE_LINEAR = 0,        // Bilinear
+    SURROGATE_CUBIC,             // Bicubic Catmull-Rom
+    SURROGATE_NUM_METHODS
+} SurrogateInterpolation;
+
+// Surrogate table grid (see build_cf_surrogate)
+typedef struct {
+    double expansion_min;        // Expansion ratio range, spaced logarithmically (> 1)
+    double expansion_max;
+    int expansion_count;         // Grid nodes (0 = 512)
+    double gamma_min;            // Specific heat ratio range, spaced evenly (> 1)
+    double gamma_max;
+    int gamma_count;             // Grid nodes (0 = 128)
+    int num_threads;             // Threads building the table (0 = all cores)
+} SurrogateConfig;
+
+typedef struct {
+    double thrust_coefficient;
+    double exit_mach;
+    double pressure_ratio;       // pe / pc
+    double temperature_ratio;    // Te / Tc
+} SurrogateResult;
+
+// Surrogate table mapped from disk (see cf_surrogate_open)
+typedef struct {
+    const double* nodes;         // Node records in the mapping, with a border of extrapolated nodes
+    int expansion_count;         // Nodes inside the range
+    int gamma_count;
+    int row_stride;              // Doubles per row of gamma nodes
+    double expansion_min;
+    double expansion_max;
+    double gamma_min;
+    double gamma_max;
+    double log_expansion_min;
+    double inverse_log_step;     // 1 / ln-spacing of the expansion ratio nodes
+    double inverse_gamma_step;
+    // Largest relative error against the exact solver, measured between the nodes when the table was built
+    double max_error[SURROGATE_NUM_METHODS][SURROGATE_NUM_FIELDS];
+    NgcDataFile file;
+} CfSurrogate;
+
+// Propellant combinations of the thermochemistry module
+typedef enum {
+    PROPELLANT_LOX_LH2 = 0,      // Liquid oxygen / liquid hydrogen
+    PROPELLANT_LOX_CH4,          // Liquid oxygen / liquid methane
+    PROPELLANT_LOX_RP1,          // Liquid oxygen / RP-1 kerosene
+    PROPELLANT_NUM
+} Propellant;
+
+// Exhaust composition assumed when choosing the chamber gamma
+typedef enum {
+    COMPOSITION_SHIFTING = 0,    // Equilibrium gamma: composition follows the expansion
+    COMPOSITION_FROZEN           // Frozen gamma: composition fixed at the chamber
+} CompositionModel;
+
+// Combustion products tracked (H2, O2, H2O, OH, H, O, CO, CO2; see thermo_species_name)
+#define THERMO_NUM_SPECIES 8
+#define CHAMBER_NUM_PROPERTIES 4
+
+typedef struct {
+    double chamber_temperature;  // Adiabatic flame temperature (K)
+    double molecular_weight;     // (kg/mol)
+    double gamma_frozen;         // Specific heat ratio at fixed composition
+    double gamma_shifting;       // Specific heat ratio at equilibrium
+} ChamberProperties;
+
+// Chamber equilibrium (see calculate_chamber_state)
+typedef struct {
+    ChamberProperties properties;
+    double mole_fractions[THERMO_NUM_SPECIES];
+    int iterations;              // Newton iterations of the equilibrium solve
+} ChamberState;
+
+// Propellant property table grid (see build_propellant_table)
+typedef struct {
+    Propellant propellant;
+    double ratio_min;            // Oxidizer-to-fuel mass ratio range, spaced evenly
+    double ratio_max;
+    int ratio_count;             // Grid nodes (>= 2)
+    double pressure_min;         // Chamber pressure range (Pa), spaced logarithmically
+    double pressure_max;
+    int pressure_count;          // Grid nodes (>= 2)
+    int num_threads;             // Threads building the table (0 = all cores)
+} PropellantTableConfig;
+
+// Chamber properties over mixture ratio and chamber pressure, interpolated bilinearly
+typedef struct {
+    Propellant propellant;
+    ChamberProperties* nodes;    // ratio_count rows of pressure_count nodes
+    int ratio_count;
+    int pressure_count;
+    double ratio_min;
+    double ratio_max;
+    double pressure_min;
+    double pressure_max;
+    double ratio_step;
+    double log_pressure_min;
+    double log_pressure_step;
+    // Largest relative error against the equilibrium solver, measured at the cell centres when built
+    ChamberProperties max_error;
+} PropellantTable;
+
+// Plot output formats
+typedef enum {
+    PLOT_FORMAT_PNG = 0,
+    PLOT_FORMAT_SVG
+} PlotFormat;
+
+typedef struct {
+    PlotFormat format;
+    int width;                   // Image width in pixels (0 = 800)
+    int height;                  // Image height in pixels (0 = 600)
+} PlotOptions;
+
+// Surface mesh formats
+typedef enum {
+    MESH_STL = 0,                // Binary STL
+    MESH_OBJ                     // Wavefront OBJ
+} MeshFormat;
+
+// Revolved-contour mesh settings (see write_nozzle_mesh)
+typedef struct {
+    MeshFormat format;
+    int segments;                // Divisions around the axis (0 = 128)
+    double wall_thickness;       // Wall thickness along the contour normal (m, 0 = inner surface only)
+    int num_threads;             // Threads generating the mesh (0 = all cores)
+} MeshOptions;
+
+// Method-of-characteristics contour variants
+typedef enum {
+    MOC_CONTOUR_IDEAL = 0,       // Full minimum-length contour, uniform parallel exit flow
+    MOC_CONTOUR_TRUNCATED        // Ideal contour of a stronger design cut at the exit radius
+} MocContourType;
+
+typedef struct {
+    MocContourType type;
+    int num_characteristics;     // C- lines in the throat-corner fan
+    int num_threads;             // Wavefront threads (0 = all cores)
+} MocOptions;
+
+typedef struct {
+    double initial_angle;        // Wall angle leaving the throat (radians)
+    double exit_angle;           // Wall angle at the exit (radians)
+    double exit_mach;            // Wall Mach number at the exit
+    int truncated;               // 1 if the contour was cut short for the length fraction
+    int threads_used;            // Wavefront threads actually used
+    double elapsed_seconds;      // Wall-clock time including the corner-angle search
+} MocSummary;
+
+// Worker callback for parallel_for: processes cases [begin, end)
+typedef void (*ParallelTask)(long long begin, long long end, int thread_id, void* context);
+
 // Function prototypes
 
+// Library context functions
+void ngc_context_init(NgcContext* context);
+const char* ngc_context_error(const NgcContext* context);
+
+// Profiling functions
+int ngc_profile_available(void);
+void ngc_profile_init(NgcProfile* profile, int sample_period);
+NgcProfile* ngc_profile_attach(NgcProfile* profile);
+void ngc_profile_merge(NgcProfile* total, const NgcProfile* part);
+const char* ngc_profile_stage_name(NgcProfileStage stage);
+double ngc_profile_stage_seconds(const NgcProfile* profile, NgcProfileStage stage);
+int ngc_profile_print(FILE* stream, const NgcProfile* profile);
+int ngc_profile_write_json(FILE* stream, const NgcProfile* profile);
+
 // Nozzle geometry functions
 int calculate_bell_nozzle_geometry(NozzleGeometry* nozzle, double length_fraction);
 int calculate_expansion_ratio(NozzleGeometry* nozzle);
 double calculate_nozzle_area(double radius);
+double calculate_contour_wall_area(const NozzleContour* contour);
+int calculate_bell_nozzle_contour(NozzleContour* contour, double length_fraction, const ContourOptions* options);
+int sample_nozzle_contour(NozzleContour* contour, double length, ContourRadiusFn radius,
+                          const void* context, const ContourOptions* options);
+int nozzle_contour_init(NozzleContour* contour, double throat_radius, double exit_radius,
+                        Point* buffer, int capacity);
+int nozzle_contour_alloc(NozzleContour* contour, NgcArena* arena, double throat_radius,
+                         double exit_radius, int capacity);
+int nozzle_contour_from_geometry(NozzleContour* contour, NozzleGeometry* nozzle);
+int nozzle_contour_to_geometry(const NozzleContour* contour, NozzleGeometry* nozzle);
+int nozzle_contour_to_float(const NozzleContour* contour, PointF* points);
+int nozzle_contour_from_float(NozzleContour* contour, const PointF* points, int count);
+
+// Method-of-characteristics contour functions
+int calculate_moc_nozzle_contour(NgcContext* context, NozzleContour* contour, const FlowConditions* conditions,
+                                 double length_fraction, const MocOptions* options,
+                                 const ContourOptions* sampling, MocSummary* summary);
+int calculate_moc_nozzle_geometry(NgcContext* context, NozzleGeometry* nozzle, const FlowConditions* conditions,
+                                  double length_fraction, const MocOptions* options);
+
+// Arena allocation functions
+int ngc_arena_init(NgcArena* arena, void* buffer, size_t size);
+void* ngc_arena_alloc(NgcArena* arena, size_t bytes);
+void ngc_arena_reset(NgcArena* arena);
+void ngc_arena_release(NgcArena* arena);
 
 // Performance calculation functions
 int calculate_performance(const NozzleGeometry* nozzle, const FlowConditions* conditions, PerformanceResults* results);
+int calculate_contour_performance(const NozzleContour* contour, const FlowConditions* conditions, PerformanceResults* results);
 double calculate_throat_conditions(const FlowConditions* conditions, double* throat_pressure, double* throat_temperature);
 double calculate_exit_conditions(const NozzleGeometry* nozzle, const FlowConditions* conditions, 
                                  double* exit_pressure, double* exit_temperature, double* exit_velocity);
+int area_mach_solver_init(AreaMachSolver* solver, double gamma);
+int solve_area_mach(const AreaMachSolver* solver, double area_ratio, int supersonic,
+                    double mach_guess, double* mach, int* iterations);
+int evaluate_nozzle_design(const NozzleDesign* design, NozzleContour* contour, PerformanceResults* results);
+int calculate_performance_sensitivities(const NozzleDesign* design, PerformanceSensitivities* sensitivities);
+const char* sensitivity_output_name(SensitivityOutput output);
+
+// Ambient sweep functions
+int thrust_profile_init(ThrustProfile* profile, const NozzleContour* contour, const FlowConditions* conditions);
+int thrust_profile_pressures(const ThrustProfile* profile, const double* ambient_pressures,
+                             AmbientPerformanceOutput* output, size_t count);
+int thrust_profile_altitudes(const ThrustProfile* profile, const double* altitudes,
+                             AmbientPerformanceOutput* output, size_t count);
+double standard_atmosphere_pressure(double altitude);
+
+// Flow profile functions
+int calculate_flow_profile(const NozzleContour* contour, const FlowConditions* conditions,
+                           FlowProfileOutput* output);
+int calculate_flow_profile_isa(const NozzleContour* contour, const FlowConditions* conditions,
+                               FlowProfileOutput* output, BatchIsa isa);
+
+// Thermal functions
+int calculate_thermal_profile(const NozzleContour* contour, const FlowConditions* conditions,
+                              const ThermalConditions* thermal, ThermalProfileOutput* output,
+                              ThermalSummary* summary);
+int calculate_thermal_profile_isa(const NozzleContour* contour, const FlowConditions* conditions,
+                                  const ThermalConditions* thermal, ThermalProfileOutput* output,
+                                  ThermalSummary* summary, BatchIsa isa);
+int calculate_thermal_batch(ThermalCase* cases, size_t count, int num_threads);
+int calculate_throat_heat_flux(const NozzleContour* contour, const FlowConditions* conditions,
+                               const ThermalConditions* thermal, double* heat_flux);
+
+// Batch performance functions
+int calculate_performance_batch(const PerformanceBatchInput* input, PerformanceBatchOutput* output, size_t count);
+int calculate_performance_batch_isa(const PerformanceBatchInput* input, PerformanceBatchOutput* output,
+                                    size_t count, BatchIsa isa);
+int calculate_performance_batch_f32(const PerformanceBatchInputF* input, PerformanceBatchOutputF* output,
+                                    size_t count);
+int calculate_performance_batch_f32_isa(const PerformanceBatchInputF* input, PerformanceBatchOutputF* output,
+                                        size_t count, BatchIsa isa);
+int check_performance_f32(const PrecisionConfig* config, PrecisionReport* report);
+const char* precision_output_name(PrecisionOutput output);
+BatchIsa batch_isa_available(void);
+const char* batch_isa_name(BatchIsa isa);
 
 // Plotting and output functions
-int plot_nozzle_geometry(const NozzleGeometry* nozzle, const char* filename);
-int write_geometry_data(const NozzleGeometry* nozzle, const char* filename);
-int print_performance_results(const PerformanceResults* results);
+int plot_nozzle_geometry(NgcContext* context, const NozzleGeometry* nozzle, const char* filename);
+int write_geometry_data(NgcContext* context, const NozzleGeometry* nozzle, const char* filename);
+int plot_nozzle_contour(NgcContext* context, const NozzleContour* contour, const char* filename);
+int render_nozzle_plot(const NozzleContour* contour, const PlotOptions* options,
+                       unsigned char** data, size_t* size);
+int write_nozzle_plot(NgcContext* context, const NozzleContour* contour, const PlotOptions* options,
+                      const char* filename);
+PlotFormat plot_format_from_filename(const char* filename);
+int write_contour_data(NgcContext* context, const NozzleContour* contour, const char* filename);
+int write_flow_profile_data(NgcContext* context, const NozzleContour* contour,
+                            const FlowProfileOutput* profile, const char* filename);
+int write_thermal_profile_data(NgcContext* context, const NozzleContour* contour,
+                               const ThermalProfileOutput* profile, const char* filename);
+int print_performance_results(FILE* stream, const PerformanceResults* results);
+
+// Mesh export functions
+int write_nozzle_mesh(NgcContext* context, const NozzleContour* contour, const MeshOptions* options,
+                      const char* filename);
+MeshFormat mesh_format_from_filename(const char* filename);
+
+// Result cache functions
+NgcCache* ngc_cache_create(NgcContext* context, long long max_entries, const char* path);
+int ngc_cache_save(NgcContext* context, NgcCache* cache);
+void ngc_cache_destroy(NgcCache* cache);
+int ngc_cache_lookup(NgcCache* cache, const NozzleDesign* design, PerformanceResults* results);
+void ngc_cache_insert(NgcCache* cache, const NozzleDesign* design, const PerformanceResults* results);
+void ngc_cache_stats(NgcCache* cache, NgcCacheStats* stats);
+int evaluate_nozzle_design_cached(NgcCache* cache, const NozzleDesign* design, NozzleContour* contour,
+                                  PerformanceResults* results);
+
+// Binary data file functions
+int write_contour_binary(NgcContext* context, const NozzleContour* contour, const char* filename);
+int write_sweep_binary(NgcContext* context, const SweepConfig* config, const char* filename);
+int ngc_data_open(NgcContext* context, NgcDataFile* file, const char* filename);
+void ngc_data_close(NgcDataFile* file);
+const Point* ngc_data_points(const NgcDataFile* file);
+const PerformanceResults* ngc_data_results(const NgcDataFile* file);
+const ParetoPoint* ngc_data_pareto(const NgcDataFile* file);
+int ngc_data_sweep_config(const NgcDataFile* file, SweepConfig* config);
+
+// Thrust-coefficient surrogate functions
+int build_cf_surrogate(NgcContext* context, const SurrogateConfig* config, const char* filename);
+int cf_surrogate_open(NgcContext* context, CfSurrogate* surrogate, const char* filename);
+void cf_surrogate_close(CfSurrogate* surrogate);
+int cf_surrogate_lookup(const CfSurrogate* surrogate, SurrogateInterpolation method, double expansion_ratio,
+                        double gamma, double chamber_to_ambient, SurrogateResult* result);
+const char* surrogate_field_name(SurrogateField field);
+
+// Propellant thermochemistry functions
+int calculate_chamber_state(NgcContext* context, Propellant propellant, double mixture_ratio,
+                            double chamber_pressure, ChamberState* state);
+int chamber_flow_conditions(const ChamberProperties* properties, CompositionModel model,
+                            FlowConditions* conditions);
+int build_propellant_table(NgcContext* context, const PropellantTableConfig* config, PropellantTable* table);
+void propellant_table_free(PropellantTable* table);
+int propellant_table_lookup(const PropellantTable* table, double mixture_ratio, double chamber_pressure,
+                            ChamberProperties* properties);
+int propellant_table_conditions(const PropellantTable* table, CompositionModel model, const double* mixture_ratio,
+                                const double* chamber_pressure, size_t count, double* chamber_temperature,
+                                double* molecular_weight, double* gamma);
+const char* propellant_name(Propellant propellant);
+int propellant_from_name(const char* name);
+double propellant_default_mixture_ratio(Propellant propellant);
+const char* thermo_species_name(int species);
+
+// Parameter sweep functions
+long long sweep_case_count(const SweepConfig* config);
+int sweep_case_design(const SweepConfig* config, long long index, NozzleDesign* design);
+int parse_sweep_range(SweepConfig* config, const char* spec);
+int run_parameter_sweep(const SweepConfig* config, SweepSummary* summary);
+const char* sweep_parameter_name(SweepParameter parameter);
+int sweep_parameter_from_name(const char* name);
+double* nozzle_design_parameter(NozzleDesign* design, SweepParameter parameter);
+
+// Design optimization functions
+int parse_design_bounds(DesignBound* bounds, const char* spec);
+int parse_optimize_bounds(OptimizeConfig* config, const char* spec);
+int run_design_optimization(NgcContext* context, const OptimizeConfig* config, OptimizeSummary* summary);
+
+// Pareto exploration functions
+int run_pareto_exploration(NgcContext* context, const ParetoConfig* config, ParetoFront* front,
+                           ParetoSummary* summary);
+void pareto_front_free(ParetoFront* front);
+int write_pareto_binary(NgcContext* context, const ParetoConfig* config, const ParetoFront* front,
+                        const char* filename);
+int parse_pareto_objectives(ParetoConfig* config, const char* spec);
+const char* pareto_objective_name(ParetoObjective objective);
+
+// Uncertainty analysis functions
+int parse_uncertain_input(UncertaintyConfig* config, const char* spec);
+int uncertainty_sample_design(const UncertaintyConfig* config, long long index, NozzleDesign* design);
+int run_uncertainty_analysis(const UncertaintyConfig* config, UncertaintySummary* summary);
+const char* uncertainty_output_name(UncertaintyOutput output);
+double uncertainty_quantile_level(int index);
+
+// Request server functions
+int run_server(NgcContext* context, const ServerConfig* config, ServerSummary* summary);
+
+// Case file functions
+int run_case_file(NgcContext* context, const CaseFileConfig* config, CaseFileSummary* summary);
+
+// Parallel execution functions
+int ngc_cpu_count(void);
+int parallel_for(long long count, long long chunk_size, int num_threads, ParallelTask task, void* context);
 
 // Utility functions
-int validate_input_parameters(const NozzleGeometry* nozzle, const FlowConditions* conditions);
-void print_usage(const char* program_name);
+int validate_input_parameters(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions);
+const char* input_parameter_error(const NozzleGeometry* nozzle, const FlowConditions* conditions);
+const char* design_parameter_error(const NozzleDesign* design);
+double ngc_wall_time(void);
 
 #endif // NGC_H
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "../include/ngc.h"
+
+// Thrust over many ambient pressures for one nozzle and chamber state. The
+// throat conditions and the area-Mach solve do not depend on the ambient
+// pressure, so they are done once; each point is then a multiply-add.
+
+// Summerfield criterion: the flow separates once the exit pressure falls
+// below this fraction of the ambient pressure
+#define SUMMERFIELD_RATIO 0.4
+
+// Points converted from altitude to pressure per block
+#define ALTITUDE_BLOCK 256
+
+// U.S. Standard Atmosphere 1976, geopotential layers up to 84.852 km
+#define EARTH_RADIUS 6356766.0          // m
+#define ATMOSPHERE_G0 9.80665            // m/s^2
+#define ATMOSPHERE_M0 0.0289644          // kg/mol
+#define ATMOSPHERE_R 8.3144598           // J/(mol K)
+
+typedef struct {
+    double base_height;          // Geopotential height (m)
+    double base_temperature;     // (K)
+    double base_pressure;        // (Pa)
+    double lapse_rate;           // (K/m)
+} AtmosphereLayer;
+
+static const AtmosphereLayer atmosphere_layers[] = {
+    {     0.0, 288.15, 101325.0,    -0.0065 },
+    { 11000.0, 216.65,  22632.06,    0.0    },
+    { 20000.0, 216.65,   5474.889,   0.001  },
+    { 32000.0, 228.65,    868.0187,  0.0028 },
+    { 47000.0, 270.65,    110.9063,  0.0    },
+    { 51000.0, 270.65,     66.93887, -0.0028 },
+    { 71000.0, 214.65,      3.956420, -0.002 },
+};
+#define NUM_LAYERS ((int)(sizeof(atmosphere_layers) / sizeof(atmosphere_layers[0])))
+
+double standard_atmosphere_pressure(double altitude) {
+    const double exponent = ATMOSPHERE_G0 * ATMOSPHERE_M0 / ATMOSPHERE_R;
+
+    // Geometric altitude to geopotential height
+    double height = EARTH_RADIUS * altitude / (EARTH_RADIUS + altitude);
+
+    // The last layer extends upward and the first downward
+    int layer = 0;
+    while (layer + 1 < NUM_LAYERS && height >= atmosphere_layers[layer + 1].base_height) {
+        layer++;
+    }
+
+    const AtmosphereLayer* l = &atmosphere_layers[layer];
+    double dh = height - l->base_height;
+    if (l->lapse_rate == 0.0) {
+        return l->base_pressure * exp(-exponent * dh / l->base_temperature);
+    }
+    double temperature = l->base_temperature + l->lapse_rate * dh;
+    if (temperature <= 0.0) {
+        return 0.0;
+    }
+    return l->base_pressure * pow(l->base_temperature / temperature, exponent / l->lapse_rate);
+}
+
+int thrust_profile_init(ThrustProfile* profile, const NozzleContour* contour, const FlowConditions* conditions) {
+    if (!profile || !contour || !conditions) {
+        return -1;
+    }
+
+    // Vacuum performance supplies every ambient-independent term
+    FlowConditions vacuum = *conditions;
+    vacuum.ambient_pressure = 0.0;
+    PerformanceResults results;
+    if (calculate_contour_performance(contour, &vacuum, &results) != 0 ||
+        !isfinite(results.thrust) || !isfinite(results.mass_flow_rate) || results.mass_flow_rate <= 0) {
+        return -1;
+    }
+
+    // Same association as calculate_contour_performance, so the thrust at
+    // any ambient pressure matches the full call exactly
+    profile->momentum_thrust = results.mass_flow_rate * results.exit_velocity;
+    profile->exit_pressure = results.exit_pressure;
+    profile->exit_area = calculate_nozzle_area(contour->exit_radius);
+    profile->weight_flow_rate = results.mass_flow_rate * 9.81;
+    profile->throat_force = conditions->chamber_pressure * calculate_nozzle_area(contour->throat_radius);
+    profile->separation_pressure = results.exit_pressure / SUMMERFIELD_RATIO;
+    return 0;
+}
+
+// One pass per requested output keeps every loop branch-free
+static void evaluate_ambient(const ThrustProfile* profile, const double* ambient,
+                             AmbientPerformanceOutput* output, size_t offset, size_t count) {
+    const double momentum = profile->momentum_thrust;
+    const double exit_pressure = profile->exit_pressure;
+    const double exit_area = profile->exit_area;
+
+    if (output->thrust) {
+        double* thrust = output->thrust + offset;
+        for (size_t i = 0; i < count; i++) {
+            thrust[i] = momentum + (exit_pressure - ambient[i]) * exit_area;
+        }
+    }
+    if (output->specific_impulse) {
+        double* isp = output->specific_impulse + offset;
+        for (size_t i = 0; i < count; i++) {
+            isp[i] = (momentum + (exit_pressure - ambient[i]) * exit_area) / profile->weight_flow_rate;
+        }
+    }
+    if (output->thrust_coefficient) {
+        double* cf = output->thrust_coefficient + offset;
+        for (size_t i = 0; i < count; i++) {
+            cf[i] = (momentum + (exit_pressure - ambient[i]) * exit_area) / profile->throat_force;
+        }
+    }
+    if (output->separated) {
+        unsigned char* separated = output->separated + offset;
+        for (size_t i = 0; i < count; i++) {
+            separated[i] = ambient[i] > profile->separation_pressure;
+        }
+    }
+}
+
+int thrust_profile_pressures(const ThrustProfile* profile, const double* ambient_pressures,
+                             AmbientPerformanceOutput* output, size_t count) {
+    if (!profile || !ambient_pressures || !output) {
+        return -1;
+    }
+
+    evaluate_ambient(profile, ambient_pressures, output, 0, count);
+    return 0;
+}
+
+int thrust_profile_altitudes(const ThrustProfile* profile, const double* altitudes,
+                             AmbientPerformanceOutput* output, size_t count) {
+    if (!profile || !altitudes || !output) {
+        return -1;
+    }
+
+    double pressures[ALTITUDE_BLOCK];
+    for (size_t begin = 0; begin < count; begin += ALTITUDE_BLOCK) {
+        size_t block = count - begin < ALTITUDE_BLOCK ? count - begin : ALTITUDE_BLOCK;
+        for (size_t i = 0; i < block; i++) {
+            pressures[i] = standard_atmosphere_pressure(altitudes[begin + i]);
+        }
+        evaluate_ambient(profile, pressures, output, begin, block);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "profile.h"
+
+// Inverse of the isentropic area-Mach relation
+//
+//   A/A* = (1/M) [ (2/(gamma+1)) (1 + (gamma-1)/2 M^2) ]^((gamma+1)/(2(gamma-1)))
+//
+// solved by Newton's method on g(u) = ln(A/A*)(M) - ln(area_ratio) with
+// u = ln M. In these variables g is nearly linear away from M = 1
+// (slope 2k-1 supersonic, -1 subsonic), so a few steps suffice from the
+// closed-form guess and one or two from a nearby warm start.
+
+int area_mach_solver_init(AreaMachSolver* solver, double gamma) {
+    if (!solver || !(gamma > 1.0)) {
+        return -1;
+    }
+
+    solver->gamma = gamma;
+    solver->half_gm1 = 0.5 * (gamma - 1.0);
+    solver->exponent = (gamma + 1.0) / (2.0 * (gamma - 1.0));
+    solver->log_critical = log(2.0 / (gamma + 1.0));
+    solver->sonic_scale = 0.5 * (gamma + 1.0);
+    solver->tolerance = 1e-12;
+    solver->max_iterations = 50;
+    return 0;
+}
+
+static double area_mach_initial_guess(const AreaMachSolver* solver, double log_area_ratio, int supersonic) {
+    // Near M = 1, ln(A/A*) ~ (2/(gamma+1)) (M-1)^2
+    double s = sqrt(solver->sonic_scale * log_area_ratio);
+
+    if (supersonic) {
+        // One fixed-point step of M = sqrt(((A/A* M)^(1/k) (gamma+1)/2 - 1) / h)
+        double m = 1.0 + s;
+        double q = exp((log_area_ratio + log(m)) / solver->exponent - solver->log_critical);
+        return sqrt((q - 1.0) / solver->half_gm1);
+    }
+
+    // One fixed-point step of M = ((2/(gamma+1)) (1 + h M^2))^k / (A/A*)
+    double m = s < 1.0 ? 1.0 - s : 0.0;
+    return exp(solver->exponent * (solver->log_critical + log(1.0 + solver->half_gm1 * m * m)) - log_area_ratio);
+}
+
+static int area_mach_newton(const AreaMachSolver* solver, double area_ratio, int supersonic,
+                            double mach_guess, double* mach, int* iterations) {
+    if (area_ratio == 1.0) {
+        *mach = 1.0;
+        return 0;
+    }
+
+    double log_area_ratio = log(area_ratio);
+    double m = mach_guess;
+
+    // A warm start on the wrong side of M = 1 falls back to the closed form
+    if (!(supersonic ? m > 1.0 : (m > 0.0 && m < 1.0))) {
+        m = area_mach_initial_guess(solver, log_area_ratio, supersonic);
+    }
+
+    for (int iter = 1; iter <= solver->max_iterations; iter++) {
+        double m2 = m * m;
+        double base = 1.0 + solver->half_gm1 * m2;
+        double g = solver->exponent * (solver->log_critical + log(base)) - log(m) - log_area_ratio;
+        double dg = (m2 - 1.0) / base;
+        double du = -g / dg;
+        double next = m * exp(du);
+
+        // Never step across the sonic point; halve the distance instead
+        if (supersonic ? next <= 1.0 : next >= 1.0) {
+            next = 0.5 * (m + 1.0);
+        }
+        if (!isfinite(next) || next <= 0.0) {
+            *mach = m;
+            *iterations = iter;
+            return -1;
+        }
+        m = next;
+
+        // Quadratic convergence: the remaining error is ~du^2
+        if (du * du <= solver->tolerance) {
+            *mach = m;
+            *iterations = iter;
+            return 0;
+        }
+    }
+
+    *mach = m;
+    *iterations = solver->max_iterations;
+    return -1;
+}
+
+int solve_area_mach(const AreaMachSolver* solver, double area_ratio, int supersonic,
+                    double mach_guess, double* mach, int* iterations) {
+    int count = 0;
+    if (iterations) {
+        *iterations = 0;
+    }
+    if (!solver || !mach || !(area_ratio >= 1.0)) {
+        return -1;
+    }
+
+    int status = area_mach_newton(solver, area_ratio, supersonic, mach_guess, mach, &count);
+    NGC_PROFILE_SOLVE(count, status);
+    if (iterations) {
+        *iterations = count;
+    }
+    return status;
+}
@@ -0,0 +1,175 @@
+#include "../include/ngc.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NGC_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+typedef void (*BatchBlockFn)(const PerformanceBatchInput* in, PerformanceBatchOutput* out, size_t i);
+
+#ifdef NGC_HAVE_X86_SIMD
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define VEC_WIDTH 4
+#define VEC_NAME(n) n##_avx2
+#define VEC_SQRT(x) _mm256_sqrt_pd(x)
+#include "batch_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VEC_WIDTH 8
+#define VEC_NAME(n) n##_avx512
+#define VEC_SQRT(x) _mm512_sqrt_pd(x)
+#include "batch_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#endif
+
+#define BATCH_MAX_WIDTH 8
+
+BatchIsa batch_isa_available(void) {
+#ifdef NGC_HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return BATCH_ISA_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return BATCH_ISA_AVX2;
+    }
+#endif
+    return BATCH_ISA_SCALAR;
+}
+
+const char* batch_isa_name(BatchIsa isa) {
+    switch (isa) {
+        case BATCH_ISA_AUTO:   return batch_isa_name(batch_isa_available());
+        case BATCH_ISA_SCALAR: return "scalar";
+        case BATCH_ISA_AVX2:   return "avx2";
+        case BATCH_ISA_AVX512: return "avx512";
+        default:               return "unknown";
+    }
+}
+
+static void performance_batch_scalar(const PerformanceBatchInput* in, PerformanceBatchOutput* out, size_t count) {
+    // Performance only depends on the radii, so the contour has no points
+    NozzleContour contour;
+    FlowConditions conditions;
+    PerformanceResults results;
+
+    nozzle_contour_init(&contour, 0.0, 0.0, NULL, 0);
+    for (size_t i = 0; i < count; i++) {
+        contour.throat_radius = in->throat_radius[i];
+        contour.exit_radius = in->exit_radius[i];
+        contour.expansion_ratio = (contour.exit_radius * contour.exit_radius) /
+                                  (contour.throat_radius * contour.throat_radius);
+
+        conditions.chamber_pressure = in->chamber_pressure[i];
+        conditions.ambient_pressure = in->ambient_pressure[i];
+        conditions.chamber_temperature = in->chamber_temperature[i];
+        conditions.molecular_weight = in->molecular_weight[i];
+        conditions.gamma = in->gamma[i];
+        conditions.gas_constant = in->gas_constant[i];
+
+        calculate_contour_performance(&contour, &conditions, &results);
+
+        out->thrust[i] = results.thrust;
+        out->specific_impulse[i] = results.specific_impulse;
+        out->exit_velocity[i] = results.exit_velocity;
+        out->exit_pressure[i] = results.exit_pressure;
+        out->exit_temperature[i] = results.exit_temperature;
+        out->mass_flow_rate[i] = results.mass_flow_rate;
+        out->characteristic_velocity[i] = results.characteristic_velocity;
+        out->thrust_coefficient[i] = results.thrust_coefficient;
+        out->exit_mach[i] = results.exit_mach;
+    }
+}
+
+#ifdef NGC_HAVE_X86_SIMD
+static void run_blocks(BatchBlockFn block, size_t width, const PerformanceBatchInput* in,
+                       PerformanceBatchOutput* out, size_t count) {
+    size_t i = 0;
+    for (; i + width <= count; i += width) {
+        block(in, out, i);
+    }
+    if (i == count) {
+        return;
+    }
+
+    // Stage the remainder in full-width buffers, padding with the last case
+    double in_buf[8][BATCH_MAX_WIDTH];
+    double out_buf[9][BATCH_MAX_WIDTH];
+    const double* in_src[8] = {
+        in->throat_radius, in->exit_radius, in->chamber_pressure, in->ambient_pressure,
+        in->chamber_temperature, in->molecular_weight, in->gamma, in->gas_constant
+    };
+    double* out_dst[9] = {
+        out->thrust, out->specific_impulse, out->exit_velocity, out->exit_pressure,
+        out->exit_temperature, out->mass_flow_rate, out->characteristic_velocity, out->thrust_coefficient,
+        out->exit_mach
+    };
+
+    for (int f = 0; f < 8; f++) {
+        for (size_t lane = 0; lane < width; lane++) {
+            size_t src = i + lane < count ? i + lane : count - 1;
+            in_buf[f][lane] = in_src[f][src];
+        }
+    }
+
+    PerformanceBatchInput tail_in = {
+        in_buf[0], in_buf[1], in_buf[2], in_buf[3], in_buf[4], in_buf[5], in_buf[6], in_buf[7]
+    };
+    PerformanceBatchOutput tail_out = {
+        out_buf[0], out_buf[1], out_buf[2], out_buf[3], out_buf[4], out_buf[5], out_buf[6], out_buf[7],
+        out_buf[8]
+    };
+    block(&tail_in, &tail_out, 0);
+
+    for (int f = 0; f < 9; f++) {
+        memcpy(out_dst[f] + i, out_buf[f], (count - i) * sizeof(double));
+    }
+}
+#endif
+
+int calculate_performance_batch_isa(const PerformanceBatchInput* input, PerformanceBatchOutput* output,
+                                    size_t count, BatchIsa isa) {
+    if (!input || !output) {
+        return -1;
+    }
+
+    BatchIsa available = batch_isa_available();
+    if (isa == BATCH_ISA_AUTO) {
+        isa = available;
+    }
+    if (isa > available) {
+        return -1;
+    }
+
+    switch (isa) {
+#ifdef NGC_HAVE_X86_SIMD
+        case BATCH_ISA_AVX512:
+            run_blocks(performance_block_avx512, 8, input, output, count);
+            break;
+        case BATCH_ISA_AVX2:
+            run_blocks(performance_block_avx2, 4, input, output, count);
+            break;
+#endif
+        default:
+            performance_batch_scalar(input, output, count);
+            break;
+    }
+
+    return 0;
+}
+
+int calculate_performance_batch(const PerformanceBatchInput* input, PerformanceBatchOutput* output, size_t count) {
+    return calculate_performance_batch_isa(input, output, count, BATCH_ISA_AUTO);
+}
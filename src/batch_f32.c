@@ -0,0 +1,195 @@
+#include "../include/ngc.h"
+#include <string.h>
+
+// Single-precision batch performance. The kernels are those of batch.c
+// with float lanes: twice the cases per vector and half the memory traffic
+// per case. check_performance_f32 (precision.c) measures how far the
+// results are from the double path; below PRECISION_F32_GAMMA_MIN they
+// are not accurate enough for the uncertainty analysis, which uses double.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NGC_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+typedef void (*BatchBlockF32Fn)(const PerformanceBatchInputF* in, PerformanceBatchOutputF* out, size_t i);
+
+#ifdef NGC_HAVE_X86_SIMD
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define VEC_WIDTH 8
+#define VEC_NAME(n) n##_avx2
+#define VEC_SQRT(x) _mm256_sqrt_ps(x)
+#include "batch_f32_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VEC_WIDTH 16
+#define VEC_NAME(n) n##_avx512
+#define VEC_SQRT(x) _mm512_sqrt_ps(x)
+#include "batch_f32_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#endif
+
+#define BATCH_F32_MAX_WIDTH 16
+
+// One case with the float functions of libm; same steps as the vector kernel
+static void performance_case_f32(const PerformanceBatchInputF* in, PerformanceBatchOutputF* out, size_t i) {
+    float throat_radius = in->throat_radius[i];
+    float exit_radius = in->exit_radius[i];
+    float chamber_pressure = in->chamber_pressure[i];
+    float chamber_temperature = in->chamber_temperature[i];
+    float gamma = in->gamma[i];
+
+    float throat_area = (float)PI * throat_radius * throat_radius;
+    float exit_area = (float)PI * exit_radius * exit_radius;
+    float area_ratio = (exit_radius * exit_radius) / (throat_radius * throat_radius);
+    float R_specific = in->gas_constant[i] / in->molecular_weight[i];
+
+    float gm1 = gamma - 1.0f;
+    float gp1 = gamma + 1.0f;
+    float half_gm1 = 0.5f * gm1;
+    float crit_ratio = 2.0f / gp1;
+    float log_crit = logf(crit_ratio);
+    float k = gp1 / (2.0f * gm1);
+
+    float throat_pressure = chamber_pressure * expf(gamma / gm1 * log_crit);
+    float throat_temperature = chamber_temperature * crit_ratio;
+
+    float mach = 1.0f;
+    if (area_ratio > 1.0f) {
+        float log_area_ratio = logf(area_ratio);
+        float m1 = 1.0f + sqrtf(0.5f * gp1 * log_area_ratio);
+        float q = expf((log_area_ratio + logf(m1)) / k - log_crit);
+        float u = 0.5f * logf((q - 1.0f) / half_gm1);
+        mach = expf(u);
+        for (int iter = 0; iter < 50; iter++) {
+            float m2 = mach * mach;
+            float base = 1.0f + half_gm1 * m2;
+            float g = k * (log_crit + logf(base)) - u - log_area_ratio;
+            float du = -g * base / (m2 - 1.0f);
+            float next_u = u + du;
+            float next = expf(next_u);
+            if (next_u <= 0.0f) {
+                next = 0.5f * (mach + 1.0f);
+                next_u = logf(next);
+            }
+            mach = next;
+            u = next_u;
+            if (du * du <= 1e-12f) {
+                break;
+            }
+        }
+    }
+
+    float temp_ratio = 1.0f / (1.0f + half_gm1 * mach * mach);
+    float exit_temperature = chamber_temperature * temp_ratio;
+    float exit_pressure = chamber_pressure * powf(temp_ratio, gamma / gm1);
+    float exit_velocity = mach * sqrtf(gamma * R_specific * exit_temperature);
+    float mass_flow_rate = throat_area * throat_pressure / sqrtf(R_specific * throat_temperature);
+    float thrust = mass_flow_rate * exit_velocity + (exit_pressure - in->ambient_pressure[i]) * exit_area;
+
+    out->thrust[i] = thrust;
+    out->specific_impulse[i] = thrust / (mass_flow_rate * 9.81f);
+    out->exit_velocity[i] = exit_velocity;
+    out->exit_pressure[i] = exit_pressure;
+    out->exit_temperature[i] = exit_temperature;
+    out->mass_flow_rate[i] = mass_flow_rate;
+    out->characteristic_velocity[i] = sqrtf(gamma * R_specific * chamber_temperature) /
+                                      sqrtf(gamma * expf(2.0f * k * log_crit));
+    out->thrust_coefficient[i] = thrust / (chamber_pressure * throat_area);
+    out->exit_mach[i] = mach;
+}
+
+#ifdef NGC_HAVE_X86_SIMD
+static void run_blocks_f32(BatchBlockF32Fn block, size_t width, const PerformanceBatchInputF* in,
+                           PerformanceBatchOutputF* out, size_t count) {
+    size_t i = 0;
+    for (; i + width <= count; i += width) {
+        block(in, out, i);
+    }
+    if (i == count) {
+        return;
+    }
+
+    // Stage the remainder in full-width buffers, padding with the last case
+    float in_buf[8][BATCH_F32_MAX_WIDTH];
+    float out_buf[9][BATCH_F32_MAX_WIDTH];
+    const float* in_src[8] = {
+        in->throat_radius, in->exit_radius, in->chamber_pressure, in->ambient_pressure,
+        in->chamber_temperature, in->molecular_weight, in->gamma, in->gas_constant
+    };
+    float* out_dst[9] = {
+        out->thrust, out->specific_impulse, out->exit_velocity, out->exit_pressure,
+        out->exit_temperature, out->mass_flow_rate, out->characteristic_velocity, out->thrust_coefficient,
+        out->exit_mach
+    };
+
+    for (int f = 0; f < 8; f++) {
+        for (size_t lane = 0; lane < width; lane++) {
+            size_t src = i + lane < count ? i + lane : count - 1;
+            in_buf[f][lane] = in_src[f][src];
+        }
+    }
+
+    PerformanceBatchInputF tail_in = {
+        in_buf[0], in_buf[1], in_buf[2], in_buf[3], in_buf[4], in_buf[5], in_buf[6], in_buf[7]
+    };
+    PerformanceBatchOutputF tail_out = {
+        out_buf[0], out_buf[1], out_buf[2], out_buf[3], out_buf[4], out_buf[5], out_buf[6], out_buf[7],
+        out_buf[8]
+    };
+    block(&tail_in, &tail_out, 0);
+
+    for (int f = 0; f < 9; f++) {
+        memcpy(out_dst[f] + i, out_buf[f], (count - i) * sizeof(float));
+    }
+}
+#endif
+
+int calculate_performance_batch_f32_isa(const PerformanceBatchInputF* input, PerformanceBatchOutputF* output,
+                                        size_t count, BatchIsa isa) {
+    if (!input || !output) {
+        return -1;
+    }
+
+    BatchIsa available = batch_isa_available();
+    if (isa == BATCH_ISA_AUTO) {
+        isa = available;
+    }
+    if (isa > available) {
+        return -1;
+    }
+
+    switch (isa) {
+#ifdef NGC_HAVE_X86_SIMD
+        case BATCH_ISA_AVX512:
+            run_blocks_f32(performance_block_f32_avx512, 16, input, output, count);
+            break;
+        case BATCH_ISA_AVX2:
+            run_blocks_f32(performance_block_f32_avx2, 8, input, output, count);
+            break;
+#endif
+        default:
+            for (size_t i = 0; i < count; i++) {
+                performance_case_f32(input, output, i);
+            }
+            break;
+    }
+
+    return 0;
+}
+
+int calculate_performance_batch_f32(const PerformanceBatchInputF* input, PerformanceBatchOutputF* output,
+                                    size_t count) {
+    return calculate_performance_batch_f32_isa(input, output, count, BATCH_ISA_AUTO);
+}
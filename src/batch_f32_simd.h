@@ -0,0 +1,187 @@
+// Single-precision vector math and batch performance kernel, instantiated
+// once per ISA by batch_f32.c (no include guard on purpose). Before
+// including, define:
+//   VEC_WIDTH    number of float lanes
+//   VEC_NAME(n)  suffixes an identifier for this instantiation
+//   VEC_SQRT(x)  lane-wise square root
+// and enable the matching target with #pragma GCC target. The kernel is
+// the one in batch_simd.h with float lanes, so a vector holds twice the
+// cases; the polynomials are shortened to float accuracy.
+
+typedef float VEC_NAME(vf) __attribute__((vector_size(VEC_WIDTH * sizeof(float))));
+typedef int VEC_NAME(vi) __attribute__((vector_size(VEC_WIDTH * sizeof(float))));
+typedef unsigned int VEC_NAME(vu) __attribute__((vector_size(VEC_WIDTH * sizeof(float))));
+
+#define VF VEC_NAME(vf)
+#define VI VEC_NAME(vi)
+#define VU VEC_NAME(vu)
+
+static inline VF VEC_NAME(select)(VI mask, VF a, VF b) {
+    return (VF)((mask & (VI)a) | (~mask & (VI)b));
+}
+
+static inline VF VEC_NAME(splat)(float value) {
+    VF v = {0};
+    return v + value;
+}
+
+static inline int VEC_NAME(any)(VI mask) {
+    int bits = 0;
+    for (int lane = 0; lane < VEC_WIDTH; lane++) {
+        bits |= mask[lane];
+    }
+    return bits != 0;
+}
+
+static inline VF VEC_NAME(vsqrt)(VF x) {
+    return VEC_SQRT(x);
+}
+
+static inline VF VEC_NAME(load)(const float* p) {
+    VF v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void VEC_NAME(store)(float* p, VF v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// exp(x): x = n*ln2 + r with |r| <= ln2/2, degree-7 Taylor for exp(r),
+// 2^n assembled directly in the exponent bits
+static inline VF VEC_NAME(vexp)(VF x) {
+    const float shifter = 12582912.0f;  // 1.5 * 2^23
+    VF lo = VEC_NAME(splat)(-87.0f);
+    VF hi = VEC_NAME(splat)(88.0f);
+    x = VEC_NAME(select)(x < lo, lo, x);
+    x = VEC_NAME(select)(x > hi, hi, x);
+
+    VF t = x * 1.44269504f + shifter;
+    VF n = t - shifter;
+    VF r = x - n * 0.693145752f - n * 1.42860677e-6f;
+
+    VF p = r * (1.0f / 5040.0f) + 1.0f / 720.0f;
+    p = p * r + 1.0f / 120.0f;
+    p = p * r + 1.0f / 24.0f;
+    p = p * r + 1.0f / 6.0f;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+
+    VI k = (VI)t - (VI)VEC_NAME(splat)(shifter);
+    VI scale = (k + 127) << 23;
+    return p * (VF)scale;
+}
+
+// log(x) for positive normal x: x = 2^e * m with m in [sqrt(2)/2, sqrt(2)),
+// log(m) = 2 atanh(s) with s = (m - 1) / (m + 1)
+static inline VF VEC_NAME(vlog)(VF x) {
+    const float shifter = 12582912.0f;
+    VU bits = (VU)x;
+    VI e = (VI)(bits >> 23) - 127;
+    VF m = (VF)((bits & 0x007fffffu) | 0x3f800000u);
+
+    VI big = m > 1.41421356f;
+    m = VEC_NAME(select)(big, m * 0.5f, m);
+    e = e - big;   // mask lanes are -1
+
+    VF s = (m - 1.0f) / (m + 1.0f);
+    VF z = s * s;
+    VF p = z * (1.0f / 9.0f) + 1.0f / 7.0f;
+    p = p * z + 1.0f / 5.0f;
+    p = p * z + 1.0f / 3.0f;
+    p = p * z + 1.0f;
+    VF log_m = 2.0f * s * p;
+
+    VF ef = (VF)(e + (VI)VEC_NAME(splat)(shifter)) - shifter;
+    return ef * 0.693145752f + (log_m + ef * 1.42860677e-6f);
+}
+
+static inline VF VEC_NAME(vpow)(VF x, VF y) {
+    return VEC_NAME(vexp)(y * VEC_NAME(vlog)(x));
+}
+
+// Evaluates VEC_WIDTH consecutive cases starting at index i; mirrors
+// performance_block in batch_simd.h
+static inline void VEC_NAME(performance_block_f32)(const PerformanceBatchInputF* in, PerformanceBatchOutputF* out,
+                                                   size_t i) {
+    VF throat_radius = VEC_NAME(load)(in->throat_radius + i);
+    VF exit_radius = VEC_NAME(load)(in->exit_radius + i);
+    VF chamber_pressure = VEC_NAME(load)(in->chamber_pressure + i);
+    VF ambient_pressure = VEC_NAME(load)(in->ambient_pressure + i);
+    VF chamber_temperature = VEC_NAME(load)(in->chamber_temperature + i);
+    VF molecular_weight = VEC_NAME(load)(in->molecular_weight + i);
+    VF gamma = VEC_NAME(load)(in->gamma + i);
+    VF gas_constant = VEC_NAME(load)(in->gas_constant + i);
+
+    VF throat_area = (float)PI * throat_radius * throat_radius;
+    VF exit_area = (float)PI * exit_radius * exit_radius;
+    VF area_ratio = (exit_radius * exit_radius) / (throat_radius * throat_radius);
+    VF R_specific = gas_constant / molecular_weight;
+
+    // Shared logarithm of the critical temperature ratio 2/(gamma+1)
+    VF gm1 = gamma - 1.0f;
+    VF gp1 = gamma + 1.0f;
+    VF half_gm1 = 0.5f * gm1;
+    VF crit_ratio = 2.0f / gp1;
+    VF log_crit = VEC_NAME(vlog)(crit_ratio);
+    VF k = gp1 / (2.0f * gm1);
+
+    // Throat conditions
+    VF throat_pressure = chamber_pressure * VEC_NAME(vexp)(gamma / gm1 * log_crit);
+    VF throat_temperature = chamber_temperature * crit_ratio;
+
+    // Exit Mach number: closed-form guess, then Newton in u = ln M; the
+    // tolerance stays well above the float rounding of the residual
+    VF log_area_ratio = VEC_NAME(vlog)(area_ratio);
+    VF m1 = 1.0f + VEC_NAME(vsqrt)(0.5f * gp1 * log_area_ratio);
+    VF q = VEC_NAME(vexp)((log_area_ratio + VEC_NAME(vlog)(m1)) / k - log_crit);
+    VF u = 0.5f * VEC_NAME(vlog)((q - 1.0f) / half_gm1);
+    VF mach = VEC_NAME(vexp)(u);
+    VI active = area_ratio > 1.0f;
+    for (int iter = 0; iter < 50 && VEC_NAME(any)(active); iter++) {
+        VF m2 = mach * mach;
+        VF base = 1.0f + half_gm1 * m2;
+        VF g = k * (log_crit + VEC_NAME(vlog)(base)) - u - log_area_ratio;
+        VF du = VEC_NAME(select)(active, -g * base / (m2 - 1.0f), VEC_NAME(splat)(0.0f));
+        VF next_u = u + du;
+        VF next = VEC_NAME(vexp)(next_u);
+
+        // Never step across the sonic point; halve the distance instead
+        VI crossed = next_u <= 0.0f;
+        if (VEC_NAME(any)(crossed)) {
+            next = VEC_NAME(select)(crossed, 0.5f * (mach + 1.0f), next);
+            next_u = VEC_NAME(select)(crossed, VEC_NAME(vlog)(next), next_u);
+        }
+        mach = next;
+        u = next_u;
+        active &= du * du > 1e-12f;
+    }
+    mach = VEC_NAME(select)(area_ratio == 1.0f, VEC_NAME(splat)(1.0f), mach);
+
+    // Exit conditions
+    VF temp_ratio = 1.0f / (1.0f + half_gm1 * mach * mach);
+    VF press_ratio = VEC_NAME(vpow)(temp_ratio, gamma / gm1);
+    VF exit_temperature = chamber_temperature * temp_ratio;
+    VF exit_pressure = chamber_pressure * press_ratio;
+    VF exit_velocity = mach * VEC_NAME(vsqrt)(gamma * R_specific * exit_temperature);
+
+    VF characteristic_velocity = VEC_NAME(vsqrt)(gamma * R_specific * chamber_temperature) /
+                                 VEC_NAME(vsqrt)(gamma * VEC_NAME(vexp)(2.0f * k * log_crit));
+    VF mass_flow_rate = throat_area * throat_pressure / VEC_NAME(vsqrt)(R_specific * throat_temperature);
+    VF thrust = mass_flow_rate * exit_velocity + (exit_pressure - ambient_pressure) * exit_area;
+
+    VEC_NAME(store)(out->thrust + i, thrust);
+    VEC_NAME(store)(out->specific_impulse + i, thrust / (mass_flow_rate * 9.81f));
+    VEC_NAME(store)(out->exit_velocity + i, exit_velocity);
+    VEC_NAME(store)(out->exit_pressure + i, exit_pressure);
+    VEC_NAME(store)(out->exit_temperature + i, exit_temperature);
+    VEC_NAME(store)(out->mass_flow_rate + i, mass_flow_rate);
+    VEC_NAME(store)(out->characteristic_velocity + i, characteristic_velocity);
+    VEC_NAME(store)(out->thrust_coefficient + i, thrust / (chamber_pressure * throat_area));
+    VEC_NAME(store)(out->exit_mach + i, mach);
+}
+
+#undef VF
+#undef VI
+#undef VU
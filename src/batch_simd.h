@@ -0,0 +1,196 @@
+// Vector math and batch performance kernel, instantiated once per ISA by
+// batch.c (no include guard on purpose). Before including, define:
+//   VEC_WIDTH    number of double lanes
+//   VEC_NAME(n)  suffixes an identifier for this instantiation
+//   VEC_SQRT(x)  lane-wise square root
+// and enable the matching target with #pragma GCC target. Everything here
+// is static inline, so a file that instantiates it pays only for what it
+// calls (flow.c adds the station kernel from flow_simd.h).
+
+typedef double VEC_NAME(vd) __attribute__((vector_size(VEC_WIDTH * sizeof(double))));
+typedef long long VEC_NAME(vi) __attribute__((vector_size(VEC_WIDTH * sizeof(double))));
+typedef unsigned long long VEC_NAME(vu) __attribute__((vector_size(VEC_WIDTH * sizeof(double))));
+
+#define VD VEC_NAME(vd)
+#define VI VEC_NAME(vi)
+#define VU VEC_NAME(vu)
+
+static inline VD VEC_NAME(select)(VI mask, VD a, VD b) {
+    return (VD)((mask & (VI)a) | (~mask & (VI)b));
+}
+
+static inline VD VEC_NAME(splat)(double value) {
+    VD v = {0};
+    return v + value;
+}
+
+static inline int VEC_NAME(any)(VI mask) {
+    long long bits = 0;
+    for (int lane = 0; lane < VEC_WIDTH; lane++) {
+        bits |= mask[lane];
+    }
+    return bits != 0;
+}
+
+static inline VD VEC_NAME(vsqrt)(VD x) {
+    return VEC_SQRT(x);
+}
+
+static inline VD VEC_NAME(load)(const double* p) {
+    VD v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void VEC_NAME(store)(double* p, VD v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// exp(x): x = n*ln2 + r with |r| <= ln2/2, degree-13 Taylor for exp(r),
+// 2^n assembled directly in the exponent bits
+static inline VD VEC_NAME(vexp)(VD x) {
+    const double shifter = 6755399441055744.0;  // 1.5 * 2^52
+    VD lo = VEC_NAME(splat)(-708.0);
+    VD hi = VEC_NAME(splat)(709.0);
+    x = VEC_NAME(select)(x < lo, lo, x);
+    x = VEC_NAME(select)(x > hi, hi, x);
+
+    VD t = x * 1.4426950408889634 + shifter;
+    VD n = t - shifter;
+    VD r = x - n * 6.93147180369123816490e-01 - n * 1.90821492927058770002e-10;
+
+    VD p = r * (1.0 / 6227020800.0) + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    VI k = (VI)t - (VI)VEC_NAME(splat)(shifter);
+    VI scale = (k + 1023) << 52;
+    return p * (VD)scale;
+}
+
+// log(x) for positive normal x: x = 2^e * m with m in [sqrt(2)/2, sqrt(2)),
+// log(m) = 2 atanh(s) with s = (m - 1) / (m + 1)
+static inline VD VEC_NAME(vlog)(VD x) {
+    const double shifter = 6755399441055744.0;
+    VU bits = (VU)x;
+    VI e = (VI)(bits >> 52) - 1023;
+    VD m = (VD)((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+
+    VI big = m > 1.4142135623730951;
+    m = VEC_NAME(select)(big, m * 0.5, m);
+    e = e - big;   // mask lanes are -1
+
+    VD s = (m - 1.0) / (m + 1.0);
+    VD z = s * s;
+    VD p = z * (1.0 / 19.0) + 1.0 / 17.0;
+    p = p * z + 1.0 / 15.0;
+    p = p * z + 1.0 / 13.0;
+    p = p * z + 1.0 / 11.0;
+    p = p * z + 1.0 / 9.0;
+    p = p * z + 1.0 / 7.0;
+    p = p * z + 1.0 / 5.0;
+    p = p * z + 1.0 / 3.0;
+    p = p * z + 1.0;
+    VD log_m = 2.0 * s * p;
+
+    VD ef = (VD)(e + (VI)VEC_NAME(splat)(shifter)) - shifter;
+    return ef * 6.93147180369123816490e-01 + (log_m + ef * 1.90821492927058770002e-10);
+}
+
+static inline VD VEC_NAME(vpow)(VD x, VD y) {
+    return VEC_NAME(vexp)(y * VEC_NAME(vlog)(x));
+}
+
+// Evaluates VEC_WIDTH consecutive cases starting at index i; mirrors
+// calculate_performance lane by lane
+static inline void VEC_NAME(performance_block)(const PerformanceBatchInput* in, PerformanceBatchOutput* out, size_t i) {
+    VD throat_radius = VEC_NAME(load)(in->throat_radius + i);
+    VD exit_radius = VEC_NAME(load)(in->exit_radius + i);
+    VD chamber_pressure = VEC_NAME(load)(in->chamber_pressure + i);
+    VD ambient_pressure = VEC_NAME(load)(in->ambient_pressure + i);
+    VD chamber_temperature = VEC_NAME(load)(in->chamber_temperature + i);
+    VD molecular_weight = VEC_NAME(load)(in->molecular_weight + i);
+    VD gamma = VEC_NAME(load)(in->gamma + i);
+    VD gas_constant = VEC_NAME(load)(in->gas_constant + i);
+
+    VD throat_area = PI * throat_radius * throat_radius;
+    VD exit_area = PI * exit_radius * exit_radius;
+    VD area_ratio = (exit_radius * exit_radius) / (throat_radius * throat_radius);
+    VD R_specific = gas_constant / molecular_weight;
+
+    // Shared logarithm of the critical temperature ratio 2/(gamma+1)
+    VD gm1 = gamma - 1.0;
+    VD gp1 = gamma + 1.0;
+    VD half_gm1 = 0.5 * gm1;
+    VD crit_ratio = 2.0 / gp1;
+    VD log_crit = VEC_NAME(vlog)(crit_ratio);
+    VD k = gp1 / (2.0 * gm1);
+
+    // Throat conditions
+    VD throat_pressure = chamber_pressure * VEC_NAME(vexp)(gamma / gm1 * log_crit);
+    VD throat_temperature = chamber_temperature * crit_ratio;
+
+    // Exit Mach number: closed-form guess (see area_mach.c), then Newton in
+    // u = ln M until every lane has converged
+    VD log_area_ratio = VEC_NAME(vlog)(area_ratio);
+    VD m1 = 1.0 + VEC_NAME(vsqrt)(0.5 * gp1 * log_area_ratio);
+    VD q = VEC_NAME(vexp)((log_area_ratio + VEC_NAME(vlog)(m1)) / k - log_crit);
+    VD u = 0.5 * VEC_NAME(vlog)((q - 1.0) / half_gm1);
+    VD mach = VEC_NAME(vexp)(u);
+    VI active = area_ratio > 1.0;
+    for (int iter = 0; iter < 50 && VEC_NAME(any)(active); iter++) {
+        VD m2 = mach * mach;
+        VD base = 1.0 + half_gm1 * m2;
+        VD g = k * (log_crit + VEC_NAME(vlog)(base)) - u - log_area_ratio;
+        VD du = VEC_NAME(select)(active, -g * base / (m2 - 1.0), VEC_NAME(splat)(0.0));
+        VD next_u = u + du;
+        VD next = VEC_NAME(vexp)(next_u);
+
+        // Never step across the sonic point; halve the distance instead
+        VI crossed = next_u <= 0.0;
+        if (VEC_NAME(any)(crossed)) {
+            next = VEC_NAME(select)(crossed, 0.5 * (mach + 1.0), next);
+            next_u = VEC_NAME(select)(crossed, VEC_NAME(vlog)(next), next_u);
+        }
+        mach = next;
+        u = next_u;
+        active &= du * du > 1e-12;
+    }
+    mach = VEC_NAME(select)(area_ratio == 1.0, VEC_NAME(splat)(1.0), mach);
+
+    // Exit conditions
+    VD temp_ratio = 1.0 / (1.0 + half_gm1 * mach * mach);
+    VD press_ratio = VEC_NAME(vpow)(temp_ratio, gamma / gm1);
+    VD exit_temperature = chamber_temperature * temp_ratio;
+    VD exit_pressure = chamber_pressure * press_ratio;
+    VD exit_velocity = mach * VEC_NAME(vsqrt)(gamma * R_specific * exit_temperature);
+
+    VD characteristic_velocity = VEC_NAME(vsqrt)(gamma * R_specific * chamber_temperature) /
+                                 VEC_NAME(vsqrt)(gamma * VEC_NAME(vexp)(2.0 * k * log_crit));
+    VD mass_flow_rate = throat_area * throat_pressure / VEC_NAME(vsqrt)(R_specific * throat_temperature);
+    VD thrust = mass_flow_rate * exit_velocity + (exit_pressure - ambient_pressure) * exit_area;
+
+    VEC_NAME(store)(out->thrust + i, thrust);
+    VEC_NAME(store)(out->specific_impulse + i, thrust / (mass_flow_rate * 9.81));
+    VEC_NAME(store)(out->exit_velocity + i, exit_velocity);
+    VEC_NAME(store)(out->exit_pressure + i, exit_pressure);
+    VEC_NAME(store)(out->exit_temperature + i, exit_temperature);
+    VEC_NAME(store)(out->mass_flow_rate + i, mass_flow_rate);
+    VEC_NAME(store)(out->characteristic_velocity + i, characteristic_velocity);
+    VEC_NAME(store)(out->thrust_coefficient + i, thrust / (chamber_pressure * throat_area));
+    VEC_NAME(store)(out->exit_mach + i, mach);
+}
+
+#undef VD
+#undef VI
+#undef VU
@@ -0,0 +1,512 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "context.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+// Content-addressed result cache. The key is the bit pattern of the whole
+// NozzleDesign, so a hit returns exactly what evaluate_nozzle_design would.
+// The table is split into shards, each with its own lock; the top bits of
+// the hash pick the shard, out of fewer than CACHE_SHARDS for tiny caches. A shard is a linear-probing table of (tag,
+// index) buckets over an entry pool, evicted in CLOCK order, the usual
+// approximation of LRU: a hit only sets a bit in the entry it reads
+// instead of relinking list neighbours, so it touches two cache lines.
+// Pools and tables grow with use, so a large size limit does not scatter
+// a small working set over memory.
+
+#define CACHE_SHARD_BITS 6
+#define CACHE_SHARDS (1 << CACHE_SHARD_BITS)
+#define CACHE_NONE (-1)
+#define CACHE_MIN_BUCKETS 64
+
+// Each shard times its first lookup and every 64th after it for the lookup
+// latency estimate; the time runs from taking the shard lock
+#define CACHE_TIMING_MASK 63
+
+// Store file layout: header, then the records
+#define CACHE_MAGIC "NGCCACHE"
+#define CACHE_VERSION 1
+#define CACHE_BYTE_ORDER 0x01020304u
+#define CACHE_IO_RECORDS 4096
+
+#define DESIGN_WORDS (sizeof(NozzleDesign) / sizeof(uint64_t))
+
+typedef char cache_design_check[sizeof(NozzleDesign) == DESIGN_WORDS * sizeof(uint64_t) ? 1 : -1];
+
+typedef struct {
+    uint64_t hash;
+    int32_t referenced;          // Used since the CLOCK hand last passed
+    int32_t reserved;
+    NozzleDesign design;
+    PerformanceResults results;
+} CacheEntry;
+
+typedef struct {
+    uint32_t tag;                // Low hash bits; also the home bucket
+    int32_t index;               // Entry, or CACHE_NONE when empty
+} CacheBucket;
+
+typedef struct {
+    pthread_mutex_t lock;
+    CacheEntry* entries;
+    CacheBucket* buckets;        // Kept at least twice the entry count
+    uint32_t bucket_mask;
+    int32_t capacity;            // Most entries held
+    int32_t allocated;           // Entries in the pool
+    int32_t count;
+    int32_t hand;                // Next eviction candidate
+    long long lookups;
+    long long hits;
+    long long insertions;
+    long long evictions;
+    long long timed_lookups;
+    double timed_seconds;
+    char padding[64];            // Keep neighbouring locks off the same cache line
+} CacheShard;
+
+struct NgcCache {
+    CacheShard shards[CACHE_SHARDS];
+    uint64_t num_shards;         // Shards in use, so each can hold an entry
+    char* path;
+    long long loaded;            // Store records still held once loading ends
+    long long load_dropped;      // Store records evicted by later ones while loading
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t record_size;
+    uint32_t model_version;      // NGC_MODEL_VERSION of the stored results
+    uint64_t record_count;
+} CacheFileHeader;
+
+typedef struct {
+    NozzleDesign design;
+    PerformanceResults results;
+} CacheRecord;
+
+static uint64_t design_hash(const NozzleDesign* design) {
+    uint64_t words[DESIGN_WORDS];
+    memcpy(words, design, sizeof(words));
+
+    uint64_t hash = 0x243f6a8885a308d3ull;
+    for (size_t i = 0; i < DESIGN_WORDS; i++) {
+        hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    }
+
+    // Final avalanche so the shard and bucket bits are both well mixed
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static CacheShard* shard_for(NgcCache* cache, uint64_t hash) {
+    // Multiply-shift range reduction; with all shards in use it is the top bits
+    return &cache->shards[((hash >> 32) * cache->num_shards) >> 32];
+}
+
+// Returns the bucket holding the design, or the empty bucket ending its probe
+static uint32_t find_bucket(const CacheShard* shard, uint64_t hash, const NozzleDesign* design) {
+    uint32_t tag = (uint32_t)hash;
+    uint32_t position = tag & shard->bucket_mask;
+    for (;;) {
+        const CacheBucket* bucket = &shard->buckets[position];
+        if (bucket->index == CACHE_NONE ||
+            (bucket->tag == tag &&
+             memcmp(&shard->entries[bucket->index].design, design, sizeof(NozzleDesign)) == 0)) {
+            return position;
+        }
+        position = (position + 1) & shard->bucket_mask;
+    }
+}
+
+// Backward-shift deletion keeps every probe sequence unbroken
+static void bucket_remove(CacheShard* shard, uint32_t hole) {
+    uint32_t mask = shard->bucket_mask;
+    uint32_t position = hole;
+    for (;;) {
+        position = (position + 1) & mask;
+        CacheBucket* bucket = &shard->buckets[position];
+        if (bucket->index == CACHE_NONE) {
+            break;
+        }
+        // Move the bucket back unless its home lies cyclically in (hole, position]
+        uint32_t home = bucket->tag & mask;
+        if (((position - home) & mask) >= ((position - hole) & mask)) {
+            shard->buckets[hole] = *bucket;
+            hole = position;
+        }
+    }
+    shard->buckets[hole].index = CACHE_NONE;
+}
+
+// Second-chance sweep: referenced entries are spared once
+static int32_t clock_victim(CacheShard* shard) {
+    for (;;) {
+        CacheEntry* entry = &shard->entries[shard->hand];
+        int32_t index = shard->hand;
+        shard->hand = shard->hand + 1 < shard->count ? shard->hand + 1 : 0;
+        if (!entry->referenced) {
+            return index;
+        }
+        entry->referenced = 0;
+    }
+}
+
+static CacheBucket* allocate_buckets(uint32_t count) {
+    CacheBucket* buckets = malloc((size_t)count * sizeof(CacheBucket));
+    if (buckets) {
+        for (uint32_t b = 0; b < count; b++) {
+            buckets[b].tag = 0;
+            buckets[b].index = CACHE_NONE;
+        }
+    }
+    return buckets;
+}
+
+// Makes room for one more entry without eviction; fails at the size limit
+static int shard_grow(CacheShard* shard) {
+    if (shard->count == shard->capacity) {
+        return -1;
+    }
+
+    if (shard->count == shard->allocated) {
+        int32_t allocated = shard->allocated < 16 ? 16 : shard->allocated;
+        allocated = allocated > shard->capacity / 2 ? shard->capacity : allocated * 2;
+        CacheEntry* entries = realloc(shard->entries, (size_t)allocated * sizeof(CacheEntry));
+        if (!entries) {
+            return -1;
+        }
+        shard->entries = entries;
+        shard->allocated = allocated;
+    }
+
+    uint32_t num_buckets = shard->bucket_mask + 1;
+    if (2 * (uint32_t)(shard->count + 1) > num_buckets) {
+        CacheBucket* buckets = allocate_buckets(2 * num_buckets);
+        if (!buckets) {
+            return -1;
+        }
+        free(shard->buckets);
+        shard->buckets = buckets;
+        shard->bucket_mask = 2 * num_buckets - 1;
+        for (int32_t index = 0; index < shard->count; index++) {
+            uint32_t tag = (uint32_t)shard->entries[index].hash;
+            uint32_t position = tag & shard->bucket_mask;
+            while (buckets[position].index != CACHE_NONE) {
+                position = (position + 1) & shard->bucket_mask;
+            }
+            buckets[position].tag = tag;
+            buckets[position].index = index;
+        }
+    }
+    return 0;
+}
+
+// Returns 1 when a new entry was added; the caller holds the shard lock
+static int shard_insert(CacheShard* shard, uint64_t hash, const NozzleDesign* design,
+                        const PerformanceResults* results) {
+    uint32_t position = find_bucket(shard, hash, design);
+    int32_t index = shard->buckets[position].index;
+    if (index != CACHE_NONE) {
+        shard->entries[index].results = *results;
+        shard->entries[index].referenced = 1;
+        return 0;
+    }
+
+    if (shard_grow(shard) == 0) {
+        index = shard->count++;
+    } else if (shard->count > 0) {
+        index = clock_victim(shard);
+        CacheEntry* victim = &shard->entries[index];
+        bucket_remove(shard, find_bucket(shard, victim->hash, &victim->design));
+        shard->evictions++;
+    } else {
+        return 0;
+    }
+    // Growing or removing may have moved the new key's probe position
+    position = find_bucket(shard, hash, design);
+
+    CacheEntry* entry = &shard->entries[index];
+    entry->hash = hash;
+    entry->referenced = 0;
+    entry->design = *design;
+    entry->results = *results;
+    shard->buckets[position].tag = (uint32_t)hash;
+    shard->buckets[position].index = index;
+    return 1;
+}
+
+static int load_store(NgcContext* context, NgcCache* cache, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        // A missing store is an empty cache
+        return 0;
+    }
+
+    CacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, CACHE_MAGIC, 8) != 0 ||
+        header.byte_order != CACHE_BYTE_ORDER || header.record_size != sizeof(CacheRecord)) {
+        fclose(file);
+        return ngc_set_error(context, "%s is not an NGC cache file", path);
+    }
+    if (header.version != CACHE_VERSION || header.model_version != NGC_MODEL_VERSION) {
+        // Results from another format or model version are stale; start over
+        fclose(file);
+        return 0;
+    }
+
+    CacheRecord* records = malloc(CACHE_IO_RECORDS * sizeof(CacheRecord));
+    if (!records) {
+        fclose(file);
+        return ngc_set_error(context, "Cannot allocate cache records");
+    }
+
+    uint64_t remaining = header.record_count;
+    while (remaining > 0) {
+        size_t batch = remaining < CACHE_IO_RECORDS ? (size_t)remaining : CACHE_IO_RECORDS;
+        if (fread(records, sizeof(CacheRecord), batch, file) != batch) {
+            free(records);
+            fclose(file);
+            return ngc_set_error(context, "%s is truncated", path);
+        }
+        for (size_t i = 0; i < batch; i++) {
+            uint64_t hash = design_hash(&records[i].design);
+            shard_insert(shard_for(cache, hash), hash, &records[i].design, &records[i].results);
+        }
+        remaining -= batch;
+    }
+
+    // A store larger than the cache only leaves its last records resident;
+    // the rest are not evictions of this run's results
+    for (int s = 0; s < CACHE_SHARDS; s++) {
+        cache->loaded += cache->shards[s].count;
+        cache->load_dropped += cache->shards[s].evictions;
+        cache->shards[s].evictions = 0;
+    }
+
+    free(records);
+    fclose(file);
+    return 0;
+}
+
+NgcCache* ngc_cache_create(NgcContext* context, long long max_entries, const char* path) {
+    if (max_entries < 1) {
+        ngc_set_error(context, "Cache size must be positive");
+        return NULL;
+    }
+
+    NgcCache* cache = calloc(1, sizeof(NgcCache));
+    if (!cache) {
+        ngc_set_error(context, "Cannot allocate the result cache");
+        return NULL;
+    }
+
+    // The size is split over the shards in use exactly, the first ones
+    // taking the remainder
+    cache->num_shards = max_entries < CACHE_SHARDS ? (uint64_t)max_entries : CACHE_SHARDS;
+    long long num_shards = (long long)cache->num_shards;
+    for (int s = 0; s < CACHE_SHARDS; s++) {
+        CacheShard* shard = &cache->shards[s];
+        long long per_shard = s < num_shards ? max_entries / num_shards + (s < max_entries % num_shards) : 0;
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->capacity = (int32_t)(per_shard < INT32_MAX / 2 ? per_shard : INT32_MAX / 2);
+        shard->bucket_mask = CACHE_MIN_BUCKETS - 1;
+        shard->buckets = allocate_buckets(CACHE_MIN_BUCKETS);
+        if (!shard->buckets) {
+            ngc_cache_destroy(cache);
+            ngc_set_error(context, "Cannot allocate a cache of %lld entries", max_entries);
+            return NULL;
+        }
+    }
+
+    if (path) {
+        cache->path = malloc(strlen(path) + 1);
+        if (!cache->path) {
+            ngc_cache_destroy(cache);
+            ngc_set_error(context, "Cannot allocate the result cache");
+            return NULL;
+        }
+        strcpy(cache->path, path);
+        if (load_store(context, cache, path) != 0) {
+            ngc_cache_destroy(cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+int ngc_cache_save(NgcContext* context, NgcCache* cache) {
+    if (!cache || !cache->path) {
+        return ngc_set_error(context, "The cache has no store file");
+    }
+
+    // Written beside the store and renamed over it, so an interrupted save
+    // leaves the previous store intact
+    size_t size = strlen(cache->path) + 32;
+    char* temporary = malloc(size);
+    if (!temporary) {
+        return ngc_set_error(context, "Cannot save the cache");
+    }
+    snprintf(temporary, size, "%s.%ld.tmp", cache->path, (long)getpid());
+
+    FILE* file = fopen(temporary, "wb");
+    if (!file) {
+        ngc_set_error(context, "Cannot create file %s", temporary);
+        free(temporary);
+        return -1;
+    }
+
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, 8);
+    header.version = CACHE_VERSION;
+    header.model_version = NGC_MODEL_VERSION;
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.record_size = sizeof(CacheRecord);
+    fwrite(&header, sizeof(header), 1, file);
+
+    uint64_t written = 0;
+    for (int s = 0; s < CACHE_SHARDS; s++) {
+        CacheShard* shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        for (int32_t index = 0; index < shard->count; index++) {
+            CacheRecord record = { shard->entries[index].design, shard->entries[index].results };
+            fwrite(&record, sizeof(record), 1, file);
+            written++;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    header.record_count = written;
+    int failed = fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1;
+    failed |= ferror(file) != 0;
+    failed |= fclose(file) != 0;
+    if (failed || rename(temporary, cache->path) != 0) {
+        remove(temporary);
+        free(temporary);
+        return ngc_set_error(context, "Cannot write file %s", cache->path);
+    }
+
+    free(temporary);
+    return 0;
+}
+
+void ngc_cache_destroy(NgcCache* cache) {
+    if (!cache) {
+        return;
+    }
+    for (int s = 0; s < CACHE_SHARDS; s++) {
+        pthread_mutex_destroy(&cache->shards[s].lock);
+        free(cache->shards[s].entries);
+        free(cache->shards[s].buckets);
+    }
+    free(cache->path);
+    free(cache);
+}
+
+int ngc_cache_lookup(NgcCache* cache, const NozzleDesign* design, PerformanceResults* results) {
+    if (!cache || !design || !results) {
+        return -1;
+    }
+
+    uint64_t hash = design_hash(design);
+    CacheShard* shard = shard_for(cache, hash);
+
+    pthread_mutex_lock(&shard->lock);
+    int timed = (shard->lookups & CACHE_TIMING_MASK) == 0;
+    double start = timed ? ngc_wall_time() : 0.0;
+    int32_t index = shard->buckets[find_bucket(shard, hash, design)].index;
+    shard->lookups++;
+    if (index != CACHE_NONE) {
+        shard->hits++;
+        shard->entries[index].referenced = 1;
+        *results = shard->entries[index].results;
+    }
+    if (timed) {
+        shard->timed_lookups++;
+        shard->timed_seconds += ngc_wall_time() - start;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return index != CACHE_NONE ? 0 : -1;
+}
+
+void ngc_cache_insert(NgcCache* cache, const NozzleDesign* design, const PerformanceResults* results) {
+    if (!cache || !design || !results) {
+        return;
+    }
+
+    uint64_t hash = design_hash(design);
+    CacheShard* shard = shard_for(cache, hash);
+    pthread_mutex_lock(&shard->lock);
+    shard->insertions += shard_insert(shard, hash, design, results);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void ngc_cache_stats(NgcCache* cache, NgcCacheStats* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(NgcCacheStats));
+    if (!cache) {
+        return;
+    }
+
+    long long timed_lookups = 0;
+    double timed_seconds = 0.0;
+    for (int s = 0; s < CACHE_SHARDS; s++) {
+        CacheShard* shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->lock);
+        stats->lookups += shard->lookups;
+        stats->hits += shard->hits;
+        stats->insertions += shard->insertions;
+        stats->evictions += shard->evictions;
+        stats->entries += shard->count;
+        stats->capacity += shard->capacity;
+        timed_lookups += shard->timed_lookups;
+        timed_seconds += shard->timed_seconds;
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    stats->loaded = cache->loaded;
+    stats->load_dropped = cache->load_dropped;
+    if (stats->lookups > 0) {
+        stats->hit_rate = (double)stats->hits / (double)stats->lookups;
+    }
+    if (timed_lookups > 0) {
+        stats->mean_lookup_seconds = timed_seconds / (double)timed_lookups;
+    }
+}
+
+int evaluate_nozzle_design_cached(NgcCache* cache, const NozzleDesign* design, NozzleContour* contour,
+                                  PerformanceResults* results) {
+    if (!cache) {
+        return evaluate_nozzle_design(design, contour, results);
+    }
+    if (!design || !results) {
+        return -1;
+    }
+
+    // Only valid designs are stored, so a hit needs no validation; the
+    // caller's contour is still filled, which costs little next to the
+    // exit-condition solve
+    if (ngc_cache_lookup(cache, design, results) == 0) {
+        if (contour) {
+            contour->throat_radius = design->throat_radius;
+            contour->exit_radius = design->exit_radius;
+            return calculate_bell_nozzle_contour(contour, design->length_fraction, NULL);
+        }
+        return 0;
+    }
+
+    if (evaluate_nozzle_design(design, contour, results) != 0) {
+        return -1;
+    }
+    ngc_cache_insert(cache, design, results);
+    return 0;
+}
@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "context.h"
+#include "request.h"
+#include <pthread.h>
+#include <string.h>
+
+// Case-file batch mode. The file is read in chunks of rows that move
+// through a ring of chunk slots: the calling thread parses rows into a free
+// slot, worker threads evaluate and format whole slots, and a writer thread
+// writes the slots out in file order, waiting for a slot whose turn has
+// come when a later one finishes first. The stages run at the same time,
+// and the ring bounds the memory to a few chunks whatever the file size.
+
+#define CASE_CHUNK_ROWS 1024
+#define MAX_CASE_LINE 4096
+
+typedef enum {
+    CHUNK_FREE = 0,
+    CHUNK_PARSED,
+    CHUNK_EVALUATED
+} ChunkState;
+
+typedef struct {
+    ChunkState state;
+    int count;                   // Rows in the chunk
+    int failed;                  // Rows answered with an error
+    CaseRequest rows[CASE_CHUNK_ROWS];
+    char* text;                  // Formatted results
+    size_t text_length;
+} CaseChunk;
+
+typedef struct {
+    const CaseFileConfig* config;
+    int csv;
+    CsvLayout layout;
+    CaseChunk* chunks;
+    int num_chunks;
+    FILE* output;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed;      // Any chunk changed state
+    long long parsed;            // Chunks handed to the workers
+    long long next_evaluate;     // Next chunk a worker takes
+    int done_reading;
+    int write_failed;
+    long long failed_rows;
+} CasePipeline;
+
+static void evaluate_chunk(CasePipeline* pipeline, CaseChunk* chunk) {
+    char* text = chunk->text;
+    chunk->failed = 0;
+
+    for (int i = 0; i < chunk->count; i++) {
+        CaseRequest* request = &chunk->rows[i];
+        if (!request->error &&
+            evaluate_nozzle_design_cached(pipeline->config->cache, &request->design, NULL,
+                                          &request->results) != 0) {
+            request->error = "Design could not be evaluated";
+        }
+        if (request->error) {
+            chunk->failed++;
+        }
+        text += pipeline->csv ? format_csv_response(&pipeline->layout, request, text) :
+                                format_json_response(request, text);
+    }
+    chunk->text_length = (size_t)(text - chunk->text);
+}
+
+static void* case_worker(void* argument) {
+    CasePipeline* pipeline = (CasePipeline*)argument;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        while (pipeline->next_evaluate == pipeline->parsed && !pipeline->done_reading &&
+               !pipeline->write_failed) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        if (pipeline->next_evaluate == pipeline->parsed || pipeline->write_failed) {
+            break;
+        }
+        CaseChunk* chunk = &pipeline->chunks[pipeline->next_evaluate++ % pipeline->num_chunks];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        evaluate_chunk(pipeline, chunk);
+
+        pthread_mutex_lock(&pipeline->lock);
+        chunk->state = CHUNK_EVALUATED;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+// Writes the chunks in file order; a chunk is freed once written
+static void* case_writer(void* argument) {
+    CasePipeline* pipeline = (CasePipeline*)argument;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (long long sequence = 0;; sequence++) {
+        CaseChunk* chunk = &pipeline->chunks[sequence % pipeline->num_chunks];
+        while (!(sequence < pipeline->parsed && chunk->state == CHUNK_EVALUATED) &&
+               !(pipeline->done_reading && sequence == pipeline->parsed)) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        if (sequence == pipeline->parsed) {
+            break;
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+
+        int failed = fwrite(chunk->text, 1, chunk->text_length, pipeline->output) != chunk->text_length;
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->failed_rows += chunk->failed;
+        chunk->state = CHUNK_FREE;
+        if (failed) {
+            pipeline->write_failed = 1;
+        }
+        pthread_cond_broadcast(&pipeline->changed);
+        if (failed) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+// Next non-blank line without its newline, or NULL at the end of the file
+static char* next_case_line(FILE* input, char** buffer, size_t* capacity) {
+    ssize_t length;
+    while ((length = getline(buffer, capacity, input)) >= 0) {
+        if (length > 0 && (*buffer)[length - 1] == '\n') {
+            (*buffer)[--length] = '\0';
+        }
+        if (*request_skip_space(*buffer) != '\0') {
+            return *buffer;
+        }
+    }
+    return NULL;
+}
+
+static void parse_case_line(const CasePipeline* pipeline, const char* line, CaseRequest* request) {
+    if (strlen(line) > MAX_CASE_LINE) {
+        request->id[0] = '\0';
+        request->error = "Row too long";
+    } else if (pipeline->csv) {
+        request->error = parse_csv_request(line, &pipeline->layout, &pipeline->config->base, request);
+    } else {
+        request->error = parse_json_request(line, &pipeline->config->base, request);
+    }
+}
+
+// Parses the file into chunks as slots come free
+static long long read_cases(CasePipeline* pipeline, FILE* input, const char* first_line, char** buffer,
+                            size_t* capacity) {
+    long long rows = 0;
+    const char* line = first_line;
+
+    for (long long sequence = 0; line; sequence++) {
+        CaseChunk* chunk = &pipeline->chunks[sequence % pipeline->num_chunks];
+
+        pthread_mutex_lock(&pipeline->lock);
+        while (chunk->state != CHUNK_FREE && !pipeline->write_failed) {
+            pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+        }
+        int stop = pipeline->write_failed;
+        pthread_mutex_unlock(&pipeline->lock);
+        if (stop) {
+            break;
+        }
+
+        chunk->count = 0;
+        while (line && chunk->count < CASE_CHUNK_ROWS) {
+            parse_case_line(pipeline, line, &chunk->rows[chunk->count++]);
+            line = next_case_line(input, buffer, capacity);
+        }
+        rows += chunk->count;
+
+        pthread_mutex_lock(&pipeline->lock);
+        chunk->state = CHUNK_PARSED;
+        pipeline->parsed = sequence + 1;
+        pthread_cond_broadcast(&pipeline->changed);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->done_reading = 1;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    return rows;
+}
+
+static int run_pipeline(NgcContext* context, CasePipeline* pipeline, int num_workers, FILE* input,
+                        const char* first_line, char** buffer, size_t* capacity, CaseFileSummary* summary) {
+    pthread_t* workers = calloc((size_t)num_workers, sizeof(pthread_t));
+    pthread_t writer;
+    if (!workers) {
+        return ngc_set_error(context, "Cannot allocate the worker threads");
+    }
+
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->changed, NULL);
+
+    int started = 0;
+    int status = 0;
+    int writer_started = pthread_create(&writer, NULL, case_writer, pipeline) == 0;
+    if (writer_started) {
+        for (; started < num_workers; started++) {
+            if (pthread_create(&workers[started], NULL, case_worker, pipeline) != 0) {
+                break;
+            }
+        }
+    }
+
+    if (!writer_started || started == 0) {
+        status = ngc_set_error(context, "Cannot start the pipeline threads");
+        first_line = NULL;
+    }
+    summary->rows = read_cases(pipeline, input, first_line, buffer, capacity);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    if (writer_started) {
+        pthread_join(writer, NULL);
+    }
+    if (status == 0 && pipeline->write_failed) {
+        status = ngc_set_error(context, "Cannot write the results");
+    }
+
+    summary->threads_used = started;
+    summary->failed_rows = pipeline->failed_rows;
+    pthread_cond_destroy(&pipeline->changed);
+    pthread_mutex_destroy(&pipeline->lock);
+    free(workers);
+    return status;
+}
+
+int run_case_file(NgcContext* context, const CaseFileConfig* config, CaseFileSummary* summary) {
+    if (!config || !summary || !config->input_path) {
+        return ngc_set_error(context, "Null pointer passed to run_case_file");
+    }
+    memset(summary, 0, sizeof(CaseFileSummary));
+
+    double start = ngc_wall_time();
+    int use_stdin = strcmp(config->input_path, "-") == 0;
+    int use_stdout = !config->output_path || strcmp(config->output_path, "-") == 0;
+    FILE* input = use_stdin ? stdin : fopen(config->input_path, "r");
+    if (!input) {
+        return ngc_set_error(context, "Cannot open case file %s", config->input_path);
+    }
+
+    CasePipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.config = config;
+
+    // The first line tells the format: a JSON object, or a CSV header
+    char* buffer = NULL;
+    size_t capacity = 0;
+    int status = 0;
+    const char* first_line = next_case_line(input, &buffer, &capacity);
+    if (first_line && *request_skip_space(first_line) != '{') {
+        const char* error = parse_csv_header(first_line, &pipeline.layout);
+        if (error) {
+            status = ngc_set_error(context, "%s: %s in the CSV header", config->input_path, error);
+        }
+        pipeline.csv = 1;
+        first_line = next_case_line(input, &buffer, &capacity);
+    }
+    summary->csv = pipeline.csv;
+
+    int num_workers = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+    pipeline.num_chunks = 2 * num_workers + 2;
+    pipeline.chunks = status == 0 ? calloc((size_t)pipeline.num_chunks, sizeof(CaseChunk)) : NULL;
+    for (int c = 0; pipeline.chunks && c < pipeline.num_chunks; c++) {
+        pipeline.chunks[c].text = malloc((size_t)CASE_CHUNK_ROWS * RESPONSE_SIZE);
+        if (!pipeline.chunks[c].text) {
+            status = ngc_set_error(context, "Cannot allocate the case chunks");
+            break;
+        }
+    }
+    if (status == 0 && !pipeline.chunks) {
+        status = ngc_set_error(context, "Cannot allocate the case chunks");
+    }
+
+    pipeline.output = use_stdout ? stdout : NULL;
+    if (status == 0 && !use_stdout) {
+        pipeline.output = fopen(config->output_path, "w");
+        if (!pipeline.output) {
+            status = ngc_set_error(context, "Cannot create results file %s", config->output_path);
+        }
+    }
+
+    if (status == 0 && pipeline.csv) {
+        char header[RESPONSE_SIZE];
+        int length = format_csv_header(&pipeline.layout, header);
+        if (fwrite(header, 1, (size_t)length, pipeline.output) != (size_t)length) {
+            status = ngc_set_error(context, "Cannot write the results");
+        }
+    }
+    if (status == 0) {
+        status = run_pipeline(context, &pipeline, num_workers, input, first_line, &buffer, &capacity, summary);
+    }
+
+    if (pipeline.output && !use_stdout && fclose(pipeline.output) != 0 && status == 0) {
+        status = ngc_set_error(context, "Cannot write results file %s", config->output_path);
+    } else if (use_stdout && fflush(stdout) != 0 && status == 0) {
+        status = ngc_set_error(context, "Cannot write the results");
+    }
+    if (!use_stdin) {
+        fclose(input);
+    }
+    for (int c = 0; pipeline.chunks && c < pipeline.num_chunks; c++) {
+        free(pipeline.chunks[c].text);
+    }
+    free(pipeline.chunks);
+    free(buffer);
+
+    summary->elapsed_seconds = ngc_wall_time() - start;
+    if (summary->elapsed_seconds > 0) {
+        summary->rows_per_second = (double)summary->rows / summary->elapsed_seconds;
+    }
+    if (status == 0 && !use_stdout) {
+        ngc_diagnostic(context, "Results written to %s", config->output_path);
+    }
+    return status;
+}
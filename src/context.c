@@ -0,0 +1,36 @@
+#include "context.h"
+#include <stdarg.h>
+#include <string.h>
+
+void ngc_context_init(NgcContext* context) {
+    if (context) {
+        memset(context, 0, sizeof(NgcContext));
+    }
+}
+
+const char* ngc_context_error(const NgcContext* context) {
+    return context ? context->error : "";
+}
+
+int ngc_set_error(NgcContext* context, const char* format, ...) {
+    if (context) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(context->error, sizeof(context->error), format, args);
+        va_end(args);
+    }
+    return -1;
+}
+
+void ngc_diagnostic(NgcContext* context, const char* format, ...) {
+    if (!context || !context->diagnostic) {
+        return;
+    }
+
+    char message[NGC_MESSAGE_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    context->diagnostic(context->user_data, message);
+}
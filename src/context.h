@@ -0,0 +1,20 @@
+#ifndef NGC_CONTEXT_H
+#define NGC_CONTEXT_H
+
+#include "../include/ngc.h"
+
+// Message helpers shared by the library sources; both accept a NULL context
+
+#if defined(__GNUC__)
+#define NGC_PRINTF_FORMAT(index, first) __attribute__((format(printf, index, first)))
+#else
+#define NGC_PRINTF_FORMAT(index, first)
+#endif
+
+// Records the error in the context and returns -1
+int ngc_set_error(NgcContext* context, const char* format, ...) NGC_PRINTF_FORMAT(2, 3);
+
+// Passes an informational message to the context's diagnostic callback
+void ngc_diagnostic(NgcContext* context, const char* format, ...) NGC_PRINTF_FORMAT(2, 3);
+
+#endif // NGC_CONTEXT_H
@@ -0,0 +1,240 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "context.h"
+#include "datafile.h"
+#include "profile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define GEOMETRY_FIELDS 2
+#define SWEEP_FIELDS 9
+
+// The header is part of the file format: its size must not drift, and the
+// record arrays must map directly onto Point and PerformanceResults
+typedef char ngc_data_header_size_check[sizeof(NgcDataHeader) == NGC_DATA_HEADER_SIZE ? 1 : -1];
+typedef char ngc_data_point_check[sizeof(Point) == GEOMETRY_FIELDS * sizeof(double) ? 1 : -1];
+typedef char ngc_data_results_check[sizeof(PerformanceResults) == SWEEP_FIELDS * sizeof(double) ? 1 : -1];
+
+void ngc_data_header_init(NgcDataHeader* header, NgcDataKind kind, uint32_t fields, uint64_t count,
+                          const char* field_names) {
+    memset(header, 0, sizeof(NgcDataHeader));
+    memcpy(header->magic, NGC_DATA_MAGIC, sizeof(NGC_DATA_MAGIC));
+    header->version = NGC_DATA_VERSION;
+    header->byte_order = NGC_DATA_BYTE_ORDER;
+    header->kind = (uint32_t)kind;
+    header->record_fields = fields;
+    header->record_count = count;
+    header->header_size = NGC_DATA_HEADER_SIZE;
+    strncpy(header->fields, field_names, sizeof(header->fields) - 1);
+}
+
+// Header and records go out in a single writev; the loop only repeats
+// when the kernel accepts a partial write
+static int write_data_records(NgcContext* context, const char* filename, const NgcDataHeader* header,
+                              const void* records, size_t record_bytes) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return ngc_set_error(context, "Cannot create file %s", filename);
+    }
+
+    struct iovec parts[2];
+    parts[0].iov_base = (void*)header;
+    parts[0].iov_len = sizeof(NgcDataHeader);
+    parts[1].iov_base = (void*)records;
+    parts[1].iov_len = record_bytes;
+
+    struct iovec* pending = parts;
+    int num_pending = record_bytes > 0 ? 2 : 1;
+    while (num_pending > 0) {
+        ssize_t written = writev(fd, pending, num_pending);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return ngc_set_error(context, "Cannot write file %s", filename);
+        }
+
+        size_t remaining = (size_t)written;
+        while (num_pending > 0 && remaining >= pending->iov_len) {
+            remaining -= pending->iov_len;
+            pending++;
+            num_pending--;
+        }
+        if (num_pending > 0) {
+            pending->iov_base = (char*)pending->iov_base + remaining;
+            pending->iov_len -= remaining;
+        }
+    }
+
+    if (close(fd) != 0) {
+        return ngc_set_error(context, "Cannot write file %s", filename);
+    }
+    return 0;
+}
+
+int ngc_data_write(NgcContext* context, const char* filename, const NgcDataHeader* header,
+                   const void* records, size_t record_bytes) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_IO);
+    int status = write_data_records(context, filename, header, records, record_bytes);
+    NGC_PROFILE_END(timer);
+    return status;
+}
+
+int write_contour_binary(NgcContext* context, const NozzleContour* contour, const char* filename) {
+    if (!contour || !filename || contour->num_points < 0 ||
+        (contour->num_points > 0 && !contour->points)) {
+        return ngc_set_error(context, "Invalid contour for binary output");
+    }
+
+    NgcDataHeader header;
+    ngc_data_header_init(&header, NGC_DATA_GEOMETRY, GEOMETRY_FIELDS, (uint64_t)contour->num_points, "x,y");
+    header.throat_radius = contour->throat_radius;
+    header.exit_radius = contour->exit_radius;
+    header.throat_x = contour->throat_x;
+    header.exit_x = contour->exit_x;
+    header.expansion_ratio = contour->expansion_ratio;
+    header.bell_angle = contour->bell_angle;
+
+    return ngc_data_write(context, filename, &header, contour->points,
+                          (size_t)contour->num_points * sizeof(Point));
+}
+
+int write_sweep_binary(NgcContext* context, const SweepConfig* config, const char* filename) {
+    if (!config || !config->results || !filename) {
+        return ngc_set_error(context, "Sweep results are required for binary output");
+    }
+
+    long long total_cases = sweep_case_count(config);
+    if (total_cases < 0) {
+        return ngc_set_error(context, "Sweep has too many cases");
+    }
+    if (total_cases == 0) {
+        return ngc_set_error(context, "Sweep has no cases");
+    }
+
+    NgcDataHeader header;
+    ngc_data_header_init(&header, NGC_DATA_SWEEP, SWEEP_FIELDS, (uint64_t)total_cases,
+                         "thrust,specific_impulse,exit_velocity,exit_pressure,exit_temperature,"
+                         "mass_flow_rate,characteristic_velocity,thrust_coefficient,exit_mach");
+
+    NozzleDesign base = config->base;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        header.base[p] = *nozzle_design_parameter(&base, (SweepParameter)p);
+        header.range_start[p] = config->ranges[p].start;
+        header.range_stop[p] = config->ranges[p].stop;
+        header.range_count[p] = config->ranges[p].count;
+    }
+    header.gas_constant = base.conditions.gas_constant;
+
+    return ngc_data_write(context, filename, &header, config->results,
+                          (size_t)total_cases * sizeof(PerformanceResults));
+}
+
+int ngc_data_open(NgcContext* context, NgcDataFile* file, const char* filename) {
+    if (!file || !filename) {
+        return ngc_set_error(context, "Null pointer passed to ngc_data_open");
+    }
+    memset(file, 0, sizeof(NgcDataFile));
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return ngc_set_error(context, "Cannot open file %s", filename);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(NgcDataHeader)) {
+        close(fd);
+        return ngc_set_error(context, "%s is not an NGC data file", filename);
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return ngc_set_error(context, "Cannot map file %s", filename);
+    }
+
+    const NgcDataHeader* header = (const NgcDataHeader*)mapping;
+    const char* error = NULL;
+    if (memcmp(header->magic, NGC_DATA_MAGIC, sizeof(NGC_DATA_MAGIC)) != 0) {
+        error = "is not an NGC data file";
+    } else if (header->byte_order != NGC_DATA_BYTE_ORDER) {
+        error = "was written with a different byte order";
+    } else if (header->version != NGC_DATA_VERSION) {
+        error = "has an unsupported format version";
+    } else if (header->header_size < sizeof(NgcDataHeader) || header->header_size % sizeof(double) != 0 ||
+               header->record_fields == 0 || header->header_size > size ||
+               header->record_count > (size - header->header_size) / sizeof(double) / header->record_fields) {
+        error = "is truncated or corrupt";
+    } else if ((header->kind == NGC_DATA_GEOMETRY && header->record_fields != GEOMETRY_FIELDS) ||
+               (header->kind == NGC_DATA_SWEEP && header->record_fields != SWEEP_FIELDS) ||
+               (header->kind == NGC_DATA_SURROGATE && header->record_fields != SURROGATE_NUM_FIELDS) ||
+               (header->kind == NGC_DATA_PARETO && header->record_fields != PARETO_NUM_FIELDS)) {
+        error = "has an unexpected record layout";
+    }
+
+    if (error) {
+        munmap(mapping, size);
+        return ngc_set_error(context, "%s %s", filename, error);
+    }
+
+    file->header = header;
+    file->records = (const double*)((const char*)mapping + header->header_size);
+    file->mapping = mapping;
+    file->mapping_size = size;
+    return 0;
+}
+
+void ngc_data_close(NgcDataFile* file) {
+    if (!file) {
+        return;
+    }
+    if (file->mapping) {
+        munmap(file->mapping, file->mapping_size);
+    }
+    memset(file, 0, sizeof(NgcDataFile));
+}
+
+const Point* ngc_data_points(const NgcDataFile* file) {
+    if (!file || !file->header || file->header->kind != NGC_DATA_GEOMETRY) {
+        return NULL;
+    }
+    return (const Point*)file->records;
+}
+
+const PerformanceResults* ngc_data_results(const NgcDataFile* file) {
+    if (!file || !file->header || file->header->kind != NGC_DATA_SWEEP) {
+        return NULL;
+    }
+    return (const PerformanceResults*)file->records;
+}
+
+const ParetoPoint* ngc_data_pareto(const NgcDataFile* file) {
+    if (!file || !file->header || file->header->kind != NGC_DATA_PARETO) {
+        return NULL;
+    }
+    return (const ParetoPoint*)file->records;
+}
+
+int ngc_data_sweep_config(const NgcDataFile* file, SweepConfig* config) {
+    if (!file || !file->header || !config || file->header->kind != NGC_DATA_SWEEP) {
+        return -1;
+    }
+
+    const NgcDataHeader* header = file->header;
+    memset(config, 0, sizeof(SweepConfig));
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        *nozzle_design_parameter(&config->base, (SweepParameter)p) = header->base[p];
+        config->ranges[p].start = header->range_start[p];
+        config->ranges[p].stop = header->range_stop[p];
+        config->ranges[p].count = (int)header->range_count[p];
+    }
+    config->base.conditions.gas_constant = header->gas_constant;
+    return 0;
+}
@@ -0,0 +1,18 @@
+#ifndef NGC_DATAFILE_H
+#define NGC_DATAFILE_H
+
+#include "../include/ngc.h"
+
+// Binary data file writing shared by the sources that produce NGC data
+// files. A kind may extend the header: its records then start past
+// sizeof(NgcDataHeader), and the extension is written as the first bytes of
+// the records.
+
+void ngc_data_header_init(NgcDataHeader* header, NgcDataKind kind, uint32_t fields, uint64_t count,
+                          const char* field_names);
+
+// Writes the header and records in one writev; 0 or -1
+int ngc_data_write(NgcContext* context, const char* filename, const NgcDataHeader* header,
+                   const void* records, size_t record_bytes);
+
+#endif // NGC_DATAFILE_H
@@ -0,0 +1,339 @@
+#include "profile.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NGC_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Quasi-1D isentropic flow at every station of a contour. A station's area
+// ratio is (r / r_throat)^2 and its Mach number solves the area-Mach
+// relation: subsonic upstream of the throat, supersonic downstream.
+// Each station starts from its neighbour's solution, so a solve usually
+// takes one Newton iteration instead of four or five from the closed-form
+// guess.
+//
+// Downstream of the throat the stations are split into contiguous segments,
+// one per vector lane, and every lane marches along its own segment. A
+// station then waits only for the one before it in the same segment. The
+// march runs FLOW_SLICE stations at a time in three passes: area ratios and
+// the final state are independent per station and vectorize freely, which
+// leaves only the Mach number on the sequential path, and FLOW_INTERLEAVE
+// vectors are in flight there so the core can overlap their chains.
+
+// Below this Mach number the previous station is too close to the sonic
+// point for its slope to give a useful warm start
+#define FLOW_WARM_START_MACH 1.01
+
+// Largest increment between neighbouring stations taken by power series
+#define FLOW_SERIES_LIMIT 0.05
+
+// Newton steps taken by series before a vector is solved from scratch, and
+// the largest one
+#define FLOW_SERIES_ITERATIONS 4
+#define FLOW_NEWTON_LIMIT 1e-3
+
+#define FLOW_MAX_WIDTH 8
+
+// Vectors advanced per step
+#define FLOW_INTERLEAVE 4
+
+// Steps per pass
+#define FLOW_SLICE 8
+#define FLOW_SLICE_SIZE (FLOW_SLICE * FLOW_INTERLEAVE * FLOW_MAX_WIDTH)
+
+enum {
+    FLOW_AREA_RATIO = 0,
+    FLOW_MACH,
+    FLOW_PRESSURE,
+    FLOW_TEMPERATURE,
+    FLOW_DENSITY,
+    FLOW_VELOCITY,
+    FLOW_FIELDS
+};
+
+typedef struct {
+    double inv_throat_radius;
+    double half_gm1;             // (gamma - 1) / 2
+    double exponent;             // (gamma + 1) / (2 (gamma - 1))
+    double log_critical;         // ln(2 / (gamma + 1))
+    double sonic_scale;          // (gamma + 1) / 2
+    double pressure_exponent;    // gamma / (gamma - 1)
+    double tolerance;
+    int max_iterations;
+    double gamma;
+    double gas_constant;         // Specific gas constant (J/kg-K)
+    double chamber_pressure;
+    double chamber_temperature;
+    double inv_chamber_rt;       // 1 / (R T_c)
+} FlowConstants;
+
+// Last station solved in each lane's segment
+typedef struct {
+    double log_area_ratio[FLOW_MAX_WIDTH];
+    double mach[FLOW_MAX_WIDTH];
+    double log_mach[FLOW_MAX_WIDTH];
+    double inv_sm1[FLOW_MAX_WIDTH];          // 1 / (M^2 - 1)
+    double log_base[FLOW_MAX_WIDTH];         // ln(1 + (gamma - 1)/2 M^2)
+    double inv_base[FLOW_MAX_WIDTH];         // T / T_c
+} FlowLaneState;
+
+// Stations of one slice, ordered by step, then vector, then lane
+typedef struct {
+    int index[FLOW_SLICE_SIZE];              // Station, or -1 past the end of a segment
+    double radius[FLOW_SLICE_SIZE];
+    double log_area_ratio[FLOW_SLICE_SIZE];
+    double log_base[FLOW_SLICE_SIZE];
+    double field[FLOW_FIELDS][FLOW_SLICE_SIZE];
+    long long iterations[FLOW_SLICE_SIZE];
+    long long unconverged[FLOW_SLICE_SIZE];  // Nonzero where Newton did not converge
+} FlowSlice;
+
+typedef struct {
+    int width;
+    void (*log_area)(const FlowConstants* c, const double* radius, double* area_ratio, double* log_area_ratio);
+    void (*march)(const FlowConstants* c, const double* log_area_ratio, FlowLaneState* state, double* mach,
+                  double* log_base, long long* iterations, long long* unconverged);
+    void (*state)(const FlowConstants* c, const double* mach, const double* log_base, double* pressure,
+                  double* temperature, double* density, double* velocity);
+} FlowKernels;
+
+#ifdef NGC_HAVE_X86_SIMD
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define VEC_WIDTH 4
+#define VEC_NAME(n) n##_avx2
+#define VEC_SQRT(x) _mm256_sqrt_pd(x)
+#include "batch_simd.h"
+#include "flow_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VEC_WIDTH 8
+#define VEC_NAME(n) n##_avx512
+#define VEC_SQRT(x) _mm512_sqrt_pd(x)
+#include "batch_simd.h"
+#include "flow_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+static const FlowKernels flow_kernels_avx2 = {
+    4, flow_log_area_avx2, flow_march_avx2, flow_state_avx2
+};
+
+static const FlowKernels flow_kernels_avx512 = {
+    8, flow_log_area_avx512, flow_march_avx512, flow_state_avx512
+};
+
+#endif
+
+static void flow_constants_init(FlowConstants* c, const AreaMachSolver* solver, double throat_radius,
+                                const FlowConditions* conditions) {
+    c->inv_throat_radius = 1.0 / throat_radius;
+    c->half_gm1 = solver->half_gm1;
+    c->exponent = solver->exponent;
+    c->log_critical = solver->log_critical;
+    c->sonic_scale = solver->sonic_scale;
+    c->pressure_exponent = conditions->gamma / (conditions->gamma - 1.0);
+    c->tolerance = solver->tolerance;
+    c->max_iterations = solver->max_iterations;
+    c->gamma = conditions->gamma;
+    c->gas_constant = conditions->gas_constant / conditions->molecular_weight;
+    c->chamber_pressure = conditions->chamber_pressure;
+    c->chamber_temperature = conditions->chamber_temperature;
+    c->inv_chamber_rt = 1.0 / (c->gas_constant * conditions->chamber_temperature);
+}
+
+// One station through solve_area_mach, warm-started from *mach_guess
+static int flow_station_scalar(const AreaMachSolver* solver, const FlowConstants* c, double radius,
+                               int supersonic, double* mach_guess, double values[FLOW_FIELDS]) {
+    double r = radius * c->inv_throat_radius;
+    double area_ratio = r * r < 1.0 ? 1.0 : r * r;
+    double mach;
+    int status = solve_area_mach(solver, area_ratio, supersonic, *mach_guess, &mach, NULL);
+
+    double temp_ratio = 1.0 / (1.0 + c->half_gm1 * mach * mach);
+    double temperature = c->chamber_temperature * temp_ratio;
+    double pressure = c->chamber_pressure * pow(temp_ratio, c->pressure_exponent);
+
+    values[FLOW_AREA_RATIO] = area_ratio;
+    values[FLOW_MACH] = mach;
+    values[FLOW_PRESSURE] = pressure;
+    values[FLOW_TEMPERATURE] = temperature;
+    values[FLOW_DENSITY] = pressure / (c->gas_constant * temperature);
+    values[FLOW_VELOCITY] = mach * sqrt(c->gamma * c->gas_constant * temperature);
+    *mach_guess = mach;
+    return status;
+}
+
+// Runs the supersonic stations [begin, end) through the vector kernels.
+// Lanes whose segment has ended repeat its last station without storing it.
+static int flow_segments(const FlowKernels* kernels, const FlowConstants* c, const NozzleContour* contour,
+                         int begin, int end, double* const fields[FLOW_FIELDS]) {
+    const int width = kernels->width;
+    const int segments = width * FLOW_INTERLEAVE;
+    const int length = (end - begin + segments - 1) / segments;
+    FlowLaneState state[FLOW_INTERLEAVE];
+    FlowSlice slice;
+    int first[FLOW_INTERLEAVE * FLOW_MAX_WIDTH];
+    int last[FLOW_INTERLEAVE * FLOW_MAX_WIDTH];
+    int status = 0;
+
+    // An empty segment repeats the last station
+    for (int segment = 0; segment < segments; segment++) {
+        first[segment] = begin + segment * length;
+        last[segment] = first[segment] + length < end ? first[segment] + length - 1 : end - 1;
+        if (last[segment] < begin) {
+            last[segment] = end - 1;
+        }
+    }
+
+    // Every lane starts at the sonic point, which forces a cold start
+    memset(state, 0, sizeof(state));
+    for (int k = 0; k < FLOW_INTERLEAVE; k++) {
+        for (int lane = 0; lane < FLOW_MAX_WIDTH; lane++) {
+            state[k].mach[lane] = 1.0;
+        }
+    }
+
+    for (int t0 = 0; t0 < length; t0 += FLOW_SLICE) {
+        int steps = length - t0 < FLOW_SLICE ? length - t0 : FLOW_SLICE;
+        int size = steps * segments;
+
+        for (int t = 0, i = 0; t < steps; t++) {
+            for (int segment = 0; segment < segments; segment++, i++) {
+                int station = first[segment] + t0 + t;
+                int valid = station <= last[segment];
+                slice.index[i] = valid ? station : -1;
+                slice.radius[i] = contour->points[valid ? station : last[segment]].y;
+            }
+        }
+
+        for (int i = 0; i < size; i += width) {
+            kernels->log_area(c, slice.radius + i, slice.field[FLOW_AREA_RATIO] + i, slice.log_area_ratio + i);
+        }
+        for (int i = 0; i < size; i += segments) {
+            kernels->march(c, slice.log_area_ratio + i, state, slice.field[FLOW_MACH] + i, slice.log_base + i,
+                           slice.iterations + i, slice.unconverged + i);
+        }
+        for (int i = 0; i < size; i += width) {
+            kernels->state(c, slice.field[FLOW_MACH] + i, slice.log_base + i, slice.field[FLOW_PRESSURE] + i,
+                           slice.field[FLOW_TEMPERATURE] + i, slice.field[FLOW_DENSITY] + i,
+                           slice.field[FLOW_VELOCITY] + i);
+        }
+
+        for (int f = 0; f < FLOW_FIELDS; f++) {
+            if (!fields[f]) {
+                continue;
+            }
+            for (int i = 0; i < size; i++) {
+                if (slice.index[i] >= 0) {
+                    fields[f][slice.index[i]] = slice.field[f][i];
+                }
+            }
+        }
+        for (int i = 0; i < size; i++) {
+            if (slice.index[i] < 0) {
+                continue;
+            }
+            NGC_PROFILE_SOLVE((int)slice.iterations[i], slice.unconverged[i] != 0);
+            if (slice.unconverged[i]) {
+                status = -1;
+            }
+        }
+    }
+    return status;
+}
+
+static int compute_flow_profile(const NozzleContour* contour, const FlowConditions* conditions,
+                                FlowProfileOutput* output, BatchIsa isa) {
+    double* const fields[FLOW_FIELDS] = {
+        output->area_ratio, output->mach, output->pressure, output->temperature, output->density, output->velocity
+    };
+    AreaMachSolver solver;
+    FlowConstants c;
+    double values[FLOW_FIELDS];
+    int status = 0;
+
+    if (area_mach_solver_init(&solver, conditions->gamma) != 0) {
+        return -1;
+    }
+    flow_constants_init(&c, &solver, contour->throat_radius, conditions);
+
+    // Stations are ordered by x, so the subsonic ones come first
+    int throat = 0;
+    while (throat < contour->num_points && contour->points[throat].x < contour->throat_x) {
+        throat++;
+    }
+
+    // Converging section, marching upstream from the throat; the supersonic
+    // section falls back to the same loop without vector support
+    double guess = 0.0;
+    for (int i = throat - 1; i >= 0; i--) {
+        if (flow_station_scalar(&solver, &c, contour->points[i].y, 0, &guess, values) != 0) {
+            status = -1;
+        }
+        for (int f = 0; f < FLOW_FIELDS; f++) {
+            if (fields[f]) {
+                fields[f][i] = values[f];
+            }
+        }
+    }
+
+    switch (isa) {
+#ifdef NGC_HAVE_X86_SIMD
+        case BATCH_ISA_AVX512:
+            return flow_segments(&flow_kernels_avx512, &c, contour, throat, contour->num_points, fields) | status;
+        case BATCH_ISA_AVX2:
+            return flow_segments(&flow_kernels_avx2, &c, contour, throat, contour->num_points, fields) | status;
+#endif
+        default:
+            break;
+    }
+
+    guess = 0.0;
+    for (int i = throat; i < contour->num_points; i++) {
+        if (flow_station_scalar(&solver, &c, contour->points[i].y, 1, &guess, values) != 0) {
+            status = -1;
+        }
+        for (int f = 0; f < FLOW_FIELDS; f++) {
+            if (fields[f]) {
+                fields[f][i] = values[f];
+            }
+        }
+    }
+    return status;
+}
+
+int calculate_flow_profile_isa(const NozzleContour* contour, const FlowConditions* conditions,
+                               FlowProfileOutput* output, BatchIsa isa) {
+    if (!contour || !conditions || !output || contour->num_points < 0 ||
+        (contour->num_points > 0 && !contour->points) || !(contour->throat_radius > 0)) {
+        return -1;
+    }
+
+    BatchIsa available = batch_isa_available();
+    if (isa == BATCH_ISA_AUTO) {
+        isa = available;
+    }
+    if (isa > available) {
+        return -1;
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_FLOW);
+    int status = compute_flow_profile(contour, conditions, output, isa);
+    NGC_PROFILE_END(timer);
+    return status;
+}
+
+int calculate_flow_profile(const NozzleContour* contour, const FlowConditions* conditions,
+                           FlowProfileOutput* output) {
+    return calculate_flow_profile_isa(contour, conditions, output, BATCH_ISA_AUTO);
+}
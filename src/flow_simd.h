@@ -0,0 +1,246 @@
+// Supersonic station kernels for calculate_flow_profile, instantiated once
+// per ISA by flow.c after batch_simd.h (no include guard on purpose); they
+// use the same VEC_* macros and vector math.
+//
+// flow_log_area and flow_state see independent stations. flow_march moves
+// each lane one station along its own segment of the contour and is the
+// only sequential part, so it avoids exp and log: neighbouring stations are
+// close, and short power series in the increments plus a Newton step or
+// two reach the next solution. Whenever an increment is too large for the
+// series, or Newton does not converge within FLOW_SERIES_ITERATIONS steps,
+// the whole vector is solved from scratch instead.
+
+#define VD VEC_NAME(vd)
+#define VI VEC_NAME(vi)
+
+// exp(x) for |x| <= FLOW_SERIES_LIMIT: degree-10 Taylor polynomial
+static inline VD VEC_NAME(exp_small)(VD x) {
+    VD p = x * (1.0 / 3628800.0) + 1.0 / 362880.0;
+    p = p * x + 1.0 / 40320.0;
+    p = p * x + 1.0 / 5040.0;
+    p = p * x + 1.0 / 720.0;
+    p = p * x + 1.0 / 120.0;
+    p = p * x + 1.0 / 24.0;
+    p = p * x + 1.0 / 6.0;
+    p = p * x + 0.5;
+    p = p * x + 1.0;
+    return p * x + 1.0;
+}
+
+// ln(1 + x) for |x| <= FLOW_SERIES_LIMIT: degree-12 Taylor polynomial
+static inline VD VEC_NAME(log1p_small)(VD x) {
+    VD p = x * (-1.0 / 12.0) + 1.0 / 11.0;
+    p = p * x - 1.0 / 10.0;
+    p = p * x + 1.0 / 9.0;
+    p = p * x - 1.0 / 8.0;
+    p = p * x + 1.0 / 7.0;
+    p = p * x - 1.0 / 6.0;
+    p = p * x + 1.0 / 5.0;
+    p = p * x - 1.0 / 4.0;
+    p = p * x + 1.0 / 3.0;
+    p = p * x - 0.5;
+    p = p * x + 1.0;
+    return p * x;
+}
+
+// exp(x) and ln(1 + x) for |x| <= FLOW_NEWTON_LIMIT: degree-5 Taylor
+static inline VD VEC_NAME(exp_tiny)(VD x) {
+    return 1.0 + x * (1.0 + x * (0.5 + x * (1.0 / 6.0 + x * (1.0 / 24.0 + x * (1.0 / 120.0)))));
+}
+
+static inline VD VEC_NAME(log1p_tiny)(VD x) {
+    return x * (1.0 + x * (-0.5 + x * (1.0 / 3.0 + x * (-0.25 + x * 0.2))));
+}
+
+static inline int VEC_NAME(all)(VI mask) {
+    long long bits = -1;
+    for (int lane = 0; lane < VEC_WIDTH; lane++) {
+        bits &= mask[lane];
+    }
+    return bits != 0;
+}
+
+// Area ratio (r / r_throat)^2, never below 1, and its logarithm
+static void VEC_NAME(flow_log_area)(const FlowConstants* c, const double* radius,
+                                    double* area_ratio, double* log_area_ratio) {
+    VD r = VEC_NAME(load)(radius) * c->inv_throat_radius;
+    VD a = r * r;
+    a = VEC_NAME(select)(a < 1.0, VEC_NAME(splat)(1.0), a);
+    VEC_NAME(store)(area_ratio, a);
+    VEC_NAME(store)(log_area_ratio, VEC_NAME(vlog)(a));
+}
+
+static inline void VEC_NAME(flow_advance)(const FlowConstants* c, FlowLaneState* state, VD log_area_ratio,
+                                          VD mach, VD u, VD log_base, double* mach_out, double* log_base_out) {
+    VD sm1 = mach * mach - 1.0;
+    VD base = 1.0 + c->half_gm1 * mach * mach;
+    VD inv = 1.0 / (sm1 * base);
+
+    VEC_NAME(store)(state->log_area_ratio, log_area_ratio);
+    VEC_NAME(store)(state->mach, mach);
+    VEC_NAME(store)(state->log_mach, u);
+    VEC_NAME(store)(state->log_base, log_base);
+    VEC_NAME(store)(state->inv_base, inv * sm1);
+    VEC_NAME(store)(state->inv_sm1, inv * base);
+    VEC_NAME(store)(mach_out, mach);
+    VEC_NAME(store)(log_base_out, log_base);
+}
+
+// Solves every lane from scratch: closed-form guess (see area_mach.c) or a
+// first-order step from the previous station, then Newton to convergence
+static void VEC_NAME(flow_solve)(const FlowConstants* c, VD log_area_ratio, FlowLaneState* state,
+                                 double* mach_out, double* log_base_out, long long* iterations_out,
+                                 long long* unconverged_out) {
+    VD m0 = VEC_NAME(load)(state->mach);
+    VD u = VEC_NAME(load)(state->log_mach) + (log_area_ratio - VEC_NAME(load)(state->log_area_ratio)) *
+           (1.0 + c->half_gm1 * m0 * m0) * VEC_NAME(load)(state->inv_sm1);
+    VI cold = (log_area_ratio > 0.0) & ((m0 <= FLOW_WARM_START_MACH) | (u <= 0.0));
+    if (VEC_NAME(any)(cold)) {
+        VD m1 = 1.0 + VEC_NAME(vsqrt)(c->sonic_scale * log_area_ratio);
+        VD q = VEC_NAME(vexp)((log_area_ratio + VEC_NAME(vlog)(m1)) / c->exponent - c->log_critical);
+        VD guess = 0.5 * VEC_NAME(vlog)((q - 1.0) / c->half_gm1);
+        u = VEC_NAME(select)(cold, guess, u);
+    }
+
+    VD mach = VEC_NAME(vexp)(u);
+    VI active = log_area_ratio > 0.0;
+    VI iterations = {0};
+    for (int iter = 0; iter < c->max_iterations && VEC_NAME(any)(active); iter++) {
+        VD m2 = mach * mach;
+        VD base = 1.0 + c->half_gm1 * m2;
+        VD g = c->exponent * (c->log_critical + VEC_NAME(vlog)(base)) - u - log_area_ratio;
+        VD du = VEC_NAME(select)(active, -g * base / (m2 - 1.0), VEC_NAME(splat)(0.0));
+        VD next_u = u + du;
+        VD next = VEC_NAME(vexp)(next_u);
+
+        // Never step across the sonic point; halve the distance instead
+        VI crossed = active & (next_u <= 0.0);
+        if (VEC_NAME(any)(crossed)) {
+            next = VEC_NAME(select)(crossed, 0.5 * (mach + 1.0), next);
+            next_u = VEC_NAME(select)(crossed, VEC_NAME(vlog)(next), next_u);
+        }
+        mach = next;
+        u = next_u;
+        iterations -= active;   // mask lanes are -1
+        active &= du * du > c->tolerance;
+    }
+    VI sonic = log_area_ratio <= 0.0;
+    mach = VEC_NAME(select)(sonic, VEC_NAME(splat)(1.0), mach);
+    u = VEC_NAME(select)(sonic, VEC_NAME(splat)(0.0), u);
+
+    memcpy(iterations_out, &iterations, sizeof(iterations));
+    memcpy(unconverged_out, &active, sizeof(active));
+    VD log_base = VEC_NAME(vlog)(1.0 + c->half_gm1 * mach * mach);
+    VEC_NAME(flow_advance)(c, state, log_area_ratio, mach, u, log_base, mach_out, log_base_out);
+}
+
+// Advances each lane of FLOW_INTERLEAVE vectors one station along its
+// segment: state[k] holds vector k's previous stations on entry and the new
+// ones on return. Every phase loops over the vectors, so their independent
+// dependency chains sit next to each other in the instruction stream.
+static void VEC_NAME(flow_march)(const FlowConstants* c, const double* log_area_ratio_in, FlowLaneState* state,
+                                 double* mach_out, double* log_base_out, long long* iterations_out,
+                                 long long* unconverged_out) {
+    const double limit = FLOW_SERIES_LIMIT;
+    VD log_area_ratio[FLOW_INTERLEAVE];
+    VD u[FLOW_INTERLEAVE];
+    VD mach[FLOW_INTERLEAVE];
+    VD s[FLOW_INTERLEAVE];
+    VD inv_base[FLOW_INTERLEAVE];
+    VD log_base[FLOW_INTERLEAVE];
+    VI ok[FLOW_INTERLEAVE];
+    VI active[FLOW_INTERLEAVE];
+    VI iterations[FLOW_INTERLEAVE];
+
+    // Third-order Taylor step of u = ln M in L = ln(A/A*). With s = M^2,
+    // du/dL = f = (1 + h s) / (s - 1), f_u = -2 (1 + h) s / (s - 1)^2 and
+    // f_uu = -2 f_u (s + 1) / (s - 1), so the second and third derivatives
+    // are f f_u and f (f_u^2 + f f_uu). ln(1 + h s) then advances by
+    // ln(1 + h (s - s0) / (1 + h s0)).
+    for (int k = 0; k < FLOW_INTERLEAVE; k++) {
+        const FlowLaneState* prev = &state[k];
+        log_area_ratio[k] = VEC_NAME(load)(log_area_ratio_in + k * VEC_WIDTH);
+        VD dl = log_area_ratio[k] - VEC_NAME(load)(prev->log_area_ratio);
+        VD m0 = VEC_NAME(load)(prev->mach);
+        VD s0 = m0 * m0;
+        VD inv = VEC_NAME(load)(prev->inv_sm1);
+        VD f = (1.0 + c->half_gm1 * s0) * inv;
+        VD f_u = -2.0 * c->sonic_scale * s0 * inv * inv;
+        VD f_uu = -2.0 * f_u * (s0 + 1.0) * inv;
+        VD du = dl * (f + dl * (0.5 * f * f_u + dl * (1.0 / 6.0) * f * (f_u * f_u + f * f_uu)));
+
+        u[k] = VEC_NAME(load)(prev->log_mach) + du;
+        mach[k] = m0 * VEC_NAME(exp_small)(du);
+        s[k] = mach[k] * mach[k];
+        VD y = c->half_gm1 * (s[k] - s0) * VEC_NAME(load)(prev->inv_base);
+        log_base[k] = VEC_NAME(load)(prev->log_base) + VEC_NAME(log1p_small)(y);
+
+        // 1 / (1 + h s) by two Newton steps for the reciprocal from its
+        // value at s0, relative error y^4
+        inv_base[k] = VEC_NAME(load)(prev->inv_base) * (1.0 - y);
+        inv_base[k] *= 2.0 - (1.0 + c->half_gm1 * s[k]) * inv_base[k];
+        ok[k] = (m0 > FLOW_WARM_START_MACH) & (dl >= -limit) & (dl <= limit) & (du >= -limit) & (du <= limit) &
+                (y >= -limit) & (y <= limit);
+        active[k] = ok[k];
+        iterations[k] = active[k] & 0;
+    }
+
+    // Newton, g'(u) = (s - 1) / (1 + h s), carrying ln(1 + h s) along by
+    // the same series
+    for (int iter = 0; iter < FLOW_SERIES_ITERATIONS; iter++) {
+        VI any = active[0];
+        for (int k = 1; k < FLOW_INTERLEAVE; k++) {
+            any |= active[k];
+        }
+        if (!VEC_NAME(any)(any)) {
+            break;
+        }
+        for (int k = 0; k < FLOW_INTERLEAVE; k++) {
+            VD base = 1.0 + c->half_gm1 * s[k];
+            VD g = c->exponent * (c->log_critical + log_base[k]) - u[k] - log_area_ratio[k];
+            VD du = VEC_NAME(select)(active[k], -g * base / (s[k] - 1.0), VEC_NAME(splat)(0.0));
+            ok[k] &= (du >= -FLOW_NEWTON_LIMIT) & (du <= FLOW_NEWTON_LIMIT);
+            u[k] += du;
+            mach[k] *= VEC_NAME(exp_tiny)(du);
+            iterations[k] -= active[k];   // mask lanes are -1
+            active[k] &= du * du > c->tolerance;
+
+            VD next = mach[k] * mach[k];
+            VD y = c->half_gm1 * (next - s[k]) * inv_base[k];
+            log_base[k] += VEC_NAME(log1p_tiny)(y);
+            s[k] = next;
+            inv_base[k] *= 2.0 - (1.0 + c->half_gm1 * s[k]) * inv_base[k];
+        }
+    }
+
+    for (int k = 0; k < FLOW_INTERLEAVE; k++) {
+        int offset = k * VEC_WIDTH;
+        if (!VEC_NAME(all)(ok[k] & ~active[k])) {
+            VEC_NAME(flow_solve)(c, log_area_ratio[k], &state[k], mach_out + offset, log_base_out + offset,
+                                 iterations_out + offset, unconverged_out + offset);
+            continue;
+        }
+        memcpy(iterations_out + offset, &iterations[k], sizeof(iterations[k]));
+        memset(unconverged_out + offset, 0, sizeof(iterations[k]));
+        VEC_NAME(flow_advance)(c, &state[k], log_area_ratio[k], mach[k], u[k], log_base[k],
+                               mach_out + offset, log_base_out + offset);
+    }
+}
+
+// Isentropic state from M and ln(1 + (gamma - 1)/2 M^2), as in exit_conditions
+static void VEC_NAME(flow_state)(const FlowConstants* c, const double* mach_in, const double* log_base_in,
+                                 double* pressure_out, double* temperature_out, double* density_out,
+                                 double* velocity_out) {
+    VD mach = VEC_NAME(load)(mach_in);
+    VD base = 1.0 + c->half_gm1 * mach * mach;
+    VD temperature = c->chamber_temperature / base;
+    VD pressure = c->chamber_pressure * VEC_NAME(vexp)(-c->pressure_exponent * VEC_NAME(load)(log_base_in));
+
+    VEC_NAME(store)(pressure_out, pressure);
+    VEC_NAME(store)(temperature_out, temperature);
+    VEC_NAME(store)(density_out, pressure * base * c->inv_chamber_rt);
+    VEC_NAME(store)(velocity_out, mach * VEC_NAME(vsqrt)(c->gamma * c->gas_constant * temperature));
+}
+
+#undef VD
+#undef VI
@@ -1,12 +1,928 @@
+#define _POSIX_C_SOURCE 200809L
 #include "../include/ngc.h"
 #include <string.h>
 #include <getopt.h>
+#include <signal.h>
+
+// Long-only options
+enum {
+    OPT_SWEEP = 256,
+    OPT_THREADS,
+    OPT_POINTS,
+    OPT_TOLERANCE,
+    OPT_CONTOUR,
+    OPT_CHARACTERISTICS,
+    OPT_OPTIMIZE,
+    OPT_OBJECTIVE,
+    OPT_MAX_LENGTH,
+    OPT_MAX_EXIT_DIAMETER,
+    OPT_MIN_PRESSURE_RATIO,
+    OPT_MAX_PRESSURE_RATIO,
+    OPT_MAX_EVALUATIONS,
+    OPT_POPULATION,
+    OPT_BINARY,
+    OPT_PROFILE,
+    OPT_SERVE,
+    OPT_ALTITUDES,
+    OPT_CACHE,
+    OPT_CACHE_SIZE,
+    OPT_FLOW,
+    OPT_THERMAL,
+    OPT_WALL_TEMPERATURE,
+    OPT_MAX_HEAT_FLUX,
+    OPT_UNCERTAIN,
+    OPT_SAMPLES,
+    OPT_SEED,
+    OPT_BATCH,
+    OPT_BATCH_OUTPUT,
+    OPT_MESH,
+    OPT_MESH_SEGMENTS,
+    OPT_WALL_THICKNESS,
+    OPT_SENSITIVITIES,
+    OPT_BUILD_SURROGATE,
+    OPT_SURROGATE_GRID,
+    OPT_PROPELLANT,
+    OPT_MIXTURE_RATIO,
+    OPT_COMPOSITION,
+    OPT_EXPLORE,
+    OPT_OBJECTIVES,
+    OPT_FRONT,
+    OPT_SINGLE_PRECISION,
+    OPT_CHECK_PRECISION,
+    OPT_PRECISION_RANGES
+};
+
+// Point storage used when adaptive spacing is requested without --points
+#define ADAPTIVE_MAX_POINTS 100000
+
+// Characteristics in the throat-corner fan unless --characteristics is given
+#define DEFAULT_CHARACTERISTICS 500
+
+// Result cache entries unless --cache-size is given
+#define DEFAULT_CACHE_SIZE 1000000
+
+// Monte Carlo samples unless --samples is given
+#define DEFAULT_SAMPLES 1000000
+
+// Surrogate table grid unless --surrogate-grid is given
+#define DEFAULT_SURROGATE_GRID { 1.5, 1000.0, 512, 1.1, 1.7, 128, 0 }
+
+// Pareto objectives unless --objectives is given
+#define DEFAULT_PARETO_OBJECTIVES "isp,length,exit-area,wall-area"
+
+// Pareto designs listed after an exploration, evenly spaced along the front
+#define PARETO_PRINT_LIMIT 20
+
+// Propellant table nodes along the mixture ratio for --mixture-ratio A:B:N; the
+// pressure nodes span half to twice the chamber pressure, with it in the middle
+#define MIXTURE_TABLE_RATIOS 128
+#define MIXTURE_TABLE_PRESSURES 5
+
+// Mixture-ratio results listed row by row up to this many ratios
+#define MIXTURE_PRINT_LIMIT 50
+
+// Hot-gas wall temperature for --thermal and --max-heat-flux unless --wall-temperature is given
+#define DEFAULT_WALL_TEMPERATURE 800.0
+
+typedef enum {
+    CONTOUR_BELL = 0,
+    CONTOUR_MOC_IDEAL,
+    CONTOUR_MOC_TRUNCATED
+} ContourMethod;
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("\nRocket Nozzle Geometry Calculator (NGC)\n");
+    printf("A tool for calculating and plotting bell nozzle geometries and propulsion performance\n\n");
+    printf("Options:\n");
+    printf("  -h, --help              Show this help message\n");
+    printf("  -t, --throat-radius     Throat radius in meters (default: 0.01)\n");
+    printf("  -e, --exit-radius       Exit radius in meters (default: 0.03)\n");
+    printf("  -p, --chamber-pressure  Chamber pressure in Pa (default: 1000000)\n");
+    printf("  -a, --ambient-pressure  Ambient pressure in Pa (default: 101325)\n");
+    printf("  -T, --chamber-temp      Chamber temperature in K (default: 3000)\n");
+    printf("  -M, --molecular-weight  Molecular weight in kg/mol (default: 0.02)\n");
+    printf("  -g, --gamma             Specific heat ratio (default: 1.3)\n");
+    printf("  -l, --length-fraction   Nozzle length fraction (default: 0.8)\n");
+    printf("  -o, --output            Output plot filename, .png or .svg (default: nozzle_plot.png)\n");
+    printf("  --data                  Output geometry data filename\n");
+    printf("  --binary FILE           Write the geometry, or the sweep results, as a binary data file\n");
+    printf("  --altitudes A:B:N       Thrust at N standard-atmosphere altitudes from A to B meters\n");
+    printf("  --flow FILE             Write Mach, pressure, temperature, density and velocity at\n");
+    printf("                          every contour point to FILE\n");
+    printf("  --thermal FILE          Write the Bartz heat-transfer coefficient, adiabatic wall\n");
+    printf("                          temperature and heat flux at every contour point to FILE\n");
+    printf("  --wall-temperature K    Hot-gas wall temperature for --thermal and --max-heat-flux\n");
+    printf("                          (default: 800)\n");
+    printf("  --mesh FILE             Write the nozzle surface revolved about its axis to FILE,\n");
+    printf("                          binary STL, or OBJ for a .obj name\n");
+    printf("  --mesh-segments N       Mesh divisions around the axis (default: 128)\n");
+    printf("  --wall-thickness T      Mesh a closed wall T meters thick (default: inner surface only)\n");
+    printf("  --sensitivities         Print the derivatives of thrust, Isp, Cf and exit pressure\n");
+    printf("                          with respect to each input\n");
+    printf("  --points N              Contour points (uniform), or maximum points with --tolerance\n");
+    printf("  --tolerance TOL         Adaptive contour spacing for a radial error of TOL meters\n");
+    printf("  --contour METHOD        bell (default), moc-ideal or moc-truncated\n");
+    printf("  --characteristics N     Characteristics for the moc contours (default: 500)\n");
+    printf("  --sweep NAME=A:B:N      Sweep a parameter over N values from A to B (repeatable,\n");
+    printf("                          comma-separated); NAME is any long option above from\n");
+    printf("                          throat-radius to length-fraction\n");
+    printf("  --optimize NAME=LO:HI   Optimize parameters within bounds (repeatable, comma-separated)\n");
+    printf("  --explore NAME=LO:HI    Pareto front of --objectives within bounds (repeatable,\n");
+    printf("                          comma-separated); --max-evaluations sets the budget\n");
+    printf("                          (default: 100000)\n");
+    printf("  --objectives LIST       Objectives of --explore from isp, cf, thrust, length,\n");
+    printf("                          exit-area and wall-area (default: isp,length,exit-area,wall-area)\n");
+    printf("  --front FILE            Write the --explore front as a binary data file\n");
+    printf("  --uncertain NAME=DIST:A:B\n");
+    printf("                          Monte Carlo analysis with NAME drawn from normal:MEAN:SD or\n");
+    printf("                          uniform:LO:HI (repeatable, comma-separated)\n");
+    printf("  --samples N             Monte Carlo samples (default: 1000000)\n");
+    printf("  --single-precision      Evaluate --uncertain samples with the float batch kernels\n");
+    printf("  --check-precision       Measure the float kernels' error against double over --samples\n");
+    printf("                          random designs\n");
+    printf("  --precision-ranges EMIN:EMAX,GMIN:GMAX,PMIN:PMAX,TMIN:TMAX\n");
+    printf("                          Expansion ratio, gamma, chamber pressure and temperature of\n");
+    printf("                          --check-precision (default: 1.01:10000,1:1.67,1e5:3e7,500:4000)\n");
+    printf("  --seed S                Random seed for --uncertain, --optimize, --explore and\n");
+    printf("                          --check-precision\n");
+    printf("  --objective OBJ         Optimization objective: isp (default) or cf\n");
+    printf("  --max-length L          Constraint: nozzle length at most L meters\n");
+    printf("  --max-exit-diameter D   Constraint: exit diameter at most D meters\n");
+    printf("  --min-pressure-ratio R  Constraint: exit/ambient pressure at least R\n");
+    printf("  --max-pressure-ratio R  Constraint: exit/ambient pressure at most R\n");
+    printf("  --max-heat-flux Q       Constraint: throat heat flux at most Q W/m^2\n");
+    printf("  --max-evaluations N     Optimization evaluation budget (default: 2000)\n");
+    printf("  --population N          Candidates evaluated in parallel per generation\n");
+    printf("  --profile[=FILE]        Report per-stage timings and solver counters, or write\n");
+    printf("                          them to FILE as JSON\n");
+    printf("  --serve[=SOCKET]        Answer JSON requests, one per line, on standard input or a\n");
+    printf("                          Unix domain socket; the other options set the defaults\n");
+    printf("  --batch FILE            Evaluate every case in a CSV or JSON Lines file (- for standard\n");
+    printf("                          input); the other options set the defaults\n");
+    printf("  --batch-output FILE     Results of --batch, in the input's format (default: standard\n");
+    printf("                          output)\n");
+    printf("  --build-surrogate FILE  Tabulate Cf, exit Mach and exit pressure ratio over expansion\n");
+    printf("                          ratio and gamma into FILE, and report the interpolation error\n");
+    printf("  --surrogate-grid EMIN:EMAX:N,GMIN:GMAX:M\n");
+    printf("                          Grid of --build-surrogate (default: 1.5:1000:512,1.1:1.7:128)\n");
+    printf("  --propellant NAME       Chamber temperature, molecular weight and gamma from the\n");
+    printf("                          equilibrium of lox-lh2, lox-ch4 or lox-rp1\n");
+    printf("  --mixture-ratio R       Oxidizer-to-fuel mass ratio for --propellant, or A:B:N for N\n");
+    printf("                          ratios from A to B through a property table (default: 6.0,\n");
+    printf("                          3.6 and 2.6)\n");
+    printf("  --composition MODEL     Gamma of shifting (default) or frozen exhaust composition\n");
+    printf("  --cache FILE            Reuse sweep, optimization and server results stored in FILE,\n");
+    printf("                          and store the new ones there\n");
+    printf("  --cache-size N          Most cached results (default: 1000000); without --cache the\n");
+    printf("                          cache lasts for this run only\n");
+    printf("  --threads N             Worker threads for sweeps, optimization, moc contours and\n");
+    printf("                          large server batches\n");
+    printf("                          (default: all cores)\n");
+    printf("\nExamples:\n");
+    printf("  %s -t 0.005 -e 0.025 -p 2000000\n", program_name);
+    printf("  %s --throat-radius 0.01 --exit-radius 0.05 --output my_nozzle.png\n", program_name);
+    printf("  %s --sweep exit-radius=0.02:0.08:100,gamma=1.2:1.4:21 --threads 8\n", program_name);
+    printf("  %s --sweep exit-radius=0.02:0.08:1000 --binary sweep.ngc\n", program_name);
+    printf("  %s --contour moc-truncated --characteristics 1000 --length-fraction 0.8\n", program_name);
+    printf("  %s --propellant lox-ch4 --mixture-ratio 2.5:4.5:41 -p 1e7\n", program_name);
+    printf("  %s --mesh nozzle.stl --mesh-segments 256 --wall-thickness 0.002\n", program_name);
+    printf("  %s --batch cases.csv --batch-output results.csv --threads 8\n", program_name);
+    printf("  echo '{\"id\":1,\"exit_radius\":0.05}' | %s --serve\n", program_name);
+    printf("  %s --uncertain chamber-pressure=normal:1e6:2e4,throat-radius=uniform:0.0099:0.0101\n", program_name);
+    printf("  %s --explore exit-radius=0.011:0.1,length-fraction=0.6:1 --objectives isp,length --front front.ngc\n", program_name);
+    printf("  %s --optimize exit-radius=0.011:0.1,length-fraction=0.6:1 --max-length 0.1 --min-pressure-ratio 0.4\n", program_name);
+    printf("\n");
+}
+
+// Library diagnostics (files written) are shown on stdout
+static void print_diagnostic(void* user_data, const char* message) {
+    (void)user_data;
+    printf("%s\n", message);
+}
+
+// --profile prints the table; --profile=FILE writes JSON instead
+static void report_profile(const NgcProfile* profile, const char* json_filename) {
+    if (strlen(json_filename) == 0) {
+        ngc_profile_print(stdout, profile);
+        return;
+    }
+
+    FILE* file = fopen(json_filename, "w");
+    if (!file) {
+        printf("Warning: Cannot create profile file %s\n", json_filename);
+        return;
+    }
+    int status = ngc_profile_write_json(file, profile);
+    if (fclose(file) != 0 || status != 0) {
+        printf("Warning: Failed to write profile %s\n", json_filename);
+        return;
+    }
+    printf("Profile written to %s\n", json_filename);
+}
+
+// Set from SIGINT and SIGTERM so the server can remove its socket
+static volatile int server_stop = 0;
+
+static void stop_server(int signal_number) {
+    (void)signal_number;
+    server_stop = 1;
+}
+
+// Standard output carries the responses, so server messages go to stderr
+static void print_server_diagnostic(void* user_data, const char* message) {
+    (void)user_data;
+    fprintf(stderr, "%s\n", message);
+}
+
+// Prints the hit statistics and writes the cache back to its store
+static void finish_cache(FILE* stream, NgcContext* context, NgcCache* cache, const char* cache_filename) {
+    NgcCacheStats stats;
+
+    ngc_cache_stats(cache, &stats);
+    fprintf(stream, "\n=== RESULT CACHE ===\n");
+    fprintf(stream, "Lookups:                 %lld\n", stats.lookups);
+    fprintf(stream, "Hits:                    %lld (%.1f%%)\n", stats.hits, 100.0 * stats.hit_rate);
+    if (stats.mean_lookup_seconds > 0) {
+        fprintf(stream, "Mean lookup time:        %.0f ns\n", stats.mean_lookup_seconds * 1e9);
+    }
+    fprintf(stream, "Entries:                 %lld of %lld (%lld loaded, %lld evicted)\n",
+            stats.entries, stats.capacity, stats.loaded, stats.evictions);
+    if (stats.load_dropped > 0) {
+        fprintf(stream, "Not loaded:              %lld store entries beyond the cache size\n", stats.load_dropped);
+    }
+
+    if (strlen(cache_filename) > 0) {
+        if (ngc_cache_save(context, cache) == 0) {
+            fprintf(stream, "Cache saved to %s\n", cache_filename);
+        } else {
+            fprintf(stream, "Warning: Failed to save the cache: %s\n", ngc_context_error(context));
+        }
+    }
+    ngc_cache_destroy(cache);
+}
+
+static int run_serve_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                          double length_fraction, const char* socket_path, int num_threads, NgcCache* cache) {
+    ServerConfig config = {0};
+    ServerSummary summary;
+    struct sigaction action;
+
+    config.base.throat_radius = nozzle->throat_radius;
+    config.base.exit_radius = nozzle->exit_radius;
+    config.base.length_fraction = length_fraction;
+    config.base.conditions = *conditions;
+    config.socket_path = strlen(socket_path) > 0 ? socket_path : NULL;
+    config.num_threads = num_threads;
+    config.stop = &server_stop;
+    config.cache = cache;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_server;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    context->diagnostic = print_server_diagnostic;
+    if (run_server(context, &config, &summary) != 0) {
+        fprintf(stderr, "Error: %s\n", ngc_context_error(context));
+        return 1;
+    }
+
+    if (config.socket_path) {
+        fprintf(stderr, "Served %lld requests (%lld failed) from %d connections in %lld batches\n",
+                summary.requests, summary.failed_requests, summary.connections, summary.batches);
+    }
+    return 0;
+}
+
+static int run_batch_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                          double length_fraction, const char* input_path, const char* output_path,
+                          int num_threads, NgcCache* cache) {
+    CaseFileConfig config = {0};
+    CaseFileSummary summary;
+
+    config.base.throat_radius = nozzle->throat_radius;
+    config.base.exit_radius = nozzle->exit_radius;
+    config.base.length_fraction = length_fraction;
+    config.base.conditions = *conditions;
+    config.input_path = input_path;
+    config.output_path = strlen(output_path) > 0 ? output_path : NULL;
+    config.num_threads = num_threads;
+    config.cache = cache;
+
+    // Results on standard output push the report to stderr
+    FILE* report = config.output_path ? stdout : stderr;
+    if (!config.output_path) {
+        context->diagnostic = print_server_diagnostic;
+    }
+    if (run_case_file(context, &config, &summary) != 0) {
+        fprintf(report, "Error: %s\n", ngc_context_error(context));
+        return 1;
+    }
+
+    fprintf(report, "=== BATCH FILE SUMMARY ===\n");
+    fprintf(report, "Format:                  %s\n", summary.csv ? "CSV" : "JSON Lines");
+    fprintf(report, "Rows evaluated:          %lld\n", summary.rows - summary.failed_rows);
+    fprintf(report, "Rows failed:             %lld\n", summary.failed_rows);
+    fprintf(report, "Threads:                 %d\n", summary.threads_used);
+    fprintf(report, "Elapsed time:            %.3f s\n", summary.elapsed_seconds);
+    fprintf(report, "Throughput:              %.0f rows/s\n", summary.rows_per_second);
+    return 0;
+}
+
+static int print_sensitivity_table(const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                                   double length_fraction) {
+    NozzleDesign design = { nozzle->throat_radius, nozzle->exit_radius, length_fraction, *conditions };
+    PerformanceSensitivities sensitivities;
+    if (calculate_performance_sensitivities(&design, &sensitivities) != 0) {
+        return -1;
+    }
+
+    // The length fraction does not enter the performance model
+    printf("=== SENSITIVITIES (d output / d input) ===\n");
+    printf("%-20s %13s %13s %13s %13s\n", "Input", "Thrust (N)", "Isp (s)", "Cf", "Pe (Pa)");
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        if (p == SWEEP_LENGTH_FRACTION) {
+            continue;
+        }
+        printf("%-20s", sweep_parameter_name((SweepParameter)p));
+        for (int o = 0; o < SENSITIVITY_NUM_OUTPUTS; o++) {
+            printf(" %13.5e", sensitivities.jacobian[o][p]);
+        }
+        printf("\n");
+    }
+    printf("==========================================\n\n");
+    return 0;
+}
+
+static int print_altitude_table(const NozzleContour* contour, const FlowConditions* conditions,
+                                double start, double stop, int count) {
+    ThrustProfile profile;
+    double* altitudes = malloc((size_t)count * 4 * sizeof(double));
+    unsigned char* separated = malloc((size_t)count);
+    if (!altitudes || !separated || thrust_profile_init(&profile, contour, conditions) != 0) {
+        free(altitudes);
+        free(separated);
+        return -1;
+    }
+
+    AmbientPerformanceOutput output = { altitudes + count, altitudes + 2 * count, altitudes + 3 * count, separated };
+    for (int i = 0; i < count; i++) {
+        altitudes[i] = count > 1 ? start + (stop - start) * i / (count - 1) : start;
+    }
+    thrust_profile_altitudes(&profile, altitudes, &output, (size_t)count);
+
+    printf("=== ALTITUDE PERFORMANCE ===\n");
+    printf("%12s %14s %12s %10s %8s\n", "Altitude (m)", "Ambient (Pa)", "Thrust (N)", "Isp (s)", "Cf");
+    for (int i = 0; i < count; i++) {
+        printf("%12.0f %14.2f %12.2f %10.2f %8.4f%s\n", altitudes[i], standard_atmosphere_pressure(altitudes[i]),
+               output.thrust[i], output.specific_impulse[i], output.thrust_coefficient[i],
+               separated[i] ? "  separated" : "");
+    }
+    printf("Flow separation (Summerfield) above ambient %.0f Pa\n", profile.separation_pressure);
+    printf("============================\n\n");
+
+    free(altitudes);
+    free(separated);
+    return 0;
+}
+
+// Flow state at every contour point, for --flow
+static void write_flow_file(NgcContext* context, const NozzleContour* contour, const FlowConditions* conditions,
+                            const char* filename) {
+    size_t count = (size_t)contour->num_points;
+    double* values = malloc((count > 0 ? count : 1) * 6 * sizeof(double));
+    if (!values) {
+        printf("Warning: Cannot allocate the flow profile\n");
+        return;
+    }
+
+    FlowProfileOutput profile = {
+        values, values + count, values + 2 * count, values + 3 * count, values + 4 * count, values + 5 * count
+    };
+    if (calculate_flow_profile(contour, conditions, &profile) != 0) {
+        printf("Warning: Flow solution failed along the contour\n");
+    } else if (write_flow_profile_data(context, contour, &profile, filename) != 0) {
+        printf("Warning: Failed to write flow profile: %s\n", ngc_context_error(context));
+    }
+    free(values);
+}
+
+// Wall heat transfer at every contour point, for --thermal
+static void write_thermal_file(NgcContext* context, const NozzleContour* contour, const FlowConditions* conditions,
+                               const ThermalConditions* thermal, const char* filename) {
+    size_t count = (size_t)contour->num_points;
+    double* values = malloc((count > 0 ? count : 1) * 3 * sizeof(double));
+    if (!values) {
+        printf("Warning: Cannot allocate the thermal profile\n");
+        return;
+    }
+
+    ThermalProfileOutput profile = { values, values + count, values + 2 * count };
+    ThermalSummary summary;
+    if (calculate_thermal_profile(contour, conditions, thermal, &profile, &summary) != 0) {
+        printf("Warning: Heat-transfer solution failed along the contour\n");
+    } else {
+        printf("Peak heat flux:        %.4e W/m^2 at x = %.6f m\n", summary.peak_heat_flux, summary.peak_x);
+        printf("Wall heat rate:        %.4e W\n", summary.heat_rate);
+        if (write_thermal_profile_data(context, contour, &profile, filename) != 0) {
+            printf("Warning: Failed to write thermal profile: %s\n", ngc_context_error(context));
+        }
+    }
+    free(values);
+}
+
+static int run_sweep_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                          double length_fraction, SweepConfig* config, const char* binary_filename) {
+    SweepSummary summary;
+
+    config->base.throat_radius = nozzle->throat_radius;
+    config->base.exit_radius = nozzle->exit_radius;
+    config->base.length_fraction = length_fraction;
+    config->base.conditions = *conditions;
+
+    printf("Sweep parameters:\n");
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        const SweepRange* range = &config->ranges[p];
+        if (range->count > 0) {
+            printf("  %-20s %g .. %g (%d values)\n", sweep_parameter_name((SweepParameter)p),
+                   range->start, range->stop, range->count);
+        }
+    }
+    printf("  Total cases:         %lld\n\n", sweep_case_count(config));
+
+    // Per-case results are only kept when they are written out
+    if (strlen(binary_filename) > 0) {
+        config->results = malloc((size_t)sweep_case_count(config) * sizeof(PerformanceResults));
+        if (!config->results) {
+            printf("Error: Cannot allocate results for %lld cases\n", sweep_case_count(config));
+            return 1;
+        }
+    }
+
+    if (run_parameter_sweep(config, &summary) != 0) {
+        printf("Error: Parameter sweep failed\n");
+        free(config->results);
+        return 1;
+    }
+
+    printf("=== PARAMETER SWEEP SUMMARY ===\n");
+    printf("Cases evaluated:         %lld\n", summary.completed_cases);
+    printf("Cases rejected:          %lld\n", summary.failed_cases);
+    printf("Threads:                 %d\n", summary.threads_used);
+    printf("Elapsed time:            %.3f s\n", summary.elapsed_seconds);
+    printf("Throughput:              %.0f cases/s\n", summary.cases_per_second);
+
+    if (summary.completed_cases > 0) {
+        printf("\nBest specific impulse case:\n");
+        printf("  Throat radius:       %.6f m\n", summary.best_design.throat_radius);
+        printf("  Exit radius:         %.6f m\n", summary.best_design.exit_radius);
+        printf("  Chamber pressure:    %.0f Pa\n", summary.best_design.conditions.chamber_pressure);
+        printf("  Ambient pressure:    %.0f Pa\n", summary.best_design.conditions.ambient_pressure);
+        printf("  Chamber temperature: %.0f K\n", summary.best_design.conditions.chamber_temperature);
+        printf("  Molecular weight:    %.6f kg/mol\n", summary.best_design.conditions.molecular_weight);
+        printf("  Specific heat ratio: %.3f\n", summary.best_design.conditions.gamma);
+        printf("  Length fraction:     %.3f\n", summary.best_design.length_fraction);
+        print_performance_results(stdout, &summary.best_results);
+    }
+
+    if (config->results) {
+        if (write_sweep_binary(context, config, binary_filename) == 0) {
+            printf("Sweep results written to %s\n", binary_filename);
+        } else {
+            printf("Warning: Failed to write sweep results: %s\n", ngc_context_error(context));
+        }
+        free(config->results);
+        config->results = NULL;
+    }
+
+    return summary.completed_cases > 0 ? 0 : 1;
+}
+
+static int run_optimize_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                             double length_fraction, OptimizeConfig* config) {
+    OptimizeSummary summary;
+    const DesignConstraints* limits = &config->constraints;
+
+    config->base.throat_radius = nozzle->throat_radius;
+    config->base.exit_radius = nozzle->exit_radius;
+    config->base.length_fraction = length_fraction;
+    config->base.conditions = *conditions;
+
+    printf("Optimization parameters:\n");
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        const DesignBound* bound = &config->bounds[p];
+        if (bound->enabled) {
+            printf("  %-20s %g .. %g\n", sweep_parameter_name((SweepParameter)p), bound->lower, bound->upper);
+        }
+    }
+    printf("  Objective:           %s\n",
+           config->objective == OPTIMIZE_THRUST_COEFFICIENT ? "thrust coefficient" : "specific impulse");
+    if (limits->max_length > 0) printf("  Max length:          %.6f m\n", limits->max_length);
+    if (limits->max_exit_diameter > 0) printf("  Max exit diameter:   %.6f m\n", limits->max_exit_diameter);
+    if (limits->min_pressure_ratio > 0) printf("  Min pe/pa:           %.3f\n", limits->min_pressure_ratio);
+    if (limits->max_pressure_ratio > 0) printf("  Max pe/pa:           %.3f\n", limits->max_pressure_ratio);
+    if (limits->max_heat_flux > 0) {
+        printf("  Max heat flux:       %.4e W/m^2 (wall %.1f K)\n", limits->max_heat_flux,
+               config->thermal.wall_temperature);
+    }
+    printf("\n");
+
+    if (run_design_optimization(context, config, &summary) != 0) {
+        printf("Error: %s\n", ngc_context_error(context));
+        return 1;
+    }
+
+    printf("=== DESIGN OPTIMIZATION SUMMARY ===\n");
+    printf("Evaluations:             %d\n", summary.evaluations);
+    printf("Generations:             %d\n", summary.generations);
+    printf("Converged:               %s\n", summary.converged ? "yes" : "no (evaluation budget reached)");
+    printf("Threads:                 %d\n", summary.threads_used);
+    printf("Elapsed time:            %.3f s\n", summary.elapsed_seconds);
+
+    const NozzleDesign* best = &summary.best_design;
+    double ambient = best->conditions.ambient_pressure;
+    printf("\n%s design:\n", summary.feasible ? "Best feasible" : "No feasible design found; least infeasible");
+    printf("  Throat radius:       %.6f m\n", best->throat_radius);
+    printf("  Exit radius:         %.6f m\n", best->exit_radius);
+    printf("  Chamber pressure:    %.0f Pa\n", best->conditions.chamber_pressure);
+    printf("  Ambient pressure:    %.0f Pa\n", ambient);
+    printf("  Chamber temperature: %.0f K\n", best->conditions.chamber_temperature);
+    printf("  Molecular weight:    %.6f kg/mol\n", best->conditions.molecular_weight);
+    printf("  Specific heat ratio: %.3f\n", best->conditions.gamma);
+    printf("  Length fraction:     %.3f\n", best->length_fraction);
+    printf("  Nozzle length:       %.6f m\n", summary.best_length);
+    printf("  Exit diameter:       %.6f m\n", 2.0 * best->exit_radius);
+    if (ambient > 0) {
+        printf("  Exit/ambient press.: %.4f\n", summary.best_results.exit_pressure / ambient);
+    }
+    print_performance_results(stdout, &summary.best_results);
+
+    return summary.feasible ? 0 : 1;
+}
+
+static int run_pareto_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                           double length_fraction, ParetoConfig* config, const char* filename) {
+    config->base.throat_radius = nozzle->throat_radius;
+    config->base.exit_radius = nozzle->exit_radius;
+    config->base.length_fraction = length_fraction;
+    config->base.conditions = *conditions;
+
+    printf("Explored parameters:\n");
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        const DesignBound* bound = &config->bounds[p];
+        if (bound->enabled) {
+            printf("  %-20s %g .. %g\n", sweep_parameter_name((SweepParameter)p), bound->lower, bound->upper);
+        }
+    }
+    printf("  Objectives:         ");
+    for (int o = 0; o < PARETO_NUM_OBJECTIVES; o++) {
+        if (config->objectives[o]) {
+            printf(" %s", pareto_objective_name((ParetoObjective)o));
+        }
+    }
+    printf("\n\n");
+
+    ParetoFront front;
+    ParetoSummary summary;
+    if (run_pareto_exploration(context, config, &front, &summary) != 0) {
+        printf("Error: %s\n", ngc_context_error(context));
+        return 1;
+    }
+
+    printf("=== PARETO FRONT SUMMARY ===\n");
+    printf("Evaluations:             %lld (%lld failed)\n", summary.evaluations, summary.failed);
+    printf("Accepted into archive:   %lld (%lld later dominated)\n", summary.accepted, summary.removed);
+    printf("Front size:              %lld designs (peak %lld, %.1f KB)\n", front.count, summary.peak_size,
+           front.count * sizeof(ParetoPoint) / 1024.0);
+    printf("Rounds:                  %d\n", summary.rounds);
+    printf("Threads:                 %d\n", summary.threads_used);
+    printf("Elapsed time:            %.3f s\n", summary.elapsed_seconds);
+    printf("Throughput:              %.0f designs/s\n\n", summary.evaluations_per_second);
+
+    // Evenly spaced members, in the order of the first objective
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        if (config->bounds[p].enabled) {
+            printf("%16s", sweep_parameter_name((SweepParameter)p));
+        }
+    }
+    printf("%12s %12s %12s %12s %12s\n", "Isp (s)", "Cf", "Length (m)", "Ae (m^2)", "Wall (m^2)");
+    long long rows = front.count < PARETO_PRINT_LIMIT ? front.count : PARETO_PRINT_LIMIT;
+    for (long long r = 0; r < rows; r++) {
+        const ParetoPoint* point = &front.points[rows > 1 ? r * (front.count - 1) / (rows - 1) : 0];
+        for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+            if (config->bounds[p].enabled) {
+                printf("%16.6g", point->parameters[p]);
+            }
+        }
+        printf("%12.2f %12.4f %12.6f %12.4e %12.4e\n", point->specific_impulse, point->thrust_coefficient,
+               point->length, point->exit_area, point->wall_area);
+    }
+
+    int status = 0;
+    if (strlen(filename) > 0 && write_pareto_binary(context, config, &front, filename) != 0) {
+        printf("Error: %s\n", ngc_context_error(context));
+        status = 1;
+    } else if (strlen(filename) > 0) {
+        printf("\nFront written to %s\n", filename);
+    }
+    pareto_front_free(&front);
+    return status;
+}
+
+static int run_uncertainty_mode(const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                                double length_fraction, UncertaintyConfig* config) {
+    UncertaintySummary summary;
+
+    config->base.throat_radius = nozzle->throat_radius;
+    config->base.exit_radius = nozzle->exit_radius;
+    config->base.length_fraction = length_fraction;
+    config->base.conditions = *conditions;
+
+    printf("Uncertain inputs:\n");
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        const UncertainInput* input = &config->inputs[p];
+        if (input->distribution == UNCERTAINTY_NORMAL) {
+            printf("  %-20s normal, mean %g, sd %g\n", sweep_parameter_name((SweepParameter)p), input->a, input->b);
+        } else if (input->distribution == UNCERTAINTY_UNIFORM) {
+            printf("  %-20s uniform, %g .. %g\n", sweep_parameter_name((SweepParameter)p), input->a, input->b);
+        }
+    }
+    printf("  Samples:             %lld\n", config->samples);
+    printf("  Precision:           %s\n\n", config->single_precision ? "single" : "double");
+
+    if (run_uncertainty_analysis(config, &summary) != 0) {
+        printf("Error: Uncertainty analysis failed\n");
+        return 1;
+    }
+
+    printf("=== UNCERTAINTY ANALYSIS SUMMARY ===\n");
+    printf("Samples evaluated:       %lld\n", summary.completed);
+    printf("Samples rejected:        %lld\n", summary.rejected);
+    if (config->single_precision) {
+        printf("Evaluated in double:     %lld (gamma below %g)\n", summary.double_fallback, PRECISION_F32_GAMMA_MIN);
+    }
+    printf("Threads:                 %d\n", summary.threads_used);
+    printf("Elapsed time:            %.3f s\n", summary.elapsed_seconds);
+    printf("Throughput:              %.0f samples/s\n\n", summary.samples_per_second);
+
+    printf("%-20s %12s %12s %12s", "Output", "Mean", "Std dev", "Min");
+    for (int q = 0; q < UNCERTAINTY_NUM_QUANTILES; q++) {
+        char label[16];
+        snprintf(label, sizeof(label), "P%g", 100.0 * uncertainty_quantile_level(q));
+        printf(" %12s", label);
+    }
+    printf(" %12s\n", "Max");
+    for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+        const UncertaintyStatistics* stats = &summary.outputs[o];
+        printf("%-20s %12.6g %12.6g %12.6g", uncertainty_output_name((UncertaintyOutput)o), stats->mean,
+               stats->std_dev, stats->min);
+        for (int q = 0; q < UNCERTAINTY_NUM_QUANTILES; q++) {
+            printf(" %12.6g", stats->quantiles[q]);
+        }
+        printf(" %12.6g\n", stats->max);
+    }
+
+    return 0;
+}
+
+static int run_surrogate_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                              double length_fraction, const SurrogateConfig* config, const char* filename) {
+    printf("Surrogate grid:\n");
+    printf("  Expansion ratio:     %g .. %g, %d nodes (logarithmic)\n", config->expansion_min,
+           config->expansion_max, config->expansion_count);
+    printf("  Gamma:               %g .. %g, %d nodes\n\n", config->gamma_min, config->gamma_max,
+           config->gamma_count);
+
+    double start = ngc_wall_time();
+    CfSurrogate surrogate;
+    if (build_cf_surrogate(context, config, filename) != 0 || cf_surrogate_open(context, &surrogate, filename) != 0) {
+        printf("Error: %s\n", ngc_context_error(context));
+        return 1;
+    }
+    printf("Build time:              %.3f s\n", ngc_wall_time() - start);
+    printf("Table size:              %.1f MB\n\n", surrogate.file.mapping_size / 1.0e6);
+
+    printf("%-20s %14s %14s\n", "Max relative error", "Linear", "Cubic");
+    for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+        printf("%-20s %14.3e %14.3e\n", surrogate_field_name((SurrogateField)f),
+               surrogate.max_error[SURROGATE_LINEAR][f], surrogate.max_error[SURROGATE_CUBIC][f]);
+    }
+
+    // The current design through the table and the exact solver
+    NozzleDesign design = { nozzle->throat_radius, nozzle->exit_radius, length_fraction, *conditions };
+    double expansion_ratio = (nozzle->exit_radius * nozzle->exit_radius) / (nozzle->throat_radius * nozzle->throat_radius);
+    PerformanceResults results;
+    SurrogateResult lookup;
+    if (evaluate_nozzle_design(&design, NULL, &results) == 0 &&
+        cf_surrogate_lookup(&surrogate, SURROGATE_CUBIC, expansion_ratio, conditions->gamma,
+                            conditions->chamber_pressure / conditions->ambient_pressure, &lookup) == 0) {
+        printf("\nThis design:             Cf %.9f exact, %.9f cubic\n", results.thrust_coefficient,
+               lookup.thrust_coefficient);
+    }
+
+    cf_surrogate_close(&surrogate);
+    return 0;
+}
+
+static int run_precision_mode(const PrecisionConfig* config) {
+    PrecisionReport report;
+    if (check_performance_f32(config, &report) != 0) {
+        printf("Error: Precision check failed\n");
+        return 1;
+    }
+
+    printf("=== SINGLE-PRECISION CHECK ===\n");
+    printf("Designs:                 %lld (%lld non-finite), %lld more below gamma %g\n", report.total.samples,
+           report.nonfinite, report.low_gamma.samples, PRECISION_F32_GAMMA_MIN);
+    printf("Kernels:                 %s, %.1f ns/case float, %.1f ns/case double\n",
+           batch_isa_name(config->isa), report.f32_ns_per_case, report.f64_ns_per_case);
+    printf("Threads:                 %d\n", report.threads_used);
+    printf("Elapsed time:            %.3f s\n\n", report.elapsed_seconds);
+
+    printf("%-22s %12s %12s %12s\n", "Max relative error", "Thrust", "Isp", "Cf");
+    for (int b = 0; b <= PRECISION_NUM_BANDS; b++) {
+        const PrecisionBand* band = b < PRECISION_NUM_BANDS ? &report.bands[b] : &report.total;
+        char label[32];
+        snprintf(label, sizeof(label), "%s%.4g .. %.4g", b < PRECISION_NUM_BANDS ? "AR " : "All ",
+                 band->expansion_min, band->expansion_max);
+        printf("%-22s %12.3e %12.3e %12.3e\n", label, band->max_error[PRECISION_THRUST],
+               band->max_error[PRECISION_SPECIFIC_IMPULSE], band->max_error[PRECISION_THRUST_COEFFICIENT]);
+    }
+    printf("%-22s %12.3e %12.3e %12.3e\n", "Mean relative error", report.total.mean_error[PRECISION_THRUST],
+           report.total.mean_error[PRECISION_SPECIFIC_IMPULSE],
+           report.total.mean_error[PRECISION_THRUST_COEFFICIENT]);
+    if (report.low_gamma.samples > 0) {
+        // --single-precision evaluates these designs in double instead
+        const PrecisionBand* low = &report.low_gamma;
+        char label[32];
+        snprintf(label, sizeof(label), "Gamma %.4g .. %.4g", low->gamma_min, low->gamma_max);
+        printf("%-22s %12.3e %12.3e %12.3e  (max; run in double)\n", label, low->max_error[PRECISION_THRUST],
+               low->max_error[PRECISION_SPECIFIC_IMPULSE], low->max_error[PRECISION_THRUST_COEFFICIENT]);
+    }
+    printf("\nContour storage (PointF): %.3e of the throat radius at most\n", report.contour_error);
+
+    const NozzleDesign* worst = &report.worst[PRECISION_THRUST];
+    printf("Worst thrust case:       rt %g m, re %g m, pc %g Pa, pa %g Pa, Tc %g K, Mw %g, gamma %g\n",
+           worst->throat_radius, worst->exit_radius, worst->conditions.chamber_pressure,
+           worst->conditions.ambient_pressure, worst->conditions.chamber_temperature,
+           worst->conditions.molecular_weight, worst->conditions.gamma);
+    return 0;
+}
+
+static void print_chamber_state(Propellant propellant, double mixture_ratio, CompositionModel composition,
+                                const ChamberState* state) {
+    const ChamberProperties* properties = &state->properties;
+    printf("Chamber equilibrium (%s, mixture ratio %.3f):\n", propellant_name(propellant), mixture_ratio);
+    printf("  Temperature:         %.1f K\n", properties->chamber_temperature);
+    printf("  Molecular weight:    %.3f g/mol\n", properties->molecular_weight * 1e3);
+    printf("  Gamma:               %.4f frozen, %.4f shifting (%s used)\n", properties->gamma_frozen,
+           properties->gamma_shifting, composition == COMPOSITION_FROZEN ? "frozen" : "shifting");
+    printf("  Mole fractions:     ");
+    for (int s = 0; s < THERMO_NUM_SPECIES; s++) {
+        if (state->mole_fractions[s] >= 1e-4) {
+            printf(" %s %.4f", thermo_species_name(s), state->mole_fractions[s]);
+        }
+    }
+    printf("\n\n");
+}
+
+// Performance over a range of mixture ratios: the chamber properties come
+// from a propellant table, and the cases run through the batch kernel
+static int run_mixture_mode(NgcContext* context, const NozzleGeometry* nozzle, const FlowConditions* conditions,
+                            const PropellantTableConfig* config, CompositionModel composition) {
+    int count = config->ratio_count;
+    PropellantTableConfig grid = *config;
+    grid.ratio_count = MIXTURE_TABLE_RATIOS;
+    grid.pressure_min = 0.5 * conditions->chamber_pressure;
+    grid.pressure_max = 2.0 * conditions->chamber_pressure;
+    grid.pressure_count = MIXTURE_TABLE_PRESSURES;
+
+    double start = ngc_wall_time();
+    PropellantTable table;
+    if (build_propellant_table(context, &grid, &table) != 0) {
+        printf("Error: %s\n", ngc_context_error(context));
+        return 1;
+    }
+    printf("Propellant table (%s):\n", propellant_name(config->propellant));
+    printf("  Mixture ratio:       %g .. %g, %d nodes\n", grid.ratio_min, grid.ratio_max, grid.ratio_count);
+    printf("  Chamber pressure:    %g .. %g Pa, %d nodes (logarithmic)\n", grid.pressure_min, grid.pressure_max,
+           grid.pressure_count);
+    printf("  Build time:          %.3f s\n", ngc_wall_time() - start);
+    printf("  Max relative error:  T %.1e, Mw %.1e, gamma %.1e frozen, %.1e shifting\n\n",
+           table.max_error.chamber_temperature, table.max_error.molecular_weight, table.max_error.gamma_frozen,
+           table.max_error.gamma_shifting);
+
+    // The mixture ratios, eight batch inputs and nine batch outputs
+    double* storage = malloc((size_t)count * 18 * sizeof(double));
+    if (!storage) {
+        printf("Error: Cannot allocate %d cases\n", count);
+        propellant_table_free(&table);
+        return 1;
+    }
+    double* ratio = storage;
+    double* throat_radius = ratio + count;
+    double* exit_radius = throat_radius + count;
+    double* chamber_pressure = exit_radius + count;
+    double* ambient_pressure = chamber_pressure + count;
+    double* chamber_temperature = ambient_pressure + count;
+    double* molecular_weight = chamber_temperature + count;
+    double* gamma = molecular_weight + count;
+    double* gas_constant = gamma + count;
+    double* results = gas_constant + count;
+    PerformanceBatchOutput output = { results, results + count, results + 2 * (size_t)count,
+                                      results + 3 * (size_t)count, results + 4 * (size_t)count,
+                                      results + 5 * (size_t)count, results + 6 * (size_t)count,
+                                      results + 7 * (size_t)count, results + 8 * (size_t)count };
+
+    FlowConditions flow = *conditions;
+    ChamberProperties properties = {0};
+    chamber_flow_conditions(&properties, composition, &flow);
+    for (int i = 0; i < count; i++) {
+        ratio[i] = count > 1 ? config->ratio_min + (config->ratio_max - config->ratio_min) * i / (count - 1) :
+                               config->ratio_min;
+        throat_radius[i] = nozzle->throat_radius;
+        exit_radius[i] = nozzle->exit_radius;
+        chamber_pressure[i] = conditions->chamber_pressure;
+        ambient_pressure[i] = conditions->ambient_pressure;
+        gas_constant[i] = flow.gas_constant;
+    }
+
+    start = ngc_wall_time();
+    PerformanceBatchInput input = { throat_radius, exit_radius, chamber_pressure, ambient_pressure,
+                                    chamber_temperature, molecular_weight, gamma, gas_constant };
+    int status = propellant_table_conditions(&table, composition, ratio, chamber_pressure, (size_t)count,
+                                             chamber_temperature, molecular_weight, gamma);
+    if (status == 0) {
+        status = calculate_performance_batch(&input, &output, (size_t)count);
+    }
+    double elapsed = ngc_wall_time() - start;
+    if (status != 0) {
+        printf("Error: Mixture-ratio evaluation failed\n");
+        free(storage);
+        propellant_table_free(&table);
+        return 1;
+    }
+
+    int best = 0;
+    for (int i = 1; i < count; i++) {
+        if (output.specific_impulse[i] > output.specific_impulse[best]) {
+            best = i;
+        }
+    }
+    printf("%10s %10s %10s %8s %10s %10s %8s\n", "O/F", "Tc (K)", "Mw (g/mol)", "Gamma", "c* (m/s)", "Isp (s)", "Cf");
+    for (int i = 0; i < count; i++) {
+        if (count > MIXTURE_PRINT_LIMIT && i != best) {
+            continue;
+        }
+        printf("%10.4f %10.1f %10.3f %8.4f %10.1f %10.2f %8.4f%s\n", ratio[i], chamber_temperature[i],
+               molecular_weight[i] * 1e3, gamma[i], output.characteristic_velocity[i], output.specific_impulse[i],
+               output.thrust_coefficient[i], i == best ? "  (best Isp)" : "");
+    }
+    printf("\nEvaluated %d mixture ratios in %.3f ms (%.0f cases/s)\n", count, elapsed * 1e3,
+           elapsed > 0 ? count / elapsed : 0.0);
+
+    free(storage);
+    propellant_table_free(&table);
+    return 0;
+}
+
+// Validates the base design in the parameters that are not varied. Each
+// swept, optimized or explored design is validated on its own, so the
+// varied parameters get stand-in values that pass, with the exit radius
+// kept above a fixed throat radius and the other way round.
+static int validate_fixed_parameters(NgcContext* context, const NozzleGeometry* nozzle,
+                                     const FlowConditions* conditions, const int* varied) {
+    NozzleGeometry fixed_nozzle = *nozzle;
+    FlowConditions fixed = *conditions;
+
+    if (varied[SWEEP_THROAT_RADIUS] && varied[SWEEP_EXIT_RADIUS]) {
+        fixed_nozzle.throat_radius = 1.0;
+        fixed_nozzle.exit_radius = 2.0;
+    } else if (varied[SWEEP_THROAT_RADIUS]) {
+        fixed_nozzle.throat_radius = nozzle->exit_radius > 0 ? 0.5 * nozzle->exit_radius : 1.0;
+    } else if (varied[SWEEP_EXIT_RADIUS]) {
+        fixed_nozzle.exit_radius = 2.0 * nozzle->throat_radius;
+    }
+    if (varied[SWEEP_CHAMBER_PRESSURE]) fixed.chamber_pressure = 1e6;
+    if (varied[SWEEP_AMBIENT_PRESSURE]) fixed.ambient_pressure = 0.0;
+    if (varied[SWEEP_CHAMBER_TEMPERATURE]) fixed.chamber_temperature = 3000.0;
+    if (varied[SWEEP_MOLECULAR_WEIGHT]) fixed.molecular_weight = 0.020;
+    if (varied[SWEEP_GAMMA]) fixed.gamma = 1.3;
+
+    return validate_input_parameters(context, &fixed_nozzle, &fixed);
+}
 
 int main(int argc, char* argv[]) {
     // Default parameters
     NozzleGeometry nozzle = {0};
     FlowConditions conditions = {0};
     PerformanceResults results = {0};
+    NgcContext context;
+    
+    ngc_context_init(&context);
+    context.diagnostic = print_diagnostic;
     
     // Set default values
     nozzle.throat_radius = 0.01;        // 1 cm
@@ -16,11 +932,50 @@ int main(int argc, char* argv[]) {
     conditions.chamber_temperature = 3000; // 3000 K
     conditions.molecular_weight = 0.020;  // 20 g/mol (typical for combustion products)
     conditions.gamma = 1.3;               // Typical for hot gases
-    conditions.gas_constant = 8314.5;     // J/(kmol·K)
+    conditions.gas_constant = 8.314462618; // J/(mol·K), to match the molecular weight in kg/mol
     
     double length_fraction = 0.8;
     char output_filename[MAX_FILENAME] = "nozzle_plot.png";
     char data_filename[MAX_FILENAME] = "";
+    char binary_filename[MAX_FILENAME] = "";
+    char flow_filename[MAX_FILENAME] = "";
+    char thermal_filename[MAX_FILENAME] = "";
+    ThermalConditions thermal = { DEFAULT_WALL_TEMPERATURE, 0.0, 0.0, 0.0 };
+    char mesh_filename[MAX_FILENAME] = "";
+    int sensitivity_mode = 0;
+    char surrogate_filename[MAX_FILENAME] = "";
+    SurrogateConfig surrogate = DEFAULT_SURROGATE_GRID;
+    PropellantTableConfig mixture = { PROPELLANT_NUM, 0.0, 0.0, 0, 0.0, 0.0, 0, 0 };
+    CompositionModel composition = COMPOSITION_SHIFTING;
+    ChamberState chamber_state;
+    MeshOptions mesh_options = { MESH_STL, 0, 0.0, 0 };
+    SweepConfig sweep = {0};
+    int sweep_mode = 0;
+    OptimizeConfig optimize = {0};
+    NgcCache* cache = NULL;
+    char cache_filename[MAX_FILENAME] = "";
+    long long cache_size = 0;
+    int optimize_mode = 0;
+    UncertaintyConfig uncertainty = {0};
+    ParetoConfig pareto = {0};
+    PrecisionConfig precision = {0};
+    int precision_mode = 0;
+    int pareto_mode = 0;
+    char front_filename[MAX_FILENAME] = "";
+    int uncertainty_mode = 0;
+    NgcProfile profile;
+    int profile_mode = 0;
+    int serve_mode = 0;
+    char batch_filename[MAX_FILENAME] = "";
+    char batch_output_filename[MAX_FILENAME] = "";
+    char socket_path[MAX_FILENAME] = "";
+    double altitude_start = 0.0, altitude_stop = 0.0;
+    int altitude_count = 0;
+    char profile_filename[MAX_FILENAME] = "";
+    ContourOptions contour_options = { CONTOUR_UNIFORM, 0, 0.0 };
+    ContourMethod contour_method = CONTOUR_BELL;
+    int status;
+    MocOptions moc_options = { MOC_CONTOUR_IDEAL, DEFAULT_CHARACTERISTICS, 0 };
     
     // Command line options
     static struct option long_options[] = {
@@ -35,6 +990,50 @@ int main(int argc, char* argv[]) {
         {"length-fraction", required_argument, 0, 'l'},
         {"output", required_argument, 0, 'o'},
         {"data", required_argument, 0, 'd'},
+        {"sweep", required_argument, 0, OPT_SWEEP},
+        {"threads", required_argument, 0, OPT_THREADS},
+        {"points", required_argument, 0, OPT_POINTS},
+        {"tolerance", required_argument, 0, OPT_TOLERANCE},
+        {"contour", required_argument, 0, OPT_CONTOUR},
+        {"characteristics", required_argument, 0, OPT_CHARACTERISTICS},
+        {"optimize", required_argument, 0, OPT_OPTIMIZE},
+        {"objective", required_argument, 0, OPT_OBJECTIVE},
+        {"max-length", required_argument, 0, OPT_MAX_LENGTH},
+        {"max-exit-diameter", required_argument, 0, OPT_MAX_EXIT_DIAMETER},
+        {"min-pressure-ratio", required_argument, 0, OPT_MIN_PRESSURE_RATIO},
+        {"max-pressure-ratio", required_argument, 0, OPT_MAX_PRESSURE_RATIO},
+        {"max-evaluations", required_argument, 0, OPT_MAX_EVALUATIONS},
+        {"population", required_argument, 0, OPT_POPULATION},
+        {"binary", required_argument, 0, OPT_BINARY},
+        {"profile", optional_argument, 0, OPT_PROFILE},
+        {"serve", optional_argument, 0, OPT_SERVE},
+        {"altitudes", required_argument, 0, OPT_ALTITUDES},
+        {"cache", required_argument, 0, OPT_CACHE},
+        {"cache-size", required_argument, 0, OPT_CACHE_SIZE},
+        {"flow", required_argument, 0, OPT_FLOW},
+        {"thermal", required_argument, 0, OPT_THERMAL},
+        {"wall-temperature", required_argument, 0, OPT_WALL_TEMPERATURE},
+        {"max-heat-flux", required_argument, 0, OPT_MAX_HEAT_FLUX},
+        {"uncertain", required_argument, 0, OPT_UNCERTAIN},
+        {"samples", required_argument, 0, OPT_SAMPLES},
+        {"seed", required_argument, 0, OPT_SEED},
+        {"batch", required_argument, 0, OPT_BATCH},
+        {"batch-output", required_argument, 0, OPT_BATCH_OUTPUT},
+        {"mesh", required_argument, 0, OPT_MESH},
+        {"mesh-segments", required_argument, 0, OPT_MESH_SEGMENTS},
+        {"wall-thickness", required_argument, 0, OPT_WALL_THICKNESS},
+        {"sensitivities", no_argument, 0, OPT_SENSITIVITIES},
+        {"build-surrogate", required_argument, 0, OPT_BUILD_SURROGATE},
+        {"surrogate-grid", required_argument, 0, OPT_SURROGATE_GRID},
+        {"single-precision", no_argument, 0, OPT_SINGLE_PRECISION},
+        {"check-precision", no_argument, 0, OPT_CHECK_PRECISION},
+        {"precision-ranges", required_argument, 0, OPT_PRECISION_RANGES},
+        {"explore", required_argument, 0, OPT_EXPLORE},
+        {"objectives", required_argument, 0, OPT_OBJECTIVES},
+        {"front", required_argument, 0, OPT_FRONT},
+        {"propellant", required_argument, 0, OPT_PROPELLANT},
+        {"mixture-ratio", required_argument, 0, OPT_MIXTURE_RATIO},
+        {"composition", required_argument, 0, OPT_COMPOSITION},
         {0, 0, 0, 0}
     };
 
@@ -78,6 +1077,259 @@ int main(int argc, char* argv[]) {
                 strncpy(data_filename, optarg, MAX_FILENAME - 1);
                 data_filename[MAX_FILENAME - 1] = '\0';
                 break;
+            case OPT_BINARY:
+                strncpy(binary_filename, optarg, MAX_FILENAME - 1);
+                binary_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_FLOW:
+                strncpy(flow_filename, optarg, MAX_FILENAME - 1);
+                flow_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_THERMAL:
+                strncpy(thermal_filename, optarg, MAX_FILENAME - 1);
+                thermal_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_MESH:
+                strncpy(mesh_filename, optarg, MAX_FILENAME - 1);
+                mesh_filename[MAX_FILENAME - 1] = '\0';
+                mesh_options.format = mesh_format_from_filename(mesh_filename);
+                break;
+            case OPT_MESH_SEGMENTS:
+                mesh_options.segments = atoi(optarg);
+                break;
+            case OPT_WALL_THICKNESS:
+                mesh_options.wall_thickness = atof(optarg);
+                break;
+            case OPT_SENSITIVITIES:
+                sensitivity_mode = 1;
+                break;
+            case OPT_BUILD_SURROGATE:
+                strncpy(surrogate_filename, optarg, MAX_FILENAME - 1);
+                surrogate_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_SURROGATE_GRID:
+                if (sscanf(optarg, "%lf:%lf:%d,%lf:%lf:%d", &surrogate.expansion_min, &surrogate.expansion_max,
+                           &surrogate.expansion_count, &surrogate.gamma_min, &surrogate.gamma_max,
+                           &surrogate.gamma_count) != 6) {
+                    printf("Error: Invalid surrogate grid '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_SINGLE_PRECISION:
+                uncertainty.single_precision = 1;
+                break;
+            case OPT_CHECK_PRECISION:
+                precision_mode = 1;
+                break;
+            case OPT_PRECISION_RANGES:
+                if (sscanf(optarg, "%lf:%lf,%lf:%lf,%lf:%lf,%lf:%lf", &precision.expansion_min,
+                           &precision.expansion_max, &precision.gamma_min, &precision.gamma_max,
+                           &precision.pressure_min, &precision.pressure_max, &precision.temperature_min,
+                           &precision.temperature_max) != 8) {
+                    printf("Error: Invalid precision ranges '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_EXPLORE:
+                if (parse_design_bounds(pareto.bounds, optarg) != 0) {
+                    printf("Error: Invalid exploration bounds '%s'\n", optarg);
+                    return 1;
+                }
+                pareto_mode = 1;
+                break;
+            case OPT_OBJECTIVES:
+                if (parse_pareto_objectives(&pareto, optarg) != 0) {
+                    printf("Error: Invalid objectives '%s' (at least two of isp, cf, thrust, length, "
+                           "exit-area and wall-area)\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_FRONT:
+                strncpy(front_filename, optarg, MAX_FILENAME - 1);
+                front_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_PROPELLANT:
+                if (propellant_from_name(optarg) < 0) {
+                    printf("Error: Unknown propellant '%s'\n", optarg);
+                    return 1;
+                }
+                mixture.propellant = (Propellant)propellant_from_name(optarg);
+                break;
+            case OPT_MIXTURE_RATIO:
+                if (sscanf(optarg, "%lf:%lf:%d", &mixture.ratio_min, &mixture.ratio_max, &mixture.ratio_count) == 3) {
+                    if (!(mixture.ratio_min > 0 && mixture.ratio_max > mixture.ratio_min) || mixture.ratio_count < 2) {
+                        printf("Error: Invalid mixture-ratio range '%s'\n", optarg);
+                        return 1;
+                    }
+                } else {
+                    mixture.ratio_min = atof(optarg);
+                    mixture.ratio_max = mixture.ratio_min;
+                    mixture.ratio_count = 1;
+                    if (!(mixture.ratio_min > 0)) {
+                        printf("Error: Invalid mixture ratio '%s'\n", optarg);
+                        return 1;
+                    }
+                }
+                break;
+            case OPT_COMPOSITION:
+                if (strcmp(optarg, "shifting") == 0) {
+                    composition = COMPOSITION_SHIFTING;
+                } else if (strcmp(optarg, "frozen") == 0) {
+                    composition = COMPOSITION_FROZEN;
+                } else {
+                    printf("Error: Unknown composition model '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_PROFILE:
+                profile_mode = 1;
+                if (optarg) {
+                    strncpy(profile_filename, optarg, MAX_FILENAME - 1);
+                    profile_filename[MAX_FILENAME - 1] = '\0';
+                }
+                break;
+            case OPT_SERVE:
+                serve_mode = 1;
+                if (optarg) {
+                    strncpy(socket_path, optarg, MAX_FILENAME - 1);
+                    socket_path[MAX_FILENAME - 1] = '\0';
+                }
+                break;
+            case OPT_BATCH:
+                strncpy(batch_filename, optarg, MAX_FILENAME - 1);
+                batch_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_BATCH_OUTPUT:
+                strncpy(batch_output_filename, optarg, MAX_FILENAME - 1);
+                batch_output_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_ALTITUDES:
+                if (sscanf(optarg, "%lf:%lf:%d", &altitude_start, &altitude_stop, &altitude_count) != 3 ||
+                    altitude_count < 1) {
+                    printf("Error: Invalid altitude range '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_CACHE:
+                strncpy(cache_filename, optarg, MAX_FILENAME - 1);
+                cache_filename[MAX_FILENAME - 1] = '\0';
+                break;
+            case OPT_CACHE_SIZE:
+                cache_size = atoll(optarg);
+                if (cache_size < 1) {
+                    printf("Error: Invalid cache size '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_SWEEP:
+                if (parse_sweep_range(&sweep, optarg) != 0) {
+                    printf("Error: Invalid sweep specification '%s'\n", optarg);
+                    return 1;
+                }
+                if (sweep_case_count(&sweep) < 0) {
+                    printf("Error: Sweep '%s' has too many cases (the product of the counts overflows)\n", optarg);
+                    return 1;
+                }
+                sweep_mode = 1;
+                break;
+            case OPT_THREADS:
+                sweep.num_threads = atoi(optarg);
+                moc_options.num_threads = sweep.num_threads;
+                optimize.num_threads = sweep.num_threads;
+                uncertainty.num_threads = sweep.num_threads;
+                mesh_options.num_threads = sweep.num_threads;
+                surrogate.num_threads = sweep.num_threads;
+                mixture.num_threads = sweep.num_threads;
+                pareto.num_threads = sweep.num_threads;
+                precision.num_threads = sweep.num_threads;
+                break;
+            case OPT_POINTS:
+                contour_options.num_points = atoi(optarg);
+                break;
+            case OPT_TOLERANCE:
+                contour_options.spacing = CONTOUR_ADAPTIVE;
+                contour_options.tolerance = atof(optarg);
+                break;
+            case OPT_CONTOUR:
+                if (strcmp(optarg, "bell") == 0) {
+                    contour_method = CONTOUR_BELL;
+                } else if (strcmp(optarg, "moc-ideal") == 0) {
+                    contour_method = CONTOUR_MOC_IDEAL;
+                    moc_options.type = MOC_CONTOUR_IDEAL;
+                } else if (strcmp(optarg, "moc-truncated") == 0) {
+                    contour_method = CONTOUR_MOC_TRUNCATED;
+                    moc_options.type = MOC_CONTOUR_TRUNCATED;
+                } else {
+                    printf("Error: Unknown contour method '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_CHARACTERISTICS:
+                moc_options.num_characteristics = atoi(optarg);
+                break;
+            case OPT_OPTIMIZE:
+                if (parse_optimize_bounds(&optimize, optarg) != 0) {
+                    printf("Error: Invalid optimization bounds '%s'\n", optarg);
+                    return 1;
+                }
+                optimize_mode = 1;
+                break;
+            case OPT_UNCERTAIN:
+                if (parse_uncertain_input(&uncertainty, optarg) != 0) {
+                    printf("Error: Invalid uncertain input '%s'\n", optarg);
+                    return 1;
+                }
+                uncertainty_mode = 1;
+                break;
+            case OPT_SAMPLES:
+                uncertainty.samples = atoll(optarg);
+                precision.samples = uncertainty.samples;
+                if (uncertainty.samples <= 0) {
+                    printf("Error: Invalid sample count '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_SEED:
+                uncertainty.seed = strtoull(optarg, NULL, 0);
+                optimize.seed = uncertainty.seed;
+                pareto.seed = uncertainty.seed;
+                precision.seed = uncertainty.seed;
+                break;
+            case OPT_OBJECTIVE:
+                if (strcmp(optarg, "isp") == 0) {
+                    optimize.objective = OPTIMIZE_SPECIFIC_IMPULSE;
+                } else if (strcmp(optarg, "cf") == 0) {
+                    optimize.objective = OPTIMIZE_THRUST_COEFFICIENT;
+                } else {
+                    printf("Error: Unknown objective '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_MAX_LENGTH:
+                optimize.constraints.max_length = atof(optarg);
+                break;
+            case OPT_MAX_EXIT_DIAMETER:
+                optimize.constraints.max_exit_diameter = atof(optarg);
+                break;
+            case OPT_MIN_PRESSURE_RATIO:
+                optimize.constraints.min_pressure_ratio = atof(optarg);
+                break;
+            case OPT_MAX_PRESSURE_RATIO:
+                optimize.constraints.max_pressure_ratio = atof(optarg);
+                break;
+            case OPT_MAX_HEAT_FLUX:
+                optimize.constraints.max_heat_flux = atof(optarg);
+                break;
+            case OPT_WALL_TEMPERATURE:
+                thermal.wall_temperature = atof(optarg);
+                break;
+            case OPT_MAX_EVALUATIONS:
+                optimize.max_evaluations = atoi(optarg);
+                pareto.max_evaluations = atoll(optarg);
+                break;
+            case OPT_POPULATION:
+                optimize.population = atoi(optarg);
+                break;
             case '?':
                 print_usage(argv[0]);
                 return 1;
@@ -86,12 +1338,135 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // A propellant replaces the chamber temperature, molecular weight and
+    // gamma, for every mode; a single mixture ratio is solved exactly here
+    if (mixture.ratio_count > 0 && mixture.propellant == PROPELLANT_NUM) {
+        printf("Error: --mixture-ratio requires --propellant\n");
+        return 1;
+    }
+    if (mixture.propellant != PROPELLANT_NUM && mixture.ratio_count == 0) {
+        mixture.ratio_min = propellant_default_mixture_ratio(mixture.propellant);
+        mixture.ratio_max = mixture.ratio_min;
+        mixture.ratio_count = 1;
+    }
+    if (mixture.ratio_count == 1) {
+        if (calculate_chamber_state(&context, mixture.propellant, mixture.ratio_min, conditions.chamber_pressure,
+                                    &chamber_state) != 0) {
+            printf("Error: %s\n", ngc_context_error(&context));
+            return 1;
+        }
+        chamber_flow_conditions(&chamber_state.properties, composition, &conditions);
+    }
+
+    // Single designs are not cached
+    int batch_mode = strlen(batch_filename) > 0;
+    int cache_mode = serve_mode || batch_mode || sweep_mode || optimize_mode;
+    if (cache_mode && (strlen(cache_filename) > 0 || cache_size > 0)) {
+        cache = ngc_cache_create(&context, cache_size > 0 ? cache_size : DEFAULT_CACHE_SIZE,
+                                 strlen(cache_filename) > 0 ? cache_filename : NULL);
+        if (!cache) {
+            fprintf(serve_mode || batch_mode ? stderr : stdout, "Error: %s\n", ngc_context_error(&context));
+            return 1;
+        }
+        sweep.cache = cache;
+        optimize.cache = cache;
+    }
+
+    // The server writes nothing but responses to stdout; each request is
+    // validated on its own
+    if (serve_mode) {
+        status = run_serve_mode(&context, &nozzle, &conditions, length_fraction, socket_path,
+                                sweep.num_threads, cache);
+        if (cache) {
+            finish_cache(stderr, &context, cache, cache_filename);
+        }
+        return status;
+    }
+    if (batch_mode) {
+        status = run_batch_mode(&context, &nozzle, &conditions, length_fraction, batch_filename,
+                                batch_output_filename, sweep.num_threads, cache);
+        if (cache) {
+            finish_cache(strlen(batch_output_filename) > 0 ? stdout : stderr, &context, cache, cache_filename);
+        }
+        return status;
+    }
+
     printf("=== ROCKET NOZZLE GEOMETRY CALCULATOR ===\n\n");
 
-    // Validate input parameters
-    if (validate_input_parameters(&nozzle, &conditions) != 0) {
+    // Validate input parameters; those a sweep or search varies are checked per design
+    int varied[SWEEP_NUM_PARAMETERS] = {0};
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        varied[p] = (sweep_mode && sweep.ranges[p].count > 0) || (optimize_mode && optimize.bounds[p].enabled) ||
+                    (pareto_mode && pareto.bounds[p].enabled);
+    }
+    if (validate_fixed_parameters(&context, &nozzle, &conditions, varied) != 0) {
+        printf("Error: %s\n", ngc_context_error(&context));
         return 1;
     }
+    printf("Input parameters validated successfully\n");
+    if (mixture.ratio_count > 1) {
+        return run_mixture_mode(&context, &nozzle, &conditions, &mixture, composition);
+    }
+    if (mixture.ratio_count == 1) {
+        printf("\n");
+        print_chamber_state(mixture.propellant, mixture.ratio_min, composition, &chamber_state);
+    }
+
+    if (profile_mode) {
+        if (!ngc_profile_available()) {
+            printf("Error: Profiling is not available in this build\n");
+            return 1;
+        }
+        // A single design is timed exactly; sweeps sample their stage timers.
+        // Sweep workers profile separately and are merged into this profile,
+        // the other modes profile the calling thread
+        ngc_profile_init(&profile, sweep_mode ? 0 : 1);
+        ngc_profile_attach(&profile);
+        sweep.profile = &profile;
+    }
+
+    // The modes other than a single design share one exit, so --profile
+    // reports whichever of them ran
+    int mode_run = 1;
+    if (sweep_mode) {
+        status = run_sweep_mode(&context, &nozzle, &conditions, length_fraction, &sweep, binary_filename);
+        if (cache) {
+            finish_cache(stdout, &context, cache, cache_filename);
+        }
+    } else if (precision_mode) {
+        status = run_precision_mode(&precision);
+    } else if (strlen(surrogate_filename) > 0) {
+        status = run_surrogate_mode(&context, &nozzle, &conditions, length_fraction, &surrogate,
+                                    surrogate_filename);
+    } else if (pareto_mode) {
+        int enabled = 0;
+        for (int o = 0; o < PARETO_NUM_OBJECTIVES; o++) {
+            enabled += pareto.objectives[o];
+        }
+        if (enabled == 0) {
+            parse_pareto_objectives(&pareto, DEFAULT_PARETO_OBJECTIVES);
+        }
+        status = run_pareto_mode(&context, &nozzle, &conditions, length_fraction, &pareto, front_filename);
+    } else if (uncertainty_mode) {
+        if (uncertainty.samples == 0) {
+            uncertainty.samples = DEFAULT_SAMPLES;
+        }
+        status = run_uncertainty_mode(&nozzle, &conditions, length_fraction, &uncertainty);
+    } else if (optimize_mode) {
+        optimize.thermal = thermal;
+        status = run_optimize_mode(&context, &nozzle, &conditions, length_fraction, &optimize);
+        if (cache) {
+            finish_cache(stdout, &context, cache, cache_filename);
+        }
+    } else {
+        mode_run = 0;
+    }
+    if (mode_run) {
+        if (profile_mode) {
+            report_profile(&profile, profile_filename);
+        }
+        return status;
+    }
 
     // Print input parameters
     printf("Input Parameters:\n");
@@ -105,42 +1480,108 @@ int main(int argc, char* argv[]) {
     printf("  Length fraction:     %.3f\n", length_fraction);
     printf("\n");
 
+    // Allocate contour storage: --points sets the count (uniform) or the
+    // upper bound (adaptive)
+    int capacity = contour_options.num_points > 0 ? contour_options.num_points :
+                   contour_options.spacing == CONTOUR_ADAPTIVE ? ADAPTIVE_MAX_POINTS : MAX_POINTS;
+    Point* points = malloc((size_t)capacity * sizeof(Point));
+    NozzleContour contour;
+    if (!points || nozzle_contour_init(&contour, nozzle.throat_radius, nozzle.exit_radius, points, capacity) != 0) {
+        printf("Error: Cannot allocate %d contour points\n", capacity);
+        free(points);
+        return 1;
+    }
+
     // Calculate nozzle geometry
     printf("Calculating nozzle geometry...\n");
-    if (calculate_bell_nozzle_geometry(&nozzle, length_fraction) != 0) {
-        printf("Error: Failed to calculate nozzle geometry\n");
+    MocSummary moc_summary;
+    if (contour_method == CONTOUR_BELL) {
+        status = calculate_bell_nozzle_contour(&contour, length_fraction, &contour_options);
+    } else {
+        status = calculate_moc_nozzle_contour(&context, &contour, &conditions, length_fraction, &moc_options,
+                                              &contour_options, &moc_summary);
+    }
+    if (status != 0 && contour_method == CONTOUR_BELL && contour_options.spacing == CONTOUR_ADAPTIVE) {
+        printf("Error: %d points cannot meet a tolerance of %g m; raise --points or --tolerance\n", capacity,
+               contour_options.tolerance);
+        free(points);
+        return 1;
+    }
+    if (status != 0) {
+        printf("Error: %s\n", contour_method == CONTOUR_BELL ? "Failed to calculate nozzle geometry" :
+               ngc_context_error(&context));
+        free(points);
         return 1;
     }
 
     printf("Nozzle geometry calculated:\n");
-    printf("  Expansion ratio:     %.3f\n", nozzle.expansion_ratio);
-    printf("  Nozzle length:       %.6f m\n", nozzle.exit_x);
-    printf("  Number of points:    %d\n", nozzle.num_points);
+    printf("  Expansion ratio:     %.3f\n", contour.expansion_ratio);
+    printf("  Nozzle length:       %.6f m\n", contour.exit_x);
+    printf("  Number of points:    %d\n", contour.num_points);
+    if (contour_method != CONTOUR_BELL) {
+        printf("  Characteristics:     %d (%d thread%s, %.3f s)\n", moc_options.num_characteristics,
+               moc_summary.threads_used, moc_summary.threads_used == 1 ? "" : "s",
+               moc_summary.elapsed_seconds);
+        printf("  Initial wall angle:  %.3f deg\n", moc_summary.initial_angle * 180.0 / PI);
+        printf("  Exit wall angle:     %.3f deg\n", moc_summary.exit_angle * 180.0 / PI);
+        printf("  Exit wall Mach:      %.4f\n", moc_summary.exit_mach);
+        if (contour_method == CONTOUR_MOC_TRUNCATED && !moc_summary.truncated) {
+            printf("  Note: the ideal contour is already shorter than the length fraction\n");
+        }
+    }
     printf("\n");
 
     // Calculate performance
     printf("Calculating performance...\n");
-    if (calculate_performance(&nozzle, &conditions, &results) != 0) {
+    if (calculate_contour_performance(&contour, &conditions, &results) != 0) {
         printf("Error: Failed to calculate performance\n");
+        free(points);
         return 1;
     }
 
     // Print results
-    print_performance_results(&results);
+    print_performance_results(stdout, &results);
+    if (altitude_count > 0 &&
+        print_altitude_table(&contour, &conditions, altitude_start, altitude_stop, altitude_count) != 0) {
+        printf("Warning: Failed to evaluate the altitude profile\n");
+    }
+    if (sensitivity_mode && print_sensitivity_table(&nozzle, &conditions, length_fraction) != 0) {
+        printf("Warning: Failed to evaluate the sensitivities\n");
+    }
 
     // Generate plot
     printf("Generating nozzle geometry plot...\n");
-    if (plot_nozzle_geometry(&nozzle, output_filename) != 0) {
-        printf("Warning: Failed to generate plot\n");
+    if (plot_nozzle_contour(&context, &contour, output_filename) != 0) {
+        printf("Warning: Failed to generate plot: %s\n", ngc_context_error(&context));
     }
 
     // Write geometry data if requested
     if (strlen(data_filename) > 0) {
-        if (write_geometry_data(&nozzle, data_filename) != 0) {
-            printf("Warning: Failed to write geometry data\n");
+        if (write_contour_data(&context, &contour, data_filename) != 0) {
+            printf("Warning: Failed to write geometry data: %s\n", ngc_context_error(&context));
+        }
+    }
+    if (strlen(flow_filename) > 0) {
+        write_flow_file(&context, &contour, &conditions, flow_filename);
+    }
+    if (strlen(thermal_filename) > 0) {
+        write_thermal_file(&context, &contour, &conditions, &thermal, thermal_filename);
+    }
+    if (strlen(mesh_filename) > 0 && write_nozzle_mesh(&context, &contour, &mesh_options, mesh_filename) != 0) {
+        printf("Warning: Failed to write mesh: %s\n", ngc_context_error(&context));
+    }
+    if (strlen(binary_filename) > 0) {
+        if (write_contour_binary(&context, &contour, binary_filename) == 0) {
+            printf("Binary geometry written to %s\n", binary_filename);
+        } else {
+            printf("Warning: Failed to write binary geometry: %s\n", ngc_context_error(&context));
         }
     }
 
+    free(points);
+    if (profile_mode) {
+        report_profile(&profile, profile_filename);
+    }
     printf("Calculation completed successfully!\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "context.h"
+#include "profile.h"
+#include <string.h>
+
+// Surface mesh of the contour revolved about the x axis. The mesh is made
+// of units: one axial strip of quads around the circumference, or one ring
+// of vertices with the faces behind it for OBJ. A round of units small
+// enough for MESH_ROUND_BYTES is generated in parallel, each unit into its
+// own slot of the round buffer, and the round is written in one call, so
+// the whole mesh is never held in memory.
+//
+// Without a wall thickness the mesh is the open inner wall with normals
+// away from the axis. With one, it is a closed shell: the inner wall faces
+// the axis, an outer wall offset along the contour normal faces away, and
+// annular caps close both ends.
+
+#define MESH_DEFAULT_SEGMENTS 128
+#define MESH_ROUND_BYTES (8 << 20)
+
+#define STL_HEADER_SIZE 80
+#define STL_TRIANGLE_SIZE 50
+
+// Upper bounds of one OBJ line: "v" and three %.9g values, and "f" and
+// three 20-digit indices
+#define OBJ_VERTEX_BYTES 64
+#define OBJ_FACE_BYTES 72
+
+typedef struct {
+    const NozzleContour* contour;
+    MeshFormat format;
+    int segments;
+    int solid;                   // Nonzero with a wall thickness
+    int num_units;
+    const double* ring_cos;
+    const double* ring_sin;
+    const double* outer_x;       // Outer wall profile, when solid
+    const double* outer_r;
+    char* buffer;                // Round buffer
+    const size_t* offsets;       // Start of each unit of the round in buffer
+    size_t* lengths;             // Bytes each unit wrote
+    int first_unit;              // First unit of the round
+} MeshJob;
+
+MeshFormat mesh_format_from_filename(const char* filename) {
+    const char* dot = filename ? strrchr(filename, '.') : NULL;
+    if (dot && (strcmp(dot, ".obj") == 0 || strcmp(dot, ".OBJ") == 0)) {
+        return MESH_OBJ;
+    }
+    return MESH_STL;
+}
+
+static long long mesh_triangle_count(const MeshJob* job) {
+    long long strips = job->contour->num_points - 1;
+    long long per_wall = 2LL * strips * job->segments;
+    return job->solid ? 2 * per_wall + 4LL * job->segments : per_wall;
+}
+
+static long long mesh_vertex_count(const MeshJob* job) {
+    return (long long)job->contour->num_points * job->segments * (job->solid ? 2 : 1);
+}
+
+static void mesh_vertex(const MeshJob* job, int ring, int outer, int segment, double v[3]) {
+    double x = outer ? job->outer_x[ring] : job->contour->points[ring].x;
+    double r = outer ? job->outer_r[ring] : job->contour->points[ring].y;
+    v[0] = x;
+    v[1] = r * job->ring_cos[segment];
+    v[2] = r * job->ring_sin[segment];
+}
+
+// Unit sizes: STL units are strips, plus one for the caps; OBJ units are rings
+static size_t mesh_unit_bytes(const MeshJob* job, int unit) {
+    size_t segments = (size_t)job->segments;
+    size_t walls = job->solid ? 2 : 1;
+    if (job->format == MESH_STL) {
+        size_t triangles = unit < job->contour->num_points - 1 ? 2 * segments * walls : 4 * segments;
+        return triangles * STL_TRIANGLE_SIZE;
+    }
+
+    size_t bytes = segments * walls * OBJ_VERTEX_BYTES;
+    if (unit > 0) {
+        bytes += 2 * segments * walls * OBJ_FACE_BYTES;
+    }
+    if (unit == job->num_units - 1 && job->solid) {
+        bytes += 4 * segments * OBJ_FACE_BYTES;
+    }
+    return bytes;
+}
+
+static char* stl_triangle(char* out, const double a[3], const double b[3], const double c[3]) {
+    double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double w[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    double n[3] = { u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2], u[0] * w[1] - u[1] * w[0] };
+    double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    double scale = length > 0 ? 1.0 / length : 0.0;
+
+    // Binary STL is little-endian, as are the x86 and ARM hosts this targets
+    float values[12] = {
+        (float)(n[0] * scale), (float)(n[1] * scale), (float)(n[2] * scale),
+        (float)a[0], (float)a[1], (float)a[2],
+        (float)b[0], (float)b[1], (float)b[2],
+        (float)c[0], (float)c[1], (float)c[2]
+    };
+    uint16_t attribute = 0;
+    memcpy(out, values, sizeof(values));
+    memcpy(out + sizeof(values), &attribute, sizeof(attribute));
+    return out + STL_TRIANGLE_SIZE;
+}
+
+// Quad a-b-c-d as two triangles; flip reverses the winding
+static char* stl_quad(char* out, const double a[3], const double b[3], const double c[3], const double d[3],
+                      int flip) {
+    if (flip) {
+        out = stl_triangle(out, a, c, b);
+        return stl_triangle(out, a, d, c);
+    }
+    out = stl_triangle(out, a, b, c);
+    return stl_triangle(out, a, c, d);
+}
+
+static char* obj_quad(char* out, long long a, long long b, long long c, long long d, int flip) {
+    if (flip) {
+        out += sprintf(out, "f %lld %lld %lld\nf %lld %lld %lld\n", a, c, b, a, d, c);
+    } else {
+        out += sprintf(out, "f %lld %lld %lld\nf %lld %lld %lld\n", a, b, c, a, c, d);
+    }
+    return out;
+}
+
+// 1-based OBJ index of a vertex; ring k holds its inner, then outer, vertices
+static long long obj_index(const MeshJob* job, int ring, int outer, int segment) {
+    long long per_ring = (long long)job->segments * (job->solid ? 2 : 1);
+    return 1 + ring * per_ring + (long long)outer * job->segments + segment;
+}
+
+// Quads from segment j to j + 1 run a -> b around the axis and b -> c along
+// it, which faces away from the axis (or towards -x for a cap from inner
+// to outer); flip turns them round
+static char* write_stl_unit(const MeshJob* job, int unit, char* out) {
+    int segments = job->segments;
+    double a[3], b[3], c[3], d[3];
+
+    if (unit < job->contour->num_points - 1) {
+        for (int wall = 0; wall < (job->solid ? 2 : 1); wall++) {
+            int flip = job->solid && wall == 0;
+            for (int j = 0; j < segments; j++) {
+                int next = j + 1 < segments ? j + 1 : 0;
+                mesh_vertex(job, unit, wall, j, a);
+                mesh_vertex(job, unit, wall, next, b);
+                mesh_vertex(job, unit + 1, wall, next, c);
+                mesh_vertex(job, unit + 1, wall, j, d);
+                out = stl_quad(out, a, b, c, d, flip);
+            }
+        }
+        return out;
+    }
+
+    // Inlet cap faces -x, exit cap +x
+    int last = job->contour->num_points - 1;
+    for (int end = 0; end < 2; end++) {
+        int ring = end ? last : 0;
+        for (int j = 0; j < segments; j++) {
+            int next = j + 1 < segments ? j + 1 : 0;
+            mesh_vertex(job, ring, 0, j, a);
+            mesh_vertex(job, ring, 0, next, b);
+            mesh_vertex(job, ring, 1, next, c);
+            mesh_vertex(job, ring, 1, j, d);
+            out = stl_quad(out, a, b, c, d, end);
+        }
+    }
+    return out;
+}
+
+static char* write_obj_unit(const MeshJob* job, int ring, char* out) {
+    int segments = job->segments;
+    int walls = job->solid ? 2 : 1;
+    double v[3];
+
+    for (int wall = 0; wall < walls; wall++) {
+        for (int j = 0; j < segments; j++) {
+            mesh_vertex(job, ring, wall, j, v);
+            out += sprintf(out, "v %.9g %.9g %.9g\n", v[0], v[1], v[2]);
+        }
+    }
+
+    // Faces only refer back to rings already written
+    if (ring > 0) {
+        for (int wall = 0; wall < walls; wall++) {
+            int flip = job->solid && wall == 0;
+            for (int j = 0; j < segments; j++) {
+                int next = j + 1 < segments ? j + 1 : 0;
+                out = obj_quad(out, obj_index(job, ring - 1, wall, j), obj_index(job, ring - 1, wall, next),
+                               obj_index(job, ring, wall, next), obj_index(job, ring, wall, j), flip);
+            }
+        }
+    }
+    if (ring == job->num_units - 1 && job->solid) {
+        for (int end = 0; end < 2; end++) {
+            int cap_ring = end ? ring : 0;
+            for (int j = 0; j < segments; j++) {
+                int next = j + 1 < segments ? j + 1 : 0;
+                out = obj_quad(out, obj_index(job, cap_ring, 0, j), obj_index(job, cap_ring, 0, next),
+                               obj_index(job, cap_ring, 1, next), obj_index(job, cap_ring, 1, j), end);
+            }
+        }
+    }
+    return out;
+}
+
+static void mesh_task(long long begin, long long end, int thread_id, void* context) {
+    MeshJob* job = (MeshJob*)context;
+    (void)thread_id;
+
+    for (long long k = begin; k < end; k++) {
+        int unit = job->first_unit + (int)k;
+        char* start = job->buffer + job->offsets[k];
+        char* stop = job->format == MESH_STL ? write_stl_unit(job, unit, start) : write_obj_unit(job, unit, start);
+        job->lengths[k] = (size_t)(stop - start);
+    }
+}
+
+// Outer wall offset by thickness along the contour normal
+static void mesh_outer_profile(const NozzleContour* contour, double thickness, double* outer_x,
+                               double* outer_r) {
+    int n = contour->num_points;
+    for (int i = 0; i < n; i++) {
+        const Point* before = &contour->points[i > 0 ? i - 1 : i];
+        const Point* after = &contour->points[i < n - 1 ? i + 1 : i];
+        double dx = after->x - before->x;
+        double dr = after->y - before->y;
+        double length = hypot(dx, dr);
+        if (!(length > 0)) {
+            dx = 1.0;
+            dr = 0.0;
+            length = 1.0;
+        }
+        outer_x[i] = contour->points[i].x - thickness * dr / length;
+        outer_r[i] = contour->points[i].y + thickness * dx / length;
+    }
+}
+
+static int write_mesh_rounds(NgcContext* context, MeshJob* job, int num_threads, FILE* file,
+                             const char* filename) {
+    size_t* offsets = malloc((size_t)job->num_units * sizeof(size_t));
+    size_t* lengths = malloc((size_t)job->num_units * sizeof(size_t));
+    size_t capacity = MESH_ROUND_BYTES;
+    for (int unit = 0; unit < job->num_units; unit++) {
+        size_t bytes = mesh_unit_bytes(job, unit);
+        if (bytes > capacity) {
+            capacity = bytes;
+        }
+    }
+    char* buffer = malloc(capacity);
+    if (!offsets || !lengths || !buffer) {
+        free(offsets);
+        free(lengths);
+        free(buffer);
+        return ngc_set_error(context, "Cannot allocate the mesh buffers");
+    }
+
+    job->buffer = buffer;
+    job->offsets = offsets;
+    job->lengths = lengths;
+
+    int status = 0;
+    for (int first = 0; first < job->num_units && status == 0;) {
+        // As many units as fit in the round buffer, and at least one
+        int count = 0;
+        size_t used = 0;
+        while (first + count < job->num_units) {
+            size_t bytes = mesh_unit_bytes(job, first + count);
+            if (count > 0 && used + bytes > capacity) {
+                break;
+            }
+            offsets[count++] = used;
+            used += bytes;
+        }
+
+        job->first_unit = first;
+        if (parallel_for(count, 0, num_threads, mesh_task, job) < 0) {
+            status = ngc_set_error(context, "Cannot start the mesh workers");
+            break;
+        }
+
+        // OBJ units are shorter than their bounds; close the gaps
+        size_t length = 0;
+        for (int k = 0; k < count; k++) {
+            if (offsets[k] != length) {
+                memmove(buffer + length, buffer + offsets[k], lengths[k]);
+            }
+            length += lengths[k];
+        }
+        if (fwrite(buffer, 1, length, file) != length) {
+            status = ngc_set_error(context, "Cannot write mesh file %s", filename);
+        }
+        first += count;
+    }
+
+    free(offsets);
+    free(lengths);
+    free(buffer);
+    return status;
+}
+
+static int write_mesh_file(NgcContext* context, MeshJob* job, int num_threads, const char* filename) {
+    long long triangles = mesh_triangle_count(job);
+    if (job->format == MESH_STL && triangles > (long long)UINT32_MAX) {
+        return ngc_set_error(context, "Mesh of %lld triangles is too large for STL", triangles);
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return ngc_set_error(context, "Cannot create mesh file %s", filename);
+    }
+
+    int status = 0;
+    if (job->format == MESH_STL) {
+        // The header must not start with "solid", which marks ASCII STL
+        char header[STL_HEADER_SIZE] = {0};
+        uint32_t count = (uint32_t)triangles;
+        snprintf(header, sizeof(header), "NGC revolved nozzle contour, %d segments", job->segments);
+        if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+            fwrite(&count, sizeof(count), 1, file) != 1) {
+            status = ngc_set_error(context, "Cannot write mesh file %s", filename);
+        }
+    } else if (fprintf(file, "# NGC revolved nozzle contour, %d segments\n# %lld vertices, %lld triangles\n",
+                       job->segments, mesh_vertex_count(job), triangles) < 0) {
+        status = ngc_set_error(context, "Cannot write mesh file %s", filename);
+    }
+
+    if (status == 0) {
+        status = write_mesh_rounds(context, job, num_threads, file, filename);
+    }
+    if (fclose(file) != 0 && status == 0) {
+        status = ngc_set_error(context, "Cannot write mesh file %s", filename);
+    }
+    return status;
+}
+
+int write_nozzle_mesh(NgcContext* context, const NozzleContour* contour, const MeshOptions* options,
+                      const char* filename) {
+    MeshOptions defaults = { MESH_STL, 0, 0.0, 0 };
+    if (!options) {
+        options = &defaults;
+    }
+    if (!contour || !filename || !contour->points || contour->num_points < 2) {
+        return ngc_set_error(context, "A contour with at least two points is required for a mesh");
+    }
+    if (options->segments < 0 || options->segments == 1 || options->segments == 2 ||
+        !(options->wall_thickness >= 0) || (options->format != MESH_STL && options->format != MESH_OBJ)) {
+        return ngc_set_error(context, "Invalid mesh options");
+    }
+
+    MeshJob job;
+    memset(&job, 0, sizeof(job));
+    job.contour = contour;
+    job.format = options->format;
+    job.segments = options->segments > 0 ? options->segments : MESH_DEFAULT_SEGMENTS;
+    job.solid = options->wall_thickness > 0;
+    job.num_units = job.format == MESH_OBJ ? contour->num_points :
+                    contour->num_points - 1 + (job.solid ? 1 : 0);
+
+    size_t n = (size_t)contour->num_points;
+    double* tables = malloc((2 * (size_t)job.segments + (job.solid ? 2 * n : 0)) * sizeof(double));
+    if (!tables) {
+        return ngc_set_error(context, "Cannot allocate the mesh tables");
+    }
+    double* ring_cos = tables;
+    double* ring_sin = tables + job.segments;
+    for (int j = 0; j < job.segments; j++) {
+        double angle = 2.0 * PI * j / job.segments;
+        ring_cos[j] = cos(angle);
+        ring_sin[j] = sin(angle);
+    }
+    job.ring_cos = ring_cos;
+    job.ring_sin = ring_sin;
+    if (job.solid) {
+        double* outer_x = tables + 2 * job.segments;
+        double* outer_r = outer_x + n;
+        mesh_outer_profile(contour, options->wall_thickness, outer_x, outer_r);
+        job.outer_x = outer_x;
+        job.outer_r = outer_r;
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_IO);
+    int status = write_mesh_file(context, &job, options->num_threads, filename);
+    NGC_PROFILE_END(timer);
+    free(tables);
+
+    if (status == 0) {
+        ngc_diagnostic(context, "%s mesh of %lld triangles written to %s",
+                       job.format == MESH_STL ? "STL" : "OBJ", mesh_triangle_count(&job), filename);
+    }
+    return status;
+}
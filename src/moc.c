@@ -0,0 +1,848 @@
+#define _POSIX_C_SOURCE 200809L
+#include "context.h"
+#include "profile.h"
+#include <pthread.h>
+
+// Axisymmetric method of characteristics for a sharp-corner (minimum
+// length) nozzle, in units of the throat radius with the corner at (0, 1).
+//
+// A centred expansion fan of n C- characteristics leaves the corner with
+// flow angles theta_i = theta_max i / n. Point (i, j), j <= i, is where the
+// i-th C- line meets the j-th C+ line; j = i lies on the axis. Along the
+// characteristics
+//
+//   C-:  d(theta + nu) =  sin(theta) sin(mu) ds / y
+//   C+:  d(theta - nu) = -sin(theta) sin(mu) ds / y
+//
+// with sin(mu) = 1/M. Each C+ line is turned straight at the wall, which
+// is built from the last C- line outwards.
+//
+// Point (i, j) needs (i-1, j) and (i, j-1), so every anti-diagonal
+// i + j = d depends only on the previous one. Diagonals are computed in
+// turn, split across threads, with three O(n) buffers indexed by j.
+
+// Minimum characteristics per thread before a wavefront is split
+#define MOC_MIN_PER_THREAD 128
+
+// Coarse fan resolutions (each twice the last) used to extrapolate the
+// corner angle to the requested one
+#define MOC_NUM_LEVELS 3
+static const int moc_levels[MOC_NUM_LEVELS] = { 16, 32, 64 };
+
+// Largest relative correction left to the final rescaling of the wall
+#define MOC_RESCALE_LIMIT 1e-4
+
+// Largest rescaling accepted at all; beyond it the net has not converged on
+// the target and stretching it would no longer give a MOC wall
+#define MOC_RESCALE_MAX 0.02
+
+#define MOC_POINT_TOLERANCE 1e-8
+#define MOC_POINT_ITERATIONS 20
+
+typedef struct {
+    double x;
+    double y;
+    double theta;                // Flow angle (rad)
+    double nu;                   // Prandtl-Meyer angle (rad)
+    double mach;
+} MocPoint;
+
+typedef struct {
+    double gamma;
+    double half_gm1;
+    double pm_scale;             // sqrt((gamma+1)/(gamma-1))
+    double nu_max;               // Prandtl-Meyer angle at infinite Mach
+} MocGas;
+
+typedef struct {
+    const MocGas* gas;
+    int n;
+    int num_threads;
+    const MocPoint* fan;         // Corner states, indexed by C- line
+    MocPoint* front[3];          // Rotating diagonals, indexed by C+ line
+    MocPoint* wall;              // n + 1 wall points
+    pthread_barrier_t barrier;
+    pthread_mutex_t gate_lock;   // Holds workers until num_threads is final
+    pthread_cond_t gate;
+    int released;
+} MocSolve;
+
+typedef struct {
+    MocSolve* solve;
+    int thread_id;
+} MocWorker;
+
+static void moc_gas_init(MocGas* gas, double gamma) {
+    gas->gamma = gamma;
+    gas->half_gm1 = 0.5 * (gamma - 1.0);
+    gas->pm_scale = sqrt((gamma + 1.0) / (gamma - 1.0));
+    gas->nu_max = 0.5 * PI * (gas->pm_scale - 1.0);
+}
+
+static double prandtl_meyer(const MocGas* gas, double mach) {
+    double b = sqrt(mach * mach - 1.0);
+    return gas->pm_scale * atan(b / gas->pm_scale) - atan(b);
+}
+
+// Newton on nu(M) - nu; near M = 1, nu ~ (2/3)(M^2-1)^(3/2) / ((gamma+1)/2)
+static double inverse_prandtl_meyer(const MocGas* gas, double nu, double mach_guess) {
+    if (!(nu > 0.0)) {
+        return 1.0;
+    }
+
+    double m = mach_guess;
+    if (!(m > 1.0)) {
+        m = sqrt(1.0 + pow(1.5 * (gas->gamma + 1.0) * nu, 2.0 / 3.0));
+    }
+
+    for (int iter = 0; iter < 50; iter++) {
+        double f = prandtl_meyer(gas, m) - nu;
+        double df = sqrt(m * m - 1.0) / (m * (1.0 + gas->half_gm1 * m * m));
+        double next = m - f / df;
+
+        if (next <= 1.0) {
+            next = 0.5 * (m + 1.0);
+        }
+        if (fabs(next - m) < 1e-13 * m) {
+            return next;
+        }
+        m = next;
+    }
+    return m;
+}
+
+// One Newton step of inverse_prandtl_meyer, for callers already iterating
+static double prandtl_meyer_step(const MocGas* gas, double nu, double mach) {
+    double b = sqrt(mach * mach - 1.0);
+    double f = gas->pm_scale * atan(b / gas->pm_scale) - atan(b) - nu;
+    double df = b / (mach * (1.0 + gas->half_gm1 * mach * mach));
+    double next = mach - f / df;
+    return next > 1.0 ? next : 0.5 * (mach + 1.0);
+}
+
+// Segment length; the net is in throat radii, so hypot's overflow and
+// underflow care is not needed
+static inline double moc_distance(double dx, double dy) {
+    return sqrt(dx * dx + dy * dy);
+}
+
+// Slope dy/dx = tan(theta +/- mu) of a C+ (sign 1) or C- (sign -1) line
+static double characteristic_slope(double theta, double mach, double sign) {
+    double t = tan(theta);
+    double m = sign / sqrt(mach * mach - 1.0);
+    return (t + m) / (1.0 - t * m);
+}
+
+// Source-term coefficient sin(theta) / (M y) at the mean state of a and b
+static double moc_coefficient(const MocPoint* a, const MocPoint* b) {
+    double y = 0.5 * (a->y + b->y);
+    if (y <= 0.0) {
+        return 0.0;
+    }
+    return sin(0.5 * (a->theta + b->theta)) / (0.5 * (a->mach + b->mach) * y);
+}
+
+static int moc_converged(const MocPoint* a, const MocPoint* b) {
+    return fabs(a->x - b->x) + fabs(a->y - b->y) + fabs(a->theta - b->theta) +
+           fabs(a->nu - b->nu) + fabs(a->mach - b->mach) < MOC_POINT_TOLERANCE;
+}
+
+// Interior point from a (on the same C+ line) and b (on the same C- line).
+// guess, when given, is an estimate of p: the corrector then starts from
+// the mean states instead of from a and b alone, which saves a pass.
+static void moc_interior(const MocGas* gas, const MocPoint* a, const MocPoint* b, const MocPoint* guess,
+                         MocPoint* p) {
+    double ma, mb, coeff_a, coeff_b;
+    if (guess) {
+        *p = *guess;
+        ma = characteristic_slope(0.5 * (a->theta + p->theta), 0.5 * (a->mach + p->mach), 1.0);
+        mb = characteristic_slope(0.5 * (b->theta + p->theta), 0.5 * (b->mach + p->mach), -1.0);
+        coeff_a = moc_coefficient(a, p);
+        coeff_b = moc_coefficient(b, p);
+    } else {
+        ma = characteristic_slope(a->theta, a->mach, 1.0);
+        mb = characteristic_slope(b->theta, b->mach, -1.0);
+        coeff_b = moc_coefficient(b, b);
+        coeff_a = a->y > 0.0 ? moc_coefficient(a, a) : coeff_b;
+    }
+    MocPoint next;
+
+    for (int iter = 0; iter < MOC_POINT_ITERATIONS; iter++) {
+        next.x = (a->y - b->y + mb * b->x - ma * a->x) / (mb - ma);
+        next.y = b->y + mb * (next.x - b->x);
+
+        double ds_a = moc_distance(next.x - a->x, next.y - a->y);
+        double ds_b = moc_distance(next.x - b->x, next.y - b->y);
+        double k_plus = b->theta + b->nu + coeff_b * ds_b;
+        double k_minus = a->theta - a->nu - coeff_a * ds_a;
+
+        next.theta = 0.5 * (k_plus + k_minus);
+        next.nu = 0.5 * (k_plus - k_minus);
+        next.mach = prandtl_meyer_step(gas, next.nu, iter || guess ? p->mach : a->mach);
+
+        if ((iter > 0 || guess) && moc_converged(&next, p)) {
+            *p = next;
+            return;
+        }
+        *p = next;
+
+        // Corrector: characteristic slopes and coefficients at the mean state
+        ma = characteristic_slope(0.5 * (a->theta + p->theta), 0.5 * (a->mach + p->mach), 1.0);
+        mb = characteristic_slope(0.5 * (b->theta + p->theta), 0.5 * (b->mach + p->mach), -1.0);
+        coeff_a = moc_coefficient(a, p);
+        coeff_b = moc_coefficient(b, p);
+    }
+}
+
+// Axis point reached by the C- line through b
+static void moc_axis(const MocGas* gas, const MocPoint* b, MocPoint* p) {
+    double mb = characteristic_slope(b->theta, b->mach, -1.0);
+    double coeff_b = moc_coefficient(b, b);
+    MocPoint next;
+
+    for (int iter = 0; iter < MOC_POINT_ITERATIONS; iter++) {
+        next.x = b->x - b->y / mb;
+        next.y = 0.0;
+        next.theta = 0.0;
+        next.nu = b->theta + b->nu + coeff_b * moc_distance(next.x - b->x, b->y);
+        next.mach = prandtl_meyer_step(gas, next.nu, iter ? p->mach : b->mach);
+
+        if (iter > 0 && moc_converged(&next, p)) {
+            *p = next;
+            return;
+        }
+        *p = next;
+
+        mb = characteristic_slope(0.5 * b->theta, 0.5 * (b->mach + p->mach), -1.0);
+        coeff_b = moc_coefficient(b, p);
+    }
+}
+
+// Wall point where the C+ line through p meets the wall leaving w; the
+// flow there is turned to the C+ line's angle so it is not reflected
+static void moc_wall(const MocGas* gas, const MocPoint* p, const MocPoint* w, MocPoint* out) {
+    double theta_wall = p->theta;
+    double mp = characteristic_slope(p->theta, p->mach, 1.0);
+    double slope_w = tan(0.5 * (w->theta + theta_wall));
+    double coeff_p = moc_coefficient(p, p);
+    MocPoint next;
+
+    for (int iter = 0; iter < MOC_POINT_ITERATIONS; iter++) {
+        next.x = (p->y - w->y + slope_w * w->x - mp * p->x) / (slope_w - mp);
+        next.y = w->y + slope_w * (next.x - w->x);
+        next.theta = theta_wall;
+        next.nu = theta_wall - (p->theta - p->nu - coeff_p * moc_distance(next.x - p->x, next.y - p->y));
+        next.mach = prandtl_meyer_step(gas, next.nu, iter ? out->mach : p->mach);
+
+        if (iter > 0 && moc_converged(&next, out)) {
+            *out = next;
+            return;
+        }
+        *out = next;
+
+        mp = characteristic_slope(0.5 * (p->theta + theta_wall), 0.5 * (p->mach + out->mach), 1.0);
+        coeff_p = moc_coefficient(p, out);
+    }
+}
+
+static void moc_diagonal(MocSolve* solve, int d, int thread_id) {
+    int n = solve->n;
+    int first = d - n > 1 ? d - n : 1;
+    int last = d / 2;
+    int span = last - first + 1;
+    int begin = first + (int)((long long)span * thread_id / solve->num_threads);
+    int end = first + (int)((long long)span * (thread_id + 1) / solve->num_threads);
+    const MocPoint* previous = solve->front[(d - 1) % 3];
+    const MocPoint* older = solve->front[(d - 2) % 3];
+    MocPoint* current = solve->front[d % 3];
+
+    for (int j = begin; j < end; j++) {
+        int i = d - j;
+        const MocPoint* a = &previous[j];
+        const MocPoint* b = j == 1 ? &solve->fan[i] : &previous[j - 1];
+
+        if (j == i) {
+            moc_axis(solve->gas, b, &current[j]);
+            continue;
+        }
+
+        // The net is smooth away from the corner, so (i, j) is close to
+        // the fourth corner of the parallelogram (i-1, j), (i, j-1), (i-1, j-1)
+        const MocPoint* c = j == 1 ? &solve->fan[i - 1] : &older[j - 1];
+        MocPoint guess;
+        guess.x = a->x + b->x - c->x;
+        guess.y = a->y + b->y - c->y;
+        guess.theta = a->theta + b->theta - c->theta;
+        guess.nu = a->nu + b->nu - c->nu;
+        guess.mach = a->mach + b->mach - c->mach;
+        int usable = d > 3 && guess.mach > 1.0 && guess.y >= 0.0 && isfinite(guess.x);
+        moc_interior(solve->gas, a, b, usable ? &guess : NULL, &current[j]);
+    }
+}
+
+// Wall point j comes from (n, j), which lies on diagonal n + j
+static void moc_wall_point(MocSolve* solve, int j) {
+    const MocPoint* p = &solve->front[(solve->n + j) % 3][j];
+    moc_wall(solve->gas, p, &solve->wall[j - 1], &solve->wall[j]);
+}
+
+static void moc_sweep(MocSolve* solve, int thread_id) {
+    int n = solve->n;
+
+    for (int d = 2; d <= 2 * n; d++) {
+        moc_diagonal(solve, d, thread_id);
+
+        // The previous diagonal is read-only until the next barrier, so its
+        // wall point is built while the others work on this one
+        if (thread_id == 0 && d - 1 > n) {
+            moc_wall_point(solve, d - 1 - n);
+        }
+        if (solve->num_threads > 1) {
+            pthread_barrier_wait(&solve->barrier);
+        }
+    }
+
+    if (thread_id == 0) {
+        moc_wall_point(solve, n);
+    }
+}
+
+static void* moc_worker(void* arg) {
+    MocWorker* worker = (MocWorker*)arg;
+    MocSolve* solve = worker->solve;
+
+    pthread_mutex_lock(&solve->gate_lock);
+    while (!solve->released) {
+        pthread_cond_wait(&solve->gate, &solve->gate_lock);
+    }
+    pthread_mutex_unlock(&solve->gate_lock);
+
+    moc_sweep(solve, worker->thread_id);
+    return NULL;
+}
+
+// Starts workers 1..num_threads-1 behind the gate; if some fail to start the
+// wavefront is split over the ones that did. Returns the number started.
+static int moc_start_workers(MocSolve* solve, pthread_t* threads, MocWorker* workers) {
+    int started = 1;
+
+    solve->released = 0;
+    pthread_mutex_init(&solve->gate_lock, NULL);
+    pthread_cond_init(&solve->gate, NULL);
+
+    for (int t = 1; t < solve->num_threads; t++) {
+        workers[t].solve = solve;
+        workers[t].thread_id = t;
+        if (pthread_create(&threads[t], NULL, moc_worker, &workers[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    solve->num_threads = started;
+    if (started > 1) {
+        pthread_barrier_init(&solve->barrier, NULL, (unsigned)started);
+    }
+
+    pthread_mutex_lock(&solve->gate_lock);
+    solve->released = 1;
+    pthread_cond_broadcast(&solve->gate);
+    pthread_mutex_unlock(&solve->gate_lock);
+    return started;
+}
+
+// Runs one characteristic net; wall receives n + 1 points from the corner and
+// threads_used the number of wavefront threads that ran it
+static int moc_solve_net(const MocGas* gas, double theta_max, int n, int num_threads, MocPoint* wall,
+                         int* threads_used) {
+    MocPoint* storage = malloc((size_t)(4 * (n + 1)) * sizeof(MocPoint));
+    if (!storage) {
+        return -1;
+    }
+
+    MocSolve solve;
+    solve.gas = gas;
+    solve.n = n;
+    solve.fan = storage;
+    solve.front[0] = storage + (n + 1);
+    solve.front[1] = storage + 2 * (n + 1);
+    solve.front[2] = storage + 3 * (n + 1);
+    solve.wall = wall;
+
+    // Corner states; fan[0] is the sonic line
+    for (int i = 0; i <= n; i++) {
+        MocPoint* corner = &storage[i];
+        corner->x = 0.0;
+        corner->y = 1.0;
+        corner->theta = theta_max * i / n;
+        corner->nu = corner->theta;
+        corner->mach = inverse_prandtl_meyer(gas, corner->nu, i > 0 ? storage[i - 1].mach : 0.0);
+    }
+    wall[0] = storage[n];
+
+    int max_threads = n / MOC_MIN_PER_THREAD;
+    solve.num_threads = num_threads < max_threads ? num_threads : max_threads;
+    if (solve.num_threads < 1) {
+        solve.num_threads = 1;
+    }
+
+    pthread_t* threads = NULL;
+    MocWorker* workers = NULL;
+    int started = 1;
+
+    if (solve.num_threads > 1) {
+        threads = calloc((size_t)solve.num_threads, sizeof(pthread_t));
+        workers = calloc((size_t)solve.num_threads, sizeof(MocWorker));
+        if (threads && workers) {
+            started = moc_start_workers(&solve, threads, workers);
+        } else {
+            solve.num_threads = 1;
+        }
+    }
+
+    moc_sweep(&solve, 0);
+
+    if (threads && workers) {
+        for (int t = 1; t < started; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        if (started > 1) {
+            pthread_barrier_destroy(&solve.barrier);
+        }
+        pthread_mutex_destroy(&solve.gate_lock);
+        pthread_cond_destroy(&solve.gate);
+    }
+    free(threads);
+    free(workers);
+    free(storage);
+    *threads_used = solve.num_threads;
+
+    for (int j = 1; j <= n; j++) {
+        if (!isfinite(wall[j].x) || !isfinite(wall[j].y) || wall[j].x <= wall[j - 1].x) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    const MocGas* gas;
+    int n;
+    int num_threads;
+    int threads_used;            // Threads that ran the most recent net
+    MocPoint* wall;              // Holds the most recent net's wall
+    double exit_radius;          // Exit radius in throat radii
+    double length;               // Truncated length in throat radii
+    double cone_length;          // 15-degree cone length in throat radii
+    NgcContext* context;
+} MocTarget;
+
+// Residuals increase with theta_max; NaN means the net broke down, which
+// only happens when theta_max is too large
+typedef double (*MocResidual)(MocTarget* target, double theta_max);
+
+// First x at which the wall reaches radius, or INFINITY if it never does
+static double moc_crossing(const MocPoint* wall, int n, double radius) {
+    for (int j = 1; j <= n; j++) {
+        if (wall[j].y >= radius) {
+            double t = (radius - wall[j - 1].y) / (wall[j].y - wall[j - 1].y);
+            return wall[j - 1].x + t * (wall[j].x - wall[j - 1].x);
+        }
+    }
+    return INFINITY;
+}
+
+static double moc_ideal_residual(MocTarget* target, double theta_max) {
+    if (moc_solve_net(target->gas, theta_max, target->n, target->num_threads, target->wall,
+                      &target->threads_used) != 0) {
+        return NAN;
+    }
+    return target->wall[target->n].y - target->exit_radius;
+}
+
+static double moc_truncated_residual(MocTarget* target, double theta_max) {
+    if (moc_solve_net(target->gas, theta_max, target->n, target->num_threads, target->wall,
+                      &target->threads_used) != 0) {
+        return NAN;
+    }
+    return target->length - moc_crossing(target->wall, target->n, target->exit_radius);
+}
+
+// Brackets the root geometrically from guess, then refines it by the
+// Illinois variant of regula falsi, bisecting when a residual is not finite.
+// A residual that is not finite counts as positive, so a root past the angle
+// where the net breaks down is refined onto that angle instead; -1 is then
+// returned with *theta_max the largest angle with a finite residual. When
+// no bracket is found at all, -1 is returned with *theta_max set to NAN.
+static int moc_find_angle(MocResidual residual, MocTarget* target, double guess, double lower,
+                          double upper, double tolerance, double* theta_max) {
+    double a = guess;
+    double fa = residual(target, a);
+    double b = a;
+    double fb = fa;
+
+    for (int iter = 0; iter < 100; iter++) {
+        if (fa < 0.0) {
+            b = a * 1.25 < 0.5 * (a + upper) ? a * 1.25 : 0.5 * (a + upper);
+        } else {
+            b = a / 1.25 > 0.5 * (a + lower) ? a / 1.25 : 0.5 * (a + lower);
+        }
+        fb = residual(target, b);
+        if ((fa < 0.0) != (fb < 0.0)) {
+            break;
+        }
+        a = b;
+        fa = fb;
+        if (iter == 99) {
+            *theta_max = NAN;
+            return -1;
+        }
+    }
+
+    // Order the bracket so that f(lo) < 0 <= f(hi)
+    double lo = fa < 0.0 ? a : b, f_lo = fa < 0.0 ? fa : fb;
+    double hi = fa < 0.0 ? b : a, f_hi = fa < 0.0 ? fb : fa;
+    int side = 0;
+
+    for (int iter = 0; iter < 200; iter++) {
+        double mid;
+        if (isfinite(f_lo) && isfinite(f_hi)) {
+            mid = lo - f_lo * (hi - lo) / (f_hi - f_lo);
+        } else {
+            mid = 0.5 * (lo + hi);
+        }
+        if (!(mid > lo && mid < hi)) {
+            mid = 0.5 * (lo + hi);
+        }
+
+        double f_mid = residual(target, mid);
+        if (fabs(f_mid) <= tolerance || hi - lo <= 1e-14 * hi) {
+            *theta_max = isfinite(f_mid) && isfinite(f_hi) ? mid : lo;
+            return isfinite(f_mid) && isfinite(f_hi) ? 0 : -1;
+        }
+
+        if (f_mid < 0.0) {
+            lo = mid;
+            f_lo = f_mid;
+            if (side == -1) f_hi *= 0.5;
+            side = -1;
+        } else {
+            hi = mid;
+            f_hi = f_mid;
+            if (side == 1) f_lo *= 0.5;
+            side = 1;
+        }
+    }
+    *theta_max = NAN;
+    return -1;
+}
+
+// Corner angle of the ideal contour and, for truncated contours, of the
+// truncated one, at fan resolution target->n
+static int moc_design_angles(MocTarget* target, double guess, int truncated,
+                             double* ideal_angle, double* truncated_angle) {
+    double upper = target->gas->nu_max / 2;
+    double tolerance = 1e-10 * target->exit_radius;
+
+    if (moc_find_angle(moc_ideal_residual, target, guess, 1e-6, upper, tolerance, ideal_angle) != 0) {
+        return ngc_set_error(target->context, "No corner angle gives an ideal MOC contour with exit radius "
+                             "%.4g throat radii on a %d-characteristic net", target->exit_radius, target->n);
+    }
+    *truncated_angle = *ideal_angle;
+    if (!truncated) {
+        return 0;
+    }
+
+    // Already short enough without truncation
+    moc_ideal_residual(target, *ideal_angle);
+    if (target->wall[target->n].x <= target->length) {
+        return 0;
+    }
+    if (moc_find_angle(moc_truncated_residual, target, *ideal_angle * 1.05, *ideal_angle, upper,
+                       1e-10 * target->length, truncated_angle) == 0) {
+        return 0;
+    }
+    if (isnan(*truncated_angle)) {
+        return ngc_set_error(target->context, "No corner angle gives a truncated MOC contour %.4g throat "
+                             "radii long on a %d-characteristic net", target->length, target->n);
+    }
+
+    // The wall shortens as the corner angle grows, until the net breaks down
+    double shortest = target->length - moc_truncated_residual(target, *truncated_angle);
+    return ngc_set_error(target->context, "Length fraction %.3g is too short for a truncated MOC contour: "
+                         "the characteristic net breaks down above a %.2f deg corner angle, where the "
+                         "contour is still about %.3g of the cone length", target->length / target->cone_length,
+                         *truncated_angle * 180.0 / PI, shortest / target->cone_length);
+}
+
+// Richardson extrapolation of values at three doubling resolutions, with
+// the order of convergence estimated from the values themselves
+static double moc_extrapolate(const double* values, int finest, int n) {
+    double e1 = values[0] - values[1];
+    double e2 = values[1] - values[2];
+    double q = e1 != 0.0 ? e2 / e1 : 0.0;
+
+    if (!(q > 0.0 && q < 1.0)) {
+        return values[2];
+    }
+    double order = -log(q) / log(2.0);
+    return values[2] - e2 * q / (1.0 - q) * (1.0 - pow((double)finest / n, order));
+}
+
+// The corner angle converges slowly with the fan resolution (roughly like
+// n^-0.7), so it is searched for on coarse nets and extrapolated to n. The
+// slope of the residual on the finest coarse net is returned for a Newton
+// correction on the full net.
+static int moc_contour_angles(MocTarget* target, double guess, int truncated,
+                              double* ideal_angle, double* theta_max, double* slope) {
+    int n = target->n;
+    double ideal[MOC_NUM_LEVELS], theta[MOC_NUM_LEVELS];
+
+    *slope = 0.0;
+    if (n <= moc_levels[MOC_NUM_LEVELS - 1]) {
+        return moc_design_angles(target, guess, truncated, ideal_angle, theta_max);
+    }
+
+    for (int level = 0; level < MOC_NUM_LEVELS; level++) {
+        target->n = moc_levels[level];
+        if (moc_design_angles(target, level ? ideal[level - 1] : guess, truncated,
+                              &ideal[level], &theta[level]) != 0) {
+            target->n = n;
+            return -1;
+        }
+    }
+
+    int last = MOC_NUM_LEVELS - 1;
+    double step = 1e-4 * theta[last];
+    MocResidual residual = theta[last] > ideal[last] ? moc_truncated_residual : moc_ideal_residual;
+    *slope = residual(target, theta[last] + step) / step;
+    target->n = n;
+
+    *ideal_angle = moc_extrapolate(ideal, moc_levels[last], n);
+    *theta_max = theta[last] > ideal[last] ? moc_extrapolate(theta, moc_levels[last], n) : *ideal_angle;
+    if (*theta_max < *ideal_angle) {
+        *theta_max = *ideal_angle;
+    }
+    return 0;
+}
+
+typedef struct {
+    const Point* points;
+    const double* second_derivative;
+    int count;
+} MocWallCurve;
+
+static double moc_wall_radius(const void* context, double x, double* second_derivative) {
+    const MocWallCurve* curve = (const MocWallCurve*)context;
+    int lo = 0, hi = curve->count - 1;
+
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (curve->points[mid].x <= x) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    double span = curve->points[hi].x - curve->points[lo].x;
+    double t = span > 0 ? (x - curve->points[lo].x) / span : 0.0;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+
+    if (second_derivative) {
+        *second_derivative = curve->second_derivative[lo] +
+                             t * (curve->second_derivative[hi] - curve->second_derivative[lo]);
+    }
+    return curve->points[lo].y + t * (curve->points[hi].y - curve->points[lo].y);
+}
+
+static int moc_nozzle_contour(NgcContext* context, NozzleContour* contour, const FlowConditions* conditions,
+                              double length_fraction, const MocOptions* options,
+                              const ContourOptions* sampling, MocSummary* summary) {
+    if (!contour || !conditions || !options) {
+        return ngc_set_error(context, "Null pointer passed to calculate_moc_nozzle_contour");
+    }
+    if (!(conditions->gamma > 1.0)) {
+        return ngc_set_error(context, "MOC contours need a specific heat ratio above 1 (got %g)",
+                             conditions->gamma);
+    }
+    if (contour->throat_radius <= 0 || contour->exit_radius <= contour->throat_radius) {
+        return ngc_set_error(context, "MOC contours need an exit radius larger than a positive throat radius");
+    }
+    if (options->num_characteristics < 2) {
+        return ngc_set_error(context, "MOC contours need at least 2 characteristics (got %d)",
+                             options->num_characteristics);
+    }
+
+    int truncated = options->type == MOC_CONTOUR_TRUNCATED;
+    if (truncated && (length_fraction <= 0 || length_fraction > 1.0)) {
+        return ngc_set_error(context, "Length fraction must be in (0, 1] (got %g)", length_fraction);
+    }
+
+    double start = ngc_wall_time();
+    int n = options->num_characteristics;
+    int num_threads = options->num_threads > 0 ? options->num_threads : ngc_cpu_count();
+    double throat_radius = contour->throat_radius;
+    double exit_radius = contour->exit_radius / throat_radius;
+
+    MocGas gas;
+    moc_gas_init(&gas, conditions->gamma);
+
+    // Same reference length as the parabolic bell: a 15-degree cone
+    double conical_length = (exit_radius - 1.0) / tan(15.0 * PI / 180.0);
+    MocTarget target = { &gas, n, num_threads, 1, NULL, exit_radius, conical_length * length_fraction,
+                         conical_length, context };
+
+    // Half the exit Prandtl-Meyer angle is the planar minimum-length value,
+    // which is close enough to bracket the axisymmetric one
+    AreaMachSolver solver;
+    double exit_mach = 0.0;
+    area_mach_solver_init(&solver, conditions->gamma);
+    if (solve_area_mach(&solver, exit_radius * exit_radius, 1, 0.0, &exit_mach, NULL) != 0) {
+        return ngc_set_error(context, "Cannot solve for the exit Mach number at expansion ratio %g",
+                             exit_radius * exit_radius);
+    }
+    double guess = 0.5 * prandtl_meyer(&gas, exit_mach);
+
+    MocPoint* wall = malloc((size_t)(n + 1) * sizeof(MocPoint));
+    Point* points = malloc((size_t)(n + 2) * sizeof(Point));
+    double* curvature = malloc((size_t)(n + 2) * sizeof(double));
+    if (!wall || !points || !curvature) {
+        free(wall);
+        free(points);
+        free(curvature);
+        return ngc_set_error(context, "Cannot allocate a %d-characteristic net", n);
+    }
+    target.wall = wall;
+
+    double ideal_angle, theta_max, slope;
+    int status = moc_contour_angles(&target, guess, truncated, &ideal_angle, &theta_max, &slope);
+
+    // The full net usually lands close enough for the final rescaling below;
+    // otherwise take one Newton step with the coarse slope. The step may move
+    // an ideal angle either way, so the mode is fixed before it.
+    int cut = status == 0 && theta_max > ideal_angle;
+    MocResidual residual = cut ? moc_truncated_residual : moc_ideal_residual;
+    double scale = cut ? target.length : exit_radius;
+    double r = status == 0 ? residual(&target, theta_max) : NAN;
+    if (isfinite(r) && fabs(r) > MOC_RESCALE_LIMIT * scale && slope > 0.0) {
+        theta_max -= r / slope;
+        r = residual(&target, theta_max);
+    }
+    if (isnan(r)) {
+        if (status == 0) {
+            ngc_set_error(context, "The %d-characteristic net breaks down at a %.2f deg corner angle%s", n,
+                          theta_max * 180.0 / PI,
+                          cut ? "; the length fraction is too close to the shortest truncated contour" : "");
+        }
+        free(wall);
+        free(points);
+        free(curvature);
+        return -1;
+    }
+
+    // Truncated contours are cut at the exit radius. An ideal wall is kept
+    // whole: it is nearly flat at the end, so cutting it where it overshoots
+    // would shorten it far more than rescaling its radius does.
+    int count = 0;
+    for (int j = 0; j <= n; j++) {
+        if (cut && j > 0 && wall[j].y >= exit_radius) {
+            double t = (exit_radius - wall[j - 1].y) / (wall[j].y - wall[j - 1].y);
+            points[count].x = wall[j - 1].x + t * (wall[j].x - wall[j - 1].x);
+            points[count].y = exit_radius;
+            count++;
+            break;
+        }
+        points[count].x = wall[j].x;
+        points[count].y = wall[j].y;
+        count++;
+    }
+    double exit_angle = count <= n ? wall[count - 1].theta : wall[n].theta;
+    double wall_exit_mach = count <= n ? wall[count - 1].mach : wall[n].mach;
+
+    // Remove the residual discretisation error so the wall ends exactly at
+    // the requested radius (and, when truncated, the requested length)
+    double end_y = points[count - 1].y;
+    double end_x = points[count - 1].x;
+    double x_scale = cut ? target.length / end_x : 1.0;
+    double y_scale = (exit_radius - 1.0) / (end_y - 1.0);
+    if (!(fabs(x_scale - 1.0) <= MOC_RESCALE_MAX && fabs(y_scale - 1.0) <= MOC_RESCALE_MAX)) {
+        int length_miss = fabs(x_scale - 1.0) > fabs(y_scale - 1.0);
+        ngc_set_error(context, "The characteristic net missed the exit %s by %.2f%% (more than %.0f%%); "
+                      "try more characteristics", length_miss ? "length" : "radius",
+                      100.0 * fabs((length_miss ? x_scale : y_scale) - 1.0), 100.0 * MOC_RESCALE_MAX);
+        free(wall);
+        free(points);
+        free(curvature);
+        return -1;
+    }
+
+    for (int k = 0; k < count; k++) {
+        points[k].x *= x_scale * throat_radius;
+        points[k].y = (1.0 + (points[k].y - 1.0) * y_scale) * throat_radius;
+    }
+
+    // Second derivative at the vertices for adaptive sampling
+    for (int k = 1; k < count - 1; k++) {
+        double h0 = points[k].x - points[k - 1].x;
+        double h1 = points[k + 1].x - points[k].x;
+        double s0 = (points[k].y - points[k - 1].y) / h0;
+        double s1 = (points[k + 1].y - points[k].y) / h1;
+        curvature[k] = 2.0 * (s1 - s0) / (h0 + h1);
+    }
+    curvature[0] = count > 2 ? curvature[1] : 0.0;
+    curvature[count - 1] = count > 2 ? curvature[count - 2] : 0.0;
+
+    contour->expansion_ratio = exit_radius * exit_radius;
+    contour->throat_x = 0.0;
+    contour->exit_x = points[count - 1].x;
+    contour->bell_angle = theta_max;
+
+    MocWallCurve curve = { points, curvature, count };
+    status = sample_nozzle_contour(contour, contour->exit_x, moc_wall_radius, &curve, sampling);
+    if (status != 0) {
+        ngc_set_error(context, "%d contour points cannot hold the MOC wall at the requested %s", contour->capacity,
+                      sampling && sampling->spacing == CONTOUR_ADAPTIVE ? "tolerance" : "point count");
+    }
+
+    if (summary) {
+        summary->initial_angle = theta_max;
+        summary->exit_angle = exit_angle;
+        summary->exit_mach = wall_exit_mach;
+        summary->truncated = cut;
+        summary->threads_used = target.threads_used;
+        summary->elapsed_seconds = ngc_wall_time() - start;
+    }
+
+    free(wall);
+    free(points);
+    free(curvature);
+    return status;
+}
+
+int calculate_moc_nozzle_contour(NgcContext* context, NozzleContour* contour, const FlowConditions* conditions,
+                                 double length_fraction, const MocOptions* options,
+                                 const ContourOptions* sampling, MocSummary* summary) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_GEOMETRY);
+    int status = moc_nozzle_contour(context, contour, conditions, length_fraction, options, sampling, summary);
+    NGC_PROFILE_END(timer);
+    return status;
+}
+
+int calculate_moc_nozzle_geometry(NgcContext* context, NozzleGeometry* nozzle, const FlowConditions* conditions,
+                                  double length_fraction, const MocOptions* options) {
+    if (!nozzle) {
+        return ngc_set_error(context, "Null pointer passed to calculate_moc_nozzle_geometry");
+    }
+
+    NozzleContour contour;
+    nozzle_contour_from_geometry(&contour, nozzle);
+    if (calculate_moc_nozzle_contour(context, &contour, conditions, length_fraction, options, NULL, NULL) != 0) {
+        return -1;
+    }
+    if (nozzle_contour_to_geometry(&contour, nozzle) != 0) {
+        return ngc_set_error(context, "Cannot copy the MOC contour into the nozzle geometry");
+    }
+    return 0;
+}
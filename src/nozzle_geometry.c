@@ -1,55 +1,177 @@
-#include "../include/ngc.h"
+#include "profile.h"
+#include <string.h>
 
-int calculate_bell_nozzle_geometry(NozzleGeometry* nozzle, double length_fraction) {
-    if (!nozzle || length_fraction <= 0 || length_fraction > 1.0) {
+// Number of subintervals used to tabulate the point density in adaptive mode
+#define ADAPTIVE_TABLE_SIZE 256
+
+typedef struct {
+    double throat_radius;
+    double exit_radius;
+    double length;
+} BellContour;
+
+// Radius and its second derivative along the parabolic bell
+static double bell_radius(const void* context, double x, double* second_derivative) {
+    const BellContour* bell = (const BellContour*)context;
+    double scale = bell->exit_radius / bell->throat_radius - 1.0;
+
+    if (second_derivative) {
+        *second_derivative = -2.0 * bell->throat_radius * scale / (bell->length * bell->length);
+    }
+
+    if (x <= 0) {
+        // Throat region
+        return bell->throat_radius;
+    }
+
+    // Parabolic expansion from throat to exit
+    double x_norm = x / bell->length;
+    double radius = bell->throat_radius * (1.0 + scale * (2.0 * x_norm - x_norm * x_norm));
+
+    // Ensure radius doesn't exceed exit radius
+    return radius > bell->exit_radius ? bell->exit_radius : radius;
+}
+
+static void sample_uniform(NozzleContour* contour, double length, ContourRadiusFn radius,
+                           const void* context, int num_points) {
+    if (num_points == 1) {
+        contour->points[0].x = 0.0;
+        contour->points[0].y = radius(context, 0.0, NULL);
+        contour->num_points = 1;
+        return;
+    }
+
+    double dx = length / (num_points - 1);
+    for (int i = 0; i < num_points; i++) {
+        double x = i * dx;
+        contour->points[i].x = x;
+        contour->points[i].y = radius(context, x, NULL);
+    }
+    contour->num_points = num_points;
+}
+
+// Linear interpolation between points spaced h apart has a radial error of
+// at most |r''| h^2 / 8, so points are placed with density
+// sqrt(|r''| / (8 tol)): each segment then carries the same error budget.
+// Fails, like an oversized uniform count, when the buffer cannot hold the
+// points the tolerance needs.
+static int sample_adaptive(NozzleContour* contour, double length, ContourRadiusFn radius,
+                            const void* context, double tolerance) {
+    double cumulative[ADAPTIVE_TABLE_SIZE + 1];
+    double dx = length / ADAPTIVE_TABLE_SIZE;
+    double previous_density = 0.0;
+
+    cumulative[0] = 0.0;
+    for (int i = 0; i <= ADAPTIVE_TABLE_SIZE; i++) {
+        double r2 = 0.0;
+        radius(context, i * dx, &r2);
+        double density = sqrt(fabs(r2) / (8.0 * tolerance));
+        if (i > 0) {
+            cumulative[i] = cumulative[i - 1] + 0.5 * (density + previous_density) * dx;
+        }
+        previous_density = density;
+    }
+
+    int segments = (int)ceil(cumulative[ADAPTIVE_TABLE_SIZE]);
+    if (segments < 1) {
+        segments = 1;
+    }
+    if (segments + 1 > contour->capacity) {
+        return -1;
+    }
+
+    // Invert the cumulative density at equal increments
+    int j = 0;
+    for (int k = 0; k <= segments; k++) {
+        double target = cumulative[ADAPTIVE_TABLE_SIZE] * k / segments;
+        double x;
+
+        while (j < ADAPTIVE_TABLE_SIZE - 1 && cumulative[j + 1] < target) {
+            j++;
+        }
+        double span = cumulative[j + 1] - cumulative[j];
+        double t = span > 0 ? (target - cumulative[j]) / span : 0.0;
+        x = (j + t) * dx;
+
+        if (k == 0) x = 0.0;
+        if (k == segments) x = length;
+
+        contour->points[k].x = x;
+        contour->points[k].y = radius(context, x, NULL);
+    }
+    contour->num_points = segments + 1;
+    return 0;
+}
+
+int sample_nozzle_contour(NozzleContour* contour, double length, ContourRadiusFn radius,
+                          const void* context, const ContourOptions* options) {
+    if (!contour || !radius || !(length > 0)) {
+        return -1;
+    }
+
+    contour->num_points = 0;
+    if (contour->capacity <= 0 || !contour->points) {
+        return 0;
+    }
+
+    if (options && options->spacing == CONTOUR_ADAPTIVE) {
+        if (!(options->tolerance > 0) || contour->capacity < 2) {
+            return -1;
+        }
+        return sample_adaptive(contour, length, radius, context, options->tolerance);
+    }
+
+    int num_points = options && options->num_points > 0 ? options->num_points : contour->capacity;
+    if (num_points > contour->capacity) {
+        return -1;
+    }
+    sample_uniform(contour, length, radius, context, num_points);
+    return 0;
+}
+
+static int bell_nozzle_contour(NozzleContour* contour, double length_fraction, const ContourOptions* options) {
+    if (!contour || length_fraction <= 0 || length_fraction > 1.0) {
+        return -1;
+    }
+    if (contour->throat_radius <= 0 || contour->exit_radius <= 0) {
         return -1;
     }
 
     // Calculate basic parameters
-    nozzle->expansion_ratio = (nozzle->exit_radius * nozzle->exit_radius) / 
-                              (nozzle->throat_radius * nozzle->throat_radius);
-    
+    contour->expansion_ratio = (contour->exit_radius * contour->exit_radius) /
+                               (contour->throat_radius * contour->throat_radius);
+
     // Set throat position at x = 0
-    nozzle->throat_x = 0.0;
-    
+    contour->throat_x = 0.0;
+
     // Calculate nozzle length based on the 15-degree half-angle conical equivalent
-    double conical_length = (nozzle->exit_radius - nozzle->throat_radius) / tan(15.0 * PI / 180.0);
-    double bell_length = conical_length * length_fraction;
-    nozzle->exit_x = bell_length;
+    double conical_length = (contour->exit_radius - contour->throat_radius) / tan(15.0 * PI / 180.0);
+    contour->exit_x = conical_length * length_fraction;
+    contour->num_points = 0;
 
     // Generate bell nozzle contour using Rao's method approximation
-    int i;
-    double dx = bell_length / (MAX_POINTS - 1);
-    nozzle->num_points = 0;
+    BellContour bell = { contour->throat_radius, contour->exit_radius, contour->exit_x };
+    return sample_nozzle_contour(contour, contour->exit_x, bell_radius, &bell, options);
+}
 
-    for (i = 0; i < MAX_POINTS && nozzle->num_points < MAX_POINTS; i++) {
-        double x = i * dx;
-        double radius;
-
-        if (x <= 0) {
-            // Throat region
-            radius = nozzle->throat_radius;
-        } else {
-            // Bell expansion using parabolic approximation
-            double x_norm = x / bell_length;
-            
-            // Parabolic expansion from throat to exit
-            double radius_ratio = 1.0 + (nozzle->exit_radius / nozzle->throat_radius - 1.0) * 
-                                 (2.0 * x_norm - x_norm * x_norm);
-            radius = nozzle->throat_radius * radius_ratio;
-            
-            // Ensure radius doesn't exceed exit radius
-            if (radius > nozzle->exit_radius) {
-                radius = nozzle->exit_radius;
-            }
-        }
+int calculate_bell_nozzle_contour(NozzleContour* contour, double length_fraction, const ContourOptions* options) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_GEOMETRY);
+    int status = bell_nozzle_contour(contour, length_fraction, options);
+    NGC_PROFILE_END(timer);
+    return status;
+}
 
-        nozzle->geometry[nozzle->num_points].x = x;
-        nozzle->geometry[nozzle->num_points].y = radius;
-        nozzle->num_points++;
+int calculate_bell_nozzle_geometry(NozzleGeometry* nozzle, double length_fraction) {
+    if (!nozzle) {
+        return -1;
     }
 
-    return 0;
+    NozzleContour contour;
+    nozzle_contour_from_geometry(&contour, nozzle);
+    if (calculate_bell_nozzle_contour(&contour, length_fraction, NULL) != 0) {
+        return -1;
+    }
+    return nozzle_contour_to_geometry(&contour, nozzle);
 }
 
 int calculate_expansion_ratio(NozzleGeometry* nozzle) {
@@ -57,11 +179,171 @@ int calculate_expansion_ratio(NozzleGeometry* nozzle) {
         return -1;
     }
 
-    nozzle->expansion_ratio = (nozzle->exit_radius * nozzle->exit_radius) / 
+    nozzle->expansion_ratio = (nozzle->exit_radius * nozzle->exit_radius) /
                               (nozzle->throat_radius * nozzle->throat_radius);
     return 0;
 }
 
 double calculate_nozzle_area(double radius) {
     return PI * radius * radius;
-}
\ No newline at end of file
+}
+
+// Sum of the conical frustums between consecutive contour points
+double calculate_contour_wall_area(const NozzleContour* contour) {
+    if (!contour || !contour->points) {
+        return 0.0;
+    }
+
+    double area = 0.0;
+    for (int i = 1; i < contour->num_points; i++) {
+        const Point* a = &contour->points[i - 1];
+        const Point* b = &contour->points[i];
+        area += PI * (a->y + b->y) * hypot(b->x - a->x, b->y - a->y);
+    }
+    return area;
+}
+
+int nozzle_contour_init(NozzleContour* contour, double throat_radius, double exit_radius,
+                        Point* buffer, int capacity) {
+    if (!contour || capacity < 0 || (capacity > 0 && !buffer)) {
+        return -1;
+    }
+
+    memset(contour, 0, sizeof(NozzleContour));
+    contour->throat_radius = throat_radius;
+    contour->exit_radius = exit_radius;
+    contour->points = buffer;
+    contour->capacity = capacity;
+    return 0;
+}
+
+int nozzle_contour_from_geometry(NozzleContour* contour, NozzleGeometry* nozzle) {
+    if (!contour || !nozzle) {
+        return -1;
+    }
+
+    nozzle_contour_init(contour, nozzle->throat_radius, nozzle->exit_radius, nozzle->geometry, MAX_POINTS);
+    contour->throat_x = nozzle->throat_x;
+    contour->exit_x = nozzle->exit_x;
+    contour->expansion_ratio = nozzle->expansion_ratio;
+    contour->bell_angle = nozzle->bell_angle;
+    contour->num_points = nozzle->num_points;
+    return 0;
+}
+
+int nozzle_contour_to_geometry(const NozzleContour* contour, NozzleGeometry* nozzle) {
+    if (!contour || !nozzle || contour->num_points > MAX_POINTS) {
+        return -1;
+    }
+
+    nozzle->throat_radius = contour->throat_radius;
+    nozzle->exit_radius = contour->exit_radius;
+    nozzle->throat_x = contour->throat_x;
+    nozzle->exit_x = contour->exit_x;
+    nozzle->expansion_ratio = contour->expansion_ratio;
+    nozzle->bell_angle = contour->bell_angle;
+    nozzle->num_points = contour->num_points;
+
+    // Contours built over the geometry's own buffer are already in place
+    if (contour->num_points > 0 && contour->points != nozzle->geometry) {
+        memcpy(nozzle->geometry, contour->points, (size_t)contour->num_points * sizeof(Point));
+    }
+    return 0;
+}
+
+int nozzle_contour_to_float(const NozzleContour* contour, PointF* points) {
+    if (!contour || (contour->num_points > 0 && !points)) {
+        return -1;
+    }
+
+    for (int i = 0; i < contour->num_points; i++) {
+        points[i].x = (float)contour->points[i].x;
+        points[i].y = (float)contour->points[i].y;
+    }
+    return 0;
+}
+
+// The scalar parameters are left as they are; only the points are replaced
+int nozzle_contour_from_float(NozzleContour* contour, const PointF* points, int count) {
+    if (!contour || count < 0 || count > contour->capacity || (count > 0 && !points)) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        contour->points[i].x = points[i].x;
+        contour->points[i].y = points[i].y;
+    }
+    contour->num_points = count;
+    return 0;
+}
+
+int nozzle_contour_alloc(NozzleContour* contour, NgcArena* arena, double throat_radius,
+                         double exit_radius, int capacity) {
+    if (!arena || capacity < 0) {
+        return -1;
+    }
+
+    Point* buffer = NULL;
+    if (capacity > 0) {
+        buffer = ngc_arena_alloc(arena, (size_t)capacity * sizeof(Point));
+        if (!buffer) {
+            return -1;
+        }
+    }
+    return nozzle_contour_init(contour, throat_radius, exit_radius, buffer, capacity);
+}
+
+int ngc_arena_init(NgcArena* arena, void* buffer, size_t size) {
+    if (!arena) {
+        return -1;
+    }
+
+    arena->owns_memory = 0;
+    if (!buffer && size > 0) {
+        buffer = malloc(size);
+        if (!buffer) {
+            return -1;
+        }
+        arena->owns_memory = 1;
+    }
+    arena->base = buffer;
+    arena->size = size;
+    arena->used = 0;
+    return 0;
+}
+
+void* ngc_arena_alloc(NgcArena* arena, size_t bytes) {
+    if (!arena || !arena->base) {
+        return NULL;
+    }
+
+    // Cache-line alignment keeps per-thread contours from sharing lines
+    uintptr_t address = (uintptr_t)arena->base + arena->used;
+    size_t padding = (size_t)((64 - (address & 63)) & 63);
+    if (arena->used + padding + bytes > arena->size) {
+        return NULL;
+    }
+
+    void* result = arena->base + arena->used + padding;
+    arena->used += padding + bytes;
+    return result;
+}
+
+void ngc_arena_reset(NgcArena* arena) {
+    if (arena) {
+        arena->used = 0;
+    }
+}
+
+void ngc_arena_release(NgcArena* arena) {
+    if (!arena) {
+        return;
+    }
+    if (arena->owns_memory) {
+        free(arena->base);
+    }
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+    arena->owns_memory = 0;
+}
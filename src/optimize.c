@@ -0,0 +1,471 @@
+#include "context.h"
+#include "random.h"
+#include <string.h>
+
+// Design optimizer: a (mu/mu_w, lambda) CMA-ES over the enabled parameters,
+// each scaled to [0, 1] within its bounds. Candidates outside the box are
+// reflected back in before evaluation, and every population is evaluated in
+// parallel. Constraints are handled by feasibility ranking: feasible
+// designs rank by objective and ahead of all infeasible ones, which rank by
+// total normalised violation.
+
+#define OPT_MAX_DIM SWEEP_NUM_PARAMETERS
+#define OPT_MAX_POPULATION 1024
+#define OPT_DEFAULT_EVALUATIONS 2000
+#define OPT_DEFAULT_TOLERANCE 1e-6
+#define OPT_DEFAULT_SEED 0x9e3779b97f4a7c15ULL
+
+// Relative spread of the generation-best objective, over the last
+// 10 + 30n/lambda generations, below which the search has stalled (flat
+// directions such as throat and exit radius at a fixed area ratio never
+// shrink the step size)
+#define OPT_STALL_TOLERANCE 1e-10
+
+// Violation assigned to designs that cannot be evaluated at all
+#define OPT_INVALID_VIOLATION 1e30
+
+typedef struct {
+    double x[OPT_MAX_DIM];       // Normalised coordinates, inside [0, 1]
+    double y[OPT_MAX_DIM];       // Step (x - mean) / sigma used for the update
+    NozzleDesign design;
+    PerformanceResults results;
+    double length;
+    double objective;
+    double violation;
+} Candidate;
+
+typedef struct {
+    const OptimizeConfig* config;
+    const int* parameters;       // Enabled parameter indices
+    int dim;
+    Candidate* candidates;
+} OptimizeJob;
+
+// "name=lower:upper", several separated by commas
+int parse_design_bounds(DesignBound* bounds, const char* spec) {
+    if (!bounds || !spec) {
+        return -1;
+    }
+
+    while (*spec) {
+        const char* comma = strchr(spec, ',');
+        size_t length = comma ? (size_t)(comma - spec) : strlen(spec);
+        char buffer[128];
+
+        if (length == 0 || length >= sizeof(buffer)) {
+            return -1;
+        }
+        memcpy(buffer, spec, length);
+        buffer[length] = '\0';
+
+        char* equals = strchr(buffer, '=');
+        if (!equals) {
+            return -1;
+        }
+        *equals = '\0';
+
+        int parameter = sweep_parameter_from_name(buffer);
+        DesignBound bound;
+        char extra;
+        if (parameter < 0 ||
+            sscanf(equals + 1, "%lf:%lf%c", &bound.lower, &bound.upper, &extra) != 2 ||
+            !(bound.upper > bound.lower)) {
+            return -1;
+        }
+        bound.enabled = 1;
+        bounds[parameter] = bound;
+
+        spec += length;
+        if (*spec == ',') {
+            spec++;
+        }
+    }
+
+    return 0;
+}
+
+int parse_optimize_bounds(OptimizeConfig* config, const char* spec) {
+    if (!config) {
+        return -1;
+    }
+    return parse_design_bounds(config->bounds, spec);
+}
+
+static void evaluate_candidate(const OptimizeJob* job, Candidate* candidate) {
+    const OptimizeConfig* config = job->config;
+    const DesignConstraints* limits = &config->constraints;
+    NozzleContour contour;
+
+    candidate->design = config->base;
+    for (int k = 0; k < job->dim; k++) {
+        const DesignBound* bound = &config->bounds[job->parameters[k]];
+        *nozzle_design_parameter(&candidate->design, (SweepParameter)job->parameters[k]) =
+            bound->lower + candidate->x[k] * (bound->upper - bound->lower);
+    }
+
+    nozzle_contour_init(&contour, 0.0, 0.0, NULL, 0);
+    if (evaluate_nozzle_design_cached(config->cache, &candidate->design, &contour, &candidate->results) != 0) {
+        memset(&candidate->results, 0, sizeof(PerformanceResults));
+        candidate->length = 0.0;
+        candidate->objective = -INFINITY;
+        candidate->violation = OPT_INVALID_VIOLATION;
+        return;
+    }
+
+    candidate->length = contour.exit_x;
+    candidate->objective = config->objective == OPTIMIZE_THRUST_COEFFICIENT ?
+                           candidate->results.thrust_coefficient : candidate->results.specific_impulse;
+
+    // Violations relative to each limit, so they can be summed
+    double violation = 0.0;
+    double ambient = candidate->design.conditions.ambient_pressure;
+    double pressure_ratio = ambient > 0 ? candidate->results.exit_pressure / ambient : INFINITY;
+
+    if (limits->max_length > 0 && candidate->length > limits->max_length) {
+        violation += (candidate->length - limits->max_length) / limits->max_length;
+    }
+    if (limits->max_exit_diameter > 0 && 2.0 * candidate->design.exit_radius > limits->max_exit_diameter) {
+        violation += (2.0 * candidate->design.exit_radius - limits->max_exit_diameter) / limits->max_exit_diameter;
+    }
+    if (limits->min_pressure_ratio > 0 && pressure_ratio < limits->min_pressure_ratio) {
+        violation += (limits->min_pressure_ratio - pressure_ratio) / limits->min_pressure_ratio;
+    }
+    if (limits->max_pressure_ratio > 0 && pressure_ratio > limits->max_pressure_ratio) {
+        violation += isfinite(pressure_ratio) ?
+                     (pressure_ratio - limits->max_pressure_ratio) / limits->max_pressure_ratio :
+                     OPT_INVALID_VIOLATION;
+    }
+    if (limits->max_heat_flux > 0) {
+        double heat_flux;
+        if (calculate_throat_heat_flux(&contour, &candidate->design.conditions, &config->thermal, &heat_flux) != 0) {
+            violation += OPT_INVALID_VIOLATION;
+        } else if (heat_flux > limits->max_heat_flux) {
+            violation += (heat_flux - limits->max_heat_flux) / limits->max_heat_flux;
+        }
+    }
+    candidate->violation = violation;
+}
+
+static void optimize_task(long long begin, long long end, int thread_id, void* context) {
+    OptimizeJob* job = (OptimizeJob*)context;
+    (void)thread_id;
+
+    for (long long i = begin; i < end; i++) {
+        evaluate_candidate(job, &job->candidates[i]);
+    }
+}
+
+// Feasibility ranking: nonzero if a is better than b
+static int candidate_better(const Candidate* a, const Candidate* b) {
+    if (a->violation == 0.0 && b->violation == 0.0) {
+        return a->objective > b->objective;
+    }
+    return a->violation < b->violation;
+}
+
+// Jacobi eigen-decomposition of the symmetric matrix a (destroyed);
+// columns of v receive the eigenvectors, d the eigenvalues
+static void symmetric_eigen(int n, double a[OPT_MAX_DIM][OPT_MAX_DIM],
+                            double v[OPT_MAX_DIM][OPT_MAX_DIM], double d[OPT_MAX_DIM]) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            v[i][j] = i == j ? 1.0 : 0.0;
+        }
+    }
+
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = 0.0;
+        for (int p = 0; p < n; p++) {
+            for (int q = p + 1; q < n; q++) {
+                off += a[p][q] * a[p][q];
+            }
+        }
+        if (off < 1e-30) {
+            break;
+        }
+
+        for (int p = 0; p < n; p++) {
+            for (int q = p + 1; q < n; q++) {
+                if (a[p][q] == 0.0) {
+                    continue;
+                }
+                double theta = 0.5 * (a[q][q] - a[p][p]) / a[p][q];
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < n; k++) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        d[i] = a[i][i];
+    }
+}
+
+int run_design_optimization(NgcContext* context, const OptimizeConfig* config, OptimizeSummary* summary) {
+    if (!config || !summary) {
+        return ngc_set_error(context, "Null pointer passed to run_design_optimization");
+    }
+    memset(summary, 0, sizeof(OptimizeSummary));
+
+    int parameters[OPT_MAX_DIM];
+    int n = 0;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        if (config->bounds[p].enabled) {
+            if (!(config->bounds[p].upper > config->bounds[p].lower)) {
+                return ngc_set_error(context, "Optimization bounds of %s must have upper > lower",
+                                     sweep_parameter_name((SweepParameter)p));
+            }
+            parameters[n++] = p;
+        }
+    }
+    if (n == 0) {
+        return ngc_set_error(context, "No parameters to optimize");
+    }
+
+    // Strategy parameters (Hansen's defaults)
+    int lambda = config->population > 0 ? config->population : 4 + (int)(3.0 * log((double)n));
+    if (lambda < 4) lambda = 4;
+    if (lambda > OPT_MAX_POPULATION) lambda = OPT_MAX_POPULATION;
+    int mu = lambda / 2;
+    int max_evaluations = config->max_evaluations > 0 ? config->max_evaluations : OPT_DEFAULT_EVALUATIONS;
+    if (max_evaluations < lambda) {
+        return ngc_set_error(context, "An evaluation budget of %d is less than one generation of %d candidates; "
+                             "raise the budget or lower the population", max_evaluations, lambda);
+    }
+    double tolerance = config->tolerance > 0 ? config->tolerance : OPT_DEFAULT_TOLERANCE;
+    int num_threads = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+
+    double weights[OPT_MAX_POPULATION];
+    double weight_sum = 0.0, weight_sq = 0.0;
+    for (int i = 0; i < mu; i++) {
+        weights[i] = log(mu + 0.5) - log(i + 1.0);
+        weight_sum += weights[i];
+    }
+    for (int i = 0; i < mu; i++) {
+        weights[i] /= weight_sum;
+        weight_sq += weights[i] * weights[i];
+    }
+    double mu_eff = 1.0 / weight_sq;
+
+    double cc = (4.0 + mu_eff / n) / (n + 4.0 + 2.0 * mu_eff / n);
+    double cs = (mu_eff + 2.0) / (n + mu_eff + 5.0);
+    double c1 = 2.0 / ((n + 1.3) * (n + 1.3) + mu_eff);
+    double cmu = 2.0 * (mu_eff - 2.0 + 1.0 / mu_eff) / ((n + 2.0) * (n + 2.0) + mu_eff);
+    if (cmu > 1.0 - c1) cmu = 1.0 - c1;
+    double damps = 1.0 + 2.0 * fmax(0.0, sqrt((mu_eff - 1.0) / (n + 1.0)) - 1.0) + cs;
+    double chi_n = sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    // State: mean, step size, covariance C = B diag(D^2) B^T and evolution paths
+    double mean[OPT_MAX_DIM], pc[OPT_MAX_DIM] = {0}, ps[OPT_MAX_DIM] = {0};
+    double C[OPT_MAX_DIM][OPT_MAX_DIM], B[OPT_MAX_DIM][OPT_MAX_DIM], D[OPT_MAX_DIM];
+    double sigma = 0.3;
+
+    for (int k = 0; k < n; k++) {
+        // Start from the base design, clamped into the bounds
+        const DesignBound* bound = &config->bounds[parameters[k]];
+        NozzleDesign base = config->base;
+        double value = *nozzle_design_parameter(&base, (SweepParameter)parameters[k]);
+        double x = (value - bound->lower) / (bound->upper - bound->lower);
+        mean[k] = isfinite(x) ? fmin(fmax(x, 0.0), 1.0) : 0.5;
+        D[k] = 1.0;
+        for (int j = 0; j < n; j++) {
+            C[k][j] = B[k][j] = k == j ? 1.0 : 0.0;
+        }
+    }
+
+    int window = 10 + (int)ceil(30.0 * n / lambda);
+    Candidate* candidates = malloc((size_t)lambda * sizeof(Candidate));
+    int* order = malloc((size_t)lambda * sizeof(int));
+    double* history = malloc((size_t)window * sizeof(double));
+    if (!candidates || !order || !history) {
+        free(candidates);
+        free(order);
+        free(history);
+        return ngc_set_error(context, "Cannot allocate a population of %d candidates", lambda);
+    }
+
+    NgcRng rng = { config->seed ? config->seed : OPT_DEFAULT_SEED };
+    OptimizeJob job = { config, parameters, n, candidates };
+    Candidate best;
+    memset(&best, 0, sizeof(best));
+    int has_best = 0;
+    int status = 0;
+    double start = ngc_wall_time();
+
+    // Steps longer than this are shortened after reflection
+    double max_step = sqrt((double)n) + 2.0 * n / (n + 2.0);
+
+    while (summary->evaluations + lambda <= max_evaluations) {
+        // Sample the population: x = mean + sigma B D z
+        for (int i = 0; i < lambda; i++) {
+            double z[OPT_MAX_DIM], y[OPT_MAX_DIM];
+            for (int k = 0; k < n; k++) {
+                z[k] = D[k] * ngc_rng_gaussian(&rng);
+            }
+            double norm = 0.0;
+            for (int k = 0; k < n; k++) {
+                y[k] = 0.0;
+                for (int j = 0; j < n; j++) {
+                    y[k] += B[k][j] * z[j];
+                }
+            }
+            for (int k = 0; k < n; k++) {
+                candidates[i].x[k] = ngc_reflect_unit(mean[k] + sigma * y[k]);
+                candidates[i].y[k] = (candidates[i].x[k] - mean[k]) / sigma;
+            }
+
+            // Keep repaired steps within the normal range of C's Mahalanobis norm
+            for (int k = 0; k < n; k++) {
+                double w = 0.0;
+                for (int j = 0; j < n; j++) {
+                    w += B[j][k] * candidates[i].y[j];
+                }
+                norm += (w / D[k]) * (w / D[k]);
+            }
+            norm = sqrt(norm);
+            if (norm > max_step) {
+                for (int k = 0; k < n; k++) {
+                    candidates[i].y[k] *= max_step / norm;
+                }
+            }
+        }
+
+        summary->threads_used = parallel_for(lambda, 1, num_threads, optimize_task, &job);
+        if (summary->threads_used < 0) {
+            status = ngc_set_error(context, "Cannot start the optimization threads");
+            break;
+        }
+        summary->evaluations += lambda;
+        summary->generations++;
+
+        // Rank (insertion sort; populations are small)
+        for (int i = 0; i < lambda; i++) {
+            int k = i;
+            while (k > 0 && candidate_better(&candidates[i], &candidates[order[k - 1]])) {
+                order[k] = order[k - 1];
+                k--;
+            }
+            order[k] = i;
+        }
+        if (!has_best || candidate_better(&candidates[order[0]], &best)) {
+            best = candidates[order[0]];
+            has_best = 1;
+        }
+        history[(summary->generations - 1) % window] =
+            candidates[order[0]].violation == 0.0 ? candidates[order[0]].objective : NAN;
+
+        // Recombination
+        double y_w[OPT_MAX_DIM] = {0};
+        for (int i = 0; i < mu; i++) {
+            for (int k = 0; k < n; k++) {
+                y_w[k] += weights[i] * candidates[order[i]].y[k];
+            }
+        }
+        for (int k = 0; k < n; k++) {
+            mean[k] += sigma * y_w[k];
+        }
+
+        // Step-size path uses C^(-1/2) y_w = B D^-1 B^T y_w
+        double bty[OPT_MAX_DIM], ps_norm = 0.0;
+        for (int k = 0; k < n; k++) {
+            bty[k] = 0.0;
+            for (int j = 0; j < n; j++) {
+                bty[k] += B[j][k] * y_w[j];
+            }
+            bty[k] /= D[k];
+        }
+        for (int k = 0; k < n; k++) {
+            double inv_sqrt_c_y = 0.0;
+            for (int j = 0; j < n; j++) {
+                inv_sqrt_c_y += B[k][j] * bty[j];
+            }
+            ps[k] = (1.0 - cs) * ps[k] + sqrt(cs * (2.0 - cs) * mu_eff) * inv_sqrt_c_y;
+            ps_norm += ps[k] * ps[k];
+        }
+        ps_norm = sqrt(ps_norm);
+
+        double decay = 1.0 - pow(1.0 - cs, 2.0 * summary->generations);
+        int hsig = ps_norm / sqrt(decay) / chi_n < 1.4 + 2.0 / (n + 1.0);
+        for (int k = 0; k < n; k++) {
+            pc[k] = (1.0 - cc) * pc[k] + (hsig ? sqrt(cc * (2.0 - cc) * mu_eff) * y_w[k] : 0.0);
+        }
+
+        // Covariance: rank-one and rank-mu updates
+        for (int k = 0; k < n; k++) {
+            for (int j = 0; j <= k; j++) {
+                double rank_mu = 0.0;
+                for (int i = 0; i < mu; i++) {
+                    rank_mu += weights[i] * candidates[order[i]].y[k] * candidates[order[i]].y[j];
+                }
+                double value = (1.0 - c1 - cmu) * C[k][j] +
+                               c1 * (pc[k] * pc[j] + (hsig ? 0.0 : cc * (2.0 - cc) * C[k][j])) +
+                               cmu * rank_mu;
+                C[k][j] = C[j][k] = value;
+            }
+        }
+
+        sigma *= exp((cs / damps) * (ps_norm / chi_n - 1.0));
+
+        double work[OPT_MAX_DIM][OPT_MAX_DIM];
+        memcpy(work, C, sizeof(work));
+        symmetric_eigen(n, work, B, D);
+        double max_d = 0.0;
+        for (int k = 0; k < n; k++) {
+            D[k] = sqrt(fmax(D[k], 1e-300));
+            max_d = fmax(max_d, D[k]);
+        }
+
+        if (sigma * max_d < tolerance) {
+            summary->converged = 1;
+            break;
+        }
+
+        if (summary->generations >= window) {
+            double lo = history[0], hi = history[0];
+            for (int g = 1; g < window; g++) {
+                lo = fmin(lo, history[g]);
+                hi = fmax(hi, history[g]);
+            }
+            // fmin/fmax skip NaN, so check the ends too
+            int feasible = 1;
+            for (int g = 0; g < window; g++) {
+                feasible &= !isnan(history[g]);
+            }
+            if (feasible && hi - lo <= OPT_STALL_TOLERANCE * fabs(hi)) {
+                summary->converged = 1;
+                break;
+            }
+        }
+    }
+
+    summary->elapsed_seconds = ngc_wall_time() - start;
+    if (has_best) {
+        summary->best_design = best.design;
+        summary->best_results = best.results;
+        summary->best_length = best.length;
+        summary->best_objective = best.objective;
+        summary->feasible = best.violation == 0.0;
+    }
+
+    free(candidates);
+    free(order);
+    free(history);
+    return has_best ? status : -1;
+}
@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../include/ngc.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// Work-stealing loop scheduler. Every worker owns a contiguous slice of the
+// index space and consumes it in chunks from the front; an idle worker steals
+// the back half of another worker's remaining slice.
+
+typedef struct {
+    pthread_mutex_t lock;
+    long long next;              // Owner consumes from here
+    long long end;               // Thieves split from here
+    char padding[64];            // Keep neighbouring slices off the same cache line
+} WorkSlice;
+
+typedef struct {
+    WorkSlice* slices;
+    int num_threads;
+    long long chunk_size;
+    ParallelTask task;
+    void* context;
+} ParallelJob;
+
+typedef struct {
+    ParallelJob* job;
+    int thread_id;
+} WorkerArgs;
+
+int ngc_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static int take_chunk(WorkSlice* slice, long long chunk_size, long long* begin, long long* end) {
+    int found = 0;
+
+    pthread_mutex_lock(&slice->lock);
+    if (slice->next < slice->end) {
+        *begin = slice->next;
+        *end = slice->next + chunk_size < slice->end ? slice->next + chunk_size : slice->end;
+        slice->next = *end;
+        found = 1;
+    }
+    pthread_mutex_unlock(&slice->lock);
+
+    return found;
+}
+
+static int steal_work(ParallelJob* job, int thief) {
+    for (int k = 1; k < job->num_threads; k++) {
+        WorkSlice* victim = &job->slices[(thief + k) % job->num_threads];
+        long long begin = 0, end = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        long long remaining = victim->end - victim->next;
+        if (remaining > job->chunk_size) {
+            // Take the back half, leaving the victim its front half
+            begin = victim->next + remaining / 2;
+            end = victim->end;
+            victim->end = begin;
+        } else if (remaining > 0) {
+            begin = victim->next;
+            end = victim->end;
+            victim->next = end;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (end > begin) {
+            WorkSlice* own = &job->slices[thief];
+            pthread_mutex_lock(&own->lock);
+            own->next = begin;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void* parallel_worker(void* arg) {
+    WorkerArgs* args = (WorkerArgs*)arg;
+    ParallelJob* job = args->job;
+    WorkSlice* own = &job->slices[args->thread_id];
+    long long begin, end;
+
+    for (;;) {
+        while (take_chunk(own, job->chunk_size, &begin, &end)) {
+            job->task(begin, end, args->thread_id, job->context);
+        }
+        if (!steal_work(job, args->thread_id)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+int parallel_for(long long count, long long chunk_size, int num_threads, ParallelTask task, void* context) {
+    if (count < 0 || !task) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    if (num_threads <= 0) {
+        num_threads = ngc_cpu_count();
+    }
+    if (chunk_size <= 0) {
+        // Aim for ~64 chunks per thread so stealing has something to balance
+        chunk_size = count / ((long long)num_threads * 64);
+        if (chunk_size < 1) chunk_size = 1;
+        if (chunk_size > 4096) chunk_size = 4096;
+    }
+
+    long long num_chunks = (count + chunk_size - 1) / chunk_size;
+    if (num_threads > num_chunks) {
+        num_threads = (int)num_chunks;
+    }
+
+    // Run inline when there is nothing to parallelize
+    if (num_threads == 1) {
+        for (long long begin = 0; begin < count; begin += chunk_size) {
+            long long end = begin + chunk_size < count ? begin + chunk_size : count;
+            task(begin, end, 0, context);
+        }
+        return 1;
+    }
+
+    ParallelJob job;
+    job.num_threads = num_threads;
+    job.chunk_size = chunk_size;
+    job.task = task;
+    job.context = context;
+    job.slices = calloc((size_t)num_threads, sizeof(WorkSlice));
+    pthread_t* threads = calloc((size_t)num_threads, sizeof(pthread_t));
+    WorkerArgs* args = calloc((size_t)num_threads, sizeof(WorkerArgs));
+    if (!job.slices || !threads || !args) {
+        free(job.slices);
+        free(threads);
+        free(args);
+        return -1;
+    }
+
+    // Initial static partition on chunk boundaries
+    for (int t = 0; t < num_threads; t++) {
+        pthread_mutex_init(&job.slices[t].lock, NULL);
+        job.slices[t].next = (num_chunks * t / num_threads) * chunk_size;
+        job.slices[t].end = (num_chunks * (t + 1) / num_threads) * chunk_size;
+        if (job.slices[t].end > count) job.slices[t].end = count;
+        args[t].job = &job;
+        args[t].thread_id = t;
+    }
+
+    // The calling thread acts as worker 0
+    int started = 1;
+    for (int t = 1; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, parallel_worker, &args[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+    parallel_worker(&args[0]);
+
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // Slices owned by threads that failed to start were stolen by worker 0
+    for (int t = 0; t < num_threads; t++) {
+        pthread_mutex_destroy(&job.slices[t].lock);
+    }
+    free(job.slices);
+    free(threads);
+    free(args);
+    return started;
+}
@@ -0,0 +1,574 @@
+#include "context.h"
+#include "datafile.h"
+#include "random.h"
+#include <string.h>
+
+// Pareto exploration. Designs are evaluated in parallel batches and fed one
+// by one into an archive that keeps only the non-dominated set, so memory
+// follows the size of the front rather than the number of evaluations.
+//
+// The archive is a k-d tree over the objective vectors (all minimized; the
+// maximized objectives are negated). Every node keeps the bounding box of
+// its subtree, so the two queries of an insertion visit only the subtrees
+// whose box can hold a match:
+//
+//   dominated?  some member <= candidate in every objective: needs box low <= candidate
+//   removal     members >= candidate in every objective:     needs box high >= candidate
+//
+// Removed members stay in the tree as dead nodes until a rebuild, which
+// compacts the archive and rebalances it by median splits. Rebuilds happen
+// when the dead nodes outnumber the live ones or an insertion lands too deep.
+//
+// The first share of the budget samples the whole box on a shifted Halton
+// sequence. The rest refines the front: each candidate perturbs a random
+// archive member with a Gaussian step whose size shrinks geometrically,
+// with a small share still drawn over the whole box.
+
+#define PARETO_DEFAULT_EVALUATIONS 100000
+#define PARETO_DEFAULT_INITIAL_FRACTION 0.25
+#define PARETO_DEFAULT_BATCH 4096
+#define PARETO_DEFAULT_SEED 0x2545f4914f6cdd1dULL
+#define PARETO_WALL_POINTS 65        // Contour points for the wall area (error below 1e-4)
+#define PARETO_GLOBAL_SHARE 0.1      // Refinement candidates drawn over the whole box
+#define PARETO_STEP_START 0.1        // Refinement step, as a fraction of the bounds
+#define PARETO_STEP_END 0.002
+#define PARETO_NO_NODE -1
+
+typedef char pareto_point_check[sizeof(ParetoPoint) == PARETO_NUM_FIELDS * sizeof(double) ? 1 : -1];
+
+static const char* const pareto_objective_names[PARETO_NUM_OBJECTIVES] = {
+    "isp",
+    "cf",
+    "thrust",
+    "length",
+    "exit-area",
+    "wall-area"
+};
+
+static const int halton_primes[SWEEP_NUM_PARAMETERS] = { 2, 3, 5, 7, 11, 13, 17, 19 };
+
+typedef struct {
+    double key[PARETO_NUM_OBJECTIVES];   // Enabled objectives, minimized
+    double low[PARETO_NUM_OBJECTIVES];   // Bounding box of the subtree, dead nodes included
+    double high[PARETO_NUM_OBJECTIVES];
+    int left;
+    int right;
+    int alive;
+    ParetoPoint point;
+} ParetoEntry;
+
+typedef struct {
+    ParetoEntry* entries;
+    int count;                   // Entries in use, live and dead
+    int capacity;
+    int live;
+    int root;
+    int depth_limit;             // Insertion depth that triggers a rebuild
+    int dims;                    // Enabled objectives
+    int* order;                  // Rebuild scratch, capacity entries
+} ParetoArchive;
+
+typedef struct {
+    double x[SWEEP_NUM_PARAMETERS];  // Coordinates in [0, 1] within the bounds
+    ParetoPoint point;
+    int valid;
+} ParetoCandidate;
+
+typedef struct {
+    const ParetoConfig* config;
+    const int* parameters;       // Explored parameter indices
+    int dim;
+    ParetoCandidate* candidates;
+    Point* buffers;              // PARETO_WALL_POINTS per thread
+} ParetoJob;
+
+static double radical_inverse(unsigned long long index, int base) {
+    double inverse_base = 1.0 / base;
+    double scale = inverse_base;
+    double value = 0.0;
+    while (index > 0) {
+        value += (double)(index % (unsigned long long)base) * scale;
+        index /= (unsigned long long)base;
+        scale *= inverse_base;
+    }
+    return value;
+}
+
+const char* pareto_objective_name(ParetoObjective objective) {
+    if (objective < 0 || objective >= PARETO_NUM_OBJECTIVES) {
+        return NULL;
+    }
+    return pareto_objective_names[objective];
+}
+
+int parse_pareto_objectives(ParetoConfig* config, const char* spec) {
+    if (!config || !spec) {
+        return -1;
+    }
+
+    int objectives[PARETO_NUM_OBJECTIVES] = {0};
+    int count = 0;
+    while (*spec) {
+        const char* comma = strchr(spec, ',');
+        size_t length = comma ? (size_t)(comma - spec) : strlen(spec);
+        int found = -1;
+        for (int o = 0; o < PARETO_NUM_OBJECTIVES; o++) {
+            if (strlen(pareto_objective_names[o]) == length && strncmp(spec, pareto_objective_names[o], length) == 0) {
+                found = o;
+            }
+        }
+        if (found < 0) {
+            return -1;
+        }
+        objectives[found] = 1;
+        count++;
+
+        spec += length;
+        if (*spec == ',') {
+            spec++;
+        }
+    }
+    if (count < 2) {
+        return -1;
+    }
+
+    memcpy(config->objectives, objectives, sizeof(objectives));
+    return 0;
+}
+
+static void pareto_key(const ParetoConfig* config, const ParetoPoint* point, double* key) {
+    const double values[PARETO_NUM_OBJECTIVES] = {
+        -point->specific_impulse, -point->thrust_coefficient, -point->thrust,
+        point->length, point->exit_area, point->wall_area
+    };
+    int d = 0;
+    for (int o = 0; o < PARETO_NUM_OBJECTIVES; o++) {
+        if (config->objectives[o]) {
+            key[d++] = values[o];
+        }
+    }
+}
+
+static void evaluate_pareto_candidate(const ParetoJob* job, ParetoCandidate* candidate, Point* buffer) {
+    const ParetoConfig* config = job->config;
+    NozzleDesign design = config->base;
+    for (int k = 0; k < job->dim; k++) {
+        const DesignBound* bound = &config->bounds[job->parameters[k]];
+        *nozzle_design_parameter(&design, (SweepParameter)job->parameters[k]) =
+            bound->lower + candidate->x[k] * (bound->upper - bound->lower);
+    }
+
+    NozzleContour contour;
+    PerformanceResults results;
+    nozzle_contour_init(&contour, 0.0, 0.0, buffer, PARETO_WALL_POINTS);
+    candidate->valid = evaluate_nozzle_design(&design, &contour, &results) == 0;
+    if (!candidate->valid) {
+        return;
+    }
+
+    ParetoPoint* point = &candidate->point;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        point->parameters[p] = *nozzle_design_parameter(&design, (SweepParameter)p);
+    }
+    point->specific_impulse = results.specific_impulse;
+    point->thrust = results.thrust;
+    point->thrust_coefficient = results.thrust_coefficient;
+    point->length = contour.exit_x;
+    point->exit_area = calculate_nozzle_area(design.exit_radius);
+    point->wall_area = calculate_contour_wall_area(&contour);
+}
+
+static void pareto_task(long long begin, long long end, int thread_id, void* context) {
+    ParetoJob* job = (ParetoJob*)context;
+    Point* buffer = job->buffers + (size_t)thread_id * PARETO_WALL_POINTS;
+    for (long long i = begin; i < end; i++) {
+        evaluate_pareto_candidate(job, &job->candidates[i], buffer);
+    }
+}
+
+static int subtree_dominates(const ParetoArchive* archive, int node, const double* key) {
+    while (node != PARETO_NO_NODE) {
+        const ParetoEntry* entry = &archive->entries[node];
+        int covered = 1;
+        for (int d = 0; d < archive->dims; d++) {
+            if (entry->low[d] > key[d]) {
+                return 0;
+            }
+            covered &= entry->key[d] <= key[d];
+        }
+        if (entry->alive && covered) {
+            return 1;
+        }
+        if (subtree_dominates(archive, entry->left, key)) {
+            return 1;
+        }
+        node = entry->right;
+    }
+    return 0;
+}
+
+static int subtree_remove_dominated(ParetoArchive* archive, int node, const double* key) {
+    int removed = 0;
+    while (node != PARETO_NO_NODE) {
+        ParetoEntry* entry = &archive->entries[node];
+        int covered = 1;
+        for (int d = 0; d < archive->dims; d++) {
+            if (entry->high[d] < key[d]) {
+                return removed;
+            }
+            covered &= entry->key[d] >= key[d];
+        }
+        if (entry->alive && covered) {
+            entry->alive = 0;
+            removed++;
+        }
+        removed += subtree_remove_dominated(archive, entry->left, key);
+        node = entry->right;
+    }
+    return removed;
+}
+
+// Moves the k-th smallest key along the axis to position k
+static void select_median(ParetoArchive* archive, int* order, int count, int k, int axis) {
+    int lo = 0, hi = count - 1;
+    while (lo < hi) {
+        double pivot = archive->entries[order[(lo + hi) / 2]].key[axis];
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (archive->entries[order[i]].key[axis] < pivot) i++;
+            while (archive->entries[order[j]].key[axis] > pivot) j--;
+            if (i <= j) {
+                int swap = order[i];
+                order[i] = order[j];
+                order[j] = swap;
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+}
+
+static int build_subtree(ParetoArchive* archive, int* order, int count, int depth) {
+    if (count == 0) {
+        return PARETO_NO_NODE;
+    }
+
+    int axis = depth % archive->dims;
+    int middle = count / 2;
+    select_median(archive, order, count, middle, axis);
+    int node = order[middle];
+    ParetoEntry* entry = &archive->entries[node];
+    entry->left = build_subtree(archive, order, middle, depth + 1);
+    entry->right = build_subtree(archive, order + middle + 1, count - middle - 1, depth + 1);
+
+    memcpy(entry->low, entry->key, sizeof(entry->key));
+    memcpy(entry->high, entry->key, sizeof(entry->key));
+    int children[2] = { entry->left, entry->right };
+    for (int c = 0; c < 2; c++) {
+        if (children[c] == PARETO_NO_NODE) {
+            continue;
+        }
+        const ParetoEntry* child = &archive->entries[children[c]];
+        for (int d = 0; d < archive->dims; d++) {
+            entry->low[d] = fmin(entry->low[d], child->low[d]);
+            entry->high[d] = fmax(entry->high[d], child->high[d]);
+        }
+    }
+    return node;
+}
+
+// Drops the dead entries and rebalances the tree
+static void archive_rebuild(ParetoArchive* archive) {
+    int live = 0;
+    for (int i = 0; i < archive->count; i++) {
+        if (archive->entries[i].alive) {
+            if (i != live) {
+                archive->entries[live] = archive->entries[i];
+            }
+            archive->order[live] = live;
+            live++;
+        }
+    }
+    archive->count = live;
+    archive->live = live;
+    archive->root = build_subtree(archive, archive->order, live, 0);
+
+    int depth = 0;
+    while ((1 << depth) <= live) {
+        depth++;
+    }
+    archive->depth_limit = 2 * depth + 8;
+}
+
+static int archive_reserve(ParetoArchive* archive) {
+    if (archive->count < archive->capacity) {
+        return 0;
+    }
+    int capacity = archive->capacity > 0 ? 2 * archive->capacity : 256;
+    ParetoEntry* entries = realloc(archive->entries, (size_t)capacity * sizeof(ParetoEntry));
+    if (!entries) {
+        return -1;
+    }
+    archive->entries = entries;
+    int* order = realloc(archive->order, (size_t)capacity * sizeof(int));
+    if (!order) {
+        return -1;
+    }
+    archive->order = order;
+    archive->capacity = capacity;
+    return 0;
+}
+
+// Returns 1 if the point entered the archive, 0 if it was dominated and -1
+// when out of memory
+static int archive_insert(ParetoArchive* archive, const double* key, const ParetoPoint* point, long long* removed) {
+    if (subtree_dominates(archive, archive->root, key)) {
+        return 0;
+    }
+    int dropped = subtree_remove_dominated(archive, archive->root, key);
+    archive->live -= dropped;
+    *removed += dropped;
+    if (archive->count - archive->live > archive->live) {
+        archive_rebuild(archive);
+    }
+    if (archive_reserve(archive) != 0) {
+        return -1;
+    }
+
+    int index = archive->count++;
+    ParetoEntry* entry = &archive->entries[index];
+    memcpy(entry->key, key, sizeof(entry->key));
+    memcpy(entry->low, key, sizeof(entry->key));
+    memcpy(entry->high, key, sizeof(entry->key));
+    entry->left = PARETO_NO_NODE;
+    entry->right = PARETO_NO_NODE;
+    entry->alive = 1;
+    entry->point = *point;
+    archive->live++;
+
+    if (archive->root == PARETO_NO_NODE) {
+        archive->root = index;
+        return 1;
+    }
+
+    // Descend by the cycling split axis, widening the boxes on the way
+    int node = archive->root;
+    int depth = 0;
+    for (;;) {
+        ParetoEntry* parent = &archive->entries[node];
+        for (int d = 0; d < archive->dims; d++) {
+            parent->low[d] = fmin(parent->low[d], key[d]);
+            parent->high[d] = fmax(parent->high[d], key[d]);
+        }
+        int axis = depth % archive->dims;
+        int* next = key[axis] < parent->key[axis] ? &parent->left : &parent->right;
+        depth++;
+        if (*next == PARETO_NO_NODE) {
+            *next = index;
+            break;
+        }
+        node = *next;
+    }
+    if (depth > archive->depth_limit) {
+        archive_rebuild(archive);
+    }
+    return 1;
+}
+
+static int compare_entries(const void* a, const void* b) {
+    const ParetoEntry* x = (const ParetoEntry*)a;
+    const ParetoEntry* y = (const ParetoEntry*)b;
+    for (int d = 0; d < PARETO_NUM_OBJECTIVES; d++) {
+        if (x->key[d] != y->key[d]) {
+            return x->key[d] < y->key[d] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// Next batch of candidates: Halton points over the box while the initial
+// share lasts, then perturbations of random archive members
+static void generate_candidates(const ParetoConfig* config, const ParetoArchive* archive, const int* parameters,
+                                int dim, ParetoCandidate* candidates, int count, long long first,
+                                long long initial, long long total, const double* shift,
+                                unsigned long long* halton_index, NgcRng* rng) {
+    for (int c = 0; c < count; c++) {
+        ParetoCandidate* candidate = &candidates[c];
+        long long evaluation = first + c;
+        if (evaluation < initial || archive->live == 0 || ngc_rng_uniform(rng) < PARETO_GLOBAL_SHARE) {
+            unsigned long long index = ++*halton_index;
+            for (int k = 0; k < dim; k++) {
+                double x = radical_inverse(index, halton_primes[k]) + shift[k];
+                candidate->x[k] = x - floor(x);
+            }
+            continue;
+        }
+
+        double progress = total > initial ? (double)(evaluation - initial) / (double)(total - initial) : 1.0;
+        double step = PARETO_STEP_START * pow(PARETO_STEP_END / PARETO_STEP_START, progress);
+        const ParetoEntry* parent;
+        do {
+            parent = &archive->entries[ngc_rng_next(rng) % (unsigned long long)archive->count];
+        } while (!parent->alive);
+        for (int k = 0; k < dim; k++) {
+            const DesignBound* bound = &config->bounds[parameters[k]];
+            double x = (parent->point.parameters[parameters[k]] - bound->lower) / (bound->upper - bound->lower);
+            candidate->x[k] = ngc_reflect_unit(x + step * ngc_rng_gaussian(rng));
+        }
+    }
+}
+
+int run_pareto_exploration(NgcContext* context, const ParetoConfig* config, ParetoFront* front,
+                           ParetoSummary* summary) {
+    if (!config || !front || !summary) {
+        return ngc_set_error(context, "Null pointer passed to run_pareto_exploration");
+    }
+    memset(front, 0, sizeof(ParetoFront));
+    memset(summary, 0, sizeof(ParetoSummary));
+
+    int parameters[SWEEP_NUM_PARAMETERS];
+    int dim = 0;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        if (config->bounds[p].enabled) {
+            if (!(config->bounds[p].upper > config->bounds[p].lower)) {
+                return ngc_set_error(context, "Invalid bounds for %s", sweep_parameter_name((SweepParameter)p));
+            }
+            parameters[dim++] = p;
+        }
+    }
+    int dims = 0;
+    for (int o = 0; o < PARETO_NUM_OBJECTIVES; o++) {
+        dims += config->objectives[o] != 0;
+    }
+    if (dim == 0 || dims < 2) {
+        return ngc_set_error(context, "Pareto exploration needs a parameter to explore and two objectives");
+    }
+
+    long long total = config->max_evaluations > 0 ? config->max_evaluations : PARETO_DEFAULT_EVALUATIONS;
+    double fraction = config->initial_fraction > 0 ? fmin(config->initial_fraction, 1.0) :
+                      PARETO_DEFAULT_INITIAL_FRACTION;
+    long long initial = (long long)ceil(fraction * (double)total);
+    int batch = config->batch_size > 0 ? config->batch_size : PARETO_DEFAULT_BATCH;
+    int num_threads = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+
+    ParetoArchive archive;
+    memset(&archive, 0, sizeof(archive));
+    archive.root = PARETO_NO_NODE;
+    archive.dims = dims;
+    archive.depth_limit = 8;
+
+    ParetoJob job = { config, parameters, dim, NULL, NULL };
+    job.candidates = malloc((size_t)batch * sizeof(ParetoCandidate));
+    job.buffers = malloc((size_t)num_threads * PARETO_WALL_POINTS * sizeof(Point));
+    if (!job.candidates || !job.buffers) {
+        free(job.candidates);
+        free(job.buffers);
+        return ngc_set_error(context, "Cannot allocate the Pareto candidates");
+    }
+
+    NgcRng rng = { config->seed ? config->seed : PARETO_DEFAULT_SEED };
+    double shift[SWEEP_NUM_PARAMETERS];
+    for (int k = 0; k < dim; k++) {
+        shift[k] = ngc_rng_uniform(&rng);
+    }
+    unsigned long long halton_index = 0;
+
+    double start = ngc_wall_time();
+    int status = 0;
+    while (status == 0 && summary->evaluations < total) {
+        int count = total - summary->evaluations < batch ? (int)(total - summary->evaluations) : batch;
+        generate_candidates(config, &archive, parameters, dim, job.candidates, count, summary->evaluations,
+                            initial, total, shift, &halton_index, &rng);
+
+        summary->threads_used = parallel_for(count, 0, num_threads, pareto_task, &job);
+        if (summary->threads_used < 0) {
+            status = ngc_set_error(context, "Cannot start the Pareto workers");
+            break;
+        }
+
+        // Candidates enter in index order, so the front does not depend on the thread count
+        for (int c = 0; c < count; c++) {
+            const ParetoCandidate* candidate = &job.candidates[c];
+            if (!candidate->valid) {
+                summary->failed++;
+                continue;
+            }
+            double key[PARETO_NUM_OBJECTIVES] = {0};
+            pareto_key(config, &candidate->point, key);
+            int inserted = archive_insert(&archive, key, &candidate->point, &summary->removed);
+            if (inserted < 0) {
+                status = ngc_set_error(context, "Cannot grow the Pareto archive");
+                break;
+            }
+            summary->accepted += inserted;
+            if (archive.live > summary->peak_size) {
+                summary->peak_size = archive.live;
+            }
+        }
+        summary->evaluations += count;
+        summary->rounds++;
+    }
+    summary->elapsed_seconds = ngc_wall_time() - start;
+    summary->evaluations_per_second = summary->elapsed_seconds > 0 ?
+                                      summary->evaluations / summary->elapsed_seconds : 0.0;
+    free(job.candidates);
+    free(job.buffers);
+
+    if (status == 0 && archive.live > 0) {
+        archive_rebuild(&archive);
+        qsort(archive.entries, (size_t)archive.count, sizeof(ParetoEntry), compare_entries);
+        front->points = malloc((size_t)archive.count * sizeof(ParetoPoint));
+        if (!front->points) {
+            status = ngc_set_error(context, "Cannot allocate the Pareto front");
+        } else {
+            for (int i = 0; i < archive.count; i++) {
+                front->points[i] = archive.entries[i].point;
+            }
+            front->count = archive.count;
+        }
+    } else if (status == 0) {
+        status = ngc_set_error(context, "No design in the bounds could be evaluated");
+    }
+    free(archive.entries);
+    free(archive.order);
+    return status;
+}
+
+void pareto_front_free(ParetoFront* front) {
+    if (!front) {
+        return;
+    }
+    free(front->points);
+    memset(front, 0, sizeof(ParetoFront));
+}
+
+int write_pareto_binary(NgcContext* context, const ParetoConfig* config, const ParetoFront* front,
+                        const char* filename) {
+    if (!config || !front || !filename || (front->count > 0 && !front->points)) {
+        return ngc_set_error(context, "A Pareto front is required for binary output");
+    }
+
+    NgcDataHeader header;
+    ngc_data_header_init(&header, NGC_DATA_PARETO, PARETO_NUM_FIELDS, (uint64_t)front->count,
+                         "throat_radius,exit_radius,chamber_pressure,ambient_pressure,chamber_temperature,"
+                         "molecular_weight,gamma,length_fraction,specific_impulse,thrust,thrust_coefficient,"
+                         "length,exit_area,wall_area");
+    NozzleDesign base = config->base;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        header.base[p] = *nozzle_design_parameter(&base, (SweepParameter)p);
+        if (config->bounds[p].enabled) {
+            header.range_start[p] = config->bounds[p].lower;
+            header.range_stop[p] = config->bounds[p].upper;
+        }
+    }
+    header.gas_constant = base.conditions.gas_constant;
+
+    return ngc_data_write(context, filename, &header, front->points, (size_t)front->count * sizeof(ParetoPoint));
+}
@@ -1,20 +1,22 @@
-#include "../include/ngc.h"
+#include "profile.h"
 
-int calculate_performance(const NozzleGeometry* nozzle, const FlowConditions* conditions, PerformanceResults* results) {
-    if (!nozzle || !conditions || !results) {
-        return -1;
-    }
+static double solve_exit_conditions(double area_ratio, const FlowConditions* conditions,
+                                   double* exit_pressure, double* exit_temperature, double* exit_velocity);
+
+static int compute_performance(double throat_radius, double exit_radius, double expansion_ratio,
+                               const FlowConditions* conditions, PerformanceResults* results) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_PERFORMANCE);
 
     // Calculate throat conditions
     double throat_pressure, throat_temperature;
-    double throat_area = calculate_nozzle_area(nozzle->throat_radius);
-    double exit_area = calculate_nozzle_area(nozzle->exit_radius);
+    double throat_area = calculate_nozzle_area(throat_radius);
+    double exit_area = calculate_nozzle_area(exit_radius);
     
     calculate_throat_conditions(conditions, &throat_pressure, &throat_temperature);
 
     // Calculate exit conditions
     double exit_pressure, exit_temperature, exit_velocity;
-    calculate_exit_conditions(nozzle, conditions, &exit_pressure, &exit_temperature, &exit_velocity);
+    results->exit_mach = solve_exit_conditions(expansion_ratio, conditions, &exit_pressure, &exit_temperature, &exit_velocity);
 
     // Calculate specific gas constant
     double R_specific = conditions->gas_constant / conditions->molecular_weight;
@@ -43,10 +45,58 @@ int calculate_performance(const NozzleGeometry* nozzle, const FlowConditions* co
     // Calculate thrust coefficient
     results->thrust_coefficient = results->thrust / (conditions->chamber_pressure * throat_area);
 
+    NGC_PROFILE_END(timer);
     return 0;
 }
 
+int calculate_performance(const NozzleGeometry* nozzle, const FlowConditions* conditions, PerformanceResults* results) {
+    if (!nozzle || !conditions || !results) {
+        return -1;
+    }
+
+    return compute_performance(nozzle->throat_radius, nozzle->exit_radius, nozzle->expansion_ratio,
+                               conditions, results);
+}
+
+int calculate_contour_performance(const NozzleContour* contour, const FlowConditions* conditions, PerformanceResults* results) {
+    if (!contour || !conditions || !results) {
+        return -1;
+    }
+
+    return compute_performance(contour->throat_radius, contour->exit_radius, contour->expansion_ratio,
+                               conditions, results);
+}
+
+int evaluate_nozzle_design(const NozzleDesign* design, NozzleContour* contour, PerformanceResults* results) {
+    if (!design || !results) {
+        return -1;
+    }
+
+    // Without a caller buffer only the scalar geometry is needed
+    NozzleContour scalar_contour;
+    if (!contour) {
+        contour = &scalar_contour;
+        nozzle_contour_init(contour, 0.0, 0.0, NULL, 0);
+    }
+    contour->throat_radius = design->throat_radius;
+    contour->exit_radius = design->exit_radius;
+
+    if (design_parameter_error(design) != NULL) {
+        return -1;
+    }
+    if (calculate_bell_nozzle_contour(contour, design->length_fraction, NULL) != 0) {
+        return -1;
+    }
+    if (calculate_contour_performance(contour, &design->conditions, results) != 0) {
+        return -1;
+    }
+
+    return isfinite(results->thrust) && isfinite(results->specific_impulse) ? 0 : -1;
+}
+
 double calculate_throat_conditions(const FlowConditions* conditions, double* throat_pressure, double* throat_temperature) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_THROAT);
+
     // Isentropic relations for choked flow
     double pressure_ratio = pow(2.0 / (conditions->gamma + 1.0), 
                                conditions->gamma / (conditions->gamma - 1.0));
@@ -55,34 +105,31 @@ double calculate_throat_conditions(const FlowConditions* conditions, double* thr
     *throat_pressure = conditions->chamber_pressure * pressure_ratio;
     *throat_temperature = conditions->chamber_temperature * temperature_ratio;
 
+    NGC_PROFILE_END(timer);
     return 0;
 }
 
 double calculate_exit_conditions(const NozzleGeometry* nozzle, const FlowConditions* conditions, 
                                 double* exit_pressure, double* exit_temperature, double* exit_velocity) {
-    
+    return solve_exit_conditions(nozzle->expansion_ratio, conditions, exit_pressure, exit_temperature, exit_velocity);
+}
+
+static double exit_conditions(double area_ratio, const FlowConditions* conditions,
+                              double* exit_pressure, double* exit_temperature, double* exit_velocity) {
     // Use isentropic relations for perfect expansion
-    double area_ratio = nozzle->expansion_ratio;
     double gamma = conditions->gamma;
     double R_specific = conditions->gas_constant / conditions->molecular_weight;
 
-    // Solve for exit Mach number using area-Mach relation (approximation)
-    double mach_exit = sqrt(2.0 / (gamma - 1.0) * (pow(area_ratio, (gamma - 1.0) / gamma) - 1.0));
-    
-    // More accurate iterative solution for Mach number
-    double mach_guess = mach_exit;
-    for (int i = 0; i < 10; i++) {
-        double f = pow((gamma + 1.0) / 2.0, (gamma + 1.0) / (2.0 * (gamma - 1.0))) *
-                   pow(1.0 + (gamma - 1.0) / 2.0 * mach_guess * mach_guess, -(gamma + 1.0) / (2.0 * (gamma - 1.0))) /
-                   mach_guess - 1.0 / area_ratio;
-        
-        double df = -pow((gamma + 1.0) / 2.0, (gamma + 1.0) / (2.0 * (gamma - 1.0))) *
-                    (1.0 / (mach_guess * mach_guess) +
-                     (gamma + 1.0) / 2.0 * pow(1.0 + (gamma - 1.0) / 2.0 * mach_guess * mach_guess, -(gamma + 3.0) / (2.0 * (gamma - 1.0))));
-        
-        mach_guess = mach_guess - f / df;
+    // Solve the supersonic branch of the area-Mach relation
+    AreaMachSolver solver;
+    double mach_exit;
+    if (area_mach_solver_init(&solver, gamma) != 0 ||
+        solve_area_mach(&solver, area_ratio, 1, 0.0, &mach_exit, NULL) != 0) {
+        *exit_pressure = NAN;
+        *exit_temperature = NAN;
+        *exit_velocity = NAN;
+        return NAN;
     }
-    mach_exit = mach_guess;
 
     // Calculate exit conditions
     double temp_ratio = 1.0 / (1.0 + (gamma - 1.0) / 2.0 * mach_exit * mach_exit);
@@ -92,5 +139,13 @@ double calculate_exit_conditions(const NozzleGeometry* nozzle, const FlowConditi
     *exit_pressure = conditions->chamber_pressure * press_ratio;
     *exit_velocity = mach_exit * sqrt(gamma * R_specific * (*exit_temperature));
 
-    return 0;
-}
\ No newline at end of file
+    return mach_exit;
+}
+
+static double solve_exit_conditions(double area_ratio, const FlowConditions* conditions,
+                                   double* exit_pressure, double* exit_temperature, double* exit_velocity) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_EXIT_SOLVE);
+    double mach_exit = exit_conditions(area_ratio, conditions, exit_pressure, exit_temperature, exit_velocity);
+    NGC_PROFILE_END(timer);
+    return mach_exit;
+}
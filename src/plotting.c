@@ -1,110 +1,225 @@
-#include "../include/ngc.h"
+#include "context.h"
+#include "profile.h"
+#include <string.h>
 
-int plot_nozzle_geometry(const NozzleGeometry* nozzle, const char* filename) {
+int plot_nozzle_geometry(NgcContext* context, const NozzleGeometry* nozzle, const char* filename) {
+    if (!nozzle) {
+        return ngc_set_error(context, "Null pointer passed to plotting function");
+    }
+
+    // Read-only view over the geometry's point buffer
+    NozzleContour contour;
+    nozzle_contour_from_geometry(&contour, (NozzleGeometry*)nozzle);
+    return plot_nozzle_contour(context, &contour, filename);
+}
+
+int plot_nozzle_contour(NgcContext* context, const NozzleContour* nozzle, const char* filename) {
     if (!nozzle || !filename) {
-        return -1;
+        return ngc_set_error(context, "Null pointer passed to plotting function");
     }
 
-    FILE* gnuplot_script = fopen("plot_nozzle.gp", "w");
-    if (!gnuplot_script) {
-        printf("Error: Cannot create gnuplot script file\n");
+    PlotOptions options = { plot_format_from_filename(filename), 0, 0 };
+    if (write_nozzle_plot(context, nozzle, &options, filename) != 0) {
         return -1;
     }
 
-    // Write gnuplot script
-    fprintf(gnuplot_script, "set terminal png size 800,600\n");
-    fprintf(gnuplot_script, "set output '%s'\n", filename);
-    fprintf(gnuplot_script, "set title 'Bell Nozzle Geometry'\n");
-    fprintf(gnuplot_script, "set xlabel 'Axial Position (m)'\n");
-    fprintf(gnuplot_script, "set ylabel 'Radius (m)'\n");
-    fprintf(gnuplot_script, "set grid\n");
-    fprintf(gnuplot_script, "set key top left\n");
-    
-    // Plot upper and lower contours
-    fprintf(gnuplot_script, "plot 'nozzle_upper.dat' with lines title 'Upper Contour', \\\n");
-    fprintf(gnuplot_script, "     'nozzle_lower.dat' with lines title 'Lower Contour'\n");
-    
-    fclose(gnuplot_script);
-
-    // Create upper contour data file
-    FILE* upper_file = fopen("nozzle_upper.dat", "w");
-    if (!upper_file) {
-        printf("Error: Cannot create upper contour data file\n");
-        return -1;
+    ngc_diagnostic(context, "Nozzle geometry plot saved to %s", filename);
+    return 0;
+}
+
+static int write_plot_file(NgcContext* context, const char* filename, const unsigned char* data, size_t size) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return ngc_set_error(context, "Cannot create plot file %s", filename);
     }
 
-    // Create lower contour data file
-    FILE* lower_file = fopen("nozzle_lower.dat", "w");
-    if (!lower_file) {
-        printf("Error: Cannot create lower contour data file\n");
-        fclose(upper_file);
-        return -1;
+    int status = fwrite(data, 1, size, file) == size ? 0 : -1;
+    if (fclose(file) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        ngc_set_error(context, "Cannot write plot file %s", filename);
     }
+    return status;
+}
 
-    // Write geometry data
-    for (int i = 0; i < nozzle->num_points; i++) {
-        fprintf(upper_file, "%.6f %.6f\n", nozzle->geometry[i].x, nozzle->geometry[i].y);
-        fprintf(lower_file, "%.6f %.6f\n", nozzle->geometry[i].x, -nozzle->geometry[i].y);
+int write_nozzle_plot(NgcContext* context, const NozzleContour* nozzle, const PlotOptions* options,
+                      const char* filename) {
+    if (!nozzle || !filename) {
+        return ngc_set_error(context, "Null pointer passed to plotting function");
     }
 
-    fclose(upper_file);
-    fclose(lower_file);
+    unsigned char* data;
+    size_t size;
+    if (render_nozzle_plot(nozzle, options, &data, &size) != 0) {
+        return ngc_set_error(context, "Cannot render nozzle plot");
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_IO);
+    int status = write_plot_file(context, filename, data, size);
+    NGC_PROFILE_END(timer);
+    free(data);
+    return status;
+}
+
+PlotFormat plot_format_from_filename(const char* filename) {
+    const char* dot = filename ? strrchr(filename, '.') : NULL;
+    if (dot && (strcmp(dot, ".svg") == 0 || strcmp(dot, ".SVG") == 0)) {
+        return PLOT_FORMAT_SVG;
+    }
+    return PLOT_FORMAT_PNG;
+}
+
+int write_geometry_data(NgcContext* context, const NozzleGeometry* nozzle, const char* filename) {
+    if (!nozzle) {
+        return ngc_set_error(context, "Null pointer passed to output function");
+    }
+
+    NozzleContour contour;
+    nozzle_contour_from_geometry(&contour, (NozzleGeometry*)nozzle);
+    return write_contour_data(context, &contour, filename);
+}
+
+static int write_contour_text(NgcContext* context, const NozzleContour* nozzle, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return ngc_set_error(context, "Cannot create geometry data file %s", filename);
+    }
+
+    fprintf(file, "# Nozzle Geometry Data\n");
+    fprintf(file, "# Throat radius: %.6f m\n", nozzle->throat_radius);
+    fprintf(file, "# Exit radius: %.6f m\n", nozzle->exit_radius);
+    fprintf(file, "# Expansion ratio: %.3f\n", nozzle->expansion_ratio);
+    fprintf(file, "# Number of points: %d\n", nozzle->num_points);
+    fprintf(file, "#\n");
+    fprintf(file, "# X (m)\t\tY (m)\n");
 
-    // Execute gnuplot (if available)
-    int result = system("gnuplot plot_nozzle.gp 2>/dev/null");
-    if (result == 0) {
-        printf("Nozzle geometry plot saved to %s\n", filename);
-    } else {
-        printf("Gnuplot not available. Data files created: nozzle_upper.dat, nozzle_lower.dat\n");
-        printf("You can manually plot using: gnuplot plot_nozzle.gp\n");
+    for (int i = 0; i < nozzle->num_points; i++) {
+        fprintf(file, "%.6f\t\t%.6f\n", nozzle->points[i].x, nozzle->points[i].y);
     }
 
+    if (fclose(file) != 0) {
+        return ngc_set_error(context, "Cannot write geometry data file %s", filename);
+    }
     return 0;
 }
 
-int write_geometry_data(const NozzleGeometry* nozzle, const char* filename) {
+int write_contour_data(NgcContext* context, const NozzleContour* nozzle, const char* filename) {
     if (!nozzle || !filename) {
-        return -1;
+        return ngc_set_error(context, "Null pointer passed to output function");
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_IO);
+    int status = write_contour_text(context, nozzle, filename);
+    NGC_PROFILE_END(timer);
+    if (status == 0) {
+        ngc_diagnostic(context, "Geometry data written to %s", filename);
     }
+    return status;
+}
 
+static int write_flow_profile_text(NgcContext* context, const NozzleContour* nozzle,
+                                   const FlowProfileOutput* profile, const char* filename) {
     FILE* file = fopen(filename, "w");
     if (!file) {
-        printf("Error: Cannot create geometry data file %s\n", filename);
-        return -1;
+        return ngc_set_error(context, "Cannot create flow profile file %s", filename);
     }
 
-    fprintf(file, "# Nozzle Geometry Data\n");
+    fprintf(file, "# Nozzle Flow Profile\n");
     fprintf(file, "# Throat radius: %.6f m\n", nozzle->throat_radius);
     fprintf(file, "# Exit radius: %.6f m\n", nozzle->exit_radius);
     fprintf(file, "# Expansion ratio: %.3f\n", nozzle->expansion_ratio);
     fprintf(file, "# Number of points: %d\n", nozzle->num_points);
     fprintf(file, "#\n");
-    fprintf(file, "# X (m)\t\tY (m)\n");
+    fprintf(file, "# X (m)\t\tY (m)\t\tA/A*\t\tMach\t\tP (Pa)\t\tT (K)\t\tRho (kg/m^3)\tV (m/s)\n");
 
     for (int i = 0; i < nozzle->num_points; i++) {
-        fprintf(file, "%.6f\t\t%.6f\n", nozzle->geometry[i].x, nozzle->geometry[i].y);
+        fprintf(file, "%.6f\t%.6f\t%.6f\t%.6f\t%.6e\t%.3f\t%.6e\t%.3f\n",
+                nozzle->points[i].x, nozzle->points[i].y, profile->area_ratio[i], profile->mach[i],
+                profile->pressure[i], profile->temperature[i], profile->density[i], profile->velocity[i]);
     }
 
-    fclose(file);
-    printf("Geometry data written to %s\n", filename);
+    if (fclose(file) != 0) {
+        return ngc_set_error(context, "Cannot write flow profile file %s", filename);
+    }
     return 0;
 }
 
-int print_performance_results(const PerformanceResults* results) {
-    if (!results) {
+int write_flow_profile_data(NgcContext* context, const NozzleContour* contour,
+                            const FlowProfileOutput* profile, const char* filename) {
+    if (!contour || !profile || !filename || !profile->area_ratio || !profile->mach || !profile->pressure ||
+        !profile->temperature || !profile->density || !profile->velocity) {
+        return ngc_set_error(context, "Null pointer passed to output function");
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_IO);
+    int status = write_flow_profile_text(context, contour, profile, filename);
+    NGC_PROFILE_END(timer);
+    if (status == 0) {
+        ngc_diagnostic(context, "Flow profile written to %s", filename);
+    }
+    return status;
+}
+
+static int write_thermal_profile_text(NgcContext* context, const NozzleContour* nozzle,
+                                      const ThermalProfileOutput* profile, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        return ngc_set_error(context, "Cannot create thermal profile file %s", filename);
+    }
+
+    fprintf(file, "# Nozzle Wall Heat Transfer (Bartz)\n");
+    fprintf(file, "# Throat radius: %.6f m\n", nozzle->throat_radius);
+    fprintf(file, "# Exit radius: %.6f m\n", nozzle->exit_radius);
+    fprintf(file, "# Expansion ratio: %.3f\n", nozzle->expansion_ratio);
+    fprintf(file, "# Number of points: %d\n", nozzle->num_points);
+    fprintf(file, "#\n");
+    fprintf(file, "# X (m)\t\tY (m)\t\th (W/m^2-K)\tTaw (K)\t\tq (W/m^2)\n");
+
+    for (int i = 0; i < nozzle->num_points; i++) {
+        fprintf(file, "%.6f\t%.6f\t%.6e\t%.3f\t%.6e\n",
+                nozzle->points[i].x, nozzle->points[i].y, profile->heat_transfer_coefficient[i],
+                profile->adiabatic_wall_temperature[i], profile->heat_flux[i]);
+    }
+
+    if (fclose(file) != 0) {
+        return ngc_set_error(context, "Cannot write thermal profile file %s", filename);
+    }
+    return 0;
+}
+
+int write_thermal_profile_data(NgcContext* context, const NozzleContour* contour,
+                               const ThermalProfileOutput* profile, const char* filename) {
+    if (!contour || !profile || !filename || !profile->heat_transfer_coefficient ||
+        !profile->adiabatic_wall_temperature || !profile->heat_flux) {
+        return ngc_set_error(context, "Null pointer passed to output function");
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_IO);
+    int status = write_thermal_profile_text(context, contour, profile, filename);
+    NGC_PROFILE_END(timer);
+    if (status == 0) {
+        ngc_diagnostic(context, "Thermal profile written to %s", filename);
+    }
+    return status;
+}
+
+int print_performance_results(FILE* stream, const PerformanceResults* results) {
+    if (!stream || !results) {
         return -1;
     }
 
-    printf("\n=== NOZZLE PERFORMANCE RESULTS ===\n");
-    printf("Thrust:                  %.2f N\n", results->thrust);
-    printf("Specific Impulse:        %.2f s\n", results->specific_impulse);
-    printf("Exit Velocity:           %.2f m/s\n", results->exit_velocity);
-    printf("Exit Pressure:           %.2f Pa\n", results->exit_pressure);
-    printf("Exit Temperature:        %.2f K\n", results->exit_temperature);
-    printf("Mass Flow Rate:          %.6f kg/s\n", results->mass_flow_rate);
-    printf("Characteristic Velocity: %.2f m/s\n", results->characteristic_velocity);
-    printf("Thrust Coefficient:      %.4f\n", results->thrust_coefficient);
-    printf("==================================\n\n");
+    fprintf(stream, "\n=== NOZZLE PERFORMANCE RESULTS ===\n");
+    fprintf(stream, "Thrust:                  %.2f N\n", results->thrust);
+    fprintf(stream, "Specific Impulse:        %.2f s\n", results->specific_impulse);
+    fprintf(stream, "Exit Velocity:           %.2f m/s\n", results->exit_velocity);
+    fprintf(stream, "Exit Pressure:           %.2f Pa\n", results->exit_pressure);
+    fprintf(stream, "Exit Temperature:        %.2f K\n", results->exit_temperature);
+    fprintf(stream, "Exit Mach Number:        %.4f\n", results->exit_mach);
+    fprintf(stream, "Mass Flow Rate:          %.6f kg/s\n", results->mass_flow_rate);
+    fprintf(stream, "Characteristic Velocity: %.2f m/s\n", results->characteristic_velocity);
+    fprintf(stream, "Thrust Coefficient:      %.4f\n", results->thrust_coefficient);
+    fprintf(stream, "==================================\n\n");
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "random.h"
+#include <string.h>
+
+// Single-precision validation. Random designs are evaluated by both batch
+// paths and the relative differences of thrust, Isp and Cf are collected
+// per expansion-ratio band. Case i draws its inputs from a generator
+// seeded by the seed and i alone, so the cases do not depend on the thread
+// count. The double path gets the exact inputs and the float path their
+// rounded copies, so the errors include the rounding of the inputs.
+// Designs below PRECISION_F32_GAMMA_MIN, which single-precision runs send
+// to the double path, are collected apart from the rest.
+
+#define PRECISION_DEFAULT_SAMPLES 1000000
+#define PRECISION_DEFAULT_SEED 0x7f4a7c159e3779b9ULL
+#define PRECISION_DEFAULT_AMBIENT_RATIO 2.5   // Summerfield: separation below pe/pa = 0.4
+
+// Cases per task and per kernel call
+#define PRECISION_BLOCK 1024
+
+// Bell contours checked for the PointF rounding, spaced over the expansion range
+#define PRECISION_CONTOURS 64
+#define PRECISION_CONTOUR_POINTS 1000
+
+// Ranges of the inputs the config does not set; all are scale-free in the errors
+#define PRECISION_THROAT_MIN 1.0e-3
+#define PRECISION_THROAT_MAX 1.0
+#define PRECISION_WEIGHT_MIN 0.002
+#define PRECISION_WEIGHT_MAX 0.040
+#define PRECISION_GAS_CONSTANT 8.314462618
+
+static const char* const precision_output_names[PRECISION_NUM_OUTPUTS] = {
+    "thrust",
+    "specific-impulse",
+    "thrust-coefficient"
+};
+
+typedef struct {
+    double sum[PRECISION_NUM_BANDS][PRECISION_NUM_OUTPUTS];
+    double max[PRECISION_NUM_BANDS][PRECISION_NUM_OUTPUTS];
+    long long samples[PRECISION_NUM_BANDS];
+    double low_sum[PRECISION_NUM_OUTPUTS];
+    double low_max[PRECISION_NUM_OUTPUTS];
+    long long low_samples;
+    NozzleDesign worst[PRECISION_NUM_OUTPUTS];
+    double worst_error[PRECISION_NUM_OUTPUTS];
+    long long nonfinite;
+    double f32_seconds;
+    double f64_seconds;
+    double* buffer;              // Double inputs and outputs of a block
+    float* buffer_f32;
+    char padding[64];
+} PrecisionThreadState;
+
+typedef struct {
+    PrecisionConfig config;      // Defaults filled in
+    double log_expansion_min;
+    double log_expansion_span;
+    PrecisionThreadState* threads;
+} PrecisionJob;
+
+static double log_uniform(NgcRng* rng, double lower, double upper) {
+    return lower * exp(ngc_rng_uniform(rng) * log(upper / lower));
+}
+
+const char* precision_output_name(PrecisionOutput output) {
+    if (output < 0 || output >= PRECISION_NUM_OUTPUTS) {
+        return NULL;
+    }
+    return precision_output_names[output];
+}
+
+static int precision_band(const PrecisionJob* job, double expansion_ratio) {
+    int band = (int)((log(expansion_ratio) - job->log_expansion_min) / job->log_expansion_span * PRECISION_NUM_BANDS);
+    return band < 0 ? 0 : band >= PRECISION_NUM_BANDS ? PRECISION_NUM_BANDS - 1 : band;
+}
+
+static void precision_task(long long begin, long long end, int thread_id, void* context) {
+    PrecisionJob* job = (PrecisionJob*)context;
+    const PrecisionConfig* config = &job->config;
+    PrecisionThreadState* state = &job->threads[thread_id];
+    double (*in)[PRECISION_BLOCK] = (double (*)[PRECISION_BLOCK])state->buffer;
+    double (*out)[PRECISION_BLOCK] = in + 8;
+    float (*in_f32)[PRECISION_BLOCK] = (float (*)[PRECISION_BLOCK])state->buffer_f32;
+    float (*out_f32)[PRECISION_BLOCK] = in_f32 + 8;
+
+    PerformanceBatchInput input = { in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7] };
+    PerformanceBatchOutput output = {
+        out[0], out[1], out[2], out[3], out[4], out[5], out[6], out[7], out[8]
+    };
+    PerformanceBatchInputF input_f32 = {
+        in_f32[0], in_f32[1], in_f32[2], in_f32[3], in_f32[4], in_f32[5], in_f32[6], in_f32[7]
+    };
+    PerformanceBatchOutputF output_f32 = {
+        out_f32[0], out_f32[1], out_f32[2], out_f32[3], out_f32[4], out_f32[5], out_f32[6], out_f32[7],
+        out_f32[8]
+    };
+
+    for (long long b = begin; b < end; b++) {
+        long long first = b * PRECISION_BLOCK;
+        size_t count = (size_t)(config->samples - first < PRECISION_BLOCK ? config->samples - first
+                                                                          : PRECISION_BLOCK);
+        double ambient_fraction[PRECISION_BLOCK];
+
+        for (size_t i = 0; i < count; i++) {
+            NgcRng rng = { config->seed ^ ((unsigned long long)(first + (long long)i) * 0xd1b54a32d192ed03ULL) };
+            double expansion_ratio = log_uniform(&rng, config->expansion_min, config->expansion_max);
+            in[0][i] = log_uniform(&rng, PRECISION_THROAT_MIN, PRECISION_THROAT_MAX);
+            in[1][i] = in[0][i] * sqrt(expansion_ratio);
+            in[2][i] = log_uniform(&rng, config->pressure_min, config->pressure_max);
+            in[3][i] = 0.0;
+            in[4][i] = config->temperature_min +
+                       ngc_rng_uniform(&rng) * (config->temperature_max - config->temperature_min);
+            in[5][i] = PRECISION_WEIGHT_MIN + ngc_rng_uniform(&rng) * (PRECISION_WEIGHT_MAX - PRECISION_WEIGHT_MIN);
+            in[6][i] = config->gamma_max - ngc_rng_uniform(&rng) * (config->gamma_max - config->gamma_min);
+            in[7][i] = PRECISION_GAS_CONSTANT;
+            ambient_fraction[i] = ngc_rng_uniform(&rng) * config->ambient_ratio;
+        }
+
+        // The vacuum pass gives the exit pressure that bounds the ambient
+        // pressure; below the throat pressure the nozzle is always choked
+        calculate_performance_batch_isa(&input, &output, count, config->isa);
+        for (size_t i = 0; i < count; i++) {
+            double gamma = in[6][i];
+            double throat_pressure = in[2][i] * pow(2.0 / (gamma + 1.0), gamma / (gamma - 1.0));
+            in[3][i] = fmin(ambient_fraction[i] * out[3][i], throat_pressure);
+        }
+        for (int f = 0; f < 8; f++) {
+            for (size_t i = 0; i < count; i++) {
+                in_f32[f][i] = (float)in[f][i];
+            }
+        }
+
+        double start = ngc_wall_time();
+        calculate_performance_batch_isa(&input, &output, count, config->isa);
+        double middle = ngc_wall_time();
+        calculate_performance_batch_f32_isa(&input_f32, &output_f32, count, config->isa);
+        state->f64_seconds += middle - start;
+        state->f32_seconds += ngc_wall_time() - middle;
+
+        const double* reference[PRECISION_NUM_OUTPUTS] = {
+            output.thrust, output.specific_impulse, output.thrust_coefficient
+        };
+        const float* values[PRECISION_NUM_OUTPUTS] = {
+            output_f32.thrust, output_f32.specific_impulse, output_f32.thrust_coefficient
+        };
+        for (size_t i = 0; i < count; i++) {
+            if (in[6][i] < PRECISION_F32_GAMMA_MIN) {
+                for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+                    double value = values[o][i];
+                    double error = isfinite(value) ? fabs(value - reference[o][i]) / fabs(reference[o][i]) : 1.0;
+                    state->low_sum[o] += error;
+                    state->low_max[o] = fmax(state->low_max[o], error);
+                }
+                state->low_samples++;
+                continue;
+            }
+
+            int band = precision_band(job, (in[1][i] * in[1][i]) / (in[0][i] * in[0][i]));
+            int finite = 1;
+            for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+                double value = values[o][i];
+                double error = isfinite(value) ? fabs(value - reference[o][i]) / fabs(reference[o][i]) : 1.0;
+                finite &= isfinite(value);
+                state->sum[band][o] += error;
+                if (error > state->max[band][o]) {
+                    state->max[band][o] = error;
+                }
+                if (error > state->worst_error[o]) {
+                    NozzleDesign* worst = &state->worst[o];
+                    state->worst_error[o] = error;
+                    worst->throat_radius = in[0][i];
+                    worst->exit_radius = in[1][i];
+                    worst->length_fraction = 1.0;
+                    worst->conditions.chamber_pressure = in[2][i];
+                    worst->conditions.ambient_pressure = in[3][i];
+                    worst->conditions.chamber_temperature = in[4][i];
+                    worst->conditions.molecular_weight = in[5][i];
+                    worst->conditions.gamma = in[6][i];
+                    worst->conditions.gas_constant = in[7][i];
+                }
+            }
+            state->nonfinite += !finite;
+            state->samples[band]++;
+        }
+    }
+}
+
+// Largest PointF rounding over bell contours spanning the expansion range
+static double contour_rounding_error(const PrecisionConfig* config) {
+    Point points[PRECISION_CONTOUR_POINTS];
+    PointF stored[PRECISION_CONTOUR_POINTS];
+    ContourOptions options = { CONTOUR_UNIFORM, PRECISION_CONTOUR_POINTS, 0 };
+    double max_error = 0.0;
+
+    for (int c = 0; c < PRECISION_CONTOURS; c++) {
+        double expansion_ratio = config->expansion_min *
+                                 pow(config->expansion_max / config->expansion_min, c / (PRECISION_CONTOURS - 1.0));
+        NozzleContour contour;
+        nozzle_contour_init(&contour, 1.0, sqrt(expansion_ratio), points, PRECISION_CONTOUR_POINTS);
+        if (calculate_bell_nozzle_contour(&contour, 1.0, &options) != 0) {
+            continue;
+        }
+        nozzle_contour_to_float(&contour, stored);
+        for (int i = 0; i < contour.num_points; i++) {
+            double error = fmax(fabs(stored[i].x - contour.points[i].x), fabs(stored[i].y - contour.points[i].y));
+            max_error = fmax(max_error, error / contour.throat_radius);
+        }
+    }
+    return max_error;
+}
+
+int check_performance_f32(const PrecisionConfig* config, PrecisionReport* report) {
+    if (!config || !report) {
+        return -1;
+    }
+
+    PrecisionJob job;
+    PrecisionConfig* c = &job.config;
+    *c = *config;
+    if (c->samples <= 0) c->samples = PRECISION_DEFAULT_SAMPLES;
+    if (c->expansion_min <= 0) c->expansion_min = 1.01;
+    if (c->expansion_max <= 0) c->expansion_max = 10000.0;
+    if (c->gamma_min <= 0) c->gamma_min = 1.0;
+    if (c->gamma_max <= 0) c->gamma_max = 1.67;
+    if (c->pressure_min <= 0) c->pressure_min = 1.0e5;
+    if (c->pressure_max <= 0) c->pressure_max = 3.0e7;
+    if (c->temperature_min <= 0) c->temperature_min = 500.0;
+    if (c->temperature_max <= 0) c->temperature_max = 4000.0;
+    if (c->ambient_ratio <= 0) c->ambient_ratio = PRECISION_DEFAULT_AMBIENT_RATIO;
+    if (c->seed == 0) c->seed = PRECISION_DEFAULT_SEED;
+    if (c->expansion_min <= 1.0 || c->expansion_max < c->expansion_min || c->gamma_min < 1.0 ||
+        !(c->gamma_max > c->gamma_min) || c->pressure_max < c->pressure_min ||
+        c->temperature_max < c->temperature_min) {
+        return -1;
+    }
+    BatchIsa available = batch_isa_available();
+    if (c->isa > available) {
+        return -1;
+    }
+    job.log_expansion_min = log(c->expansion_min);
+    job.log_expansion_span = fmax(log(c->expansion_max) - job.log_expansion_min, 1e-300);
+
+    long long num_blocks = (c->samples + PRECISION_BLOCK - 1) / PRECISION_BLOCK;
+    int num_threads = c->num_threads > 0 ? c->num_threads : ngc_cpu_count();
+    if (num_threads > num_blocks) {
+        num_threads = (int)num_blocks;
+    }
+    job.threads = calloc((size_t)num_threads, sizeof(PrecisionThreadState));
+    if (!job.threads) {
+        return -1;
+    }
+    int status = 0;
+    for (int t = 0; t < num_threads && status == 0; t++) {
+        job.threads[t].buffer = malloc(17 * PRECISION_BLOCK * sizeof(double));
+        job.threads[t].buffer_f32 = malloc(17 * PRECISION_BLOCK * sizeof(float));
+        if (!job.threads[t].buffer || !job.threads[t].buffer_f32) {
+            status = -1;
+        }
+    }
+
+    memset(report, 0, sizeof(PrecisionReport));
+    double start = ngc_wall_time();
+    if (status == 0) {
+        report->threads_used = parallel_for(num_blocks, 1, num_threads, precision_task, &job);
+        status = report->threads_used < 0 ? -1 : 0;
+    }
+
+    if (status == 0) {
+        double worst_error[PRECISION_NUM_OUTPUTS] = {0};
+        for (int b = 0; b < PRECISION_NUM_BANDS; b++) {
+            PrecisionBand* band = &report->bands[b];
+            band->expansion_min = exp(job.log_expansion_min + job.log_expansion_span * b / PRECISION_NUM_BANDS);
+            band->expansion_max = exp(job.log_expansion_min + job.log_expansion_span * (b + 1) / PRECISION_NUM_BANDS);
+            double sum[PRECISION_NUM_OUTPUTS] = {0};
+            for (int t = 0; t < num_threads; t++) {
+                band->samples += job.threads[t].samples[b];
+                for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+                    sum[o] += job.threads[t].sum[b][o];
+                    band->max_error[o] = fmax(band->max_error[o], job.threads[t].max[b][o]);
+                }
+            }
+            report->total.samples += band->samples;
+            for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+                band->mean_error[o] = band->samples > 0 ? sum[o] / (double)band->samples : 0.0;
+                report->total.mean_error[o] += sum[o];
+                report->total.max_error[o] = fmax(report->total.max_error[o], band->max_error[o]);
+            }
+        }
+        report->total.expansion_min = c->expansion_min;
+        report->total.expansion_max = c->expansion_max;
+        report->total.gamma_min = fmax(c->gamma_min, PRECISION_F32_GAMMA_MIN);
+        report->total.gamma_max = c->gamma_max;
+        for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+            report->total.mean_error[o] /= report->total.samples > 0 ? (double)report->total.samples : 1.0;
+        }
+        for (int b = 0; b < PRECISION_NUM_BANDS; b++) {
+            report->bands[b].gamma_min = report->total.gamma_min;
+            report->bands[b].gamma_max = report->total.gamma_max;
+        }
+
+        PrecisionBand* low = &report->low_gamma;
+        low->expansion_min = c->expansion_min;
+        low->expansion_max = c->expansion_max;
+        low->gamma_min = c->gamma_min;
+        low->gamma_max = fmin(c->gamma_max, PRECISION_F32_GAMMA_MIN);
+        for (int t = 0; t < num_threads; t++) {
+            low->samples += job.threads[t].low_samples;
+            for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+                low->mean_error[o] += job.threads[t].low_sum[o];
+                low->max_error[o] = fmax(low->max_error[o], job.threads[t].low_max[o]);
+            }
+        }
+        for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+            low->mean_error[o] /= low->samples > 0 ? (double)low->samples : 1.0;
+        }
+
+        for (int t = 0; t < num_threads; t++) {
+            PrecisionThreadState* state = &job.threads[t];
+            for (int o = 0; o < PRECISION_NUM_OUTPUTS; o++) {
+                if (state->worst_error[o] > worst_error[o]) {
+                    worst_error[o] = state->worst_error[o];
+                    report->worst[o] = state->worst[o];
+                }
+            }
+            report->nonfinite += state->nonfinite;
+            report->f32_ns_per_case += state->f32_seconds;
+            report->f64_ns_per_case += state->f64_seconds;
+        }
+        report->f32_ns_per_case *= 1e9 / (double)c->samples;
+        report->f64_ns_per_case *= 1e9 / (double)c->samples;
+        report->contour_error = contour_rounding_error(c);
+    }
+    report->elapsed_seconds = ngc_wall_time() - start;
+
+    for (int t = 0; t < num_threads; t++) {
+        free(job.threads[t].buffer);
+        free(job.threads[t].buffer_f32);
+    }
+    free(job.threads);
+    return status;
+}
@@ -0,0 +1,155 @@
+#include "profile.h"
+#include <string.h>
+
+// Default timing rate: one call in 64 per stage
+#define DEFAULT_SAMPLE_PERIOD 64
+
+// Back-to-back clock reads used to estimate the cost of one
+#define CLOCK_CALIBRATION_READS 64
+
+static const char* const stage_names[NGC_NUM_STAGES] = {
+    "geometry",
+    "throat",
+    "exit_solve",
+    "performance",
+    "flow",
+    "thermal",
+    "plot",
+    "io"
+};
+
+#ifndef NGC_NO_PROFILE
+__thread NgcProfile* ngc_profile_current = NULL;
+#endif
+
+int ngc_profile_available(void) {
+#ifdef NGC_NO_PROFILE
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+void ngc_profile_init(NgcProfile* profile, int sample_period) {
+    if (!profile) {
+        return;
+    }
+
+    memset(profile, 0, sizeof(NgcProfile));
+    if (sample_period <= 0) {
+        sample_period = DEFAULT_SAMPLE_PERIOD;
+    }
+
+    // Round up to a power of two so the sampling test is a mask
+    unsigned int period = 1;
+    while (period < (unsigned int)sample_period && period < (1u << 30)) {
+        period <<= 1;
+    }
+    profile->sample_mask = period - 1;
+
+    // Spread the stages' timed calls evenly over the period
+    for (int s = 0; s < NGC_NUM_STAGES; s++) {
+        profile->sample_phase[s] = (unsigned int)((unsigned long long)s * period / NGC_NUM_STAGES);
+    }
+
+    // The smallest interval between two reads is what an empty timed call
+    // would report
+    double overhead = INFINITY;
+    double previous = ngc_wall_time();
+    for (int i = 0; i < CLOCK_CALIBRATION_READS; i++) {
+        double now = ngc_wall_time();
+        if (now - previous < overhead) {
+            overhead = now - previous;
+        }
+        previous = now;
+    }
+    profile->clock_overhead = overhead;
+}
+
+NgcProfile* ngc_profile_attach(NgcProfile* profile) {
+#ifdef NGC_NO_PROFILE
+    (void)profile;
+    return NULL;
+#else
+    NgcProfile* previous = ngc_profile_current;
+    ngc_profile_current = profile;
+    return previous;
+#endif
+}
+
+void ngc_profile_merge(NgcProfile* total, const NgcProfile* part) {
+    if (!total || !part) {
+        return;
+    }
+
+    for (int s = 0; s < NGC_NUM_STAGES; s++) {
+        total->stages[s].calls += part->stages[s].calls;
+        total->stages[s].timed_calls += part->stages[s].timed_calls;
+        total->stages[s].timed_seconds += part->stages[s].timed_seconds;
+    }
+    total->solver_calls += part->solver_calls;
+    total->solver_iterations += part->solver_iterations;
+    total->solver_failures += part->solver_failures;
+}
+
+const char* ngc_profile_stage_name(NgcProfileStage stage) {
+    if (stage < 0 || stage >= NGC_NUM_STAGES) {
+        return NULL;
+    }
+    return stage_names[stage];
+}
+
+double ngc_profile_stage_seconds(const NgcProfile* profile, NgcProfileStage stage) {
+    if (!profile || stage < 0 || stage >= NGC_NUM_STAGES) {
+        return 0.0;
+    }
+
+    // Scale the timed calls up to all calls
+    const NgcStageProfile* s = &profile->stages[stage];
+    if (s->timed_calls == 0) {
+        return 0.0;
+    }
+    return s->timed_seconds * (double)s->calls / (double)s->timed_calls;
+}
+
+int ngc_profile_print(FILE* stream, const NgcProfile* profile) {
+    if (!stream || !profile) {
+        return -1;
+    }
+
+    fprintf(stream, "\n=== PROFILE ===\n");
+    fprintf(stream, "%-12s %12s %14s %12s\n", "Stage", "Calls", "Total (ms)", "Mean (us)");
+    for (int s = 0; s < NGC_NUM_STAGES; s++) {
+        const NgcStageProfile* stage = &profile->stages[s];
+        double seconds = ngc_profile_stage_seconds(profile, (NgcProfileStage)s);
+        fprintf(stream, "%-12s %12lld %14.3f %12.3f\n", stage_names[s], stage->calls, seconds * 1e3,
+                stage->calls > 0 ? seconds * 1e6 / stage->calls : 0.0);
+    }
+
+    fprintf(stream, "Area-Mach solves:        %lld\n", profile->solver_calls);
+    fprintf(stream, "Newton iterations:       %lld (%.2f per solve)\n", profile->solver_iterations,
+            profile->solver_calls > 0 ? (double)profile->solver_iterations / profile->solver_calls : 0.0);
+    fprintf(stream, "Non-converged solves:    %lld\n", profile->solver_failures);
+    if (profile->sample_mask > 0) {
+        fprintf(stream, "Stage times are estimated from 1 in %u calls\n", profile->sample_mask + 1);
+    }
+    fprintf(stream, "===============\n\n");
+    return 0;
+}
+
+int ngc_profile_write_json(FILE* stream, const NgcProfile* profile) {
+    if (!stream || !profile) {
+        return -1;
+    }
+
+    fprintf(stream, "{\n  \"sample_period\": %u,\n  \"stages\": {\n", profile->sample_mask + 1);
+    for (int s = 0; s < NGC_NUM_STAGES; s++) {
+        const NgcStageProfile* stage = &profile->stages[s];
+        fprintf(stream, "    \"%s\": {\"calls\": %lld, \"timed_calls\": %lld, \"seconds\": %.9g}%s\n",
+                stage_names[s], stage->calls, stage->timed_calls,
+                ngc_profile_stage_seconds(profile, (NgcProfileStage)s), s + 1 < NGC_NUM_STAGES ? "," : "");
+    }
+    fprintf(stream, "  },\n  \"solver\": {\"calls\": %lld, \"iterations\": %lld, \"failures\": %lld}\n}\n",
+            profile->solver_calls, profile->solver_iterations, profile->solver_failures);
+    return ferror(stream) ? -1 : 0;
+}
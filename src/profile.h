@@ -0,0 +1,66 @@
+#ifndef NGC_PROFILE_H
+#define NGC_PROFILE_H
+
+#include "../include/ngc.h"
+
+// Stage timers and solver counters. Building with -DNGC_NO_PROFILE
+// removes them entirely; otherwise each probe costs a thread-local load
+// and a branch until a profile is attached to the calling thread.
+
+#ifdef NGC_NO_PROFILE
+
+#define NGC_PROFILE_BEGIN(timer, stage)
+#define NGC_PROFILE_END(timer)
+#define NGC_PROFILE_SOLVE(iterations, status)
+
+#else
+
+typedef struct {
+    NgcProfile* profile;         // NULL when this call is not timed
+    NgcProfileStage stage;
+    double start;
+} NgcProfileTimer;
+
+extern __thread NgcProfile* ngc_profile_current;
+
+static inline NgcProfileTimer ngc_profile_begin(NgcProfileStage stage) {
+    NgcProfileTimer timer = { ngc_profile_current, stage, 0.0 };
+    if (timer.profile) {
+        // Every call is counted; the first and then one in (sample_mask + 1)
+        // are timed, at a different phase for each stage so that a timed
+        // call does not also pay for the clock reads of the stages it contains
+        long long calls = timer.profile->stages[stage].calls++;
+        if (calls == 0 || (calls & timer.profile->sample_mask) == timer.profile->sample_phase[stage]) {
+            timer.start = ngc_wall_time();
+        } else {
+            timer.profile = NULL;
+        }
+    }
+    return timer;
+}
+
+static inline void ngc_profile_end(const NgcProfileTimer* timer) {
+    if (timer->profile) {
+        NgcStageProfile* stage = &timer->profile->stages[timer->stage];
+        double elapsed = ngc_wall_time() - timer->start - timer->profile->clock_overhead;
+        stage->timed_calls++;
+        stage->timed_seconds += elapsed > 0.0 ? elapsed : 0.0;
+    }
+}
+
+static inline void ngc_profile_solve(int iterations, int status) {
+    NgcProfile* profile = ngc_profile_current;
+    if (profile) {
+        profile->solver_calls++;
+        profile->solver_iterations += iterations;
+        profile->solver_failures += status != 0;
+    }
+}
+
+#define NGC_PROFILE_BEGIN(timer, stage) NgcProfileTimer timer = ngc_profile_begin(stage)
+#define NGC_PROFILE_END(timer) ngc_profile_end(&(timer))
+#define NGC_PROFILE_SOLVE(iterations, status) ngc_profile_solve(iterations, status)
+
+#endif // NGC_NO_PROFILE
+
+#endif // NGC_PROFILE_H
@@ -0,0 +1,38 @@
+#ifndef NGC_RANDOM_H
+#define NGC_RANDOM_H
+
+#include "../include/ngc.h"
+
+// splitmix64 generator shared by the design searches and the precision
+// check. A generator is a single word, so each case or run seeds its own.
+
+typedef struct {
+    unsigned long long state;
+} NgcRng;
+
+static inline unsigned long long ngc_rng_next(NgcRng* rng) {
+    unsigned long long z = (rng->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+static inline double ngc_rng_uniform(NgcRng* rng) {
+    return (ngc_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Standard normal by Box-Muller; u1 is in (0, 1] so the logarithm is finite
+static inline double ngc_rng_gaussian(NgcRng* rng) {
+    double u1 = ((ngc_rng_next(rng) >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+    double u2 = ngc_rng_uniform(rng);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2);
+}
+
+// Fold a coordinate back into [0, 1] by mirroring at the bounds
+static inline double ngc_reflect_unit(double x) {
+    x = fmod(fabs(x), 2.0);
+    return x > 1.0 ? 2.0 - x : x;
+}
+
+#endif // NGC_RANDOM_H
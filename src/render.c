@@ -0,0 +1,677 @@
+#include "profile.h"
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef NGC_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#define DEFAULT_PLOT_WIDTH 800
+#define DEFAULT_PLOT_HEIGHT 600
+#define MAX_PLOT_SIZE 16384
+
+// Below this size only the frame and the contours are drawn
+#define MIN_DECORATED_WIDTH 320
+#define MIN_DECORATED_HEIGHT 240
+
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define GLYPH_ADVANCE 6
+
+#define COLOR_BACKGROUND 0xffffff
+#define COLOR_FRAME 0x000000
+#define COLOR_GRID 0xd8d8d8
+#define COLOR_UPPER 0x9400d3
+#define COLOR_LOWER 0x009e73
+#define CONTOUR_LINE_WIDTH 2.0
+
+// Largest payload of a stored deflate block
+#define STORED_BLOCK_SIZE 65535
+
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+typedef struct {
+    int width;
+    int height;
+    int left;                    // Plot area in pixels
+    int right;
+    int top;
+    int bottom;
+    double x_min;                // Axis ranges, extended to whole ticks
+    double x_max;
+    double x_step;
+    double y_min;
+    double y_max;
+    double y_step;
+    int decorated;               // Title, labels, ticks and key
+} PlotLayout;
+
+typedef struct {
+    int width;
+    int height;
+    unsigned char* rgb;          // width * height * 3
+    unsigned char* coverage;     // Line coverage layer, width * height
+} Canvas;
+
+static const char* const plot_title = "Nozzle Geometry";
+static const char* const plot_x_label = "Axial Position (m)";
+static const char* const plot_y_label = "Radius (m)";
+static const char* const plot_upper_title = "Upper Contour";
+static const char* const plot_lower_title = "Lower Contour";
+
+// 5x7 bitmap font; rows top to bottom, bit 4 is the leftmost column.
+// Text is drawn in upper case.
+static const char font_chars[] = " ()+-./0123456789:ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const unsigned char font_rows[][GLYPH_HEIGHT] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ' '
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },  // (
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },  // )
+    { 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 },  // +
+    { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },  // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c },  // .
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },  // /
+    { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },  // 0
+    { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },  // 1
+    { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },  // 2
+    { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },  // 3
+    { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },  // 4
+    { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },  // 5
+    { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },  // 6
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },  // 7
+    { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },  // 8
+    { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },  // 9
+    { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },  // :
+    { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },  // A
+    { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },  // B
+    { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },  // C
+    { 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },  // D
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },  // E
+    { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },  // F
+    { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },  // G
+    { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },  // H
+    { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },  // I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },  // J
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },  // K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },  // L
+    { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },  // M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },  // N
+    { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },  // O
+    { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },  // P
+    { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },  // Q
+    { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },  // R
+    { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },  // S
+    { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },  // U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },  // V
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },  // W
+    { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },  // X
+    { 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 },  // Y
+    { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },  // Z
+};
+
+// CRC-32 (PNG/zlib polynomial), four bits at a time
+static const uint32_t crc_nibble_table[16] = {
+    0x00000000u, 0x1db71064u, 0x3b6e20c8u, 0x26d930acu,
+    0x76dc4190u, 0x6b6b51f4u, 0x4db26158u, 0x5005713cu,
+    0xedb88320u, 0xf00f9344u, 0xd6d6a3e8u, 0xcb61b38cu,
+    0x9b64c2b0u, 0x86d3d2d4u, 0xa00ae278u, 0xbdbdf21cu
+};
+
+static int buffer_reserve(ByteBuffer* buffer, size_t extra) {
+    if (buffer->size + extra <= buffer->capacity) {
+        return 0;
+    }
+
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+    while (capacity < buffer->size + extra) {
+        capacity *= 2;
+    }
+    unsigned char* data = realloc(buffer->data, capacity);
+    if (!data) {
+        return -1;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+static int buffer_append(ByteBuffer* buffer, const void* data, size_t size) {
+    if (buffer_reserve(buffer, size) != 0) {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return 0;
+}
+
+static int buffer_printf(ByteBuffer* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (length < 0 || buffer_reserve(buffer, (size_t)length + 1) != 0) {
+        return -1;
+    }
+
+    va_start(args, format);
+    vsnprintf((char*)buffer->data + buffer->size, (size_t)length + 1, format, args);
+    va_end(args);
+    buffer->size += (size_t)length;
+    return 0;
+}
+
+static void store_u32_be(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        crc = crc_nibble_table[crc & 0x0f] ^ (crc >> 4);
+        crc = crc_nibble_table[crc & 0x0f] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+#ifndef NGC_USE_ZLIB
+static uint32_t stored_adler32(const unsigned char* data, size_t size) {
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (size > 0) {
+        // 5552 bytes is the longest run before b can overflow 32 bits
+        size_t run = size < 5552 ? size : 5552;
+        size -= run;
+        while (run-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+#endif
+
+// Axis step of 1, 2 or 5 times a power of ten giving about target intervals
+static double nice_step(double span, int target) {
+    double raw = span / target;
+    double magnitude = pow(10.0, floor(log10(raw)));
+    double fraction = raw / magnitude;
+    double nice = fraction <= 1.0 ? 1.0 : fraction <= 2.0 ? 2.0 : fraction <= 5.0 ? 5.0 : 10.0;
+    return nice * magnitude;
+}
+
+static int tick_count(double min, double max, double step) {
+    return (int)floor((max - min) / step + 0.5);
+}
+
+static void format_tick(char* text, size_t size, double value, double step) {
+    int decimals = step >= 1.0 ? 0 : (int)ceil(-log10(step) - 1e-9);
+    if (fabs(value) < 1e-9 * step) {
+        value = 0.0;
+    }
+    snprintf(text, size, "%.*f", decimals, value);
+}
+
+static int layout_plot(PlotLayout* layout, const NozzleContour* contour, int width, int height) {
+    double x_min = contour->points[0].x;
+    double x_max = x_min;
+    double r_max = 0.0;
+    for (int i = 0; i < contour->num_points; i++) {
+        const Point* p = &contour->points[i];
+        if (!isfinite(p->x) || !isfinite(p->y)) {
+            return -1;
+        }
+        if (p->x < x_min) x_min = p->x;
+        if (p->x > x_max) x_max = p->x;
+        if (fabs(p->y) > r_max) r_max = fabs(p->y);
+    }
+    if (!(x_max > x_min)) {
+        x_max = x_min + (r_max > 0 ? r_max : 1.0);
+    }
+    if (!(r_max > 0)) {
+        r_max = 0.5 * (x_max - x_min);
+    }
+
+    layout->width = width;
+    layout->height = height;
+    layout->decorated = width >= MIN_DECORATED_WIDTH && height >= MIN_DECORATED_HEIGHT;
+
+    // Autoscale like gnuplot: extend each range out to whole ticks
+    layout->x_step = nice_step(x_max - x_min, 8);
+    layout->x_min = floor(x_min / layout->x_step + 1e-9) * layout->x_step;
+    layout->x_max = ceil(x_max / layout->x_step - 1e-9) * layout->x_step;
+    layout->y_step = nice_step(2.0 * r_max, 8);
+    layout->y_max = ceil(r_max / layout->y_step - 1e-9) * layout->y_step;
+    layout->y_min = -layout->y_max;
+
+    if (layout->decorated) {
+        layout->left = 80;
+        layout->right = width - 24;
+        layout->top = 44;
+        layout->bottom = height - 52;
+    } else {
+        layout->left = 2;
+        layout->right = width - 3;
+        layout->top = 2;
+        layout->bottom = height - 3;
+    }
+    return 0;
+}
+
+static double map_x(const PlotLayout* layout, double x) {
+    return layout->left + (x - layout->x_min) / (layout->x_max - layout->x_min) * (layout->right - layout->left);
+}
+
+static double map_y(const PlotLayout* layout, double y) {
+    return layout->bottom - (y - layout->y_min) / (layout->y_max - layout->y_min) * (layout->bottom - layout->top);
+}
+
+static int text_width(const char* text, int scale) {
+    size_t length = strlen(text);
+    return length > 0 ? (int)(length * GLYPH_ADVANCE - 1) * scale : 0;
+}
+
+// ---- Raster output ----
+
+static void canvas_blend(Canvas* canvas, int x, int y, uint32_t color, int alpha) {
+    unsigned char* pixel = canvas->rgb + 3 * ((size_t)y * canvas->width + x);
+    int channels[3] = { (int)(color >> 16) & 0xff, (int)(color >> 8) & 0xff, (int)color & 0xff };
+    for (int c = 0; c < 3; c++) {
+        pixel[c] = (unsigned char)((pixel[c] * (255 - alpha) + channels[c] * alpha + 127) / 255);
+    }
+}
+
+static void canvas_fill(Canvas* canvas, int x0, int y0, int x1, int y1, uint32_t color) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > canvas->width) x1 = canvas->width;
+    if (y1 > canvas->height) y1 = canvas->height;
+    for (int y = y0; y < y1; y++) {
+        unsigned char* pixel = canvas->rgb + 3 * ((size_t)y * canvas->width + x0);
+        for (int x = x0; x < x1; x++, pixel += 3) {
+            pixel[0] = (unsigned char)(color >> 16);
+            pixel[1] = (unsigned char)(color >> 8);
+            pixel[2] = (unsigned char)color;
+        }
+    }
+}
+
+// Draws text with its top-left corner at (x, y); vertical text reads
+// bottom to top with (x, y) as its bottom-left corner
+static void canvas_text(Canvas* canvas, int x, int y, const char* text, int scale, uint32_t color, int vertical) {
+    for (int i = 0; text[i]; i++) {
+        char upper = (text[i] >= 'a' && text[i] <= 'z') ? (char)(text[i] - 'a' + 'A') : text[i];
+        const char* found = strchr(font_chars, upper);
+        if (!found) {
+            continue;
+        }
+        const unsigned char* rows = font_rows[found - font_chars];
+
+        for (int row = 0; row < GLYPH_HEIGHT; row++) {
+            for (int col = 0; col < GLYPH_WIDTH; col++) {
+                if (!(rows[row] & (0x10 >> col))) {
+                    continue;
+                }
+                int u = (i * GLYPH_ADVANCE + col) * scale;
+                int v = row * scale;
+                if (vertical) {
+                    canvas_fill(canvas, x + v, y - u - scale, x + v + scale, y - u, color);
+                } else {
+                    canvas_fill(canvas, x + u, y + v, x + u + scale, y + v + scale, color);
+                }
+            }
+        }
+    }
+}
+
+// Anti-aliased polyline: coverage from the distance to each segment is
+// accumulated with max() so joints are not blended twice, then composited
+static void canvas_polyline(Canvas* canvas, const PlotLayout* layout, const NozzleContour* contour,
+                            double sign, uint32_t color, double line_width) {
+    double half = 0.5 * line_width;
+    int min_x = canvas->width, min_y = canvas->height, max_x = -1, max_y = -1;
+
+    int segments = contour->num_points > 1 ? contour->num_points - 1 : 1;
+    for (int i = 0; i < segments; i++) {
+        const Point* a = &contour->points[i];
+        const Point* b = &contour->points[i + 1 < contour->num_points ? i + 1 : i];
+        double ax = map_x(layout, a->x), ay = map_y(layout, sign * a->y);
+        double bx = map_x(layout, b->x), by = map_y(layout, sign * b->y);
+        double dx = bx - ax, dy = by - ay;
+        double length_squared = dx * dx + dy * dy;
+
+        int x0 = (int)floor(fmin(ax, bx) - half - 1), x1 = (int)ceil(fmax(ax, bx) + half + 1);
+        int y0 = (int)floor(fmin(ay, by) - half - 1), y1 = (int)ceil(fmax(ay, by) + half + 1);
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 > canvas->width - 1) x1 = canvas->width - 1;
+        if (y1 > canvas->height - 1) y1 = canvas->height - 1;
+
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                double px = x + 0.5 - ax, py = y + 0.5 - ay;
+                double t = length_squared > 0 ? (px * dx + py * dy) / length_squared : 0.0;
+                t = t < 0 ? 0 : t > 1 ? 1 : t;
+                double ex = px - t * dx, ey = py - t * dy;
+                double coverage = half + 0.5 - sqrt(ex * ex + ey * ey);
+                if (coverage <= 0) {
+                    continue;
+                }
+                int alpha = coverage >= 1 ? 255 : (int)(coverage * 255 + 0.5);
+                unsigned char* cell = &canvas->coverage[(size_t)y * canvas->width + x];
+                if (alpha > *cell) {
+                    *cell = (unsigned char)alpha;
+                }
+            }
+        }
+        if (x0 < min_x) min_x = x0;
+        if (y0 < min_y) min_y = y0;
+        if (x1 > max_x) max_x = x1;
+        if (y1 > max_y) max_y = y1;
+    }
+
+    for (int y = min_y; y <= max_y; y++) {
+        for (int x = min_x; x <= max_x; x++) {
+            unsigned char* cell = &canvas->coverage[(size_t)y * canvas->width + x];
+            if (*cell) {
+                canvas_blend(canvas, x, y, color, *cell);
+                *cell = 0;
+            }
+        }
+    }
+}
+
+static void canvas_key_entry(Canvas* canvas, const PlotLayout* layout, int row, const char* title, uint32_t color) {
+    int x = layout->left + 12;
+    int y = layout->top + 12 + row * 16;
+    canvas_fill(canvas, x, y + 2, x + 30, y + 4, color);
+    canvas_text(canvas, x + 38, y, title, 1, COLOR_FRAME, 0);
+}
+
+static void render_raster(Canvas* canvas, const PlotLayout* layout, const NozzleContour* contour) {
+    canvas_fill(canvas, 0, 0, canvas->width, canvas->height, COLOR_BACKGROUND);
+
+    if (layout->decorated) {
+        char label[32];
+        int nx = tick_count(layout->x_min, layout->x_max, layout->x_step);
+        int ny = tick_count(layout->y_min, layout->y_max, layout->y_step);
+
+        for (int i = 0; i <= nx; i++) {
+            double value = layout->x_min + i * layout->x_step;
+            int x = (int)floor(map_x(layout, value));
+            canvas_fill(canvas, x, layout->top, x + 1, layout->bottom, COLOR_GRID);
+            canvas_fill(canvas, x, layout->bottom - 5, x + 1, layout->bottom, COLOR_FRAME);
+            format_tick(label, sizeof(label), value, layout->x_step);
+            canvas_text(canvas, x - text_width(label, 1) / 2, layout->bottom + 8, label, 1, COLOR_FRAME, 0);
+        }
+        for (int i = 0; i <= ny; i++) {
+            double value = layout->y_min + i * layout->y_step;
+            int y = (int)floor(map_y(layout, value));
+            canvas_fill(canvas, layout->left, y, layout->right, y + 1, COLOR_GRID);
+            canvas_fill(canvas, layout->left, y, layout->left + 5, y + 1, COLOR_FRAME);
+            format_tick(label, sizeof(label), value, layout->y_step);
+            canvas_text(canvas, layout->left - 8 - text_width(label, 1), y - GLYPH_HEIGHT / 2, label, 1, COLOR_FRAME, 0);
+        }
+
+        canvas_text(canvas, (layout->left + layout->right - text_width(plot_title, 2)) / 2, 14,
+                    plot_title, 2, COLOR_FRAME, 0);
+        canvas_text(canvas, (layout->left + layout->right - text_width(plot_x_label, 1)) / 2,
+                    layout->height - 22, plot_x_label, 1, COLOR_FRAME, 0);
+        canvas_text(canvas, 18, (layout->top + layout->bottom + text_width(plot_y_label, 1)) / 2,
+                    plot_y_label, 1, COLOR_FRAME, 1);
+    }
+
+    // Frame
+    canvas_fill(canvas, layout->left, layout->top, layout->right + 1, layout->top + 1, COLOR_FRAME);
+    canvas_fill(canvas, layout->left, layout->bottom, layout->right + 1, layout->bottom + 1, COLOR_FRAME);
+    canvas_fill(canvas, layout->left, layout->top, layout->left + 1, layout->bottom + 1, COLOR_FRAME);
+    canvas_fill(canvas, layout->right, layout->top, layout->right + 1, layout->bottom + 1, COLOR_FRAME);
+
+    double line_width = layout->decorated ? CONTOUR_LINE_WIDTH : 1.0;
+    canvas_polyline(canvas, layout, contour, 1.0, COLOR_UPPER, line_width);
+    canvas_polyline(canvas, layout, contour, -1.0, COLOR_LOWER, line_width);
+
+    if (layout->decorated) {
+        canvas_key_entry(canvas, layout, 0, plot_upper_title, COLOR_UPPER);
+        canvas_key_entry(canvas, layout, 1, plot_lower_title, COLOR_LOWER);
+    }
+}
+
+static int png_chunk(ByteBuffer* out, const char* type, const unsigned char* data, size_t size) {
+    unsigned char word[4];
+    size_t start = out->size + 4;
+
+    store_u32_be(word, (uint32_t)size);
+    if (buffer_append(out, word, 4) != 0 || buffer_append(out, type, 4) != 0 ||
+        (size > 0 && buffer_append(out, data, size) != 0)) {
+        return -1;
+    }
+    store_u32_be(word, crc32_update(0, out->data + start, size + 4));
+    return buffer_append(out, word, 4);
+}
+
+// zlib stream of the filtered scanlines: zlib's deflate when built with
+// NGC_USE_ZLIB, stored (uncompressed) deflate blocks otherwise
+static int png_compress(ByteBuffer* out, const unsigned char* raw, size_t size) {
+#ifdef NGC_USE_ZLIB
+    uLongf length = compressBound((uLong)size);
+    if (buffer_reserve(out, length) != 0 ||
+        compress2(out->data + out->size, &length, raw, (uLong)size, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return -1;
+    }
+    out->size += length;
+    return 0;
+#else
+    static const unsigned char zlib_header[2] = { 0x78, 0x01 };
+    size_t blocks = size / STORED_BLOCK_SIZE + 1;
+    if (buffer_reserve(out, 2 + size + 5 * blocks + 4) != 0) {
+        return -1;
+    }
+
+    buffer_append(out, zlib_header, 2);
+    size_t offset = 0;
+    do {
+        size_t length = size - offset < STORED_BLOCK_SIZE ? size - offset : STORED_BLOCK_SIZE;
+        unsigned char block[5];
+        block[0] = offset + length == size ? 1 : 0;    // BFINAL, BTYPE = 00
+        block[1] = (unsigned char)length;
+        block[2] = (unsigned char)(length >> 8);
+        block[3] = (unsigned char)~length;
+        block[4] = (unsigned char)(~length >> 8);
+        buffer_append(out, block, 5);
+        buffer_append(out, raw + offset, length);
+        offset += length;
+    } while (offset < size);
+
+    unsigned char word[4];
+    store_u32_be(word, stored_adler32(raw, size));
+    return buffer_append(out, word, 4);
+#endif
+}
+
+static int encode_png(ByteBuffer* out, const Canvas* canvas) {
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    size_t stride = 1 + 3 * (size_t)canvas->width;
+    size_t raw_size = stride * canvas->height;
+
+    // Scanlines with filter type 0 (None)
+    unsigned char* raw = malloc(raw_size);
+    if (!raw) {
+        return -1;
+    }
+    for (int y = 0; y < canvas->height; y++) {
+        raw[y * stride] = 0;
+        memcpy(raw + y * stride + 1, canvas->rgb + (size_t)y * canvas->width * 3, stride - 1);
+    }
+
+    unsigned char header[13];
+    store_u32_be(header, (uint32_t)canvas->width);
+    store_u32_be(header + 4, (uint32_t)canvas->height);
+    header[8] = 8;               // Bit depth
+    header[9] = 2;               // Truecolor RGB
+    header[10] = 0;              // Deflate
+    header[11] = 0;              // Adaptive filtering
+    header[12] = 0;              // No interlace
+
+    ByteBuffer idat = { NULL, 0, 0 };
+    int status = buffer_append(out, signature, sizeof(signature));
+    if (status == 0) status = png_chunk(out, "IHDR", header, sizeof(header));
+    if (status == 0) status = png_compress(&idat, raw, raw_size);
+    if (status == 0) status = png_chunk(out, "IDAT", idat.data, idat.size);
+    if (status == 0) status = png_chunk(out, "IEND", NULL, 0);
+
+    free(idat.data);
+    free(raw);
+    return status;
+}
+
+static int render_png(ByteBuffer* out, const PlotLayout* layout, const NozzleContour* contour) {
+    Canvas canvas;
+    canvas.width = layout->width;
+    canvas.height = layout->height;
+    canvas.rgb = malloc((size_t)canvas.width * canvas.height * 3);
+    canvas.coverage = calloc((size_t)canvas.width * canvas.height, 1);
+
+    int status = -1;
+    if (canvas.rgb && canvas.coverage) {
+        render_raster(&canvas, layout, contour);
+        status = encode_png(out, &canvas);
+    }
+    free(canvas.rgb);
+    free(canvas.coverage);
+    return status;
+}
+
+// ---- Vector output ----
+
+static int svg_polyline(ByteBuffer* out, const PlotLayout* layout, const NozzleContour* contour,
+                        double sign, uint32_t color, double line_width) {
+    int status = buffer_printf(out, "<polyline fill=\"none\" stroke=\"#%06x\" stroke-width=\"%g\" "
+                               "stroke-linejoin=\"round\" points=\"", (unsigned int)color, line_width);
+    for (int i = 0; i < contour->num_points && status == 0; i++) {
+        status = buffer_printf(out, "%s%.2f,%.2f", i > 0 ? " " : "",
+                               map_x(layout, contour->points[i].x), map_y(layout, sign * contour->points[i].y));
+    }
+    return status == 0 ? buffer_printf(out, "\"/>\n") : -1;
+}
+
+static int render_svg(ByteBuffer* out, const PlotLayout* layout, const NozzleContour* contour) {
+    int status = buffer_printf(out,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\" "
+        "font-family=\"sans-serif\" font-size=\"12\">\n"
+        "<rect width=\"100%%\" height=\"100%%\" fill=\"#%06x\"/>\n",
+        layout->width, layout->height, layout->width, layout->height, (unsigned int)COLOR_BACKGROUND);
+
+    if (layout->decorated) {
+        char label[32];
+        int nx = tick_count(layout->x_min, layout->x_max, layout->x_step);
+        int ny = tick_count(layout->y_min, layout->y_max, layout->y_step);
+
+        for (int i = 0; i <= nx && status == 0; i++) {
+            double value = layout->x_min + i * layout->x_step;
+            double x = map_x(layout, value);
+            format_tick(label, sizeof(label), value, layout->x_step);
+            status = buffer_printf(out,
+                "<line x1=\"%.2f\" y1=\"%d\" x2=\"%.2f\" y2=\"%d\" stroke=\"#%06x\"/>\n"
+                "<text x=\"%.2f\" y=\"%d\" text-anchor=\"middle\">%s</text>\n",
+                x, layout->top, x, layout->bottom, (unsigned int)COLOR_GRID, x, layout->bottom + 18, label);
+        }
+        for (int i = 0; i <= ny && status == 0; i++) {
+            double value = layout->y_min + i * layout->y_step;
+            double y = map_y(layout, value);
+            format_tick(label, sizeof(label), value, layout->y_step);
+            status = buffer_printf(out,
+                "<line x1=\"%d\" y1=\"%.2f\" x2=\"%d\" y2=\"%.2f\" stroke=\"#%06x\"/>\n"
+                "<text x=\"%d\" y=\"%.2f\" text-anchor=\"end\" dominant-baseline=\"middle\">%s</text>\n",
+                layout->left, y, layout->right, y, (unsigned int)COLOR_GRID, layout->left - 8, y, label);
+        }
+        if (status == 0) {
+            int middle_x = (layout->left + layout->right) / 2;
+            int middle_y = (layout->top + layout->bottom) / 2;
+            status = buffer_printf(out,
+                "<text x=\"%d\" y=\"28\" text-anchor=\"middle\" font-size=\"18\">%s</text>\n"
+                "<text x=\"%d\" y=\"%d\" text-anchor=\"middle\">%s</text>\n"
+                "<text transform=\"translate(24 %d) rotate(-90)\" text-anchor=\"middle\">%s</text>\n",
+                middle_x, plot_title, middle_x, layout->height - 14, plot_x_label, middle_y, plot_y_label);
+        }
+    }
+
+    if (status == 0) {
+        status = buffer_printf(out, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"none\" stroke=\"#%06x\"/>\n",
+                               layout->left, layout->top, layout->right - layout->left,
+                               layout->bottom - layout->top, (unsigned int)COLOR_FRAME);
+    }
+
+    double line_width = layout->decorated ? CONTOUR_LINE_WIDTH : 1.0;
+    if (status == 0) status = svg_polyline(out, layout, contour, 1.0, COLOR_UPPER, line_width);
+    if (status == 0) status = svg_polyline(out, layout, contour, -1.0, COLOR_LOWER, line_width);
+
+    if (status == 0 && layout->decorated) {
+        int x = layout->left + 12;
+        for (int row = 0; row < 2 && status == 0; row++) {
+            int y = layout->top + 16 + row * 16;
+            status = buffer_printf(out,
+                "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"#%06x\" stroke-width=\"2\"/>\n"
+                "<text x=\"%d\" y=\"%d\" dominant-baseline=\"middle\">%s</text>\n",
+                x, y, x + 30, y, (unsigned int)(row == 0 ? COLOR_UPPER : COLOR_LOWER),
+                x + 38, y, row == 0 ? plot_upper_title : plot_lower_title);
+        }
+    }
+
+    return status == 0 ? buffer_printf(out, "</svg>\n") : -1;
+}
+
+static int render_plot(const NozzleContour* contour, const PlotOptions* options,
+                       unsigned char** data, size_t* size) {
+    if (!contour || !data || !size || contour->num_points <= 0 || !contour->points) {
+        return -1;
+    }
+    *data = NULL;
+    *size = 0;
+
+    PlotFormat format = options ? options->format : PLOT_FORMAT_PNG;
+    int width = options && options->width > 0 ? options->width : DEFAULT_PLOT_WIDTH;
+    int height = options && options->height > 0 ? options->height : DEFAULT_PLOT_HEIGHT;
+    if (width < 8 || height < 8 || width > MAX_PLOT_SIZE || height > MAX_PLOT_SIZE) {
+        return -1;
+    }
+
+    PlotLayout layout;
+    if (layout_plot(&layout, contour, width, height) != 0) {
+        return -1;
+    }
+
+    ByteBuffer out = { NULL, 0, 0 };
+    int status;
+    switch (format) {
+        case PLOT_FORMAT_PNG: status = render_png(&out, &layout, contour); break;
+        case PLOT_FORMAT_SVG: status = render_svg(&out, &layout, contour); break;
+        default:              status = -1; break;
+    }
+
+    if (status != 0) {
+        free(out.data);
+        return -1;
+    }
+    *data = out.data;
+    *size = out.size;
+    return 0;
+}
+
+int render_nozzle_plot(const NozzleContour* contour, const PlotOptions* options,
+                       unsigned char** data, size_t* size) {
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_PLOT);
+    int status = render_plot(contour, options, data, size);
+    NGC_PROFILE_END(timer);
+    return status;
+}
@@ -0,0 +1,326 @@
+#include "request.h"
+#include <stddef.h>
+#include <string.h>
+
+// Field names of a case, shared by JSON objects and CSV headers
+static double* request_field(NozzleDesign* design, const char* name, size_t length) {
+#define FIELD_IS(text) (length == sizeof(text) - 1 && memcmp(name, text, length) == 0)
+    if (FIELD_IS("throat_radius"))       return &design->throat_radius;
+    if (FIELD_IS("exit_radius"))         return &design->exit_radius;
+    if (FIELD_IS("length_fraction"))     return &design->length_fraction;
+    if (FIELD_IS("chamber_pressure"))    return &design->conditions.chamber_pressure;
+    if (FIELD_IS("ambient_pressure"))    return &design->conditions.ambient_pressure;
+    if (FIELD_IS("chamber_temperature")) return &design->conditions.chamber_temperature;
+    if (FIELD_IS("molecular_weight"))    return &design->conditions.molecular_weight;
+    if (FIELD_IS("gamma"))               return &design->conditions.gamma;
+    if (FIELD_IS("gas_constant"))        return &design->conditions.gas_constant;
+#undef FIELD_IS
+    return NULL;
+}
+
+const char* request_skip_space(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+// End of the JSON string whose opening quote is at p, or NULL
+static const char* string_end(const char* p) {
+    for (p++; *p; p++) {
+        if (*p == '\\') {
+            if (!*++p) {
+                return NULL;
+            }
+        } else if (*p == '"') {
+            return p + 1;
+        } else if ((unsigned char)*p < 0x20) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// End of the JSON number at p, or NULL: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+static const char* number_end(const char* p) {
+    if (*p == '-') {
+        p++;
+    }
+    if (*p == '0') {
+        p++;
+    } else if (is_digit(*p)) {
+        while (is_digit(*p)) p++;
+    } else {
+        return NULL;
+    }
+    if (*p == '.') {
+        if (!is_digit(*++p)) {
+            return NULL;
+        }
+        while (is_digit(*p)) p++;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-') {
+            p++;
+        }
+        if (!is_digit(*p)) {
+            return NULL;
+        }
+        while (is_digit(*p)) p++;
+    }
+    return p;
+}
+
+const char* parse_json_request(const char* line, const NozzleDesign* base, CaseRequest* request) {
+    request->design = *base;
+    request->id[0] = '\0';
+
+    const char* p = request_skip_space(line);
+    if (*p++ != '{') {
+        return "Request must be a JSON object";
+    }
+    p = request_skip_space(p);
+
+    while (*p != '}') {
+        if (*p != '"') {
+            return "Expected a field name";
+        }
+        const char* key = p + 1;
+        const char* key_end = string_end(p);
+        if (!key_end) {
+            return "Unterminated field name";
+        }
+        size_t key_length = (size_t)(key_end - 1 - key);
+        p = request_skip_space(key_end);
+        if (*p++ != ':') {
+            return "Expected ':' after a field name";
+        }
+        p = request_skip_space(p);
+
+        if (key_length == 2 && memcmp(key, "id", 2) == 0) {
+            // Ids are echoed verbatim, so only plain strings and numbers are taken
+            const char* value_end = NULL;
+            if (*p == '"') {
+                value_end = string_end(p);
+            } else {
+                value_end = number_end(p);
+            }
+            if (!value_end || value_end - p >= MAX_REQUEST_ID) {
+                return "Request id must be a string or a number of under 64 characters";
+            }
+            memcpy(request->id, p, (size_t)(value_end - p));
+            request->id[value_end - p] = '\0';
+            p = value_end;
+        } else {
+            double* field = request_field(&request->design, key, key_length);
+            if (!field) {
+                return "Unknown request field";
+            }
+            const char* value_end = number_end(p);
+            double value = value_end ? strtod(p, NULL) : 0.0;
+            if (!value_end || !isfinite(value)) {
+                return "Field values must be finite numbers";
+            }
+            *field = value;
+            p = value_end;
+        }
+
+        p = request_skip_space(p);
+        if (*p == ',') {
+            p = request_skip_space(p + 1);
+            if (*p == '}') {
+                return "Expected a field name after ','";
+            }
+        } else if (*p != '}') {
+            return "Expected ',' or '}'";
+        }
+    }
+
+    if (*request_skip_space(p + 1) != '\0') {
+        return "Unexpected text after the request object";
+    }
+    return design_parameter_error(&request->design);
+}
+
+// Extent of the CSV cell starting at p: plain text up to the next comma, or
+// a quoted string with "" for a quote. Returns the end, or NULL.
+static const char* csv_cell_end(const char* p) {
+    if (*p != '"') {
+        while (*p && *p != ',') {
+            p++;
+        }
+        return p;
+    }
+    for (p++; *p; p++) {
+        if (*p == '"') {
+            if (p[1] != '"') {
+                return p + 1;
+            }
+            p++;
+        }
+    }
+    return NULL;
+}
+
+// Trims trailing blanks from [begin, end)
+static const char* csv_trim_end(const char* begin, const char* end) {
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        end--;
+    }
+    return end;
+}
+
+const char* parse_csv_header(const char* line, CsvLayout* layout) {
+    NozzleDesign design;
+    const char* p = line;
+
+    layout->num_columns = 0;
+    layout->id_column = -1;
+    for (;;) {
+        p = request_skip_space(p);
+        const char* end = csv_cell_end(p);
+        if (!end) {
+            return "Unterminated column name";
+        }
+        const char* name = p;
+        const char* name_end = csv_trim_end(p, end);
+        if (*name == '"' && name_end - name >= 2) {
+            name++;
+            name_end--;
+        }
+        if (layout->num_columns == MAX_CSV_COLUMNS) {
+            return "Too many columns";
+        }
+
+        size_t length = (size_t)(name_end - name);
+        int column = layout->num_columns++;
+        if (length == 2 && memcmp(name, "id", 2) == 0) {
+            if (layout->id_column >= 0) {
+                return "Duplicate id column";
+            }
+            layout->id_column = column;
+        } else {
+            double* field = request_field(&design, name, length);
+            if (!field) {
+                return "Unknown column";
+            }
+            layout->offsets[column] = (size_t)((char*)field - (char*)&design);
+            for (int c = 0; c < column; c++) {
+                if (c != layout->id_column && layout->offsets[c] == layout->offsets[column]) {
+                    return "Duplicate column";
+                }
+            }
+        }
+
+        p = request_skip_space(end);
+        if (*p != ',') {
+            break;
+        }
+        p++;
+    }
+    return *p == '\0' ? NULL : "Unexpected text after the header";
+}
+
+const char* parse_csv_request(const char* line, const CsvLayout* layout, const NozzleDesign* base,
+                              CaseRequest* request) {
+    request->design = *base;
+    request->id[0] = '\0';
+
+    const char* p = line;
+    for (int column = 0; column < layout->num_columns; column++) {
+        p = request_skip_space(p);
+        const char* end = csv_cell_end(p);
+        if (!end) {
+            return "Unterminated quoted field";
+        }
+        const char* cell_end = csv_trim_end(p, end);
+
+        if (column == layout->id_column) {
+            // Ids are echoed verbatim, quotes included
+            if (cell_end - p >= MAX_REQUEST_ID) {
+                return "Row id must be under 64 characters";
+            }
+            memcpy(request->id, p, (size_t)(cell_end - p));
+            request->id[cell_end - p] = '\0';
+        } else if (cell_end > p) {
+            // An empty cell keeps the default
+            char* number_end;
+            double value = strtod(p, &number_end);
+            if (number_end != cell_end || !isfinite(value)) {
+                return "Field values must be finite numbers";
+            }
+            *(double*)((char*)&request->design + layout->offsets[column]) = value;
+        }
+
+        p = request_skip_space(end);
+        if (column + 1 < layout->num_columns) {
+            if (*p != ',') {
+                return "Row has too few fields";
+            }
+            p++;
+        }
+    }
+
+    if (*p != '\0') {
+        return "Row has too many fields";
+    }
+    return design_parameter_error(&request->design);
+}
+
+int format_json_response(const CaseRequest* request, char* line) {
+    int length = 0;
+
+    if (request->id[0]) {
+        length = snprintf(line, RESPONSE_SIZE, "{\"id\":%s,", request->id);
+    } else {
+        line[length++] = '{';
+    }
+
+    const PerformanceResults* r = &request->results;
+    if (request->error) {
+        length += snprintf(line + length, RESPONSE_SIZE - (size_t)length,
+                           "\"ok\":false,\"error\":\"%s\"}\n", request->error);
+    } else {
+        // %.17g round-trips every double exactly
+        length += snprintf(line + length, RESPONSE_SIZE - (size_t)length,
+                           "\"ok\":true,\"thrust\":%.17g,\"specific_impulse\":%.17g,\"exit_velocity\":%.17g,"
+                           "\"exit_pressure\":%.17g,\"exit_temperature\":%.17g,\"mass_flow_rate\":%.17g,"
+                           "\"characteristic_velocity\":%.17g,\"thrust_coefficient\":%.17g,\"exit_mach\":%.17g}\n",
+                           r->thrust, r->specific_impulse, r->exit_velocity, r->exit_pressure,
+                           r->exit_temperature, r->mass_flow_rate, r->characteristic_velocity,
+                           r->thrust_coefficient, r->exit_mach);
+    }
+    return length;
+}
+
+int format_csv_header(const CsvLayout* layout, char* line) {
+    return snprintf(line, RESPONSE_SIZE, "%sok,error,thrust,specific_impulse,exit_velocity,exit_pressure,"
+                    "exit_temperature,mass_flow_rate,characteristic_velocity,thrust_coefficient,exit_mach\n",
+                    layout->id_column >= 0 ? "id," : "");
+}
+
+int format_csv_response(const CsvLayout* layout, const CaseRequest* request, char* line) {
+    int length = 0;
+    if (layout->id_column >= 0) {
+        length = snprintf(line, RESPONSE_SIZE, "%s,", request->id);
+    }
+
+    const PerformanceResults* r = &request->results;
+    if (request->error) {
+        // Messages contain no quotes, so quoting them is enough
+        length += snprintf(line + length, RESPONSE_SIZE - (size_t)length, "false,\"%s\",,,,,,,,,\n",
+                           request->error);
+    } else {
+        length += snprintf(line + length, RESPONSE_SIZE - (size_t)length,
+                           "true,,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+                           r->thrust, r->specific_impulse, r->exit_velocity, r->exit_pressure,
+                           r->exit_temperature, r->mass_flow_rate, r->characteristic_velocity,
+                           r->thrust_coefficient, r->exit_mach);
+    }
+    return length;
+}
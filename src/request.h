@@ -0,0 +1,42 @@
+#ifndef NGC_REQUEST_H
+#define NGC_REQUEST_H
+
+#include "../include/ngc.h"
+
+// Case codecs shared by the request server and the case-file batch mode: a
+// case is a flat JSON object or a CSV row naming design fields, and its
+// answer is one JSON object or CSV row of results
+
+#define MAX_REQUEST_ID 64
+#define RESPONSE_SIZE 1024
+#define MAX_CSV_COLUMNS 16
+
+typedef struct {
+    char id[MAX_REQUEST_ID];     // Raw id token, echoed back ("" = none)
+    const char* error;           // Why the case was not evaluated (NULL = evaluated)
+    NozzleDesign design;
+    PerformanceResults results;
+} CaseRequest;
+
+// Columns of a CSV case file, from its header row
+typedef struct {
+    int num_columns;
+    int id_column;                       // -1 = no id column
+    size_t offsets[MAX_CSV_COLUMNS];     // Offset of each column's field in NozzleDesign
+} CsvLayout;
+
+const char* request_skip_space(const char* p);
+
+// Both parsers fill the request from one line and return NULL or a message
+const char* parse_json_request(const char* line, const NozzleDesign* base, CaseRequest* request);
+const char* parse_csv_request(const char* line, const CsvLayout* layout, const NozzleDesign* base,
+                              CaseRequest* request);
+const char* parse_csv_header(const char* line, CsvLayout* layout);
+
+// Formatters write one newline-terminated line of at most RESPONSE_SIZE
+// bytes and return its length
+int format_json_response(const CaseRequest* request, char* line);
+int format_csv_header(const CsvLayout* layout, char* line);
+int format_csv_response(const CsvLayout* layout, const CaseRequest* request, char* line);
+
+#endif // NGC_REQUEST_H
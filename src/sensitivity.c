@@ -0,0 +1,102 @@
+#include "../include/ngc.h"
+#include <string.h>
+
+// Analytic derivatives of the performance outputs. The exit Mach number is
+// defined implicitly by A(M, gamma) = epsilon, so its derivatives follow
+// from the implicit function theorem on ln A:
+//
+//   d ln A / dM     = (M^2 - 1) / (M (1 + k M^2)),   k = (gamma - 1) / 2
+//   d ln A / dgamma = -ln(2 (1 + k M^2) / (gamma + 1)) / (gamma - 1)^2
+//                     + e (M^2 / 2 / (1 + k M^2) - 1 / (gamma + 1)),
+//                     e = (gamma + 1) / (2 (gamma - 1))
+//
+// and the remaining quantities are products of powers, so their logarithmic
+// derivatives add. Everything comes from one converged solve, with no
+// finite-difference steps.
+
+static const char* const sensitivity_output_names[SENSITIVITY_NUM_OUTPUTS] = {
+    "thrust",
+    "specific-impulse",
+    "thrust-coefficient",
+    "exit-pressure"
+};
+
+const char* sensitivity_output_name(SensitivityOutput output) {
+    if (output < 0 || output >= SENSITIVITY_NUM_OUTPUTS) {
+        return NULL;
+    }
+    return sensitivity_output_names[output];
+}
+
+int calculate_performance_sensitivities(const NozzleDesign* design, PerformanceSensitivities* sensitivities) {
+    if (!design || !sensitivities) {
+        return -1;
+    }
+    memset(sensitivities, 0, sizeof(PerformanceSensitivities));
+
+    const PerformanceResults* r = &sensitivities->results;
+    if (evaluate_nozzle_design(design, NULL, &sensitivities->results) != 0) {
+        return -1;
+    }
+
+    const FlowConditions* c = &design->conditions;
+    double gamma = c->gamma;
+    double gm1 = gamma - 1.0;
+    double mach = r->exit_mach;
+    double m2 = mach * mach;
+    double stagnation = 1.0 + 0.5 * gm1 * m2;        // T0 / Te
+    double log_tau = -log(stagnation);              // ln(Te / T0)
+    double log_critical = log(2.0 / (gamma + 1.0));
+    double exponent = (gamma + 1.0) / (2.0 * gm1);
+
+    double area_mach = (m2 - 1.0) / (mach * stagnation);
+    double area_gamma = -(log_critical + log(stagnation)) / (gm1 * gm1) +
+                        exponent * (0.5 * m2 / stagnation - 1.0 / (gamma + 1.0));
+    if (!(fabs(area_mach) > 0)) {
+        return -1;
+    }
+
+    double throat_area = calculate_nozzle_area(design->throat_radius);
+    double exit_area = calculate_nozzle_area(design->exit_radius);
+    double g0 = 9.81;                               // As in calculate_performance
+
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        // Unit seeds of the inputs; the length fraction leaves performance unchanged
+        double d_throat = p == SWEEP_THROAT_RADIUS ? 1.0 / design->throat_radius : 0.0;    // d ln rt
+        double d_exit = p == SWEEP_EXIT_RADIUS ? 1.0 / design->exit_radius : 0.0;          // d ln re
+        double d_chamber = p == SWEEP_CHAMBER_PRESSURE ? 1.0 / c->chamber_pressure : 0.0;  // d ln Pc
+        double d_ambient = p == SWEEP_AMBIENT_PRESSURE ? 1.0 : 0.0;                        // d Pa
+        double d_temperature = p == SWEEP_CHAMBER_TEMPERATURE ? 1.0 / c->chamber_temperature : 0.0;
+        double d_weight = p == SWEEP_MOLECULAR_WEIGHT ? 1.0 / c->molecular_weight : 0.0;
+        double d_gamma = p == SWEEP_GAMMA ? 1.0 : 0.0;
+
+        // Exit Mach number from ln A(M, gamma) = 2 ln re - 2 ln rt
+        double d_mach = (2.0 * (d_exit - d_throat) - area_gamma * d_gamma) / area_mach;
+        double d_log_tau = -(gm1 * mach * d_mach + 0.5 * m2 * d_gamma) / stagnation;
+
+        // pe = Pc tau^(gamma / (gamma - 1))
+        double d_log_pe = d_chamber + gamma / gm1 * d_log_tau - log_tau / (gm1 * gm1) * d_gamma;
+        double d_pe = r->exit_pressure * d_log_pe;
+
+        // ve = M sqrt(gamma R Tc tau), R = Ru / Mw
+        double d_log_ve = d_mach / mach + 0.5 * (d_gamma / gamma - d_weight + d_temperature + d_log_tau);
+
+        // mdot = At Pc (2 / (gamma + 1))^(gamma / (gamma - 1) - 1/2) / sqrt(R Tc)
+        double d_log_mdot = 2.0 * d_throat + d_chamber + 0.5 * (d_weight - d_temperature) +
+                            (-log_critical / (gm1 * gm1) - (gamma / gm1 - 0.5) / (gamma + 1.0)) * d_gamma;
+
+        // F = mdot ve + (pe - Pa) Ae
+        double momentum = r->mass_flow_rate * r->exit_velocity;
+        double d_thrust = momentum * (d_log_mdot + d_log_ve) + exit_area * (d_pe - d_ambient) +
+                          (r->exit_pressure - c->ambient_pressure) * exit_area * 2.0 * d_exit;
+
+        sensitivities->jacobian[SENSITIVITY_THRUST][p] = d_thrust;
+        sensitivities->jacobian[SENSITIVITY_SPECIFIC_IMPULSE][p] =
+            (d_thrust - r->thrust * d_log_mdot) / (r->mass_flow_rate * g0);
+        sensitivities->jacobian[SENSITIVITY_THRUST_COEFFICIENT][p] =
+            (d_thrust - r->thrust * (d_chamber + 2.0 * d_throat)) / (c->chamber_pressure * throat_area);
+        sensitivities->jacobian[SENSITIVITY_EXIT_PRESSURE][p] = d_pe;
+    }
+
+    return 0;
+}
@@ -0,0 +1,461 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "context.h"
+#include "request.h"
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Newline-delimited JSON request server. Every input line is one flat JSON
+// object naming design fields; every answer is one line, in request order.
+// Each poll round drains whatever the clients have queued into one batch,
+// so a client streaming requests is answered in large batches while a
+// single request is answered as soon as it arrives. Responses are buffered
+// per connection and written without blocking, so a client may send all of
+// its requests before reading any answers.
+
+#define DEFAULT_MAX_BATCH 4096
+#define MAX_REQUEST_LINE 4096
+#define READ_SIZE 65536
+
+// Writes to a pipe or file of at most this size do not block once poll
+// reports it writable
+#define PIPE_WRITE_SIZE 4096
+
+// Smaller batches are evaluated on the calling thread: starting workers
+// would cost more than they save
+#define PARALLEL_BATCH 1024
+#define BATCH_CHUNK 64
+
+typedef struct {
+    char* data;
+    size_t used;
+    size_t capacity;
+} OutputBuffer;
+
+typedef struct {
+    int in_fd;
+    int out_fd;
+    int is_socket;
+    int eof;                     // No more input will arrive
+    int skipping;                // Discarding the rest of an oversized line
+    char* data;                  // Unconsumed input is data[start, used)
+    size_t start;
+    size_t used;
+    size_t capacity;
+    OutputBuffer out;            // Unsent responses are out.data[sent, out.used)
+    size_t sent;
+} ServerConnection;
+
+typedef struct {
+    int connection;
+    CaseRequest request;
+    int response_length;
+    char response[RESPONSE_SIZE];
+} ServerRequest;
+
+typedef struct {
+    ServerRequest* requests;
+    NgcCache* cache;
+} ServerBatch;
+
+static int output_append(OutputBuffer* out, const char* data, size_t size) {
+    if (out->used + size > out->capacity) {
+        size_t capacity = out->capacity > 0 ? out->capacity : READ_SIZE;
+        while (capacity < out->used + size) {
+            capacity *= 2;
+        }
+        char* grown = realloc(out->data, capacity);
+        if (!grown) {
+            return -1;
+        }
+        out->data = grown;
+        out->capacity = capacity;
+    }
+    memcpy(out->data + out->used, data, size);
+    out->used += size;
+    return 0;
+}
+
+// Responses are formatted by the workers too; printing the doubles costs
+// more than evaluating the design
+static void evaluate_requests(long long begin, long long end, int thread_id, void* context) {
+    ServerBatch* job = (ServerBatch*)context;
+    (void)thread_id;
+
+    for (long long i = begin; i < end; i++) {
+        CaseRequest* request = &job->requests[i].request;
+        if (!request->error &&
+            evaluate_nozzle_design_cached(job->cache, &request->design, NULL, &request->results) != 0) {
+            request->error = "Design could not be evaluated";
+        }
+        job->requests[i].response_length = format_json_response(request, job->requests[i].response);
+    }
+}
+
+// Sends as much buffered output as the connection accepts without blocking
+static int flush_connection(ServerConnection* connection) {
+    while (connection->sent < connection->out.used) {
+        const char* data = connection->out.data + connection->sent;
+        size_t size = connection->out.used - connection->sent;
+        ssize_t written;
+
+        if (connection->is_socket) {
+            // Sockets must not raise SIGPIPE when a client disconnects early
+            written = send(connection->out_fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } else {
+            // Standard output may be shared, so it stays blocking; ask poll first
+            struct pollfd ready = { connection->out_fd, POLLOUT, 0 };
+            if (poll(&ready, 1, 0) <= 0 || !(ready.revents & (POLLOUT | POLLERR | POLLHUP))) {
+                return 0;
+            }
+            written = write(connection->out_fd, data, size < PIPE_WRITE_SIZE ? size : PIPE_WRITE_SIZE);
+        }
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            return -1;
+        }
+        connection->sent += (size_t)written;
+    }
+
+    connection->sent = 0;
+    connection->out.used = 0;
+    return 0;
+}
+
+// Reads what is available; the buffer always keeps one spare byte so the
+// final line of a stream can be terminated in place
+static int read_connection(ServerConnection* connection) {
+    size_t pending = connection->used - connection->start;
+    if (connection->start > 0) {
+        memmove(connection->data, connection->data + connection->start, pending);
+        connection->start = 0;
+        connection->used = pending;
+    }
+    if (connection->used + READ_SIZE + 1 > connection->capacity) {
+        size_t capacity = connection->used + READ_SIZE + 1;
+        char* grown = realloc(connection->data, capacity);
+        if (!grown) {
+            return -1;
+        }
+        connection->data = grown;
+        connection->capacity = capacity;
+    }
+
+    ssize_t received = read(connection->in_fd, connection->data + connection->used, READ_SIZE);
+    if (received < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+            return 0;
+        }
+        connection->eof = 1;
+        return -1;
+    }
+    if (received == 0) {
+        connection->eof = 1;
+    }
+    connection->used += (size_t)received;
+    return 0;
+}
+
+// Takes the next complete line. Returns 1 with *line set, or with *line NULL
+// for a line over MAX_REQUEST_LINE; 0 when no complete line is buffered.
+static int next_line(ServerConnection* connection, char** line) {
+    for (;;) {
+        char* begin = connection->data + connection->start;
+        size_t pending = connection->used - connection->start;
+        char* newline = pending > 0 ? memchr(begin, '\n', pending) : NULL;
+
+        if (connection->skipping) {
+            if (!newline) {
+                connection->start = connection->used;
+                return 0;
+            }
+            connection->start += (size_t)(newline - begin) + 1;
+            connection->skipping = 0;
+            continue;
+        }
+
+        if (newline) {
+            *newline = '\0';
+            connection->start += (size_t)(newline - begin) + 1;
+            *line = begin;
+            return 1;
+        }
+        if (pending > MAX_REQUEST_LINE) {
+            connection->skipping = 1;
+            connection->start = connection->used;
+            *line = NULL;
+            return 1;
+        }
+        if (connection->eof && pending > 0) {
+            connection->data[connection->used] = '\0';
+            connection->start = connection->used;
+            *line = begin;
+            return 1;
+        }
+        return 0;
+    }
+}
+
+static int has_buffered_line(const ServerConnection* connection) {
+    size_t pending = connection->used - connection->start;
+    if (pending == 0 || connection->skipping) {
+        return 0;
+    }
+    return connection->eof || pending > MAX_REQUEST_LINE ||
+           memchr(connection->data + connection->start, '\n', pending) != NULL;
+}
+
+static int add_connection(ServerConnection** connections, int* count, int* capacity,
+                          int in_fd, int out_fd, int is_socket) {
+    if (*count == *capacity) {
+        int grown_capacity = *capacity > 0 ? *capacity * 2 : 8;
+        ServerConnection* grown = realloc(*connections, (size_t)grown_capacity * sizeof(ServerConnection));
+        if (!grown) {
+            return -1;
+        }
+        *connections = grown;
+        *capacity = grown_capacity;
+    }
+
+    ServerConnection* connection = &(*connections)[(*count)++];
+    memset(connection, 0, sizeof(ServerConnection));
+    connection->in_fd = in_fd;
+    connection->out_fd = out_fd;
+    connection->is_socket = is_socket;
+    return 0;
+}
+
+static int open_listen_socket(NgcContext* context, const char* path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return ngc_set_error(context, "Socket path too long: %s", path);
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return ngc_set_error(context, "Cannot create socket %s", path);
+    }
+
+    // Replace a socket left behind by an earlier server, but never other files
+    struct stat info;
+    if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path);
+    }
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return ngc_set_error(context, "Cannot listen on %s", path);
+    }
+    return fd;
+}
+
+int run_server(NgcContext* context, const ServerConfig* config, ServerSummary* summary) {
+    if (!config || !summary) {
+        return ngc_set_error(context, "Null pointer passed to run_server");
+    }
+    memset(summary, 0, sizeof(ServerSummary));
+
+    int max_batch = config->max_batch > 0 ? config->max_batch : DEFAULT_MAX_BATCH;
+    ServerRequest* batch = malloc((size_t)max_batch * sizeof(ServerRequest));
+    if (!batch) {
+        return ngc_set_error(context, "Cannot allocate a batch of %d requests", max_batch);
+    }
+
+    ServerConnection* connections = NULL;
+    int num_connections = 0;
+    int connection_capacity = 0;
+    struct pollfd* fds = NULL;
+    int fds_capacity = 0;
+    int status = 0;
+
+    int listen_fd = -1;
+    if (config->socket_path) {
+        listen_fd = open_listen_socket(context, config->socket_path);
+        if (listen_fd < 0) {
+            free(batch);
+            return -1;
+        }
+        ngc_diagnostic(context, "Listening on %s", config->socket_path);
+    } else if (add_connection(&connections, &num_connections, &connection_capacity,
+                              STDIN_FILENO, STDOUT_FILENO, 0) != 0) {
+        free(batch);
+        return ngc_set_error(context, "Cannot allocate connection state");
+    }
+
+    int first_connection = 0;
+    while (!(config->stop && *config->stop)) {
+        // Standard input mode ends with its only connection
+        if (listen_fd < 0 && num_connections == 0) {
+            break;
+        }
+
+        // Wait only when no complete request is already buffered
+        int timeout = -1;
+        for (int c = 0; c < num_connections; c++) {
+            if (has_buffered_line(&connections[c])) {
+                timeout = 0;
+                break;
+            }
+        }
+
+        int num_fds = 2 * num_connections + 1;
+        if (fds_capacity < num_fds) {
+            struct pollfd* grown = realloc(fds, (size_t)(2 * connection_capacity + 1) * sizeof(struct pollfd));
+            if (!grown) {
+                status = ngc_set_error(context, "Cannot allocate connection state");
+                break;
+            }
+            fds = grown;
+            fds_capacity = 2 * connection_capacity + 1;
+        }
+
+        // fds[0] is the listening socket (or unused); connection c reads
+        // through fds[2c + 1] and writes through fds[2c + 2]
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        for (int c = 0; c < num_connections; c++) {
+            const ServerConnection* connection = &connections[c];
+            fds[2 * c + 1].fd = connection->eof ? -1 : connection->in_fd;
+            fds[2 * c + 1].events = POLLIN;
+            fds[2 * c + 1].revents = 0;
+            fds[2 * c + 2].fd = connection->sent < connection->out.used ? connection->out_fd : -1;
+            fds[2 * c + 2].events = POLLOUT;
+            fds[2 * c + 2].revents = 0;
+        }
+
+        if (poll(fds, (nfds_t)num_fds, timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = ngc_set_error(context, "Cannot wait for requests");
+            break;
+        }
+
+        int polled_connections = num_connections;
+        for (int c = 0; c < polled_connections; c++) {
+            if (fds[2 * c + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                read_connection(&connections[c]);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept(listen_fd, NULL, NULL);
+            if (client >= 0) {
+                if (add_connection(&connections, &num_connections, &connection_capacity, client, client, 1) == 0) {
+                    summary->connections++;
+                } else {
+                    close(client);
+                }
+            }
+        }
+
+        // Collect queued requests, rotating the first connection for fairness
+        int count = 0;
+        for (int k = 0; k < num_connections && count < max_batch; k++) {
+            int c = (first_connection + k) % num_connections;
+            char* line;
+            while (count < max_batch && next_line(&connections[c], &line)) {
+                ServerRequest* request = &batch[count];
+                if (!line) {
+                    request->request.id[0] = '\0';
+                    request->request.error = "Request line too long";
+                } else if (*request_skip_space(line) == '\0') {
+                    continue;
+                } else {
+                    request->request.error = parse_json_request(line, &config->base, &request->request);
+                }
+                request->connection = c;
+                count++;
+            }
+        }
+        if (num_connections > 0) {
+            first_connection = (first_connection + 1) % num_connections;
+        }
+
+        if (count > 0) {
+            ServerBatch job = { batch, config->cache };
+            if (count >= PARALLEL_BATCH) {
+                parallel_for(count, BATCH_CHUNK, config->num_threads, evaluate_requests, &job);
+            } else {
+                evaluate_requests(0, count, 0, &job);
+            }
+
+            summary->batches++;
+            summary->requests += count;
+            if (count > summary->largest_batch) {
+                summary->largest_batch = count;
+            }
+
+            for (int i = 0; i < count; i++) {
+                if (batch[i].request.error) {
+                    summary->failed_requests++;
+                }
+                if (output_append(&connections[batch[i].connection].out, batch[i].response,
+                                  (size_t)batch[i].response_length) != 0) {
+                    status = ngc_set_error(context, "Cannot allocate responses");
+                    goto done;
+                }
+            }
+        }
+
+        for (int c = 0; c < num_connections; c++) {
+            ServerConnection* connection = &connections[c];
+            if (flush_connection(connection) != 0) {
+                if (!connection->is_socket) {
+                    status = ngc_set_error(context, "Cannot write responses");
+                    goto done;
+                }
+                // The client went away; drop whatever else it sent
+                connection->eof = 1;
+                connection->start = connection->used;
+                connection->sent = 0;
+                connection->out.used = 0;
+            }
+        }
+
+        // Drop connections that are closed and fully answered
+        for (int c = num_connections - 1; c >= 0; c--) {
+            ServerConnection* connection = &connections[c];
+            if (!connection->eof || connection->sent < connection->out.used ||
+                (connection->start < connection->used && !connection->skipping)) {
+                continue;
+            }
+            if (connection->is_socket) {
+                close(connection->in_fd);
+            }
+            free(connection->data);
+            free(connection->out.data);
+            connections[c] = connections[--num_connections];
+        }
+    }
+
+done:
+    for (int c = 0; c < num_connections; c++) {
+        if (connections[c].is_socket) {
+            close(connections[c].in_fd);
+        }
+        free(connections[c].data);
+        free(connections[c].out.data);
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(config->socket_path);
+    }
+    free(connections);
+    free(fds);
+    free(batch);
+    return status;
+}
@@ -0,0 +1,388 @@
+#include "context.h"
+#include "datafile.h"
+#include <string.h>
+
+// Thrust-coefficient surrogate tables. The vacuum thrust coefficient, exit
+// Mach number and exit pressure and temperature ratios depend only on the
+// expansion ratio and gamma, so they are tabulated over a grid of
+// (ln epsilon, gamma). The ambient pressure enters the thrust coefficient
+// as the exact term -epsilon pa / pc, so it needs no axis of its own.
+//
+// Each node is a record of SURROGATE_NUM_FIELDS doubles (32 bytes, two per
+// cache line), stored row by row with a border of one node beyond the range
+// on every side, so the 4x4 cubic stencil never needs bounds checks. The
+// file is an NGC data file whose header is extended by SurrogateHeader; the
+// nodes start 64-byte aligned in the mapping.
+
+#define SURROGATE_DEFAULT_EXPANSION_COUNT 512
+#define SURROGATE_DEFAULT_GAMMA_COUNT 128
+#define SURROGATE_MAX_COUNT 16384
+
+// Error samples per node spacing along each axis
+#define SURROGATE_ERROR_DIVISIONS 4
+
+typedef struct {
+    double expansion_min;
+    double expansion_max;
+    double gamma_min;
+    double gamma_max;
+    uint64_t expansion_count;
+    uint64_t gamma_count;
+    double max_error[SURROGATE_NUM_METHODS][SURROGATE_NUM_FIELDS];
+    char reserved[400];
+} SurrogateHeader;
+
+// Keeps the nodes 64-byte aligned after the two headers
+typedef char surrogate_header_size_check[sizeof(SurrogateHeader) == 512 ? 1 : -1];
+
+typedef struct {
+    double max_error[SURROGATE_NUM_METHODS][SURROGATE_NUM_FIELDS];
+    int failed;
+} SurrogateThreadState;
+
+typedef struct {
+    CfSurrogate table;           // Nodes being built
+    double* nodes;
+    SurrogateThreadState* threads;
+} SurrogateJob;
+
+static const char* const surrogate_field_names[SURROGATE_NUM_FIELDS] = {
+    "vacuum-cf",
+    "exit-mach",
+    "pressure-ratio",
+    "temperature-ratio"
+};
+
+const char* surrogate_field_name(SurrogateField field) {
+    if (field < 0 || field >= SURROGATE_NUM_FIELDS) {
+        return NULL;
+    }
+    return surrogate_field_names[field];
+}
+
+// The tabulated quantities from the exact solver. The momentum thrust per
+// pc At reduces to (2/(gamma+1))^(gamma/(gamma-1)) M sqrt(gamma tau (gamma+1)/2)
+static int surrogate_exact(double expansion_ratio, double gamma, double values[SURROGATE_NUM_FIELDS]) {
+    AreaMachSolver solver;
+    double mach;
+    if (area_mach_solver_init(&solver, gamma) != 0 ||
+        solve_area_mach(&solver, expansion_ratio, 1, 0.0, &mach, NULL) != 0) {
+        return -1;
+    }
+
+    double gm1 = gamma - 1.0;
+    double temperature_ratio = 1.0 / (1.0 + 0.5 * gm1 * mach * mach);
+    double pressure_ratio = pow(temperature_ratio, gamma / gm1);
+    double critical = 2.0 / (gamma + 1.0);
+    double momentum = pow(critical, gamma / gm1) * mach * sqrt(gamma * temperature_ratio / critical);
+
+    values[SURROGATE_VACUUM_CF] = momentum + expansion_ratio * pressure_ratio;
+    values[SURROGATE_EXIT_MACH] = mach;
+    values[SURROGATE_PRESSURE_RATIO] = pressure_ratio;
+    values[SURROGATE_TEMPERATURE_RATIO] = temperature_ratio;
+    return 0;
+}
+
+static void catmull_rom_weights(double t, double w[4]) {
+    double t2 = t * t;
+    double t3 = t2 * t;
+    w[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+    w[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+    w[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+    w[3] = 0.5 * (t3 - t2);
+}
+
+int cf_surrogate_lookup(const CfSurrogate* surrogate, SurrogateInterpolation method, double expansion_ratio,
+                        double gamma, double chamber_to_ambient, SurrogateResult* result) {
+    // The negated comparisons also reject NaN
+    if (!(expansion_ratio >= surrogate->expansion_min && expansion_ratio <= surrogate->expansion_max) ||
+        !(gamma >= surrogate->gamma_min && gamma <= surrogate->gamma_max) || !(chamber_to_ambient > 0)) {
+        return -1;
+    }
+
+    double u = (log(expansion_ratio) - surrogate->log_expansion_min) * surrogate->inverse_log_step;
+    double v = (gamma - surrogate->gamma_min) * surrogate->inverse_gamma_step;
+    int i = (int)u;
+    int j = (int)v;
+    i = i < surrogate->expansion_count - 2 ? i : surrogate->expansion_count - 2;
+    j = j < surrogate->gamma_count - 2 ? j : surrogate->gamma_count - 2;
+    double s = u - i;
+    double t = v - j;
+
+    // Node (i, j) of the range is stored at (i + 1, j + 1), past the border
+    size_t stride = (size_t)surrogate->row_stride;
+    const double* node = surrogate->nodes + (size_t)(i + 1) * stride + (size_t)(j + 1) * SURROGATE_NUM_FIELDS;
+    double values[SURROGATE_NUM_FIELDS] = {0};
+    double wu[4], wv[4];
+    int taps;
+
+    if (method == SURROGATE_CUBIC) {
+        catmull_rom_weights(s, wu);
+        catmull_rom_weights(t, wv);
+        node -= stride + SURROGATE_NUM_FIELDS;
+        taps = 4;
+    } else {
+        wu[0] = 1.0 - s;
+        wu[1] = s;
+        wv[0] = 1.0 - t;
+        wv[1] = t;
+        taps = 2;
+    }
+
+    // Each row of the stencil is contiguous: interpolate along gamma, then
+    // weight the rows by the expansion-ratio weights
+    for (int a = 0; a < taps; a++) {
+        const double* record = node + a * stride;
+        double row[SURROGATE_NUM_FIELDS] = {0};
+        for (int b = 0; b < taps; b++) {
+            for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+                row[f] += wv[b] * record[b * SURROGATE_NUM_FIELDS + f];
+            }
+        }
+        for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+            values[f] += wu[a] * row[f];
+        }
+    }
+
+    result->thrust_coefficient = values[SURROGATE_VACUUM_CF] - expansion_ratio / chamber_to_ambient;
+    result->exit_mach = values[SURROGATE_EXIT_MACH];
+    result->pressure_ratio = values[SURROGATE_PRESSURE_RATIO];
+    result->temperature_ratio = values[SURROGATE_TEMPERATURE_RATIO];
+    return 0;
+}
+
+static void surrogate_grid(CfSurrogate* table, const SurrogateHeader* grid, const double* nodes) {
+    table->nodes = nodes;
+    table->expansion_count = (int)grid->expansion_count;
+    table->gamma_count = (int)grid->gamma_count;
+    table->row_stride = (table->gamma_count + 2) * SURROGATE_NUM_FIELDS;
+    table->expansion_min = grid->expansion_min;
+    table->expansion_max = grid->expansion_max;
+    table->gamma_min = grid->gamma_min;
+    table->gamma_max = grid->gamma_max;
+    table->log_expansion_min = log(grid->expansion_min);
+    table->inverse_log_step = (table->expansion_count - 1) / (log(grid->expansion_max) - table->log_expansion_min);
+    table->inverse_gamma_step = (table->gamma_count - 1) / (grid->gamma_max - grid->gamma_min);
+    memcpy(table->max_error, grid->max_error, sizeof(table->max_error));
+}
+
+// Grid coordinate k (in nodes, possibly fractional) of each axis, kept
+// inside the range against rounding at the ends
+static double surrogate_expansion(const CfSurrogate* table, double k) {
+    double expansion_ratio = exp(table->log_expansion_min + k / table->inverse_log_step);
+    return fmin(fmax(expansion_ratio, table->expansion_min), table->expansion_max);
+}
+
+static double surrogate_gamma(const CfSurrogate* table, double k) {
+    return fmin(fmax(table->gamma_min + k / table->inverse_gamma_step, table->gamma_min), table->gamma_max);
+}
+
+// Rows of stored nodes. Border nodes are solved exactly where the
+// expansion ratio and gamma stay above 1, and left NaN otherwise
+static void surrogate_node_task(long long begin, long long end, int thread_id, void* context) {
+    SurrogateJob* job = (SurrogateJob*)context;
+    const CfSurrogate* table = &job->table;
+
+    for (long long row = begin; row < end; row++) {
+        int i = (int)row - 1;
+        int inside_i = i >= 0 && i < table->expansion_count;
+        double expansion_ratio = inside_i ? surrogate_expansion(table, i) :
+                                 exp(table->log_expansion_min + i / table->inverse_log_step);
+        for (int j = -1; j <= table->gamma_count; j++) {
+            int inside = inside_i && j >= 0 && j < table->gamma_count;
+            double gamma = inside ? surrogate_gamma(table, j) : table->gamma_min + j / table->inverse_gamma_step;
+            double* record = job->nodes + (size_t)row * table->row_stride + (size_t)(j + 1) * SURROGATE_NUM_FIELDS;
+            if (!(expansion_ratio > 1.0 && gamma > 1.0) || surrogate_exact(expansion_ratio, gamma, record) != 0) {
+                for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+                    record[f] = NAN;
+                }
+                if (inside) {
+                    job->threads[thread_id].failed = 1;
+                }
+            }
+        }
+    }
+}
+
+// Rows of a grid SURROGATE_ERROR_DIVISIONS times finer than the nodes,
+// skipping the nodes themselves. The linear error peaks mid-cell, but the
+// leading cubic error term vanishes there and peaks near the quarter points
+static void surrogate_error_task(long long begin, long long end, int thread_id, void* context) {
+    SurrogateJob* job = (SurrogateJob*)context;
+    const CfSurrogate* table = &job->table;
+    SurrogateThreadState* state = &job->threads[thread_id];
+
+    for (long long p = begin; p < end; p++) {
+        double expansion_ratio = surrogate_expansion(table, (double)p / SURROGATE_ERROR_DIVISIONS);
+        for (int q = 0; q <= SURROGATE_ERROR_DIVISIONS * (table->gamma_count - 1); q++) {
+            if (p % SURROGATE_ERROR_DIVISIONS == 0 && q % SURROGATE_ERROR_DIVISIONS == 0) {
+                continue;
+            }
+            double gamma = surrogate_gamma(table, (double)q / SURROGATE_ERROR_DIVISIONS);
+            double exact[SURROGATE_NUM_FIELDS];
+            if (surrogate_exact(expansion_ratio, gamma, exact) != 0) {
+                state->failed = 1;
+                continue;
+            }
+            for (int m = 0; m < SURROGATE_NUM_METHODS; m++) {
+                SurrogateResult result;
+                if (cf_surrogate_lookup(table, (SurrogateInterpolation)m, expansion_ratio, gamma, INFINITY,
+                                        &result) != 0) {
+                    continue;
+                }
+                double approx[SURROGATE_NUM_FIELDS] = {
+                    result.thrust_coefficient, result.exit_mach, result.pressure_ratio, result.temperature_ratio
+                };
+                for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+                    double error = fabs(approx[f] - exact[f]) / fabs(exact[f]);
+                    if (error > state->max_error[m][f]) {
+                        state->max_error[m][f] = error;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Border nodes that could not be solved continue the two nodes next to
+// them linearly: rows first, then columns, which also fills the corners
+static void surrogate_fill_border(double* nodes, int expansion_count, int gamma_count) {
+    size_t stride = (size_t)(gamma_count + 2) * SURROGATE_NUM_FIELDS;
+    size_t step[2] = { stride, SURROGATE_NUM_FIELDS };
+    int count[2] = { expansion_count, gamma_count };
+    size_t lines[2] = { (size_t)gamma_count + 2, (size_t)expansion_count + 2 };
+
+    for (int axis = 0; axis < 2; axis++) {
+        size_t across = step[1 - axis];
+        for (size_t line = 0; line < lines[axis]; line++) {
+            double* first = nodes + line * across;
+            double* last = first + (size_t)(count[axis] + 1) * step[axis];
+            for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+                if (isnan(first[f])) {
+                    first[f] = 2.0 * first[step[axis] + f] - first[2 * step[axis] + f];
+                }
+                if (isnan(last[f])) {
+                    last[f] = 2.0 * last[f - step[axis]] - last[f - 2 * step[axis]];
+                }
+            }
+        }
+    }
+}
+
+int build_cf_surrogate(NgcContext* context, const SurrogateConfig* config, const char* filename) {
+    if (!config || !filename) {
+        return ngc_set_error(context, "Null pointer passed to build_cf_surrogate");
+    }
+
+    SurrogateHeader grid;
+    memset(&grid, 0, sizeof(grid));
+    grid.expansion_min = config->expansion_min;
+    grid.expansion_max = config->expansion_max;
+    grid.gamma_min = config->gamma_min;
+    grid.gamma_max = config->gamma_max;
+    grid.expansion_count = config->expansion_count > 0 ? (uint64_t)config->expansion_count :
+                                                         SURROGATE_DEFAULT_EXPANSION_COUNT;
+    grid.gamma_count = config->gamma_count > 0 ? (uint64_t)config->gamma_count : SURROGATE_DEFAULT_GAMMA_COUNT;
+    if (!(grid.expansion_min > 1.0 && grid.expansion_max > grid.expansion_min && isfinite(grid.expansion_max)) ||
+        !(grid.gamma_min > 1.0 && grid.gamma_max > grid.gamma_min && isfinite(grid.gamma_max)) ||
+        grid.expansion_count < 2 || grid.gamma_count < 2 || grid.expansion_count > SURROGATE_MAX_COUNT ||
+        grid.gamma_count > SURROGATE_MAX_COUNT) {
+        return ngc_set_error(context, "Invalid surrogate grid: the ranges must be above 1 and increasing, "
+                             "with 2 to %d nodes each", SURROGATE_MAX_COUNT);
+    }
+
+    size_t num_nodes = (size_t)(grid.expansion_count + 2) * (size_t)(grid.gamma_count + 2);
+    size_t node_bytes = num_nodes * SURROGATE_NUM_FIELDS * sizeof(double);
+    int num_threads = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+    char* records = malloc(sizeof(SurrogateHeader) + node_bytes);
+    SurrogateThreadState* threads = calloc((size_t)num_threads, sizeof(SurrogateThreadState));
+    if (!records || !threads) {
+        free(records);
+        free(threads);
+        return ngc_set_error(context, "Cannot allocate the surrogate table");
+    }
+
+    SurrogateJob job;
+    job.nodes = (double*)(records + sizeof(SurrogateHeader));
+    job.threads = threads;
+    surrogate_grid(&job.table, &grid, job.nodes);
+
+    int status = 0;
+    if (parallel_for((long long)grid.expansion_count + 2, 1, num_threads, surrogate_node_task, &job) < 0) {
+        status = ngc_set_error(context, "Cannot start the surrogate workers");
+    }
+    if (status == 0) {
+        surrogate_fill_border(job.nodes, (int)grid.expansion_count, (int)grid.gamma_count);
+        long long error_rows = SURROGATE_ERROR_DIVISIONS * ((long long)grid.expansion_count - 1) + 1;
+        if (parallel_for(error_rows, 1, num_threads, surrogate_error_task, &job) < 0) {
+            status = ngc_set_error(context, "Cannot start the surrogate workers");
+        }
+    }
+    for (int t = 0; status == 0 && t < num_threads; t++) {
+        if (threads[t].failed) {
+            status = ngc_set_error(context, "The area-Mach solver failed inside the surrogate grid");
+        }
+        for (int m = 0; m < SURROGATE_NUM_METHODS; m++) {
+            for (int f = 0; f < SURROGATE_NUM_FIELDS; f++) {
+                grid.max_error[m][f] = fmax(grid.max_error[m][f], threads[t].max_error[m][f]);
+            }
+        }
+    }
+
+    if (status == 0) {
+        NgcDataHeader header;
+        ngc_data_header_init(&header, NGC_DATA_SURROGATE, SURROGATE_NUM_FIELDS, (uint64_t)num_nodes,
+                             "vacuum_cf,exit_mach,pressure_ratio,temperature_ratio");
+        header.header_size = sizeof(NgcDataHeader) + sizeof(SurrogateHeader);
+        memcpy(records, &grid, sizeof(grid));
+        status = ngc_data_write(context, filename, &header, records, sizeof(SurrogateHeader) + node_bytes);
+    }
+    free(records);
+    free(threads);
+
+    if (status == 0) {
+        ngc_diagnostic(context, "Surrogate table of %d x %d nodes written to %s", (int)grid.expansion_count,
+                       (int)grid.gamma_count, filename);
+    }
+    return status;
+}
+
+int cf_surrogate_open(NgcContext* context, CfSurrogate* surrogate, const char* filename) {
+    if (!surrogate || !filename) {
+        return ngc_set_error(context, "Null pointer passed to cf_surrogate_open");
+    }
+    memset(surrogate, 0, sizeof(CfSurrogate));
+
+    NgcDataFile file;
+    if (ngc_data_open(context, &file, filename) != 0) {
+        return -1;
+    }
+
+    const NgcDataHeader* header = file.header;
+    const SurrogateHeader* grid = (const SurrogateHeader*)(header + 1);
+    if (header->kind != NGC_DATA_SURROGATE) {
+        ngc_data_close(&file);
+        return ngc_set_error(context, "%s is not a surrogate table", filename);
+    }
+    if (header->header_size != sizeof(NgcDataHeader) + sizeof(SurrogateHeader) ||
+        grid->expansion_count < 2 || grid->gamma_count < 2 || grid->expansion_count > SURROGATE_MAX_COUNT ||
+        grid->gamma_count > SURROGATE_MAX_COUNT ||
+        header->record_count != (grid->expansion_count + 2) * (grid->gamma_count + 2) ||
+        !(grid->expansion_min > 1.0 && grid->expansion_max > grid->expansion_min) ||
+        !(grid->gamma_min > 1.0 && grid->gamma_max > grid->gamma_min)) {
+        ngc_data_close(&file);
+        return ngc_set_error(context, "%s is truncated or corrupt", filename);
+    }
+
+    surrogate_grid(surrogate, grid, file.records);
+    surrogate->file = file;
+    return 0;
+}
+
+void cf_surrogate_close(CfSurrogate* surrogate) {
+    if (!surrogate) {
+        return;
+    }
+    ngc_data_close(&surrogate->file);
+    memset(surrogate, 0, sizeof(CfSurrogate));
+}
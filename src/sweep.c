@@ -0,0 +1,268 @@
+#include "../include/ngc.h"
+#include <limits.h>
+#include <string.h>
+
+// Parameter names accepted in sweep specs; they match the CLI long options
+static const char* const sweep_parameter_names[SWEEP_NUM_PARAMETERS] = {
+    "throat-radius",
+    "exit-radius",
+    "chamber-pressure",
+    "ambient-pressure",
+    "chamber-temp",
+    "molecular-weight",
+    "gamma",
+    "length-fraction"
+};
+
+typedef struct {
+    long long completed;
+    long long failed;
+    int has_best;
+    NozzleDesign best_design;
+    PerformanceResults best_results;
+    NgcProfile profile;
+    char padding[64];
+} SweepThreadState;
+
+typedef struct {
+    const SweepConfig* config;
+    SweepThreadState* threads;
+} SweepJob;
+
+const char* sweep_parameter_name(SweepParameter parameter) {
+    if (parameter < 0 || parameter >= SWEEP_NUM_PARAMETERS) {
+        return NULL;
+    }
+    return sweep_parameter_names[parameter];
+}
+
+double* nozzle_design_parameter(NozzleDesign* design, SweepParameter parameter) {
+    if (!design) {
+        return NULL;
+    }
+    switch (parameter) {
+        case SWEEP_THROAT_RADIUS:       return &design->throat_radius;
+        case SWEEP_EXIT_RADIUS:         return &design->exit_radius;
+        case SWEEP_CHAMBER_PRESSURE:    return &design->conditions.chamber_pressure;
+        case SWEEP_AMBIENT_PRESSURE:    return &design->conditions.ambient_pressure;
+        case SWEEP_CHAMBER_TEMPERATURE: return &design->conditions.chamber_temperature;
+        case SWEEP_MOLECULAR_WEIGHT:    return &design->conditions.molecular_weight;
+        case SWEEP_GAMMA:               return &design->conditions.gamma;
+        case SWEEP_LENGTH_FRACTION:     return &design->length_fraction;
+        default:                        return NULL;
+    }
+}
+
+// -1 when the product of the counts would overflow, or when its results
+// could not be addressed in memory
+long long sweep_case_count(const SweepConfig* config) {
+    if (!config) {
+        return -1;
+    }
+
+    long long limit = LLONG_MAX;
+    if ((unsigned long long)limit > SIZE_MAX / sizeof(PerformanceResults)) {
+        limit = (long long)(SIZE_MAX / sizeof(PerformanceResults));
+    }
+    long long total = 1;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        long long count = config->ranges[p].count;
+        if (count > 0) {
+            if (total > limit / count) {
+                return -1;
+            }
+            total *= count;
+        }
+    }
+    return total;
+}
+
+int sweep_case_design(const SweepConfig* config, long long index, NozzleDesign* design) {
+    if (!config || !design || index < 0) {
+        return -1;
+    }
+
+    *design = config->base;
+
+    // Mixed-radix decode; the first parameter varies fastest
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        const SweepRange* range = &config->ranges[p];
+        if (range->count <= 0) {
+            continue;
+        }
+
+        long long k = index % range->count;
+        index /= range->count;
+
+        double value = range->start;
+        if (range->count > 1) {
+            value += (range->stop - range->start) * (double)k / (double)(range->count - 1);
+        }
+        *nozzle_design_parameter(design, (SweepParameter)p) = value;
+    }
+
+    return index == 0 ? 0 : -1;
+}
+
+int sweep_parameter_from_name(const char* name) {
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        if (name && strcmp(name, sweep_parameter_names[p]) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+static int parse_single_range(SweepConfig* config, const char* spec, size_t length) {
+    char buffer[128];
+    if (length == 0 || length >= sizeof(buffer)) {
+        return -1;
+    }
+    memcpy(buffer, spec, length);
+    buffer[length] = '\0';
+
+    char* equals = strchr(buffer, '=');
+    if (!equals) {
+        return -1;
+    }
+    *equals = '\0';
+
+    int parameter = sweep_parameter_from_name(buffer);
+    if (parameter < 0) {
+        return -1;
+    }
+
+    // Accept "start:stop:count" or a single fixed value
+    SweepRange range;
+    char extra;
+    int fields = sscanf(equals + 1, "%lf:%lf:%d%c", &range.start, &range.stop, &range.count, &extra);
+    if (fields == 1) {
+        range.stop = range.start;
+        range.count = 1;
+    } else if (fields != 3 || range.count < 1) {
+        return -1;
+    }
+
+    config->ranges[parameter] = range;
+    return 0;
+}
+
+int parse_sweep_range(SweepConfig* config, const char* spec) {
+    if (!config || !spec) {
+        return -1;
+    }
+
+    // Several ranges may be given in one spec, separated by commas
+    while (*spec) {
+        const char* comma = strchr(spec, ',');
+        size_t length = comma ? (size_t)(comma - spec) : strlen(spec);
+
+        if (parse_single_range(config, spec, length) != 0) {
+            return -1;
+        }
+        spec += length;
+        if (*spec == ',') {
+            spec++;
+        }
+    }
+
+    return 0;
+}
+
+static void sweep_task(long long begin, long long end, int thread_id, void* context) {
+    SweepJob* job = (SweepJob*)context;
+    SweepThreadState* state = &job->threads[thread_id];
+    NozzleContour contour;
+    NozzleDesign design;
+    PerformanceResults results;
+
+    // Sweeps only need the scalar geometry, so no contour points are stored
+    nozzle_contour_init(&contour, 0.0, 0.0, NULL, 0);
+
+    // Workers record into their own profile; the caller merges them
+    NgcProfile* previous = NULL;
+    if (job->config->profile) {
+        previous = ngc_profile_attach(&state->profile);
+    }
+
+    for (long long i = begin; i < end; i++) {
+        sweep_case_design(job->config, i, &design);
+
+        if (evaluate_nozzle_design_cached(job->config->cache, &design, &contour, &results) != 0) {
+            state->failed++;
+            if (job->config->results) {
+                memset(&job->config->results[i], 0, sizeof(PerformanceResults));
+            }
+            continue;
+        }
+
+        state->completed++;
+        if (job->config->results) {
+            job->config->results[i] = results;
+        }
+        if (!state->has_best || results.specific_impulse > state->best_results.specific_impulse) {
+            state->has_best = 1;
+            state->best_design = design;
+            state->best_results = results;
+        }
+    }
+
+    if (job->config->profile) {
+        ngc_profile_attach(previous);
+    }
+}
+
+int run_parameter_sweep(const SweepConfig* config, SweepSummary* summary) {
+    if (!config || !summary) {
+        return -1;
+    }
+
+    memset(summary, 0, sizeof(SweepSummary));
+    summary->total_cases = sweep_case_count(config);
+    if (summary->total_cases <= 0) {
+        return -1;
+    }
+
+    int num_threads = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+    SweepThreadState* threads = calloc((size_t)num_threads, sizeof(SweepThreadState));
+    if (!threads) {
+        return -1;
+    }
+
+    int status = 0;
+    if (config->profile) {
+        for (int t = 0; t < num_threads; t++) {
+            ngc_profile_init(&threads[t].profile, (int)config->profile->sample_mask + 1);
+        }
+    }
+
+    SweepJob job = { config, threads };
+    double start = ngc_wall_time();
+    summary->threads_used = parallel_for(summary->total_cases, config->chunk_size,
+                                         num_threads, sweep_task, &job);
+    summary->elapsed_seconds = ngc_wall_time() - start;
+    if (summary->threads_used < 0) {
+        status = -1;
+    }
+
+    // Reduce per-thread statistics
+    int has_best = 0;
+    for (int t = 0; t < num_threads; t++) {
+        summary->completed_cases += threads[t].completed;
+        summary->failed_cases += threads[t].failed;
+        if (threads[t].has_best &&
+            (!has_best || threads[t].best_results.specific_impulse > summary->best_results.specific_impulse)) {
+            has_best = 1;
+            summary->best_design = threads[t].best_design;
+            summary->best_results = threads[t].best_results;
+        }
+        ngc_profile_merge(config->profile, &threads[t].profile);
+    }
+    free(threads);
+
+    if (summary->elapsed_seconds > 0) {
+        summary->cases_per_second = (double)summary->total_cases / summary->elapsed_seconds;
+    }
+
+    return status;
+}
@@ -0,0 +1,312 @@
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NGC_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Gas-side wall heat transfer along a contour from the Bartz correlation
+// (D. R. Bartz, Jet Propulsion 27, 1957):
+//   h = 0.026 / Dt^0.2 (mu^0.2 cp / Pr^0.6) (pc / c*)^0.8 (Dt / Rc)^0.1 (At / A)^0.9 sigma
+// with the transport properties at chamber conditions and sigma carrying
+// them to the boundary layer at the local Mach number. Everything but the
+// area ratio and the Mach number is a per-nozzle constant, and the Mach
+// number at every station comes from calculate_flow_profile.
+
+#define BARTZ_COEFFICIENT 0.026
+#define BARTZ_AREA_EXPONENT 0.9
+
+// sigma exponents for a viscosity proportional to T^0.6: 0.8 - 0.2 * 0.6
+// and 0.2 * 0.6
+#define BARTZ_BOUNDARY_EXPONENT 0.68
+#define BARTZ_FREESTREAM_EXPONENT 0.12
+
+// Bartz's viscosity estimate 46.6e-10 M^0.5 T^0.6 lb/(in s), with M in
+// lb/lbmol and T in degrees R, for M in g/mol and T in K
+#define BARTZ_VISCOSITY 1.1841e-7
+
+#define THERMAL_MAX_WIDTH 8
+
+typedef struct {
+    double coefficient;          // Every factor of h but (At/A)^0.9 sigma
+    double half_gm1;             // (gamma - 1) / 2
+    double half_wall_ratio;      // Tw / (2 Tc)
+    double recovery_half_gm1;    // Recovery factor Pr^(1/3) times (gamma - 1) / 2
+    double chamber_temperature;
+    double wall_temperature;
+} ThermalConstants;
+
+typedef void (*ThermalBlockFn)(const ThermalConstants* c, const double* area_ratio, const double* mach,
+                               double* coefficient, double* adiabatic_wall_temperature, double* heat_flux);
+
+#ifdef NGC_HAVE_X86_SIMD
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define VEC_WIDTH 4
+#define VEC_NAME(n) n##_avx2
+#define VEC_SQRT(x) _mm256_sqrt_pd(x)
+#include "batch_simd.h"
+#include "thermal_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VEC_WIDTH 8
+#define VEC_NAME(n) n##_avx512
+#define VEC_SQRT(x) _mm512_sqrt_pd(x)
+#include "batch_simd.h"
+#include "thermal_simd.h"
+#undef VEC_WIDTH
+#undef VEC_NAME
+#undef VEC_SQRT
+#pragma GCC pop_options
+
+#endif
+
+// Radius of the circle through the throat station and the next two. A
+// contour without points is a bell (see bell_radius in nozzle_geometry.c),
+// and its parabola has this radius of curvature just past the throat.
+static double contour_throat_curvature_radius(const NozzleContour* contour) {
+    if (contour->num_points == 0 || !contour->points) {
+        double scale = contour->exit_radius / contour->throat_radius - 1.0;
+        double length = contour->exit_x - contour->throat_x;
+        double slope = 2.0 * contour->throat_radius * scale / length;
+        double curvature = 2.0 * contour->throat_radius * scale / (length * length);
+        return pow(1.0 + slope * slope, 1.5) / fabs(curvature);
+    }
+
+    int throat = 0;
+    while (throat < contour->num_points && contour->points[throat].x < contour->throat_x) {
+        throat++;
+    }
+    if (throat + 2 >= contour->num_points) {
+        return NAN;
+    }
+
+    const Point* p = contour->points + throat;
+    double a = hypot(p[1].x - p[0].x, p[1].y - p[0].y);
+    double b = hypot(p[2].x - p[1].x, p[2].y - p[1].y);
+    double d = hypot(p[2].x - p[0].x, p[2].y - p[0].y);
+    double cross = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+    return a * b * d / (2.0 * fabs(cross));
+}
+
+static int thermal_constants_init(ThermalConstants* c, const NozzleContour* contour,
+                                  const FlowConditions* conditions, const ThermalConditions* thermal,
+                                  double* curvature_radius) {
+    double gamma = conditions->gamma;
+    if (!(gamma > 1.0) || !(conditions->chamber_pressure > 0) || !(conditions->chamber_temperature > 0) ||
+        !(conditions->molecular_weight > 0) || !(conditions->gas_constant > 0) ||
+        !(contour->throat_radius > 0) || !(thermal->wall_temperature > 0) ||
+        !(thermal->throat_curvature_radius >= 0) || !(thermal->prandtl_number >= 0) ||
+        !(thermal->viscosity >= 0)) {
+        return -1;
+    }
+
+    double rc = thermal->throat_curvature_radius > 0 ? thermal->throat_curvature_radius :
+                contour_throat_curvature_radius(contour);
+    if (!isfinite(rc) || !(rc > 0)) {
+        return -1;
+    }
+
+    // Chamber transport properties; the Prandtl number from Eucken's relation
+    double R_specific = conditions->gas_constant / conditions->molecular_weight;
+    double tc = conditions->chamber_temperature;
+    double cp = gamma * R_specific / (gamma - 1.0);
+    double prandtl = thermal->prandtl_number > 0 ? thermal->prandtl_number : 4.0 * gamma / (9.0 * gamma - 5.0);
+    double viscosity = thermal->viscosity > 0 ? thermal->viscosity :
+                       BARTZ_VISCOSITY * sqrt(1000.0 * conditions->molecular_weight) * pow(tc, 0.6);
+
+    // c* = sqrt(R Tc / gamma) ((gamma + 1) / 2)^((gamma + 1) / (2 (gamma - 1))), the
+    // chamber pressure times throat area per unit of choked mass flow
+    double characteristic_velocity = sqrt(R_specific * tc / gamma) *
+                                     pow(0.5 * (gamma + 1.0), 0.5 * (gamma + 1.0) / (gamma - 1.0));
+
+    double throat_diameter = 2.0 * contour->throat_radius;
+    c->coefficient = BARTZ_COEFFICIENT / pow(throat_diameter, 0.2) *
+                     pow(viscosity, 0.2) * cp / pow(prandtl, 0.6) *
+                     pow(conditions->chamber_pressure / characteristic_velocity, 0.8) *
+                     pow(throat_diameter / rc, 0.1);
+    c->half_gm1 = 0.5 * (gamma - 1.0);
+    c->half_wall_ratio = 0.5 * thermal->wall_temperature / tc;
+    c->recovery_half_gm1 = cbrt(prandtl) * c->half_gm1;
+    c->chamber_temperature = tc;
+    c->wall_temperature = thermal->wall_temperature;
+    *curvature_radius = rc;
+    return 0;
+}
+
+static void thermal_station(const ThermalConstants* c, double area_ratio, double mach,
+                            double* coefficient, double* adiabatic_wall_temperature, double* heat_flux) {
+    double m2 = mach * mach;
+    double base = 1.0 + c->half_gm1 * m2;
+    double sigma = 1.0 / (pow(c->half_wall_ratio * base + 0.5, BARTZ_BOUNDARY_EXPONENT) *
+                          pow(base, BARTZ_FREESTREAM_EXPONENT));
+    double h = c->coefficient * pow(area_ratio, -BARTZ_AREA_EXPONENT) * sigma;
+    double taw = c->chamber_temperature * (1.0 + c->recovery_half_gm1 * m2) / base;
+
+    *coefficient = h;
+    *adiabatic_wall_temperature = taw;
+    *heat_flux = h * (taw - c->wall_temperature);
+}
+
+// Peak and wall integral of the heat flux, the wall between stations taken
+// as a frustum
+static void thermal_summary(const NozzleContour* contour, const double* heat_flux, double curvature_radius,
+                            ThermalSummary* summary) {
+    const Point* p = contour->points;
+    int peak = 0;
+    double heat_rate = 0.0;
+
+    for (int i = 1; i < contour->num_points; i++) {
+        if (heat_flux[i] > heat_flux[peak]) {
+            peak = i;
+        }
+        double slant = hypot(p[i].x - p[i - 1].x, p[i].y - p[i - 1].y);
+        heat_rate += 0.5 * (heat_flux[i] + heat_flux[i - 1]) * PI * (p[i].y + p[i - 1].y) * slant;
+    }
+
+    summary->peak_heat_flux = heat_flux[peak];
+    summary->peak_x = p[peak].x;
+    summary->heat_rate = heat_rate;
+    summary->throat_curvature_radius = curvature_radius;
+}
+
+static int compute_thermal_profile(const NozzleContour* contour, const FlowConditions* conditions,
+                                   const ThermalConditions* thermal, ThermalProfileOutput* output,
+                                   ThermalSummary* summary, BatchIsa isa) {
+    ThermalConstants c;
+    double curvature_radius;
+    if (thermal_constants_init(&c, contour, conditions, thermal, &curvature_radius) != 0) {
+        return -1;
+    }
+
+    // Stations padded to whole vectors with copies of the last one
+    int count = contour->num_points;
+    size_t padded = ((size_t)count + THERMAL_MAX_WIDTH - 1) / THERMAL_MAX_WIDTH * THERMAL_MAX_WIDTH;
+    double* scratch = malloc(5 * padded * sizeof(double));
+    if (!scratch) {
+        return -1;
+    }
+    double* area_ratio = scratch;
+    double* mach = scratch + padded;
+    double* fields[3] = { scratch + 2 * padded, scratch + 3 * padded, scratch + 4 * padded };
+
+    FlowProfileOutput flow = { area_ratio, mach, NULL, NULL, NULL, NULL };
+    int status = calculate_flow_profile_isa(contour, conditions, &flow, isa);
+    for (size_t i = (size_t)count; i < padded; i++) {
+        area_ratio[i] = area_ratio[count - 1];
+        mach[i] = mach[count - 1];
+    }
+
+    ThermalBlockFn block = NULL;
+    int width = 1;
+#ifdef NGC_HAVE_X86_SIMD
+    if (isa == BATCH_ISA_AVX512) {
+        block = thermal_block_avx512;
+        width = 8;
+    } else if (isa == BATCH_ISA_AVX2) {
+        block = thermal_block_avx2;
+        width = 4;
+    }
+#endif
+    if (block) {
+        for (int i = 0; i < count; i += width) {
+            block(&c, area_ratio + i, mach + i, fields[0] + i, fields[1] + i, fields[2] + i);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            thermal_station(&c, area_ratio[i], mach[i], fields[0] + i, fields[1] + i, fields[2] + i);
+        }
+    }
+
+    double* const outputs[3] = {
+        output->heat_transfer_coefficient, output->adiabatic_wall_temperature, output->heat_flux
+    };
+    for (int f = 0; f < 3; f++) {
+        if (outputs[f]) {
+            memcpy(outputs[f], fields[f], (size_t)count * sizeof(double));
+        }
+    }
+    if (summary) {
+        thermal_summary(contour, fields[2], curvature_radius, summary);
+    }
+
+    free(scratch);
+    return status;
+}
+
+int calculate_thermal_profile_isa(const NozzleContour* contour, const FlowConditions* conditions,
+                                  const ThermalConditions* thermal, ThermalProfileOutput* output,
+                                  ThermalSummary* summary, BatchIsa isa) {
+    if (!contour || !conditions || !thermal || !output || contour->num_points < 1 || !contour->points) {
+        return -1;
+    }
+
+    BatchIsa available = batch_isa_available();
+    if (isa == BATCH_ISA_AUTO) {
+        isa = available;
+    }
+    if (isa > available) {
+        return -1;
+    }
+
+    NGC_PROFILE_BEGIN(timer, NGC_STAGE_THERMAL);
+    int status = compute_thermal_profile(contour, conditions, thermal, output, summary, isa);
+    NGC_PROFILE_END(timer);
+    return status;
+}
+
+int calculate_thermal_profile(const NozzleContour* contour, const FlowConditions* conditions,
+                              const ThermalConditions* thermal, ThermalProfileOutput* output,
+                              ThermalSummary* summary) {
+    return calculate_thermal_profile_isa(contour, conditions, thermal, output, summary, BATCH_ISA_AUTO);
+}
+
+static void thermal_task(long long begin, long long end, int thread_id, void* context) {
+    ThermalCase* cases = (ThermalCase*)context;
+    (void)thread_id;
+
+    for (long long i = begin; i < end; i++) {
+        ThermalCase* c = &cases[i];
+        c->status = calculate_thermal_profile(c->contour, c->conditions, c->thermal, &c->output, &c->summary);
+    }
+}
+
+int calculate_thermal_batch(ThermalCase* cases, size_t count, int num_threads) {
+    if (!cases && count > 0) {
+        return -1;
+    }
+
+    // One nozzle per chunk: a profile is already thousands of stations
+    if (parallel_for((long long)count, 1, num_threads, thermal_task, cases) < 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (cases[i].status != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Peak of the Bartz heat flux on a bell, where A = At and M = 1; cheap
+// enough for the optimizer, and needs no contour points
+int calculate_throat_heat_flux(const NozzleContour* contour, const FlowConditions* conditions,
+                               const ThermalConditions* thermal, double* heat_flux) {
+    ThermalConstants c;
+    double curvature_radius, coefficient, adiabatic_wall_temperature;
+
+    if (!contour || !conditions || !thermal || !heat_flux ||
+        thermal_constants_init(&c, contour, conditions, thermal, &curvature_radius) != 0) {
+        return -1;
+    }
+    thermal_station(&c, 1.0, 1.0, &coefficient, &adiabatic_wall_temperature, heat_flux);
+    return 0;
+}
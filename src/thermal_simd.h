@@ -0,0 +1,25 @@
+// Bartz station kernel for calculate_thermal_profile, instantiated once per
+// ISA by thermal.c after batch_simd.h (no include guard on purpose); it
+// uses the same VEC_* macros and vector math.
+
+#define VD VEC_NAME(vd)
+
+// VEC_WIDTH stations: h = C (A*/A)^0.9 sigma with
+// sigma = (Tw/(2 Tc) base + 1/2)^-0.68 base^-0.12, base = 1 + (gamma - 1)/2 M^2
+static void VEC_NAME(thermal_block)(const ThermalConstants* c, const double* area_ratio, const double* mach,
+                                    double* coefficient, double* adiabatic_wall_temperature, double* heat_flux) {
+    VD m2 = VEC_NAME(load)(mach);
+    m2 *= m2;
+    VD base = 1.0 + c->half_gm1 * m2;
+    VD exponent = -BARTZ_AREA_EXPONENT * VEC_NAME(vlog)(VEC_NAME(load)(area_ratio)) -
+                  BARTZ_BOUNDARY_EXPONENT * VEC_NAME(vlog)(c->half_wall_ratio * base + 0.5) -
+                  BARTZ_FREESTREAM_EXPONENT * VEC_NAME(vlog)(base);
+    VD h = c->coefficient * VEC_NAME(vexp)(exponent);
+    VD taw = c->chamber_temperature * (1.0 + c->recovery_half_gm1 * m2) / base;
+
+    VEC_NAME(store)(coefficient, h);
+    VEC_NAME(store)(adiabatic_wall_temperature, taw);
+    VEC_NAME(store)(heat_flux, h * (taw - c->wall_temperature));
+}
+
+#undef VD
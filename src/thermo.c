@@ -0,0 +1,649 @@
+#include "context.h"
+#include <string.h>
+
+// Propellant thermochemistry. The chamber state is the adiabatic, isobaric
+// (HP) equilibrium of the gaseous combustion products, found by Gibbs
+// energy minimization with the element-potential Newton method of NASA
+// CEA (Gordon and McBride, NASA RP-1311). Species properties come from
+// NASA 7-coefficient polynomials:
+//
+//   Cp/R = a1 + a2 T + a3 T^2 + a4 T^3 + a5 T^4
+//   H/RT = a1 + a2 T/2 + a3 T^2/3 + a4 T^3/4 + a5 T^4/5 + a6/T
+//   S/R  = a1 ln T + a2 T + a3 T^2/2 + a4 T^3/3 + a5 T^4/4 + a7
+//
+// Amounts are in mol per kg of mixture, so the molecular weight is 1 / n.
+// Sweeps use PropellantTable, which tabulates the properties over mixture
+// ratio and ln(chamber pressure) once and interpolates bilinearly.
+
+#define THERMO_NUM_ELEMENTS 3
+#define THERMO_MAX_UNKNOWNS (THERMO_NUM_ELEMENTS + 2)
+#define THERMO_GAS_CONSTANT 8.314462618  // J/(mol K)
+#define THERMO_REFERENCE_PRESSURE 1.0e5   // Pa
+#define THERMO_TEMPERATURE_SPLIT 1000.0   // K, between the two coefficient ranges
+#define THERMO_MAX_ITERATIONS 200
+#define THERMO_TOLERANCE 1.0e-10
+#define THERMO_TRACE_LOG 18.420681        // -ln(1e-8): species below this get the trace step limit
+#define THERMO_TRACE_TARGET 9.2103404      // -ln(1e-4): how far one step may raise them
+#define THERMO_MAX_TABLE_COUNT 4096
+
+typedef enum { ELEMENT_H = 0, ELEMENT_O, ELEMENT_C } ThermoElement;
+
+// Table interpolation walks ChamberProperties as an array of doubles
+typedef char chamber_properties_check[sizeof(ChamberProperties) == CHAMBER_NUM_PROPERTIES * sizeof(double)
+                                      ? 1 : -1];
+
+// kg/mol
+static const double element_masses[THERMO_NUM_ELEMENTS] = { 1.00794e-3, 15.9994e-3, 12.0107e-3 };
+
+typedef struct {
+    const char* name;
+    double atoms[THERMO_NUM_ELEMENTS];
+    double low[7];               // 200-1000 K
+    double high[7];              // 1000-3500 K (GRI-Mech 3.0 fits, valid to ~6000 K)
+} ThermoSpecies;
+
+static const ThermoSpecies thermo_species[THERMO_NUM_SPECIES] = {
+    { "H2", { 2, 0, 0 },
+      { 2.34433112E+00, 7.98052075E-03, -1.94781510E-05, 2.01572094E-08, -7.37611761E-12,
+        -9.17935173E+02, 6.83010238E-01 },
+      { 3.33727920E+00, -4.94024731E-05, 4.99456778E-07, -1.79566394E-10, 2.00255376E-14,
+        -9.50158922E+02, -3.20502331E+00 } },
+    { "O2", { 0, 2, 0 },
+      { 3.78245636E+00, -2.99673416E-03, 9.84730201E-06, -9.68129509E-09, 3.24372837E-12,
+        -1.06394356E+03, 3.65767573E+00 },
+      { 3.28253784E+00, 1.48308754E-03, -7.57966669E-07, 2.09470555E-10, -2.16717794E-14,
+        -1.08845772E+03, 5.45323129E+00 } },
+    { "H2O", { 2, 1, 0 },
+      { 4.19864056E+00, -2.03643410E-03, 6.52040211E-06, -5.48797062E-09, 1.77197817E-12,
+        -3.02937267E+04, -8.49032208E-01 },
+      { 3.03399249E+00, 2.17691804E-03, -1.64072518E-07, -9.70419870E-11, 1.68200992E-14,
+        -3.00042971E+04, 4.96677010E+00 } },
+    { "OH", { 1, 1, 0 },
+      { 3.99201543E+00, -2.40131752E-03, 4.61793841E-06, -3.88113333E-09, 1.36411470E-12,
+        3.61508056E+03, -1.03925458E-01 },
+      { 3.09288767E+00, 5.48429716E-04, 1.26505228E-07, -8.79461556E-11, 1.17412376E-14,
+        3.85865700E+03, 4.47669610E+00 } },
+    { "H", { 1, 0, 0 },
+      { 2.50000000E+00, 7.05332819E-13, -1.99591964E-15, 2.30081632E-18, -9.27732332E-22,
+        2.54736599E+04, -4.46682853E-01 },
+      { 2.50000001E+00, -2.30842973E-11, 1.61561948E-14, -4.73515235E-18, 4.98197357E-22,
+        2.54736599E+04, -4.46682914E-01 } },
+    { "O", { 0, 1, 0 },
+      { 3.16826710E+00, -3.27931884E-03, 6.64306396E-06, -6.12806624E-09, 2.11265971E-12,
+        2.91222592E+04, 2.05193346E+00 },
+      { 2.56942078E+00, -8.59741137E-05, 4.19484589E-08, -1.00177799E-11, 1.22833691E-15,
+        2.92175791E+04, 4.78433864E+00 } },
+    { "CO", { 0, 1, 1 },
+      { 3.57953347E+00, -6.10353680E-04, 1.01681433E-06, 9.07005884E-10, -9.04424499E-13,
+        -1.43440860E+04, 3.50840928E+00 },
+      { 2.71518561E+00, 2.06252743E-03, -9.98825771E-07, 2.30053008E-10, -2.03647716E-14,
+        -1.41518724E+04, 7.81868772E+00 } },
+    { "CO2", { 0, 2, 1 },
+      { 2.35677352E+00, 8.98459677E-03, -7.12356269E-06, 2.45919022E-09, -1.43699548E-13,
+        -4.83719697E+04, 9.90105222E+00 },
+      { 3.85746029E+00, 4.41437026E-03, -2.21481404E-06, 5.23490188E-10, -4.72084164E-14,
+        -4.87591660E+04, 2.27163806E+00 } }
+};
+
+// A reactant at its injection state; RP-1 is the CEA surrogate CH1.9423
+typedef struct {
+    double atoms[THERMO_NUM_ELEMENTS];
+    double enthalpy;             // Assigned enthalpy (J/mol)
+} ThermoReactant;
+
+typedef struct {
+    const char* name;
+    ThermoReactant oxidizer;
+    ThermoReactant fuel;
+    double default_mixture_ratio;
+} ThermoPropellant;
+
+static const ThermoPropellant thermo_propellants[PROPELLANT_NUM] = {
+    { "lox-lh2", { { 0, 2, 0 }, -12979.0 }, { { 2, 0, 0 }, -9012.0 }, 6.0 },
+    { "lox-ch4", { { 0, 2, 0 }, -12979.0 }, { { 4, 0, 1 }, -89233.0 }, 3.6 },
+    { "lox-rp1", { { 0, 2, 0 }, -12979.0 }, { { 1.9423, 0, 1 }, -24717.7 }, 2.6 }
+};
+
+const char* propellant_name(Propellant propellant) {
+    if (propellant < 0 || propellant >= PROPELLANT_NUM) {
+        return NULL;
+    }
+    return thermo_propellants[propellant].name;
+}
+
+int propellant_from_name(const char* name) {
+    for (int p = 0; name && p < PROPELLANT_NUM; p++) {
+        if (strcmp(name, thermo_propellants[p].name) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+double propellant_default_mixture_ratio(Propellant propellant) {
+    if (propellant < 0 || propellant >= PROPELLANT_NUM) {
+        return 0.0;
+    }
+    return thermo_propellants[propellant].default_mixture_ratio;
+}
+
+const char* thermo_species_name(int species) {
+    if (species < 0 || species >= THERMO_NUM_SPECIES) {
+        return NULL;
+    }
+    return thermo_species[species].name;
+}
+
+static double reactant_molar_mass(const ThermoReactant* reactant) {
+    double mass = 0.0;
+    for (int i = 0; i < THERMO_NUM_ELEMENTS; i++) {
+        mass += reactant->atoms[i] * element_masses[i];
+    }
+    return mass;
+}
+
+// Cp/R, H/RT and S/R of one species
+static void species_properties(const ThermoSpecies* species, double temperature, double* cp, double* h, double* s) {
+    const double* a = temperature < THERMO_TEMPERATURE_SPLIT ? species->low : species->high;
+    double t = temperature;
+    *cp = a[0] + t * (a[1] + t * (a[2] + t * (a[3] + t * a[4])));
+    *h = a[0] + t * (a[1] / 2.0 + t * (a[2] / 3.0 + t * (a[3] / 4.0 + t * a[4] / 5.0))) + a[5] / t;
+    *s = a[0] * log(t) + t * (a[1] + t * (a[2] / 2.0 + t * (a[3] / 3.0 + t * a[4] / 4.0))) + a[6];
+}
+
+// Gaussian elimination with partial pivoting on an n x n system; the
+// solution replaces b
+static int solve_linear(double a[THERMO_MAX_UNKNOWNS][THERMO_MAX_UNKNOWNS], double* b, int n) {
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++) {
+            if (fabs(a[row][col]) > fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (!(fabs(a[pivot][col]) > 0)) {
+            return -1;
+        }
+        if (pivot != col) {
+            for (int k = 0; k < n; k++) {
+                double swap = a[col][k];
+                a[col][k] = a[pivot][k];
+                a[pivot][k] = swap;
+            }
+            double swap = b[col];
+            b[col] = b[pivot];
+            b[pivot] = swap;
+        }
+        for (int row = col + 1; row < n; row++) {
+            double factor = a[row][col] / a[col][col];
+            for (int k = col; k < n; k++) {
+                a[row][k] -= factor * a[col][k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    for (int row = n - 1; row >= 0; row--) {
+        double sum = b[row];
+        for (int k = row + 1; k < n; k++) {
+            sum -= a[row][k] * b[k];
+        }
+        b[row] = sum / a[row][row];
+    }
+    return 0;
+}
+
+// Species and elements taking part in one propellant's equilibrium
+typedef struct {
+    int num_species;
+    int num_elements;
+    int species[THERMO_NUM_SPECIES];
+    double atoms[THERMO_NUM_SPECIES][THERMO_NUM_ELEMENTS];  // Active species x active elements
+    double element_moles[THERMO_NUM_ELEMENTS];              // b0 (mol/kg)
+    double enthalpy;                                        // h0 (J/kg)
+} ThermoSystem;
+
+static int thermo_system_init(ThermoSystem* system, Propellant propellant, double mixture_ratio) {
+    const ThermoPropellant* data = &thermo_propellants[propellant];
+    double oxidizer_fraction = mixture_ratio / (1.0 + mixture_ratio);
+    double oxidizer_moles = oxidizer_fraction / reactant_molar_mass(&data->oxidizer);
+    double fuel_moles = (1.0 - oxidizer_fraction) / reactant_molar_mass(&data->fuel);
+
+    int elements[THERMO_NUM_ELEMENTS];
+    double oxygen = 0.0;
+    memset(system, 0, sizeof(ThermoSystem));
+    for (int i = 0; i < THERMO_NUM_ELEMENTS; i++) {
+        double moles = oxidizer_moles * data->oxidizer.atoms[i] + fuel_moles * data->fuel.atoms[i];
+        if (moles > 0) {
+            elements[system->num_elements] = i;
+            system->element_moles[system->num_elements++] = moles;
+        }
+    }
+    system->enthalpy = oxidizer_moles * data->oxidizer.enthalpy + fuel_moles * data->fuel.enthalpy;
+
+    // A species is a candidate when all of its elements are present
+    for (int j = 0; j < THERMO_NUM_SPECIES; j++) {
+        int present = 1;
+        for (int i = 0; i < THERMO_NUM_ELEMENTS; i++) {
+            if (thermo_species[j].atoms[i] > 0 && !(oxidizer_moles * data->oxidizer.atoms[i] +
+                                                    fuel_moles * data->fuel.atoms[i] > 0)) {
+                present = 0;
+            }
+        }
+        if (!present) {
+            continue;
+        }
+        int s = system->num_species++;
+        system->species[s] = j;
+        for (int e = 0; e < system->num_elements; e++) {
+            system->atoms[s][e] = thermo_species[j].atoms[elements[e]];
+        }
+    }
+
+    // Carbon can only leave as CO or CO2, which needs at least one oxygen per carbon
+    for (int e = 0; e < system->num_elements; e++) {
+        if (elements[e] == ELEMENT_O) {
+            oxygen = system->element_moles[e];
+        }
+    }
+    for (int e = 0; e < system->num_elements; e++) {
+        if (elements[e] == ELEMENT_C && system->element_moles[e] >= oxygen) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// The (d/d ln T)_P and (d/d ln P)_T derivatives of the equilibrium give
+// the shifting specific heat and gamma (RP-1311 section 2.5)
+static int equilibrium_gamma(const ThermoSystem* system, const double* moles, double total,
+                             const double* cp, const double* h, double* gamma) {
+    int ne = system->num_elements;
+    double a[THERMO_MAX_UNKNOWNS][THERMO_MAX_UNKNOWNS];
+    double at[THERMO_MAX_UNKNOWNS][THERMO_MAX_UNKNOWNS];
+    double rhs_t[THERMO_MAX_UNKNOWNS] = {0};
+    double rhs_p[THERMO_MAX_UNKNOWNS] = {0};
+    double enthalpy_rows[THERMO_NUM_ELEMENTS] = {0};
+    double frozen_cp = 0.0, enthalpy = 0.0, enthalpy_square = 0.0;
+    memset(a, 0, sizeof(a));
+
+    for (int s = 0; s < system->num_species; s++) {
+        for (int i = 0; i < ne; i++) {
+            for (int k = 0; k < ne; k++) {
+                a[i][k] += system->atoms[s][i] * system->atoms[s][k] * moles[s];
+            }
+            a[i][ne] += system->atoms[s][i] * moles[s];
+            enthalpy_rows[i] += system->atoms[s][i] * moles[s] * h[s];
+        }
+        frozen_cp += moles[s] * cp[s];
+        enthalpy += moles[s] * h[s];
+        enthalpy_square += moles[s] * h[s] * h[s];
+    }
+    for (int i = 0; i < ne; i++) {
+        a[ne][i] = a[i][ne];
+        rhs_t[i] = -enthalpy_rows[i];
+        rhs_p[i] = a[i][ne];
+    }
+    rhs_t[ne] = -enthalpy;
+    rhs_p[ne] = total;
+    memcpy(at, a, sizeof(a));
+    if (solve_linear(at, rhs_t, ne + 1) != 0 || solve_linear(a, rhs_p, ne + 1) != 0) {
+        return -1;
+    }
+
+    double volume_temperature = 1.0 + rhs_t[ne];    // (d ln V / d ln T)_P
+    double volume_pressure = -1.0 + rhs_p[ne];      // (d ln V / d ln P)_T
+    double cp_equilibrium = frozen_cp + enthalpy_square + enthalpy * rhs_t[ne];
+    for (int k = 0; k < ne; k++) {
+        cp_equilibrium += enthalpy_rows[k] * rhs_t[k];
+    }
+    double cv_equilibrium = cp_equilibrium + total * volume_temperature * volume_temperature / volume_pressure;
+    *gamma = cp_equilibrium / cv_equilibrium / -volume_pressure;
+    return *gamma > 1.0 ? 0 : -1;
+}
+
+int calculate_chamber_state(NgcContext* context, Propellant propellant, double mixture_ratio,
+                            double chamber_pressure, ChamberState* state) {
+    if (!state) {
+        return ngc_set_error(context, "Null pointer passed to calculate_chamber_state");
+    }
+    memset(state, 0, sizeof(ChamberState));
+    if (propellant < 0 || propellant >= PROPELLANT_NUM) {
+        return ngc_set_error(context, "Unknown propellant");
+    }
+    if (!(mixture_ratio > 0 && isfinite(mixture_ratio)) || !(chamber_pressure > 0 && isfinite(chamber_pressure))) {
+        return ngc_set_error(context, "Mixture ratio and chamber pressure must be positive");
+    }
+
+    ThermoSystem system;
+    if (thermo_system_init(&system, propellant, mixture_ratio) != 0) {
+        return ngc_set_error(context, "Mixture ratio %g is too fuel-rich for %s: carbon would condense",
+                             mixture_ratio, propellant_name(propellant));
+    }
+
+    int ns = system.num_species;
+    int ne = system.num_elements;
+    double log_pressure = log(chamber_pressure / THERMO_REFERENCE_PRESSURE);
+    double log_moles[THERMO_NUM_SPECIES], moles[THERMO_NUM_SPECIES];
+    double cp[THERMO_NUM_SPECIES], h[THERMO_NUM_SPECIES], mu[THERMO_NUM_SPECIES];
+
+    // The CEA starting point: equal amounts of every species at 3800 K
+    double log_total = log(100.0);
+    double temperature = 3800.0;
+    for (int s = 0; s < ns; s++) {
+        log_moles[s] = log_total - log((double)ns);
+    }
+
+    int converged = 0;
+    int iteration;
+    for (iteration = 1; iteration <= THERMO_MAX_ITERATIONS && !converged; iteration++) {
+        double total = exp(log_total);
+        double sum_moles = 0.0;
+        for (int s = 0; s < ns; s++) {
+            double entropy;
+            moles[s] = exp(log_moles[s]);
+            sum_moles += moles[s];
+            species_properties(&thermo_species[system.species[s]], temperature, &cp[s], &h[s], &entropy);
+            mu[s] = h[s] - entropy + log_moles[s] - log_total + log_pressure;  // mu / RT
+        }
+
+        // Element rows, the total-moles row and the energy row; the unknowns
+        // are the element potentials, d ln n and d ln T
+        double a[THERMO_MAX_UNKNOWNS][THERMO_MAX_UNKNOWNS];
+        double x[THERMO_MAX_UNKNOWNS] = {0};
+        memset(a, 0, sizeof(a));
+        int rn = ne, rt = ne + 1;
+        for (int s = 0; s < ns; s++) {
+            double nj = moles[s];
+            for (int i = 0; i < ne; i++) {
+                double aij = system.atoms[s][i] * nj;
+                for (int k = 0; k < ne; k++) {
+                    a[i][k] += aij * system.atoms[s][k];
+                }
+                a[i][rn] += aij;
+                a[i][rt] += aij * h[s];
+                x[i] += aij * (mu[s] - 1.0);
+                a[rn][i] += aij;
+                a[rt][i] += aij * h[s];
+            }
+            a[rn][rn] += nj;
+            a[rn][rt] += nj * h[s];
+            x[rn] += nj * mu[s] - nj;
+            a[rt][rn] += nj * h[s];
+            a[rt][rt] += nj * (cp[s] + h[s] * h[s]);
+            x[rt] += nj * h[s] * (mu[s] - 1.0);
+        }
+        // Complete the residuals: b0 - b for the elements, n - sum n_j and h0 - h
+        for (int i = 0; i < ne; i++) {
+            x[i] += system.element_moles[i];
+        }
+        a[rn][rn] -= total;
+        x[rn] += total;
+        x[rt] += system.enthalpy / (THERMO_GAS_CONSTANT * temperature);
+        if (solve_linear(a, x, ne + 2) != 0) {
+            break;
+        }
+
+        double d_log_total = x[rn];
+        double d_log_temperature = x[rt];
+        double step[THERMO_NUM_SPECIES];
+        double largest = fmax(5.0 * fabs(d_log_temperature), 5.0 * fabs(d_log_total));
+        double trace_limit = 1.0;
+        converged = fabs(d_log_temperature) <= THERMO_TOLERANCE &&
+                    total * fabs(d_log_total) <= THERMO_TOLERANCE * sum_moles;
+        for (int s = 0; s < ns; s++) {
+            step[s] = -mu[s] + h[s] * d_log_temperature + d_log_total;
+            for (int k = 0; k < ne; k++) {
+                step[s] += system.atoms[s][k] * x[k];
+            }
+            if (moles[s] * fabs(step[s]) > THERMO_TOLERANCE * sum_moles) {
+                converged = 0;
+            }
+
+            // Trace species may grow only until they reach the trace fraction
+            double log_fraction = log_moles[s] - log_total;
+            if (log_fraction > -THERMO_TRACE_LOG) {
+                largest = fmax(largest, fabs(step[s]));
+            } else if (step[s] > d_log_total) {
+                double room = -log_fraction - THERMO_TRACE_TARGET;
+                trace_limit = fmin(trace_limit, fabs(room / (step[s] - d_log_total)));
+            }
+        }
+
+        double lambda = fmin(1.0, trace_limit);
+        if (largest > 2.0) {
+            lambda = fmin(lambda, 2.0 / largest);
+        }
+        for (int s = 0; s < ns; s++) {
+            log_moles[s] += lambda * step[s];
+        }
+        log_total += lambda * d_log_total;
+        temperature *= exp(lambda * d_log_temperature);
+    }
+
+    if (!converged || !isfinite(temperature)) {
+        return ngc_set_error(context, "Chamber equilibrium did not converge for %s at mixture ratio %g",
+                             propellant_name(propellant), mixture_ratio);
+    }
+
+    // Properties at the converged state
+    double total = 0.0, frozen_cp = 0.0;
+    for (int s = 0; s < ns; s++) {
+        double entropy;
+        moles[s] = exp(log_moles[s]);
+        total += moles[s];
+        species_properties(&thermo_species[system.species[s]], temperature, &cp[s], &h[s], &entropy);
+        frozen_cp += moles[s] * cp[s];
+    }
+    for (int s = 0; s < ns; s++) {
+        state->mole_fractions[system.species[s]] = moles[s] / total;
+    }
+
+    ChamberProperties* properties = &state->properties;
+    properties->chamber_temperature = temperature;
+    properties->molecular_weight = 1.0 / total;
+    properties->gamma_frozen = frozen_cp / (frozen_cp - total);
+    if (equilibrium_gamma(&system, moles, total, cp, h, &properties->gamma_shifting) != 0) {
+        return ngc_set_error(context, "Cannot evaluate the equilibrium gamma for %s at mixture ratio %g",
+                             propellant_name(propellant), mixture_ratio);
+    }
+    state->iterations = iteration - 1;
+    return 0;
+}
+
+int chamber_flow_conditions(const ChamberProperties* properties, CompositionModel model,
+                            FlowConditions* conditions) {
+    if (!properties || !conditions) {
+        return -1;
+    }
+    conditions->chamber_temperature = properties->chamber_temperature;
+    conditions->molecular_weight = properties->molecular_weight;
+    conditions->gamma = model == COMPOSITION_FROZEN ? properties->gamma_frozen : properties->gamma_shifting;
+    conditions->gas_constant = THERMO_GAS_CONSTANT;
+    return 0;
+}
+
+// Table construction: one task per mixture-ratio row, each node solved
+// independently so the rows can run on any thread
+typedef struct {
+    PropellantTable* table;
+    int* failed;                 // Per thread
+    ChamberProperties* max_error;  // Per thread
+} ThermoTableJob;
+
+static double table_ratio(const PropellantTable* table, double k) {
+    return fmin(table->ratio_min + k * table->ratio_step, table->ratio_max);
+}
+
+static double table_pressure(const PropellantTable* table, double k) {
+    return fmin(exp(table->log_pressure_min + k * table->log_pressure_step), table->pressure_max);
+}
+
+static void thermo_node_task(long long begin, long long end, int thread_id, void* context) {
+    ThermoTableJob* job = (ThermoTableJob*)context;
+    PropellantTable* table = job->table;
+
+    for (long long i = begin; i < end; i++) {
+        for (int j = 0; j < table->pressure_count; j++) {
+            ChamberState state;
+            if (calculate_chamber_state(NULL, table->propellant, table_ratio(table, (double)i),
+                                        table_pressure(table, j), &state) != 0) {
+                job->failed[thread_id] = 1;
+            }
+            table->nodes[(size_t)i * table->pressure_count + j] = state.properties;
+        }
+    }
+}
+
+// Cell centres, where the bilinear error peaks
+static void thermo_error_task(long long begin, long long end, int thread_id, void* context) {
+    ThermoTableJob* job = (ThermoTableJob*)context;
+    const PropellantTable* table = job->table;
+    ChamberProperties* max_error = &job->max_error[thread_id];
+
+    for (long long i = begin; i < end; i++) {
+        double mixture_ratio = table_ratio(table, i + 0.5);
+        for (int j = 0; j + 1 < table->pressure_count; j++) {
+            double pressure = table_pressure(table, j + 0.5);
+            ChamberState exact;
+            ChamberProperties approx;
+            if (calculate_chamber_state(NULL, table->propellant, mixture_ratio, pressure, &exact) != 0 ||
+                propellant_table_lookup(table, mixture_ratio, pressure, &approx) != 0) {
+                job->failed[thread_id] = 1;
+                continue;
+            }
+            const double* e = &exact.properties.chamber_temperature;
+            const double* a = &approx.chamber_temperature;
+            double* m = &max_error->chamber_temperature;
+            for (int f = 0; f < CHAMBER_NUM_PROPERTIES; f++) {
+                m[f] = fmax(m[f], fabs(a[f] - e[f]) / fabs(e[f]));
+            }
+        }
+    }
+}
+
+int build_propellant_table(NgcContext* context, const PropellantTableConfig* config, PropellantTable* table) {
+    if (!config || !table) {
+        return ngc_set_error(context, "Null pointer passed to build_propellant_table");
+    }
+    memset(table, 0, sizeof(PropellantTable));
+    if (config->propellant < 0 || config->propellant >= PROPELLANT_NUM) {
+        return ngc_set_error(context, "Unknown propellant");
+    }
+    if (!(config->ratio_min > 0 && config->ratio_max > config->ratio_min && isfinite(config->ratio_max)) ||
+        !(config->pressure_min > 0 && config->pressure_max > config->pressure_min &&
+          isfinite(config->pressure_max)) ||
+        config->ratio_count < 2 || config->pressure_count < 2 || config->ratio_count > THERMO_MAX_TABLE_COUNT ||
+        config->pressure_count > THERMO_MAX_TABLE_COUNT) {
+        return ngc_set_error(context, "Invalid propellant table: the ranges must be positive and increasing, "
+                             "with 2 to %d nodes each", THERMO_MAX_TABLE_COUNT);
+    }
+
+    table->propellant = config->propellant;
+    table->ratio_count = config->ratio_count;
+    table->pressure_count = config->pressure_count;
+    table->ratio_min = config->ratio_min;
+    table->ratio_max = config->ratio_max;
+    table->pressure_min = config->pressure_min;
+    table->pressure_max = config->pressure_max;
+    table->ratio_step = (config->ratio_max - config->ratio_min) / (config->ratio_count - 1);
+    table->log_pressure_min = log(config->pressure_min);
+    table->log_pressure_step = (log(config->pressure_max) - table->log_pressure_min) / (config->pressure_count - 1);
+
+    int num_threads = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+    table->nodes = malloc((size_t)config->ratio_count * config->pressure_count * sizeof(ChamberProperties));
+    int* failed = calloc((size_t)num_threads, sizeof(int));
+    ChamberProperties* max_error = calloc((size_t)num_threads, sizeof(ChamberProperties));
+    if (!table->nodes || !failed || !max_error) {
+        free(failed);
+        free(max_error);
+        propellant_table_free(table);
+        return ngc_set_error(context, "Cannot allocate the propellant table");
+    }
+
+    ThermoTableJob job = { table, failed, max_error };
+    int status = 0;
+    if (parallel_for(config->ratio_count, 1, num_threads, thermo_node_task, &job) < 0 ||
+        parallel_for(config->ratio_count - 1, 1, num_threads, thermo_error_task, &job) < 0) {
+        status = ngc_set_error(context, "Cannot start the propellant table workers");
+    }
+    for (int t = 0; status == 0 && t < num_threads; t++) {
+        if (failed[t]) {
+            status = ngc_set_error(context, "Chamber equilibrium failed inside the %s table; "
+                                   "narrow the mixture-ratio range", propellant_name(config->propellant));
+        }
+        const double* m = &max_error[t].chamber_temperature;
+        double* total = &table->max_error.chamber_temperature;
+        for (int f = 0; f < CHAMBER_NUM_PROPERTIES; f++) {
+            total[f] = fmax(total[f], m[f]);
+        }
+    }
+    free(failed);
+    free(max_error);
+
+    if (status != 0) {
+        propellant_table_free(table);
+    }
+    return status;
+}
+
+void propellant_table_free(PropellantTable* table) {
+    if (!table) {
+        return;
+    }
+    free(table->nodes);
+    memset(table, 0, sizeof(PropellantTable));
+}
+
+int propellant_table_lookup(const PropellantTable* table, double mixture_ratio, double chamber_pressure,
+                            ChamberProperties* properties) {
+    // The negated comparisons also reject NaN
+    if (!(mixture_ratio >= table->ratio_min && mixture_ratio <= table->ratio_max) ||
+        !(chamber_pressure >= table->pressure_min && chamber_pressure <= table->pressure_max)) {
+        return -1;
+    }
+
+    double u = (mixture_ratio - table->ratio_min) / table->ratio_step;
+    double v = (log(chamber_pressure) - table->log_pressure_min) / table->log_pressure_step;
+    int i = (int)u;
+    int j = (int)v;
+    i = i < table->ratio_count - 2 ? i : table->ratio_count - 2;
+    j = j < table->pressure_count - 2 ? j : table->pressure_count - 2;
+    double s = u - i;
+    double t = v - j;
+
+    const ChamberProperties* node = table->nodes + (size_t)i * table->pressure_count + j;
+    const double* p00 = &node[0].chamber_temperature;
+    const double* p01 = &node[1].chamber_temperature;
+    const double* p10 = &node[table->pressure_count].chamber_temperature;
+    const double* p11 = &node[table->pressure_count + 1].chamber_temperature;
+    double* out = &properties->chamber_temperature;
+    for (int f = 0; f < CHAMBER_NUM_PROPERTIES; f++) {
+        out[f] = (1.0 - s) * ((1.0 - t) * p00[f] + t * p01[f]) + s * ((1.0 - t) * p10[f] + t * p11[f]);
+    }
+    return 0;
+}
+
+int propellant_table_conditions(const PropellantTable* table, CompositionModel model, const double* mixture_ratio,
+                                const double* chamber_pressure, size_t count, double* chamber_temperature,
+                                double* molecular_weight, double* gamma) {
+    if (!table || !table->nodes || !mixture_ratio || !chamber_pressure || !chamber_temperature ||
+        !molecular_weight || !gamma) {
+        return -1;
+    }
+
+    int status = 0;
+    for (size_t c = 0; c < count; c++) {
+        ChamberProperties properties;
+        if (propellant_table_lookup(table, mixture_ratio[c], chamber_pressure[c], &properties) != 0) {
+            chamber_temperature[c] = NAN;
+            molecular_weight[c] = NAN;
+            gamma[c] = NAN;
+            status = -1;
+            continue;
+        }
+        chamber_temperature[c] = properties.chamber_temperature;
+        molecular_weight[c] = properties.molecular_weight;
+        gamma[c] = model == COMPOSITION_FROZEN ? properties.gamma_frozen : properties.gamma_shifting;
+    }
+    return status;
+}
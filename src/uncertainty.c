@@ -0,0 +1,523 @@
+#include "../include/ngc.h"
+#include <string.h>
+
+// Monte Carlo uncertainty analysis. Sample i draws its inputs from a
+// counter-based generator (Philox4x32-10, Salmon et al., SC 2011) keyed by
+// the seed, with the sample index and parameter as the counter, so every
+// sample is the same whichever thread draws it. The samples are evaluated
+// with the batch performance kernels in fixed blocks; each block keeps its
+// own mean and sum of squared deviations, and the blocks are combined in
+// order at the end, so the moments do not depend on the thread count
+// either. Quantiles come from per-thread log-linear histograms whose
+// integer counts merge exactly.
+
+#define UQ_DEFAULT_SEED 0x9e3779b97f4a7c15ULL
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// Samples per batch kernel call
+#define UQ_BATCH 512
+
+// Samples per block; blocks double in size to keep at most UQ_MAX_BLOCKS
+#define UQ_MIN_BLOCK 4096
+#define UQ_MAX_BLOCKS 65536
+
+// Histogram buckets: the exponent and leading UQ_SUB_BITS mantissa bits of
+// the magnitude, so a bucket spans at most 1/1024 of its lower edge and
+// its midpoint is within 0.05% of every value in it. Magnitudes from 2^-32 to
+// 2^48 have their own buckets; smaller and larger ones share the end
+// buckets.
+#define UQ_SUB_BITS 10
+#define UQ_MIN_EXPONENT (-32)
+#define UQ_MAX_EXPONENT 48
+#define UQ_BUCKETS ((UQ_MAX_EXPONENT - UQ_MIN_EXPONENT) << UQ_SUB_BITS)
+#define UQ_FIRST_KEY ((uint64_t)(1023 + UQ_MIN_EXPONENT) << UQ_SUB_BITS)
+
+static const double uncertainty_quantile_levels[UNCERTAINTY_NUM_QUANTILES] = {
+    0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99
+};
+
+static const char* const uncertainty_output_names[UNCERTAINTY_NUM_OUTPUTS] = {
+    "thrust",
+    "specific-impulse",
+    "thrust-coefficient",
+    "mass-flow-rate"
+};
+
+// Magnitude histogram of one output: negative values, then positive ones
+typedef struct {
+    uint64_t counts[2][UQ_BUCKETS];
+    uint64_t zeros;
+} UncertaintySketch;
+
+typedef struct {
+    long long count;             // Samples evaluated in the block
+    double mean[UNCERTAINTY_NUM_OUTPUTS];
+    double m2[UNCERTAINTY_NUM_OUTPUTS];  // Sum of squared deviations from the mean
+} UncertaintyBlock;
+
+typedef struct {
+    UncertaintySketch sketches[UNCERTAINTY_NUM_OUTPUTS];
+    double inputs[8][UQ_BATCH];
+    double outputs[9][UQ_BATCH];
+    float inputs_f32[8][UQ_BATCH];
+    float outputs_f32[9][UQ_BATCH];
+    double min[UNCERTAINTY_NUM_OUTPUTS];
+    double max[UNCERTAINTY_NUM_OUTPUTS];
+    long long completed;
+    long long rejected;
+    long long double_fallback;
+    char padding[64];
+} UncertaintyThreadState;
+
+typedef struct {
+    const UncertaintyConfig* config;
+    long long block_size;
+    UncertaintyBlock* blocks;
+    UncertaintyThreadState* threads;
+} UncertaintyJob;
+
+const char* uncertainty_output_name(UncertaintyOutput output) {
+    if (output < 0 || output >= UNCERTAINTY_NUM_OUTPUTS) {
+        return NULL;
+    }
+    return uncertainty_output_names[output];
+}
+
+double uncertainty_quantile_level(int index) {
+    if (index < 0 || index >= UNCERTAINTY_NUM_QUANTILES) {
+        return NAN;
+    }
+    return uncertainty_quantile_levels[index];
+}
+
+static void philox4x32(uint32_t counter[4], unsigned long long seed) {
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * counter[0];
+        uint64_t p1 = (uint64_t)PHILOX_M1 * counter[2];
+        uint32_t c1 = counter[1];
+        uint32_t c3 = counter[3];
+        counter[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        counter[1] = (uint32_t)p1;
+        counter[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        counter[3] = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// Draw parameter p of sample index
+static double sample_input(const UncertainInput* input, unsigned long long seed, long long index, int p) {
+    uint32_t counter[4] = { (uint32_t)index, (uint32_t)((unsigned long long)index >> 32), (uint32_t)p, 0 };
+    philox4x32(counter, seed);
+
+    // u1 is in (0, 1] so the logarithm is finite
+    uint64_t x1 = (uint64_t)counter[0] << 32 | counter[1];
+    uint64_t x2 = (uint64_t)counter[2] << 32 | counter[3];
+    double u1 = ((x1 >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+    double u2 = (x2 >> 11) * (1.0 / 9007199254740992.0);
+
+    if (input->distribution == UNCERTAINTY_NORMAL) {
+        return input->a + input->b * sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2);
+    }
+    return input->a + (input->b - input->a) * u2;
+}
+
+int uncertainty_sample_design(const UncertaintyConfig* config, long long index, NozzleDesign* design) {
+    if (!config || !design || index < 0) {
+        return -1;
+    }
+
+    unsigned long long seed = config->seed ? config->seed : UQ_DEFAULT_SEED;
+    *design = config->base;
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        if (config->inputs[p].distribution != UNCERTAINTY_FIXED) {
+            *nozzle_design_parameter(design, (SweepParameter)p) = sample_input(&config->inputs[p], seed, index, p);
+        }
+    }
+    return 0;
+}
+
+static int parse_single_input(UncertaintyConfig* config, const char* spec, size_t length) {
+    char buffer[128];
+    if (length == 0 || length >= sizeof(buffer)) {
+        return -1;
+    }
+    memcpy(buffer, spec, length);
+    buffer[length] = '\0';
+
+    char* equals = strchr(buffer, '=');
+    if (!equals) {
+        return -1;
+    }
+    *equals = '\0';
+
+    int parameter = sweep_parameter_from_name(buffer);
+    if (parameter < 0) {
+        return -1;
+    }
+
+    // Accept "normal:mean:sd" or "uniform:lower:upper"
+    char* colon = strchr(equals + 1, ':');
+    if (!colon) {
+        return -1;
+    }
+    *colon = '\0';
+
+    UncertainInput input;
+    if (strcmp(equals + 1, "normal") == 0) {
+        input.distribution = UNCERTAINTY_NORMAL;
+    } else if (strcmp(equals + 1, "uniform") == 0) {
+        input.distribution = UNCERTAINTY_UNIFORM;
+    } else {
+        return -1;
+    }
+
+    char extra;
+    if (sscanf(colon + 1, "%lf:%lf%c", &input.a, &input.b, &extra) != 2 || !isfinite(input.a) ||
+        !isfinite(input.b)) {
+        return -1;
+    }
+    if (input.distribution == UNCERTAINTY_NORMAL ? input.b < 0 : input.b < input.a) {
+        return -1;
+    }
+
+    config->inputs[parameter] = input;
+    return 0;
+}
+
+int parse_uncertain_input(UncertaintyConfig* config, const char* spec) {
+    if (!config || !spec) {
+        return -1;
+    }
+
+    // Several inputs may be given in one spec, separated by commas
+    while (*spec) {
+        const char* comma = strchr(spec, ',');
+        size_t length = comma ? (size_t)(comma - spec) : strlen(spec);
+
+        if (parse_single_input(config, spec, length) != 0) {
+            return -1;
+        }
+        spec += length;
+        if (*spec == ',') {
+            spec++;
+        }
+    }
+
+    return 0;
+}
+
+static void sketch_add(UncertaintySketch* sketch, double value) {
+    if (value == 0.0) {
+        sketch->zeros++;
+        return;
+    }
+
+    uint64_t bits;
+    double magnitude = fabs(value);
+    memcpy(&bits, &magnitude, sizeof(bits));
+    uint64_t key = bits >> (52 - UQ_SUB_BITS);
+    long long index = key < UQ_FIRST_KEY ? 0 : (long long)(key - UQ_FIRST_KEY);
+    if (index >= UQ_BUCKETS) {
+        index = UQ_BUCKETS - 1;
+    }
+    sketch->counts[value > 0][index]++;
+}
+
+static void sketch_merge(UncertaintySketch* total, const UncertaintySketch* part) {
+    for (int sign = 0; sign < 2; sign++) {
+        for (int b = 0; b < UQ_BUCKETS; b++) {
+            total->counts[sign][b] += part->counts[sign][b];
+        }
+    }
+    total->zeros += part->zeros;
+}
+
+// Midpoint of a bucket's magnitudes
+static double sketch_bucket_value(int index) {
+    uint64_t lower_bits = (UQ_FIRST_KEY + (uint64_t)index) << (52 - UQ_SUB_BITS);
+    uint64_t upper_bits = (UQ_FIRST_KEY + (uint64_t)index + 1) << (52 - UQ_SUB_BITS);
+    double lower, upper;
+    memcpy(&lower, &lower_bits, sizeof(lower));
+    memcpy(&upper, &upper_bits, sizeof(upper));
+    return 0.5 * (lower + upper);
+}
+
+// Value at 0-based rank among count values, clamped to the exact range
+static double sketch_quantile(const UncertaintySketch* sketch, long long count, double level, double min,
+                              double max) {
+    uint64_t rank = (uint64_t)floor(level * (double)(count - 1) + 0.5);
+    uint64_t seen = 0;
+    double value = max;
+    int found = 0;
+
+    // Negative values from the largest magnitude down, then zeros, then positive values
+    for (int b = UQ_BUCKETS - 1; b >= 0 && !found; b--) {
+        seen += sketch->counts[0][b];
+        if (seen > rank) {
+            value = -sketch_bucket_value(b);
+            found = 1;
+        }
+    }
+    if (!found) {
+        seen += sketch->zeros;
+        if (seen > rank) {
+            value = 0.0;
+            found = 1;
+        }
+    }
+    for (int b = 0; b < UQ_BUCKETS && !found; b++) {
+        seen += sketch->counts[1][b];
+        if (seen > rank) {
+            value = sketch_bucket_value(b);
+            found = 1;
+        }
+    }
+
+    return value < min ? min : value > max ? max : value;
+}
+
+// Evaluate sample indices [first, last) and fold them into the block and thread state
+static void evaluate_samples(const UncertaintyConfig* config, long long first, long long last,
+                             UncertaintyThreadState* state, UncertaintyBlock* block, double* shift,
+                             double* sum, double* sum_squares) {
+    double (*in)[UQ_BATCH] = state->inputs;
+    double (*out)[UQ_BATCH] = state->outputs;
+    size_t count = 0;
+
+    // Valid designs are packed into the batch inputs
+    for (long long i = first; i < last; i++) {
+        NozzleDesign design;
+        uncertainty_sample_design(config, i, &design);
+        if (design_parameter_error(&design)) {
+            state->rejected++;
+            continue;
+        }
+        in[0][count] = design.throat_radius;
+        in[1][count] = design.exit_radius;
+        in[2][count] = design.conditions.chamber_pressure;
+        in[3][count] = design.conditions.ambient_pressure;
+        in[4][count] = design.conditions.chamber_temperature;
+        in[5][count] = design.conditions.molecular_weight;
+        in[6][count] = design.conditions.gamma;
+        in[7][count] = design.conditions.gas_constant;
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    PerformanceBatchInput input = { in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7] };
+    PerformanceBatchOutput output = {
+        out[0], out[1], out[2], out[3], out[4], out[5], out[6], out[7], out[8]
+    };
+    if (config->single_precision) {
+        // Outputs are widened back, so the statistics stay in double
+        float (*in_f32)[UQ_BATCH] = state->inputs_f32;
+        float (*out_f32)[UQ_BATCH] = state->outputs_f32;
+        for (int f = 0; f < 8; f++) {
+            for (size_t i = 0; i < count; i++) {
+                in_f32[f][i] = (float)in[f][i];
+            }
+        }
+        PerformanceBatchInputF input_f32 = {
+            in_f32[0], in_f32[1], in_f32[2], in_f32[3], in_f32[4], in_f32[5], in_f32[6], in_f32[7]
+        };
+        PerformanceBatchOutputF output_f32 = {
+            out_f32[0], out_f32[1], out_f32[2], out_f32[3], out_f32[4], out_f32[5], out_f32[6], out_f32[7],
+            out_f32[8]
+        };
+        calculate_performance_batch_f32(&input_f32, &output_f32, count);
+        for (int f = 0; f < 9; f++) {
+            for (size_t i = 0; i < count; i++) {
+                out[f][i] = out_f32[f][i];
+            }
+        }
+
+        // Near gamma = 1 the float rounding of gamma - 1 dominates, so
+        // those designs are evaluated again in double
+        for (size_t i = 0; i < count; i++) {
+            if (in[6][i] < PRECISION_F32_GAMMA_MIN) {
+                PerformanceBatchInput one = {
+                    &in[0][i], &in[1][i], &in[2][i], &in[3][i], &in[4][i], &in[5][i], &in[6][i], &in[7][i]
+                };
+                PerformanceBatchOutput one_output = {
+                    &out[0][i], &out[1][i], &out[2][i], &out[3][i], &out[4][i], &out[5][i], &out[6][i],
+                    &out[7][i], &out[8][i]
+                };
+                calculate_performance_batch(&one, &one_output, 1);
+                state->double_fallback++;
+            }
+        }
+    } else {
+        calculate_performance_batch(&input, &output, count);
+    }
+
+    const double* values[UNCERTAINTY_NUM_OUTPUTS] = {
+        output.thrust, output.specific_impulse, output.thrust_coefficient, output.mass_flow_rate
+    };
+    for (size_t i = 0; i < count; i++) {
+        int finite = 1;
+        for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+            finite &= isfinite(values[o][i]);
+        }
+        if (!finite) {
+            state->rejected++;
+            continue;
+        }
+
+        // Sums are shifted by the block's first value to avoid cancellation
+        for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+            double x = values[o][i];
+            if (block->count == 0) {
+                shift[o] = x;
+            }
+            double d = x - shift[o];
+            sum[o] += d;
+            sum_squares[o] += d * d;
+            if (x < state->min[o]) state->min[o] = x;
+            if (x > state->max[o]) state->max[o] = x;
+            sketch_add(&state->sketches[o], x);
+        }
+        block->count++;
+        state->completed++;
+    }
+}
+
+static void uncertainty_task(long long begin, long long end, int thread_id, void* context) {
+    UncertaintyJob* job = (UncertaintyJob*)context;
+    UncertaintyThreadState* state = &job->threads[thread_id];
+
+    for (long long b = begin; b < end; b++) {
+        UncertaintyBlock* block = &job->blocks[b];
+        long long first = b * job->block_size;
+        long long last = first + job->block_size;
+        if (last > job->config->samples) {
+            last = job->config->samples;
+        }
+
+        double shift[UNCERTAINTY_NUM_OUTPUTS] = {0};
+        double sum[UNCERTAINTY_NUM_OUTPUTS] = {0};
+        double sum_squares[UNCERTAINTY_NUM_OUTPUTS] = {0};
+        block->count = 0;
+        for (long long i = first; i < last; i += UQ_BATCH) {
+            long long batch_end = i + UQ_BATCH < last ? i + UQ_BATCH : last;
+            evaluate_samples(job->config, i, batch_end, state, block, shift, sum, sum_squares);
+        }
+
+        for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+            double n = (double)block->count;
+            block->mean[o] = block->count > 0 ? shift[o] + sum[o] / n : 0.0;
+            block->m2[o] = block->count > 0 ? fmax(sum_squares[o] - sum[o] * sum[o] / n, 0.0) : 0.0;
+        }
+    }
+}
+
+int run_uncertainty_analysis(const UncertaintyConfig* config, UncertaintySummary* summary) {
+    if (!config || !summary || config->samples <= 0) {
+        return -1;
+    }
+    for (int p = 0; p < SWEEP_NUM_PARAMETERS; p++) {
+        UncertaintyDistribution distribution = config->inputs[p].distribution;
+        if (distribution != UNCERTAINTY_FIXED && distribution != UNCERTAINTY_NORMAL &&
+            distribution != UNCERTAINTY_UNIFORM) {
+            return -1;
+        }
+    }
+
+    memset(summary, 0, sizeof(UncertaintySummary));
+    summary->samples = config->samples;
+
+    // The block layout depends only on the sample count
+    long long block_size = UQ_MIN_BLOCK;
+    while ((config->samples + block_size - 1) / block_size > UQ_MAX_BLOCKS) {
+        block_size *= 2;
+    }
+    long long num_blocks = (config->samples + block_size - 1) / block_size;
+
+    int num_threads = config->num_threads > 0 ? config->num_threads : ngc_cpu_count();
+    if (num_threads > num_blocks) {
+        num_threads = (int)num_blocks;
+    }
+    UncertaintyBlock* blocks = calloc((size_t)num_blocks, sizeof(UncertaintyBlock));
+    UncertaintyThreadState* threads = calloc((size_t)num_threads, sizeof(UncertaintyThreadState));
+    if (!blocks || !threads) {
+        free(blocks);
+        free(threads);
+        return -1;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+            threads[t].min[o] = INFINITY;
+            threads[t].max[o] = -INFINITY;
+        }
+    }
+
+    UncertaintyJob job = { config, block_size, blocks, threads };
+    double start = ngc_wall_time();
+    summary->threads_used = parallel_for(num_blocks, 1, num_threads, uncertainty_task, &job);
+    if (summary->threads_used < 0) {
+        free(blocks);
+        free(threads);
+        return -1;
+    }
+
+    // Combine the blocks in order (Chan, Golub and LeVeque's pairwise update)
+    double n = 0.0;
+    double mean[UNCERTAINTY_NUM_OUTPUTS] = {0};
+    double m2[UNCERTAINTY_NUM_OUTPUTS] = {0};
+    for (long long b = 0; b < num_blocks; b++) {
+        if (blocks[b].count == 0) {
+            continue;
+        }
+        double nb = (double)blocks[b].count;
+        double total = n + nb;
+        for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+            double delta = blocks[b].mean[o] - mean[o];
+            mean[o] += delta * nb / total;
+            m2[o] += blocks[b].m2[o] + delta * delta * n * nb / total;
+        }
+        n = total;
+    }
+
+    // Thread sketches and counts are exact integers, so their merge order does not matter
+    for (int t = 1; t < num_threads; t++) {
+        for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS; o++) {
+            sketch_merge(&threads[0].sketches[o], &threads[t].sketches[o]);
+            threads[0].min[o] = fmin(threads[0].min[o], threads[t].min[o]);
+            threads[0].max[o] = fmax(threads[0].max[o], threads[t].max[o]);
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        summary->completed += threads[t].completed;
+        summary->rejected += threads[t].rejected;
+        summary->double_fallback += threads[t].double_fallback;
+    }
+
+    for (int o = 0; o < UNCERTAINTY_NUM_OUTPUTS && n > 0; o++) {
+        UncertaintyStatistics* stats = &summary->outputs[o];
+        stats->mean = mean[o];
+        stats->std_dev = n > 1 ? sqrt(m2[o] / (n - 1.0)) : 0.0;
+        stats->min = threads[0].min[o];
+        stats->max = threads[0].max[o];
+        for (int q = 0; q < UNCERTAINTY_NUM_QUANTILES; q++) {
+            stats->quantiles[q] = sketch_quantile(&threads[0].sketches[o], (long long)n,
+                                                  uncertainty_quantile_levels[q], stats->min, stats->max);
+        }
+    }
+    summary->elapsed_seconds = ngc_wall_time() - start;
+    if (summary->elapsed_seconds > 0) {
+        summary->samples_per_second = (double)summary->samples / summary->elapsed_seconds;
+    }
+
+    free(blocks);
+    free(threads);
+    return summary->completed > 0 ? 0 : -1;
+}